@@ -2,7 +2,9 @@
 
 #include "Args.hpp"
 #include "CLI/CLI.hpp"
+#include "core/SnapshotWriter.hpp"
 #include "frontend/Plugin.hpp"
+#include "helpers/fs/ScanReport.hpp"
 #include "taglib/Parser.hpp"
 #include "telemetry/Context.hpp"
 
@@ -34,6 +36,7 @@ enum class PrintAction
   SongsByArtist,
   SongsByAlbum,
   SongsByGenre,
+  ScanReport,
 };
 
 enum class EditAction
@@ -81,6 +84,12 @@ struct AppContext
 
   // Core objects
   taglib::Parser m_tagLibParser;
+
+  // persists the library cache off the main thread (joined when the context dies)
+  core::SnapshotWriter m_libraryWriter;
+
+  // what buildOrLoadLibrary spent its time on (see --scan-report)
+  helpers::fs::ScanReport m_scanReport;
 };
 
 auto resolvePrintAction(const Args& args) -> PrintAction;
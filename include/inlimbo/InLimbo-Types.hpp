@@ -1,11 +1,17 @@
 #pragma once
 
 #include "utils/ankerl/Cereal.hpp"
+#include "utils/map/Persistent.hpp"
+#include "utils/string/Intern.hpp"
+#include "utils/string/PropertyBlock.hpp"
 #include "utils/string/SmallString.hpp"
 #include "utils/threads/SafeMap.hpp"
 #include <cereal/types/memory.hpp>
+#include <atomic>
 #include <cstdint>
+#include <memory>
 #include <string>
+#include <sys/stat.h>
 #include <vector>
 
 using i8  = std::int8_t;
@@ -41,16 +47,24 @@ using DirectoryStr = std::string;
 using PathCStr      = const char*;
 using DirectoryCStr = const char*;
 
+// Artist, Album and Genre repeat across thousands of songs and every SongMap level, they
+// are interned library wide (see utils/string/Intern.hpp): a 32 bit id per value, hashed
+// and compared by id, resolved to characters only for display.
+using InternedString = utils::string::InternedString;
+
 using Title      = std::string;
-using Album      = std::string;
-using Artist     = std::string;
-using Genre      = std::string;
+using Album      = InternedString;
+using Artist     = InternedString;
+using Genre      = InternedString;
 using Lyrics     = std::string;
 using Comment    = std::string;
 using Year       = uint;
 using Disc       = uint;
 using Track      = uint;
-using Properties = ankerl::unordered_dense::map<std::string, std::string>;
+using Properties = ankerl::unordered_dense::map<std::string, std::string>; // while parsing
+
+// what a song keeps of Properties: interned keys, values packed in one allocation
+using PropertyBlock = utils::string::PropertyBlock;
 
 using TitleCStr  = const char*;
 using AlbumCStr  = const char*;
@@ -65,54 +79,238 @@ using Genres  = std::vector<Genre>;
 template <typename T, typename S>
 using BucketedMap = ankerl::unordered_dense::map<T, std::vector<S>>;
 
+// ============================================================
+// MetadataDetails (the cold part of a song's metadata)
+// ============================================================
+//
+// Browsing, sorting and searching only look at the tags in Metadata itself. Comment,
+// lyrics, the free form property map and the art url are needed for one song at a time
+// (now playing, info views, edits) but are most of the bytes of a song, so they live in a
+// separate immutable MetadataDetails that Metadata points to (see LazyDetails):
+//
+// -> a scan fills them in memory (details.edit())
+// -> songs loaded from the library cache only remember where their record is, details.get()
+//    reads it from the mmaped cache on first use and keeps it
+//
+// Copying a Metadata copies a pointer, not the strings.
+struct MetadataDetails
+{
+  Comment       comment;
+  Lyrics        lyrics;
+  PropertyBlock additionalProperties;
+
+  // "inlimbo-art://<id>" (core::ArtPack) or a `file://` URI
+  PathStr artUrl;
+
+  template <class Archive>
+  void serialize(Archive& ar)
+  {
+    ar(comment, lyrics, additionalProperties, artUrl);
+  }
+};
+
+// Where details that are not in memory are read back from (core::LibraryCache).
+class DetailsSource
+{
+public:
+  virtual ~DetailsSource() = default;
+
+  [[nodiscard]] virtual auto loadDetails(ui32 index) const -> MetadataDetails = 0;
+};
+
+// The details handle of a Metadata. Copies of a Metadata share one cell, so details read
+// through any copy (say the queue's copy of the playing song) are loaded once for all of
+// them. edit() detaches the cell first if it is shared.
+class LazyDetails
+{
+public:
+  // loads from the source on first use (thread safe, concurrent first calls may both load,
+  // one result is kept)
+  [[nodiscard]] auto get() const -> const MetadataDetails&
+  {
+    static const MetadataDetails none;
+
+    if (!m_cell)
+      return none;
+
+    if (auto p = m_cell->details.load(std::memory_order_acquire))
+      return *p;
+
+    std::shared_ptr<const MetadataDetails> expected;
+    std::shared_ptr<const MetadataDetails> loaded = m_cell->load();
+
+    if (!m_cell->details.compare_exchange_strong(expected, loaded, std::memory_order_acq_rel))
+      return *expected;
+
+    return *loaded;
+  }
+
+  // the details without keeping them, for one off passes over many songs (cache writes)
+  [[nodiscard]] auto peek() const -> std::shared_ptr<const MetadataDetails>
+  {
+    if (!m_cell)
+      return std::make_shared<const MetadataDetails>();
+
+    if (auto p = m_cell->details.load(std::memory_order_acquire))
+      return p;
+
+    return m_cell->load();
+  }
+
+  // writable details of this Metadata only
+  auto edit() -> MetadataDetails&
+  {
+    if (m_cell && m_cell.use_count() == 1)
+    {
+      auto p = m_cell->details.load(std::memory_order_acquire);
+
+      // p + the cell are the only owners: nobody can observe an in place change
+      if (p && p.use_count() == 2)
+      {
+        m_cell->source.reset();
+        return const_cast<MetadataDetails&>(*p);
+      }
+    }
+
+    auto  copy = std::make_shared<MetadataDetails>(get());
+    auto& ref  = *copy;
+
+    m_cell = std::make_shared<Cell>();
+    m_cell->details.store(std::move(copy), std::memory_order_release);
+    return ref;
+  }
+
+  // details stay on the source until get() asks for them
+  void bind(std::shared_ptr<const DetailsSource> source, ui32 index)
+  {
+    m_cell         = std::make_shared<Cell>();
+    m_cell->source = std::move(source);
+    m_cell->index  = index;
+  }
+
+  [[nodiscard]] auto loaded() const noexcept -> bool
+  {
+    return !m_cell || m_cell->details.load(std::memory_order_acquire) != nullptr;
+  }
+
+private:
+  struct Cell
+  {
+    std::atomic<std::shared_ptr<const MetadataDetails>> details;
+    std::shared_ptr<const DetailsSource>                source;
+    ui32                                                index = 0;
+
+    // never a const object: edit() may change it in place once it is the only owner
+    [[nodiscard]] auto load() const -> std::shared_ptr<const MetadataDetails>
+    {
+      return std::make_shared<MetadataDetails>(source ? source->loadDetails(index)
+                                                      : MetadataDetails{});
+    }
+  };
+
+  std::shared_ptr<Cell> m_cell; // null: no details at all
+};
+
 /**
  * @brief A structure to hold metadata information for a song.
+ *
+ * Only the fields every browse / sort / search touches are stored inline, the rest is in
+ * `details` (see MetadataDetails).
  */
 struct Metadata
 {
-  Title      title;
-  Artist     artist;
-  Album      album;
-  Genre      genre;
-  Comment    comment;
-  Year       year       = 0;
-  Track      track      = 0;
-  uint       trackTotal = 0;
-  Disc       discNumber = 0;
-  uint       discTotal  = 0;
-  Lyrics     lyrics;
-  Properties additionalProperties;
-  PathStr    filePath;
-  float      duration = 0.0f;
-  int        bitrate  = 0;
-
-  // Path stored in `file://` URI format.
-  PathStr artUrl;
+  Title       title;
+  Artist      artist;
+  Album       album;
+  Genre       genre;
+  Year        year       = 0;
+  Track       track      = 0;
+  uint        trackTotal = 0;
+  Disc        discNumber = 0;
+  uint        discTotal  = 0;
+  PathStr     filePath;
+  float       duration = 0.0f;
+  int         bitrate  = 0;
+  LazyDetails details;
+
+  template <class Archive>
+  void save(Archive& ar) const
+  {
+    ar(title, artist, album, genre, year, track, trackTotal, discNumber, discTotal, filePath,
+       duration, bitrate, details.get());
+  }
+
+  template <class Archive>
+  void load(Archive& ar)
+  {
+    ar(title, artist, album, genre, year, track, trackTotal, discNumber, discTotal, filePath,
+       duration, bitrate, details.edit());
+  }
+};
+
+// ============================================================
+// FileStamp Structure
+// ============================================================
+//
+// A cheap identity of the file a song was parsed from, taken from stat(2).
+//
+// If a stat-only walk of the library returns the same stamp for a path, the
+// file has not been touched since it was last parsed and its cached metadata
+// can be reused as is (see helpers::fs::dirWalkProcessChanged).
+struct FileStamp
+{
+  ui64 dev     = 0;
+  ui64 inode   = 0;
+  i64  mtimeNs = 0;
+  i64  size    = 0;
+
+  static auto fromStat(const struct stat& st) noexcept -> FileStamp
+  {
+    return {.dev     = static_cast<ui64>(st.st_dev),
+            .inode   = static_cast<ui64>(st.st_ino),
+            .mtimeNs = static_cast<i64>(st.st_mtim.tv_sec) * 1'000'000'000 +
+                       static_cast<i64>(st.st_mtim.tv_nsec),
+            .size    = static_cast<i64>(st.st_size)};
+  }
+
+  auto operator==(const FileStamp&) const -> bool = default;
 
   template <class Archive>
   void serialize(Archive& ar)
   {
-    ar(title, artist, album, genre, comment, year, track, trackTotal, discNumber, discTotal, lyrics,
-       additionalProperties, filePath, duration, bitrate, artUrl);
+    ar(dev, inode, mtimeNs, size);
   }
 };
 
+// A file with a supported extension that did not parse, kept with its stamp so that a
+// rescan only tries it again once the file changed.
+struct FailedFile
+{
+  Path      path;
+  FileStamp stamp;
+};
+
+using FailedFiles = std::vector<FailedFile>;
+
 // ============================================================
 // Song Structure
 // ============================================================
 struct Song
 {
-  ino_t    inode;    /**< The inode of the file representing the song */
-  Metadata metadata; /**< Metadata information for the song */
+  ino_t     inode;    /**< The inode of the file representing the song */
+  Metadata  metadata; /**< Metadata information for the song */
+  FileStamp stamp;    /**< stat(2) identity of the file when it was parsed */
 
   Song(ino_t inode, Metadata metadata) : inode(inode), metadata(std::move(metadata)) {};
+  Song(ino_t inode, Metadata metadata, FileStamp stamp)
+      : inode(inode), metadata(std::move(metadata)), stamp(stamp) {};
   Song() : inode(0), metadata() {};
   explicit Song(ino_t inode) : inode(inode) {}
 
   template <class Archive>
   void serialize(Archive& ar)
   {
-    ar(inode, metadata);
+    ar(inode, metadata, stamp);
   }
 };
 
@@ -123,13 +321,17 @@ using Songs = std::vector<std::shared_ptr<Song>>;
 // of memory usage and removing unneeded RBT allocs happening in std::map
 //
 // lookup time also should decrease but no benchmarks are done yet.
-using InodeMap = ankerl::unordered_dense::map<ino_t, std::shared_ptr<Song>>;
-using TrackMap = ankerl::unordered_dense::map<Track, InodeMap>;
-using DiscMap  = ankerl::unordered_dense::map<Disc, TrackMap>;
-using AlbumMap = ankerl::unordered_dense::map<Album, DiscMap>;
+//
+// Every level is a persistent (copy on write) ankerl map, see utils/map/Persistent.hpp:
+// copying a SongMap is O(1) and a write through the copy only duplicates the tables on the
+// path to the changed song, the rest stays shared with the original.
+using InodeMap = utils::map::PersistentMap<ino_t, std::shared_ptr<Song>>;
+using TrackMap = utils::map::PersistentMap<Track, InodeMap>;
+using DiscMap  = utils::map::PersistentMap<Disc, TrackMap>;
+using AlbumMap = utils::map::PersistentMap<Album, DiscMap>;
 
 // this corresponds to Artist -> Album -> Disc -> Track -> Inode -> Song
-using SongMap = ankerl::unordered_dense::map<Artist, AlbumMap>;
+using SongMap = utils::map::PersistentMap<Artist, AlbumMap>;
 
 // It is recommend to use this alias throughout the project (including frontend)
 using TS_SongMap =
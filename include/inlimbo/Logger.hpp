@@ -4,6 +4,9 @@
 // Include fmt support for SmallString
 // NOLINTNEXTLINE(build/include)
 #include "utils/string/SmallStringFmt.hpp"
+// and for the interned Artist / Album / Genre
+// NOLINTNEXTLINE(build/include)
+#include "utils/string/InternFmt.hpp"
 #include <memory>
 #include <spdlog/spdlog.h>
 
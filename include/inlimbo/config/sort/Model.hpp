@@ -5,6 +5,7 @@
 #include "query/sort/Engine.hpp"
 #include <ankerl/unordered_dense.h>
 #include <string_view>
+#include <vector>
 
 namespace config::sort
 {
@@ -12,7 +13,7 @@ namespace config::sort
 constexpr auto DefaultArtistMetric =
 []() -> query::sort::metric::ArtistMetric
 {
-#define X(name, str, tag) return query::sort::metric::ArtistMetric::name;
+#define X(name, str, key, dir) return query::sort::metric::ArtistMetric::name;
 #include "defs/config/ArtistMetrics.def"
 #undef X
 }();
@@ -20,7 +21,7 @@ constexpr auto DefaultArtistMetric =
 constexpr auto DefaultAlbumMetric =
 []() -> query::sort::metric::AlbumMetric
 {
-#define X(name, str, tag) return query::sort::metric::AlbumMetric::name;
+#define X(name, str, key, dir) return query::sort::metric::AlbumMetric::name;
 #include "defs/config/AlbumMetrics.def"
 #undef X
 }();
@@ -28,7 +29,7 @@ constexpr auto DefaultAlbumMetric =
 constexpr auto DefaultDiscMetric =
 []() -> query::sort::metric::DiscMetric
 {
-#define X(name, str, tag) return query::sort::metric::DiscMetric::name;
+#define X(name, str, key, dir) return query::sort::metric::DiscMetric::name;
 #include "defs/config/DiscMetrics.def"
 #undef X
 }();
@@ -36,7 +37,7 @@ constexpr auto DefaultDiscMetric =
 constexpr auto DefaultTrackMetric =
 []() -> query::sort::metric::TrackMetric
 {
-#define X(name, str, tag) return query::sort::metric::TrackMetric::name;
+#define X(name, str, key, dir) return query::sort::metric::TrackMetric::name;
 #include "defs/config/TrackMetrics.def"
 #undef X
 }();
@@ -57,6 +58,46 @@ auto loadMetricOrFallback(toml::SectionView section, toml::KeyView key,
   return fallbackValue;
 }
 
+// "year_asc, lex_asc": every metric of the chain, in order. One invalid name makes the whole
+// chain fall back, a partly applied chain would sort in a way nobody asked for.
+template <typename EnumT, typename ParseFn>
+auto loadMetricChainOrFallback(toml::SectionView section, toml::KeyView key,
+                               std::string_view fallbackName, EnumT fallbackValue,
+                               ParseFn parseFn, std::string_view logLabel) -> std::vector<EnumT>
+{
+  const auto str = Config::getString(section, key, fallbackName);
+
+  std::vector<EnumT> chain;
+
+  std::string_view rest = str;
+  while (!rest.empty())
+  {
+    const auto comma = rest.find(',');
+    auto       name  = rest.substr(0, comma);
+    rest             = comma == std::string_view::npos ? std::string_view{} : rest.substr(comma + 1);
+
+    while (!name.empty() && name.front() == ' ')
+      name.remove_prefix(1);
+    while (!name.empty() && name.back() == ' ')
+      name.remove_suffix(1);
+
+    auto v = parseFn(name);
+    if (!v)
+    {
+      LOG_WARN("config::sort::RuntimeSortPlan: Invalid {} sort '{}' — falling back to '{}'",
+               logLabel, str, fallbackName);
+      return {fallbackValue};
+    }
+
+    chain.push_back(*v);
+  }
+
+  if (chain.empty())
+    chain.push_back(fallbackValue);
+
+  return chain;
+}
+
 auto loadRuntimeSortPlan() -> query::sort::RuntimeSortPlan;
 
 } // namespace config::sort
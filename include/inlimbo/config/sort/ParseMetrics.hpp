@@ -19,7 +19,7 @@ constexpr auto ArtistMetric_DefCount = []() -> size_t
 {
   size_t n = 0;
 
-#define X(name, str, tag) ++n;
+#define X(name, str, key, dir) ++n;
 #include "defs/config/ArtistMetrics.def"
 #undef X
 
@@ -30,7 +30,7 @@ constexpr auto AlbumMetric_DefCount = []() -> size_t
 {
   size_t n = 0;
 
-#define X(name, str, tag) ++n;
+#define X(name, str, key, dir) ++n;
 #include "defs/config/AlbumMetrics.def"
 #undef X
 
@@ -41,7 +41,7 @@ constexpr auto DiscMetric_DefCount = []() -> size_t
 {
   size_t n = 0;
 
-#define X(name, str, tag) ++n;
+#define X(name, str, key, dir) ++n;
 #include "defs/config/DiscMetrics.def"
 #undef X
 
@@ -52,7 +52,7 @@ constexpr auto TrackMetric_DefCount = []() -> size_t
 {
   size_t n = 0;
 
-#define X(name, str, tag) ++n;
+#define X(name, str, key, dir) ++n;
 #include "defs/config/TrackMetrics.def"
 #undef X
 
@@ -0,0 +1,132 @@
+#pragma once
+
+#include "InLimbo-Types.hpp"
+#include <ankerl/unordered_dense.h>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string_view>
+
+namespace core
+{
+
+// ============================================================
+// ArtPack (content addressed album art store)
+// ============================================================
+//
+// Every embedded picture the scan finds goes into ONE append-only file
+// (~/.cache/inLimbo/art.pack) instead of a JPEG per song:
+//
+//   PackHeader
+//   record*        : RecordHeader + payload, padded to 8 bytes
+//
+// -> ART  records : key = hash of the picture bytes (the ArtId), payload = the picture
+// -> LINK records : key = hash of a song path, payload = LinkPayload (art id + picture size)
+//
+// A 15 track album with the same cover stores it once, and adds 15 small LINK records.
+// LINK records are never rewritten, a later one for the same song wins. The size lets the
+// native readers reuse the art of an unchanged song without reading the picture at all.
+//
+// Opening the pack mmaps it once and walks the record headers to rebuild both indexes in
+// memory. A torn record at the tail (crash in the middle of an append) ends the walk and
+// is cut off by the next append. Appends take an flock, so the CLI and a running frontend
+// can share the pack.
+//
+// Metadata::artUrl holds "inlimbo-art://<id>" for packed art. Consumers that need a real
+// file (image loaders, MPRIS) go through resolveFile, which exports that one picture to
+// ~/.cache/inLimbo/art/<id>.<ext> the first time it is asked for.
+//
+// Pictures no longer referenced by any song stay in the pack, deleting the file simply
+// makes the next scan start a fresh one.
+
+#define INLIMBO_ART_PACK_MAGIC   "INLBART"
+#define INLIMBO_ART_PACK_VERSION 1
+#define INLIMBO_ART_URI_SCHEME   "inlimbo-art://"
+
+using ArtId = ui64;
+
+struct PackHeader
+{
+  char magic[8];
+  ui32 version;
+  ui32 headerSize;
+};
+
+struct RecordHeader
+{
+  ui32 type; // RecordType
+  ui32 size; // payload bytes, without padding
+  ui64 key;
+};
+
+struct LinkPayload
+{
+  ArtId art;
+  ui64  pictureSize;
+};
+
+enum class RecordType : ui32
+{
+  Art  = 0x54524141, // "AART"
+  Link = 0x4b4e4c41, // "ALNK"
+};
+
+class ArtPack
+{
+public:
+  explicit ArtPack(std::filesystem::path file);
+  ~ArtPack();
+
+  ArtPack(const ArtPack&)                    = delete;
+  auto operator=(const ArtPack&) -> ArtPack& = delete;
+
+  // the process wide pack in the app cache dir, opened on first use
+  static auto global() -> ArtPack&;
+
+  // art of songPath stored by an earlier put, if the picture still has the same size
+  // (std::nullopt for pictureSize accepts any)
+  [[nodiscard]] auto lookup(std::string_view songPath, std::optional<ui64> pictureSize)
+    -> std::optional<ArtId>;
+
+  // stores picture unless the pack has it already and links songPath to it.
+  // std::nullopt if the pack is unusable (logged once).
+  auto put(std::string_view songPath, std::string_view picture) -> std::optional<ArtId>;
+
+  // copy of the picture bytes
+  [[nodiscard]] auto read(ArtId id) -> std::optional<std::string>;
+
+  // ~/.cache/inLimbo/art/<id>.<jpg|png|img>, written on the first call. Empty on failure.
+  auto exportFile(ArtId id) -> std::filesystem::path;
+
+  [[nodiscard]] auto artCount() -> size_t;
+  [[nodiscard]] auto linkCount() -> size_t;
+
+  static auto toUri(ArtId id) -> PathStr;
+  static auto fromUri(std::string_view uri) -> std::optional<ArtId>;
+
+  // a loadable file for any Metadata::artUrl (packed or a plain file:// one), empty if none
+  static auto resolveFile(std::string_view artUrl) -> PathStr;
+
+  static auto hashBytes(std::string_view bytes) noexcept -> ui64;
+
+private:
+  struct ArtEntry
+  {
+    ui64 offset; // of the payload
+    ui64 size;
+  };
+
+  std::filesystem::path m_file;
+  std::mutex            m_mtx;
+  int                   m_fd  = -1;
+  ui64                  m_end = 0; // end of the last complete record we indexed
+
+  ankerl::unordered_dense::map<ArtId, ArtEntry>    m_arts;
+  ankerl::unordered_dense::map<ui64, LinkPayload> m_links;
+
+  void open();
+  void indexFrom(ui64 offset); // walks records from offset to EOF (mmap), with m_mtx held
+  auto append(RecordType type, ui64 key, std::string_view payload) -> std::optional<ui64>;
+};
+
+} // namespace core
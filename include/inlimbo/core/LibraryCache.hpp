@@ -0,0 +1,204 @@
+#pragma once
+
+#include "InLimbo-Types.hpp"
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <string_view>
+
+namespace query::songmap
+{
+struct SortOrder;
+} // namespace query::songmap
+
+namespace core
+{
+
+// ============================================================
+// LibraryCache (on disk library format, read through mmap)
+// ============================================================
+//
+// Layout (native endian, every section 8 byte aligned):
+//
+//   CacheHeader
+//   string pool    : every distinct string once (artist, album, paths, ...)
+//   SongRecord[]   : fixed size, in SongMap order (artist -> album -> disc -> track -> inode)
+//   PropRecord[]   : additionalProperties of all songs, SongRecord points at its slice
+//   AlbumRecord[]  : per album, the contiguous SongRecord range
+//   ArtistRecord[] : per artist, the contiguous AlbumRecord range
+//   ui32[]         : the plan order of the songs (query::songmap::SortOrder), every array
+//                    of it as (count, values...) in declaration order. Empty when no order
+//                    was saved; sortPlanHash names the sort program it was built with.
+//   FailedRecord[] : files that did not parse, with their stamp. A rescan skips them until
+//                    the stamp changes (see helpers::fs::dirWalkProcessChanged).
+//
+// Strings are (offset, size) references into the pool, so nothing needs parsing:
+// opening the cache is an mmap plus a header check, and every accessor below
+// reads in place. Only what gets materialized (toSongMap / materialize) is ever
+// copied out, and only the pages actually read become resident.
+//
+// A cache owned by a shared_ptr is also the DetailsSource of the songs it
+// materializes: comment, lyrics, art url and properties stay in the mapping
+// until a song's details are first asked for (see LazyDetails).
+//
+// A loaded snapshot (core::SongLibrarySnapshot) keeps the cache as is. Startup
+// builds the query columns straight from the records (query::songmap::adoptLibraryCache),
+// a Song is only materialized when something first asks for it, and toSongMap() (every
+// record, core Metadata fields copied out) only runs when a SongMap is really needed.
+//
+// The version must be bumped on ANY layout change, an unknown version (or a
+// file that is not a cache at all, like an old cereal snapshot) throws and the
+// caller rebuilds the library.
+
+#define INLIMBO_LIBRARY_CACHE_MAGIC   "INLBLIB"
+#define INLIMBO_LIBRARY_CACHE_VERSION 3
+
+struct StrRef
+{
+  ui32 offset = 0;
+  ui32 size   = 0;
+};
+
+struct Section
+{
+  ui64 offset = 0;
+  ui64 count  = 0; // elements (bytes for the string pool)
+};
+
+struct CacheHeader
+{
+  char    magic[8];
+  ui32    version;
+  ui32    headerSize;
+  ui64    fileSize;
+  StrRef  musicPath;
+  Section strings;
+  Section songs;
+  Section props;
+  Section albums;
+  Section artists;
+  ui64    sortPlanHash; // 0 = no order saved
+  Section order;
+  Section failed;
+};
+
+struct SongRecord
+{
+  ui64   inode;
+  ui64   stampDev;
+  ui64   stampInode;
+  i64    stampMtimeNs;
+  i64    stampSize;
+  StrRef title;
+  StrRef artist;
+  StrRef album;
+  StrRef genre;
+  StrRef comment;
+  StrRef lyrics;
+  StrRef filePath;
+  StrRef artUrl;
+  ui32   year;
+  ui32   track;
+  ui32   trackTotal;
+  ui32   discNumber;
+  ui32   discTotal;
+  i32    bitrate;
+  float  duration;
+  ui32   propFirst;
+  ui32   propCount;
+  // the Disc/Track keys this song was filed under in the SongMap
+  ui32 discKey;
+  ui32 trackKey;
+  ui32 reserved; // 0, spelled out so no padding byte of the record is left unwritten
+};
+
+struct PropRecord
+{
+  StrRef key;
+  StrRef value;
+};
+
+struct AlbumRecord
+{
+  StrRef name;
+  ui32   firstSong;
+  ui32   songCount;
+};
+
+struct ArtistRecord
+{
+  StrRef name;
+  ui32   firstAlbum;
+  ui32   albumCount;
+};
+
+struct FailedRecord
+{
+  StrRef path;
+  ui64   stampDev;
+  ui64   stampInode;
+  i64    stampMtimeNs;
+  i64    stampSize;
+};
+
+static_assert(sizeof(SongRecord) == 152);
+static_assert(offsetof(SongRecord, reserved) + sizeof(ui32) == sizeof(SongRecord));
+static_assert(std::is_trivially_copyable_v<SongRecord>);
+static_assert(sizeof(FailedRecord) == 40);
+
+class LibraryCache final : public DetailsSource,
+                           public std::enable_shared_from_this<LibraryCache>
+{
+public:
+  // maps and validates the file, throws std::runtime_error if it is not a (current) cache
+  explicit LibraryCache(const Path& file);
+  ~LibraryCache() override;
+
+  LibraryCache(const LibraryCache&)                    = delete;
+  auto operator=(const LibraryCache&) -> LibraryCache& = delete;
+
+  // serializes songMap (in its current order) to file, with the plan order of its columns
+  // if given and the files that failed to parse
+  static void write(const Path& file, const SongMap& songMap, const Path& musicPath,
+                    const query::songmap::SortOrder* order = nullptr,
+                    const FailedFiles&               failed = {});
+
+  // In place accessors (valid as long as this object lives)
+  [[nodiscard]] auto str(StrRef ref) const noexcept -> std::string_view;
+  [[nodiscard]] auto musicPath() const noexcept -> std::string_view;
+
+  [[nodiscard]] auto songs() const noexcept -> std::span<const SongRecord>;
+  [[nodiscard]] auto artists() const noexcept -> std::span<const ArtistRecord>;
+  [[nodiscard]] auto albums(const ArtistRecord& artist) const noexcept
+    -> std::span<const AlbumRecord>;
+  [[nodiscard]] auto songs(const AlbumRecord& album) const noexcept -> std::span<const SongRecord>;
+  [[nodiscard]] auto props(const SongRecord& song) const noexcept -> std::span<const PropRecord>;
+
+  // the saved plan order, nullptr if there is none (or it is malformed). It is the order
+  // of the columns of these records (SongColumns::fromCache(), or toSongMap()).
+  [[nodiscard]] auto sortOrder() const -> std::shared_ptr<const query::songmap::SortOrder>;
+  // the files that failed to parse when the cache was written
+  [[nodiscard]] auto failedFiles() const -> FailedFiles;
+
+  // Materialization (rec is one of songs())
+  [[nodiscard]] auto materialize(const SongRecord& rec) const -> std::shared_ptr<Song>;
+  // every record, only the details stay in the mapping
+  [[nodiscard]] auto toSongMap() const -> SongMap;
+
+  // details of songs()[index]
+  [[nodiscard]] auto loadDetails(ui32 index) const -> MetadataDetails override;
+
+private:
+  const char* m_base = nullptr;
+  size_t      m_size = 0;
+
+  const CacheHeader* m_header = nullptr;
+
+  template <typename T>
+  [[nodiscard]] auto section(const Section& s) const noexcept -> std::span<const T>
+  {
+    return {reinterpret_cast<const T*>(m_base + s.offset), static_cast<size_t>(s.count)};
+  }
+};
+
+} // namespace core
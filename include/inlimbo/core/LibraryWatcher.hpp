@@ -0,0 +1,71 @@
+#pragma once
+
+#include "InLimbo-Types.hpp"
+#include "helpers/fs/Directory.hpp"
+#include "taglib/Parser.hpp"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <thread>
+
+namespace core
+{
+
+// ============================================================
+// LibraryWatcher (live library updates via inotify)
+// ============================================================
+//
+// Watches the music directory recursively and folds whatever happens on disk into the
+// running TS_SongMap, so new music shows up without a restart or a rebuild.
+//
+// -> every directory below the root gets its own inotify watch, directories created or
+//    moved in later are watched (and walked) as they appear
+// -> events are collected into a burst until the tree has been quiet for `settleMs`
+//    (an album copy is hundreds of events, it becomes ONE batch)
+// -> only the files touched by the burst are parsed, on a work stealing pool
+// -> the batch lands as one query::songmap::mut::applyLibraryDelta, i.e. one SafeMap
+//    publish per burst (frontends notice through TS_SongMap::version())
+// -> an inotify queue overflow falls back to a stat only rescan (dirWalkProcessChanged)
+//
+// onPublish is called on the watcher thread after every published batch (used to persist
+// the library cache), with the files of the library that failed to parse. Those are seeded
+// by setFailedFiles() and a resync does not parse them again until their stamp changes.
+
+class LibraryWatcher
+{
+public:
+  LibraryWatcher(const Directory& root, TS_SongMap& songMap, const taglib::Parser& tagParser,
+                 helpers::fs::ScanOptions scanOptions = {}, int settleMs = 300,
+                 std::function<void(const FailedFiles&)> onPublish = {});
+  ~LibraryWatcher();
+
+  LibraryWatcher(const LibraryWatcher&)                    = delete;
+  auto operator=(const LibraryWatcher&) -> LibraryWatcher& = delete;
+
+  // only before start()
+  void setFailedFiles(FailedFiles failed) { m_failedFiles = std::move(failed); }
+
+  // adds the watches (throws std::runtime_error if inotify is unusable) and starts the thread
+  void start();
+  void stop();
+
+private:
+  struct State;
+
+  void run();
+
+  Directory                               m_root;
+  TS_SongMap&                             m_songMap;
+  taglib::Parser                          m_tagParser;
+  helpers::fs::ScanOptions                m_scanOptions;
+  int                                     m_settleMs;
+  std::function<void(const FailedFiles&)> m_onPublish;
+  FailedFiles                             m_failedFiles; // watcher thread only once started
+
+  std::unique_ptr<State> m_state;
+  std::thread            m_thread;
+  std::atomic<bool>      m_running{false};
+};
+
+} // namespace core
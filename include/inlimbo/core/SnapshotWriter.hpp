@@ -0,0 +1,68 @@
+#pragma once
+
+#include "InLimbo-Types.hpp"
+#include <memory>
+
+namespace query::songmap
+{
+struct SongColumns;
+struct SortOrder;
+} // namespace query::songmap
+
+namespace core
+{
+
+// ============================================================
+// SnapshotWriter (background library cache persistence)
+// ============================================================
+//
+// Writes the library cache (core::LibraryCache) on a background thread so that
+// nothing on the startup / edit path waits for serialization or fsync.
+//
+// -> request() only stores a pinned SongMap (TS_SongMap::pin(), no copy) and returns.
+//    Given the columns of a map instead, their plan order is saved with it, so the next
+//    startup does not sort again (see query::songmap::adoptLibraryCache). Columns built
+//    from a library cache make their map on the worker thread.
+// -> requests made while a write is running collapse into ONE follow up write of the
+//    latest map, intermediate maps are never written
+// -> every write is atomic (temp file, fsync, rename), see LibraryCache::write
+// -> the files that failed to parse (setFailedFiles) are saved with every later write
+// -> flush() waits until everything requested so far is on disk, the destructor
+//    flushes as well, so the process never exits with a pending save
+//
+// The worker thread is only started by the first request. Write errors are logged,
+// the previous cache stays in place and the next startup simply rescans.
+
+class SnapshotWriter
+{
+public:
+  SnapshotWriter();
+  ~SnapshotWriter();
+
+  SnapshotWriter(SnapshotWriter&&) noexcept;
+  auto operator=(SnapshotWriter&&) noexcept -> SnapshotWriter&;
+
+  SnapshotWriter(const SnapshotWriter&)                    = delete;
+  auto operator=(const SnapshotWriter&) -> SnapshotWriter& = delete;
+
+  void request(const Path& file, std::shared_ptr<const SongMap> songMap, const Path& musicPath);
+  void request(const Path& file, const std::shared_ptr<const query::songmap::SongColumns>& columns,
+               const Path& musicPath);
+  void setFailedFiles(FailedFiles failed);
+  [[nodiscard]] auto failedFiles() const -> FailedFiles;
+  void flush();
+
+  // how long the latest finished write took (ms), 0 before the first one
+  [[nodiscard]] auto lastWriteMs() const -> double;
+
+private:
+  struct State;
+
+  void enqueue(const Path& file, std::shared_ptr<const SongMap> songMap,
+               std::shared_ptr<const query::songmap::SongColumns> columns,
+               std::shared_ptr<const query::songmap::SortOrder> order, const Path& musicPath);
+
+  std::unique_ptr<State> m_state;
+};
+
+} // namespace core
@@ -4,19 +4,14 @@
 #include "StackTrace.hpp"
 #include "utils/string/SmallString.hpp"
 
-// NOLINTNEXTLINE(build/include)
-#include "utils/string/SmallStringCereal.hpp"
-
-#include <cereal/archives/binary.hpp>
-#include <cereal/types/map.hpp>
-#include <cereal/types/string.hpp>
-#include <cereal/types/vector.hpp>
-
+#include <memory>
 #include <sys/stat.h> // for inode/stat lookup
 
 namespace core
 {
 
+class LibraryCache;
+
 // ============================================================
 // SongLibrarySnapshot Declaration (NOT THREAD SAFE)
 // ============================================================
@@ -24,16 +19,28 @@ namespace core
 // Note that this structure is used ONLY for serialization and deserialization.
 // The in-memory representation used during runtime is a threads::SafeMap<SongMap>.
 //
+// On disk it is a core::LibraryCache (see core/LibraryCache.hpp), which is mmaped
+// on load instead of being deserialized. A loaded snapshot keeps the cache and makes
+// its SongMap only when the map is first asked for, a caller that can work off the
+// cache records (see cache()) never makes one.
+//
 
 class SongLibrarySnapshot
 {
 private:
-  SongMap m_songMap;
-  Path    m_musicPath;
+  SongMap                             m_songMap;
+  Path                                m_musicPath;
+  std::shared_ptr<const LibraryCache> m_cache;       // loaded, the songs are not made yet
+  FailedFiles                         m_failedFiles; // not in the map, see FailedFile
+
+  // files the songs of m_cache into m_songMap and drops the cache
+  void materialize();
 
 public:
   // Core methods
   void addSong(const Song& song);
+  // shares the given song instead of copying it (used when carrying songs over from a cache)
+  void addSong(std::shared_ptr<Song> song);
   void setMusicPath(const Path& path) { m_musicPath = path; }
 
   ~SongLibrarySnapshot() { clear(); }
@@ -43,34 +50,35 @@ public:
     RECORD_FUNC_TO_BACKTRACE("SongLibrarySnapshot::clear");
     m_songMap.clear();
     m_musicPath.clear();
+    m_cache.reset();
+    m_failedFiles.clear();
   }
 
   // Query methods
-  [[nodiscard]] auto returnSongMap() const -> const SongMap&
-  {
-    RECORD_FUNC_TO_BACKTRACE("SongLibrarySnapshot::returnSongMap");
-    return m_songMap;
-  }
-  [[nodiscard]] auto moveSongMap() noexcept -> SongMap
+  // both make the song map of a loaded cache first
+  [[nodiscard]] auto returnSongMap() -> const SongMap&;
+  [[nodiscard]] auto moveSongMap() -> SongMap;
+  // note that this replaces the entire song map, newMap is moved from
+  void newSongMap(SongMap&& newMap) noexcept
   {
-    RECORD_FUNC_TO_BACKTRACE("SongLibrarySnapshot::moveSongMap");
-    return std::move(m_songMap);
-  }
-  // note that this replaces the entire song map and newMap is no longer valid after this call
-  void newSongMap(const SongMap& newMap)
-  {
-    RECORD_FUNC_TO_BACKTRACE("SongLibrarySnapshot::replaceSongMap");
+    RECORD_FUNC_TO_BACKTRACE("SongLibrarySnapshot::newSongMap");
     m_songMap = std::move(newMap);
+    m_cache.reset();
   }
   [[nodiscard]] auto returnMusicPath() const -> const Path { return m_musicPath; }
-
-  // Persistence
-  template <class Archive>
-  void serialize(Archive& ar)
+  // the loaded cache as long as no song map was made from it (see
+  // query::songmap::adoptLibraryCache), nullptr otherwise
+  [[nodiscard]] auto cache() const noexcept -> const std::shared_ptr<const LibraryCache>&
   {
-    ar(m_songMap, m_musicPath);
+    return m_cache;
   }
 
+  // files of the library that did not parse (filled by the dir walks, saved with the cache)
+  [[nodiscard]] auto failedFiles() const noexcept -> const FailedFiles& { return m_failedFiles; }
+  [[nodiscard]] auto moveFailedFiles() noexcept -> FailedFiles { return std::move(m_failedFiles); }
+  void setFailedFiles(FailedFiles failed) noexcept { m_failedFiles = std::move(failed); }
+
+  // Persistence
   void saveToFile(const utils::string::SmallString& filename) const;
   void loadFromFile(const utils::string::SmallString& filename);
 };
@@ -40,6 +40,8 @@ public:
 
   void executeWithTelemetry(const std::function<void(audio::Service&)>& fn);
   void setOnConfigReload(std::function<void()> fn);
+  // called when a new song map got published (say by the library watcher)
+  void setOnLibraryChange(std::function<void()> fn);
   void execute(std::function<void()> fn);
 
   auto getConfig() -> std::shared_ptr<const TuiConfig> { return m_cfg.get(); }
@@ -61,6 +63,8 @@ private:
   config::Watcher            m_cfgWatcher;
   utils::Snapshot<TuiConfig> m_cfg{};
   std::function<void()>      m_onConfigReload;
+  std::function<void()>      m_onLibraryChange;
+  ui64                       m_libraryVersion{0};
 
   std::thread status_thread;
   std::thread mpris_thread;
@@ -41,11 +41,13 @@ private:
   TS_SongMap*         m_songMap{nullptr};
   telemetry::Context* m_telemetryCtx{nullptr};
   mpris::Service*     m_mpris{nullptr};
+  ui64                m_libraryVersion{0}; // song map version m_library was built from
 
   // config stuff
   utils::Snapshot<RaylibConfig> m_cfg{};
 
   void loadConfig();
+  void reloadArtists();
   void draw(audio::Service& audio);
   void statusLoop(audio::Service& audio);
 
@@ -4,6 +4,9 @@
 #include "frontend/raylib/state/Library.hpp"
 #include "frontend/raylib/ui/Fonts.hpp"
 #include "mpris/Service.hpp"
+#include "query/Cursor.hpp"
+
+#include <vector>
 
 namespace frontend::raylib::view
 {
@@ -13,6 +16,11 @@ class AlbumsView
 public:
   void draw(const ui::Fonts& fonts, state::Library& lib, audio::Service& audio, TS_SongMap& songMap,
             mpris::Service& mpris);
+
+private:
+  // only the rows on screen are fetched each frame
+  query::songmap::Cursor           m_cursor;
+  std::vector<query::songmap::Row> m_rows;
 };
 
 } // namespace frontend::raylib::view
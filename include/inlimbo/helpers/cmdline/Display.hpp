@@ -3,6 +3,7 @@
 #include "InLimbo-Types.hpp"
 #include "audio/Registry.hpp"
 #include "audio/backend/Devices.hpp"
+#include "helpers/fs/ScanReport.hpp"
 #include "telemetry/Context.hpp"
 #include <optional>
 
@@ -40,4 +41,6 @@ void printSongPaths(const TS_SongMap& safeMap);
 
 void printSummary(const TS_SongMap& safeMap, const telemetry::Context& telemetryCtx);
 
+void printScanReport(const helpers::fs::ScanReport& report);
+
 } // namespace helpers::cmdline
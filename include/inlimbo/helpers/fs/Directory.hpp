@@ -2,12 +2,54 @@
 
 #include "InLimbo-Types.hpp"
 #include "core/SongLibrarySnapshot.hpp"
+#include "helpers/fs/ScanReport.hpp"
 #include "taglib/Parser.hpp"
 
 namespace helpers::fs
 {
 
+// How the scan talks to the disk
+enum class ScanBackend
+{
+  Auto,     // io_uring when the kernel gives us a ring, syscalls otherwise
+  Syscalls, // fstatat per entry, open + pread per file (inside the parse workers)
+  IoUring   // batched statx per directory, batched open + header read ahead of the parsers
+};
+
+struct ScanOptions
+{
+  size_t      threads    = 0; // parse pool size, 0 sizes it to the machine (hardware_concurrency)
+  ScanBackend backend    = ScanBackend::Auto;
+  unsigned    queueDepth = 64; // io_uring: operations kept in flight
+};
+
+// "auto", "syscalls" or "io_uring" (anything else is Auto)
+auto scanBackendFromString(std::string_view name) -> ScanBackend;
+
+// report (optional) gets the walk / parse / insert stages and the file counters
 void dirWalkProcessAll(const Directory& directory, taglib::Parser& tagParser,
-                       core::SongLibrarySnapshot& songLibrarySnapshot);
+                       core::SongLibrarySnapshot& songLibrarySnapshot,
+                       const ScanOptions& options = {}, ScanReport* report = nullptr);
+
+// What an incremental rescan found, compared against the cached library
+struct RescanSummary
+{
+  size_t unchanged   = 0; // stamp matched, cached song reused as is
+  size_t added       = 0; // path not in the cache, parsed
+  size_t updated     = 0; // path cached but stamp differs, re-parsed
+  size_t removed     = 0; // cached path no longer on disk (or no longer parseable)
+  size_t failed      = 0; // tried and did not parse, remembered (snapshot's failed files)
+  size_t knownFailed = 0; // did not parse before and stamp unchanged, not tried again
+
+  [[nodiscard]] auto changed() const noexcept -> bool { return added || updated || removed; }
+};
+
+// Brings an already loaded songLibrarySnapshot up to date with the directory, only files whose
+// FileStamp differs from the cached one are parsed again. Its failed files are updated as well
+// (also when nothing else changed).
+auto dirWalkProcessChanged(const Directory& directory, taglib::Parser& tagParser,
+                           core::SongLibrarySnapshot& songLibrarySnapshot,
+                           const ScanOptions& options = {}, ScanReport* report = nullptr)
+  -> RescanSummary;
 
 } // namespace helpers::fs
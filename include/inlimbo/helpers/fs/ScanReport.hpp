@@ -0,0 +1,73 @@
+#pragma once
+
+#include "InLimbo-Types.hpp"
+#include "utils/timer/Timer.hpp"
+
+#include <string>
+#include <vector>
+
+namespace helpers::fs
+{
+
+// ============================================================
+// ScanReport (where a library scan spends its time)
+// ============================================================
+//
+// Filled by dirWalkProcessAll / dirWalkProcessChanged (walk, parse, insert) and by
+// inlimbo::buildOrLoadLibrary (sort, save, total). Logged as one JSON line after every
+// startup scan and printed by `--scan-report` (modify / query subcommands), so the
+// numbers of two releases can be diffed directly.
+//
+// Stages overlap: the walk runs on the calling thread while the pool already parses, so
+// walkMs is contained in parseMs. Art extraction happens in the same pass over the file
+// as the tags (no separate stage), only its hits / misses are counted.
+
+// utils::Timer<> truncates to whole ms, most stages of an incremental scan take less
+using StageTimer =
+  utils::Timer<std::chrono::steady_clock, std::chrono::duration<double, std::milli>>;
+
+struct ScanReport
+{
+  static constexpr size_t SLOWEST_FILES = 10;
+
+  struct SlowFile
+  {
+    std::string path;
+    double      ms = 0.0;
+  };
+
+  std::string mode    = "none"; // "full", "incremental" or "none" (cache loaded as is)
+  std::string backend = "syscalls";
+  size_t      threads = 0;
+
+  // wall clock per stage (ms)
+  double walkMs   = 0.0; // directory walk + stat (+ io_uring prefetch submission)
+  double parseMs  = 0.0; // walk start -> last parse job done
+  double insertMs = 0.0; // merging the worker shards into the snapshot (addSong)
+  double sortMs   = 0.0; // columns + plan order of the new song map (or the saved order)
+  double saveMs   = 0.0; // library cache write (runs in the background, 0 if not waited for)
+  double totalMs  = 0.0;
+
+  double parseCpuMs = 0.0; // sum of every single parse over all workers
+
+  size_t filesSeen     = 0; // regular files the walk visited
+  size_t filesParsed   = 0; // parsed successfully
+  size_t filesSkipped  = 0; // incremental scan: stamp unchanged, not read at all
+  size_t parseFailures = 0;
+  size_t taglibParses  = 0; // native reader gave up, TagLib parsed the file
+  size_t artHits       = 0;
+  size_t artMisses     = 0;
+  ui64   bytesRead     = 0; // native readers only (see taglib::ParseSession)
+
+  std::vector<SlowFile> slowest; // slowest parses, slowest first
+
+  [[nodiscard]] auto filesPerSecond() const noexcept -> double;
+
+  // keeps the SLOWEST_FILES slowest of slowest + other
+  void mergeSlowest(std::vector<SlowFile>& other);
+
+  // indent < 0 gives a single line (for the log)
+  [[nodiscard]] auto toJson(int indent = -1) const -> std::string;
+};
+
+} // namespace helpers::fs
@@ -20,8 +20,8 @@ void logFuzzyNoMatch(const char* kind, const T& query)
   LOG_ERROR("No fuzzy match found for kind '{}'. Provided query='{}'", kind, query);
 }
 
-template <typename T>
-inline static auto logFuzzyFallback(std::string_view type, const T& input, const T& best) -> void
+template <typename T, typename U>
+inline static auto logFuzzyFallback(std::string_view type, const T& input, const U& best) -> void
 {
   if (!input.empty() && !best.empty() && input != best)
   {
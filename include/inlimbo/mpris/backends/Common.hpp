@@ -1,7 +1,9 @@
 #pragma once
 
 #include "audio/Service.hpp"
+#include "core/ArtPack.hpp"
 #include "mpris/Interface.hpp"
+#include "utils/fs/FileUri.hpp"
 
 namespace mpris::backend
 {
@@ -69,10 +71,19 @@ public:
     return m ? m->album : "";
   }
 
+  // MPRIS clients want a file:// url, packed art is exported to a file for them
   [[nodiscard]] auto artUrl() const -> PathStr override
   {
     auto m = m_audioService.getCurrentMetadata();
-    return m ? m->artUrl : "";
+    if (!m)
+      return "";
+
+    const auto& artUrl = m->details.get().artUrl;
+    if (artUrl.empty())
+      return "";
+
+    const auto file = core::ArtPack::resolveFile(artUrl);
+    return file.empty() ? "" : utils::fs::toAbsFilePathUri(file).c_str();
   }
 
   /* Volume */
@@ -0,0 +1,378 @@
+#pragma once
+
+#include "Config.hpp"
+#include "InLimbo-Types.hpp"
+#include "query/sort/Engine.hpp"
+#include "utils/string/Equals.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace core
+{
+class LibraryCache;
+} // namespace core
+
+namespace query::songmap
+{
+
+// ============================================================
+// SongColumns (struct of arrays view of one published SongMap)
+// ============================================================
+//
+// The SongMap nests five hash maps (Artist -> Album -> Disc -> Track -> Inode) and every
+// song is a separate heap object, so a full scan chases pointers at every level. The read
+// queries run on this flattened copy of the map instead:
+//
+// -> one contiguous array per column (title, artist, album, genre, disc, track, year,
+//    duration, bitrate, inode), index i is the same song in each. Songs keep the SongMap
+//    iteration order (insertion order, the map itself is never sorted).
+// -> artist / album / disc group tables with [firstSong, firstSong + songCount) ranges
+//    into the columns, so "songs of X" is a slice and not a lookup per level.
+//
+// A scan over one column is a linear pass over 4-8 byte values (artist, album and genre
+// are interned ids, see utils/string/Intern.hpp). The Song objects are only touched for
+// the matches.
+//
+// Point lookups do not scan at all, three hash indexes are built alongside the columns:
+//
+// -> inode -> song (the last one in map order when an inode is filed twice)
+// -> case folded title -> songs, a hash of the folded codepoints pointing at the first
+//    song with it, titleNext chains the rest in map order. Hash collisions are sorted out
+//    by comparing the titles (utils::string::isEquals) while walking the chain.
+// -> file path -> song (the first one in map order)
+//
+// The indexes hold song positions, so they are not patched on updates: applyLibraryDelta()
+// and replaceSongObjAndUpdateMetadata() publish a new map, and its columns are built with
+// fresh indexes (one pass over the map, see columns()).
+//
+// Genres get an inverted index: one posting list per distinct genre (song positions in map
+// order, genres sorted by name), and every artist keeps the sorted list of genres its songs
+// use. Library wide totals are counted during the build, so the count* queries and the
+// summary screens read a field instead of scanning. Like the hash indexes, posting lists
+// and totals are recomputed for every published map, an update does not adjust them.
+//
+// The order readers see is the one of the runtime sort plan, kept next to the columns as a
+// SortOrder (see below and query/sort/Order.hpp). Changing the plan recomputes that order
+// only: no column, index or map is rebuilt.
+//
+// Columns are built lazily, once per published map (see columns()). They hold the map
+// they were built from, and all the pointers and title views refer into that map.
+//
+// Columns of a library cache (fromCache(), see adoptLibraryCache()) are built from the
+// mapped records instead: titles and paths are views into the cache's string pool and no
+// Song exists yet. songAt() makes a song from its record when it is first asked for, and
+// songMap() files every song into a SongMap the first time something needs the map itself
+// (a write, a visitor handing out map tables, the cache writer).
+
+struct SongColumns;
+
+// ============================================================
+// SortOrder (the runtime sort plan applied to one SongColumns)
+// ============================================================
+//
+// Group and song indexes in plan order. Every level is laid out parent by parent, so the
+// albums of one artist, the discs of one album and the songs of one disc / album / artist
+// are contiguous slices:
+//
+//   artists : a2 a0 a1
+//   albums  : [albums of a2] [albums of a0] [albums of a1]
+//   songs   : [songs of a2 .............] [songs of a0 ..] [...]
+//
+// The *Album / *Disc / *Song arrays give, per group index, where its slice starts.
+// planHash names the program the order was built with (sort::hash()), an order saved in the
+// library cache is only taken back for the same one.
+
+struct SortOrder
+{
+  ui64 planHash = 0;
+
+  std::vector<ui32> artists; // artist groups
+  std::vector<ui32> albums;  // album groups
+  std::vector<ui32> discs;   // disc groups
+  std::vector<ui32> songs;   // song positions
+  std::vector<ui32> rank;    // per song position, its index in songs
+
+  std::vector<ui32> artistAlbum; // per artist group, into albums
+  std::vector<ui32> artistSong;  // per artist group, into songs
+  std::vector<ui32> albumDisc;   // per album group, into discs
+  std::vector<ui32> albumSong;   // per album group, into songs
+  std::vector<ui32> discSong;    // per disc group, into songs
+
+  std::vector<ui32> genreSongs; // SongColumns::genreSongs, every posting list in plan order
+
+  [[nodiscard]] auto albumsOf(const SongColumns& c, ui32 artist) const -> std::span<const ui32>;
+  [[nodiscard]] auto discsOf(const SongColumns& c, ui32 album) const -> std::span<const ui32>;
+  [[nodiscard]] auto songsOfArtist(const SongColumns& c, ui32 artist) const
+    -> std::span<const ui32>;
+  [[nodiscard]] auto songsOfAlbum(const SongColumns& c, ui32 album) const
+    -> std::span<const ui32>;
+  [[nodiscard]] auto songsOfDisc(const SongColumns& c, ui32 disc) const -> std::span<const ui32>;
+  [[nodiscard]] auto postings(const SongColumns& c, ui32 genre) const -> std::span<const ui32>;
+};
+
+struct SongColumns
+{
+  struct ArtistGroup
+  {
+    Artist          name;
+    const AlbumMap* albums; // null in columns of a cache, see albumMap()
+    ui32            firstAlbum;
+    ui32            albumCount;
+    ui32            firstSong;
+    ui32            songCount;
+    ui32            firstGenre; // into artistGenres
+    ui32            genreCount;
+  };
+
+  struct AlbumGroup
+  {
+    Album          name;
+    ui32           artist; // index into artists
+    const DiscMap* discs;  // null in columns of a cache, see discMap()
+    ui32           firstDisc;
+    ui32           discCount;
+    ui32           firstSong;
+    ui32           songCount;
+  };
+
+  struct DiscGroup
+  {
+    Disc            disc;
+    ui32            album;  // index into albums
+    const TrackMap* tracks; // null in columns of a cache, see trackMap()
+    ui32            firstSong;
+    ui32            songCount;
+  };
+
+  struct GenreGroup
+  {
+    Genre name;
+    ui32  firstPosting; // into genreSongs
+    ui32  songCount;
+  };
+
+  struct Totals
+  {
+    size_t tracks  = 0;
+    size_t artists = 0; // all non empty names, distinct by construction
+    size_t albums  = 0; // distinct non empty names across artists
+    size_t genres  = 0; // distinct non empty genres
+  };
+
+  // ---- per song ----
+  std::vector<std::string_view>             title;
+  std::vector<Artist>                       artist;
+  std::vector<Album>                        album;
+  std::vector<Genre>                        genre;
+  std::vector<Disc>                         disc;
+  std::vector<Track>                        track;
+  std::vector<Year>                         year;
+  std::vector<float>                        duration;
+  std::vector<int>                          bitrate;
+  std::vector<ino_t>                        inode;
+
+  // ---- groups (in map order) ----
+  std::vector<ArtistGroup> artists;
+  std::vector<AlbumGroup>  albums;
+  std::vector<DiscGroup>   discs;
+
+  // ---- genres (sorted by name) ----
+  std::vector<GenreGroup> genres;
+  std::vector<ui32>       genreSongs;   // posting lists, song positions in map order
+  std::vector<Genre>      artistGenres; // per artist slices, sorted, no empty genre
+
+  Totals totals;
+
+  // ---- plan order, swapped when the plan changes (see setSortPlan()) ----
+  mutable std::atomic<std::shared_ptr<const SortOrder>> sorted;
+
+  // ---- indexes (song positions) ----
+  static constexpr ui32 NONE = UINT32_MAX;
+
+  ankerl::unordered_dense::map<Artist, ui32>           artistIndex;
+  ankerl::unordered_dense::map<ino_t, ui32>            inodeIndex;
+  ankerl::unordered_dense::map<std::uint64_t, ui32>    titleIndex;
+  std::vector<ui32>                                    titleNext; // per song, NONE ends a chain
+  ankerl::unordered_dense::map<std::string_view, ui32> pathIndex;
+
+  [[nodiscard]] auto size() const noexcept -> size_t { return inode.size(); }
+
+  // the song at position i (its InodeMap slot, or made from the cache record on first use)
+  [[nodiscard]] auto songAt(ui32 i) const -> const std::shared_ptr<Song>&
+  {
+    if (const auto* slot = std::atomic_ref(m_song[i]).load(std::memory_order_acquire))
+      return *slot;
+    return makeSong(i);
+  }
+
+  // the map these columns stand for, made on first use for columns of a cache
+  [[nodiscard]] auto songMap() const -> const std::shared_ptr<const SongMap>&;
+
+  // the map tables of a group (through songMap())
+  [[nodiscard]] auto albumMap(const ArtistGroup& artist) const -> const AlbumMap&;
+  [[nodiscard]] auto discMap(const AlbumGroup& album) const -> const DiscMap&;
+  [[nodiscard]] auto trackMap(const DiscGroup& disc) const -> const TrackMap&;
+
+  // the current plan order, take it once per query: a plan change swaps it, the copy stays
+  // valid
+  [[nodiscard]] auto order() const -> std::shared_ptr<const SortOrder>
+  {
+    return sorted.load(std::memory_order_acquire);
+  }
+
+  // exact (interned id) lookups
+  [[nodiscard]] auto findArtist(const Artist& name) const -> const ArtistGroup*;
+  [[nodiscard]] auto findAlbum(const ArtistGroup& artist, const Album& name) const
+    -> const AlbumGroup*;
+
+  // song positions, NONE if there is no such song
+  [[nodiscard]] auto findInode(ino_t id) const -> ui32;
+  [[nodiscard]] auto findPath(std::string_view path) const -> ui32;
+
+  // calls fn(i) for every song whose title equals `title` ignoring case, in map order. fn
+  // returns false to stop early.
+  template <typename Fn>
+  void forEachTitle(std::string_view title, Fn&& fn) const
+  {
+    auto it = titleIndex.find(foldedHash(title));
+    if (it == titleIndex.end())
+      return;
+
+    for (ui32 i = it->second; i != NONE; i = titleNext[i])
+      if (utils::string::isEquals(this->title[i], title) && !fn(i))
+        return;
+  }
+
+  // song positions of one genre, in map order (SortOrder::postings for plan order)
+  [[nodiscard]] auto postings(const GenreGroup& g) const -> std::span<const ui32>
+  {
+    return {genreSongs.data() + g.firstPosting, g.songCount};
+  }
+
+  // the genre groups whose name equals `genre` ignoring case (usually one, "Rock" and
+  // "rock" are two)
+  [[nodiscard]] auto matchGenre(std::string_view genre) const -> std::vector<const GenreGroup*>;
+
+  // calls fn(i) for every song whose genre equals `genre` ignoring case, in plan order
+  template <typename Fn>
+  void forEachSongInGenre(std::string_view genre, Fn&& fn) const
+  {
+    const auto groups = matchGenre(genre);
+    const auto o      = order();
+
+    if (groups.size() == 1)
+    {
+      for (const ui32 i : o->postings(*this, static_cast<ui32>(groups.front() - genres.data())))
+        fn(i);
+      return;
+    }
+
+    std::vector<ui32> merged;
+    for (const auto* g : groups)
+      for (const ui32 i : postings(*g))
+        merged.push_back(o->rank[i]);
+
+    std::ranges::sort(merged);
+    for (const ui32 r : merged)
+      fn(o->songs[r]);
+  }
+
+  // hash of the case folded codepoints, equal for any two strings isEquals() matches
+  [[nodiscard]] static auto foldedHash(std::string_view s) noexcept -> std::uint64_t;
+
+  // columns only, sorted is left empty (columns() sets it)
+  static auto build(std::shared_ptr<const SongMap> map) -> std::shared_ptr<SongColumns>;
+  // the same for the songs of a library cache, without making a Song or a SongMap. Throws
+  // std::runtime_error if its records are not laid out the way LibraryCache::write does.
+  static auto fromCache(std::shared_ptr<const core::LibraryCache> cache)
+    -> std::shared_ptr<SongColumns>;
+
+private:
+  auto makeSong(ui32 i) const -> const std::shared_ptr<Song>&;
+
+  // owns everything the groups, titles and songs point into: the map, or the cache and the
+  // songs made from it
+  mutable std::shared_ptr<const SongMap>    m_map;
+  mutable std::once_flag                    m_mapMade;
+  std::shared_ptr<const core::LibraryCache> m_cache;
+
+  // per song, its InodeMap slot or an entry of m_made (null until made)
+  mutable std::vector<const std::shared_ptr<Song>*> m_song;
+  mutable std::vector<std::shared_ptr<Song>>        m_made;
+  mutable std::array<std::mutex, 16>                m_makeMtx; // by position
+};
+
+inline auto SortOrder::albumsOf(const SongColumns& c, ui32 artist) const
+  -> std::span<const ui32>
+{
+  return {albums.data() + artistAlbum[artist], c.artists[artist].albumCount};
+}
+
+inline auto SortOrder::discsOf(const SongColumns& c, ui32 album) const -> std::span<const ui32>
+{
+  return {discs.data() + albumDisc[album], c.albums[album].discCount};
+}
+
+inline auto SortOrder::songsOfArtist(const SongColumns& c, ui32 artist) const
+  -> std::span<const ui32>
+{
+  return {songs.data() + artistSong[artist], c.artists[artist].songCount};
+}
+
+inline auto SortOrder::songsOfAlbum(const SongColumns& c, ui32 album) const
+  -> std::span<const ui32>
+{
+  return {songs.data() + albumSong[album], c.albums[album].songCount};
+}
+
+inline auto SortOrder::songsOfDisc(const SongColumns& c, ui32 disc) const
+  -> std::span<const ui32>
+{
+  return {songs.data() + discSong[disc], c.discs[disc].songCount};
+}
+
+inline auto SortOrder::postings(const SongColumns& c, ui32 genre) const -> std::span<const ui32>
+{
+  return {genreSongs.data() + c.genres[genre].firstPosting, c.genres[genre].songCount};
+}
+
+// Columns of the map safeMap currently publishes. Built on the first call after each
+// publish and shared by every reader of that version, the previous version is released
+// on the rebuild. Only the readers of the new version wait for that build (it runs under
+// a once flag of its own, not a lock shared with other readers). Once installed, a read
+// is an epoch guarded pointer load plus the refcount of the returned columns.
+INLIMBO_API_CPP auto columns(const TS_SongMap& safeMap) -> std::shared_ptr<const SongColumns>;
+
+// Sort plan the columns of safeMap are ordered by (RuntimeSortPlan{} until set). Recomputes
+// the order of the current columns right away, later builds use the plan too. Columns of a
+// map that was replaced since are left alone, the next columns() builds them ordered by the
+// plan. Returns false if it orders the same as the plan in use.
+INLIMBO_API_CPP auto setSortPlan(const TS_SongMap& safeMap, const sort::RuntimeSortPlan& plan)
+  -> bool;
+
+// setSortPlan() without running the plan: the columns of the map safeMap publishes now take
+// `order` (an order saved with that map, see core::LibraryCache) as their plan order. Returns
+// false, and changes nothing, if order was not built with this plan. An order whose sizes or
+// indexes do not fit the columns is dropped when they are built, and the plan runs.
+INLIMBO_API_CPP auto adoptSortOrder(const TS_SongMap& safeMap, const sort::RuntimeSortPlan& plan,
+                                    std::shared_ptr<const SortOrder> order) -> bool;
+
+// Publishes the songs of a library cache as the map of safeMap, with columns built from the
+// cache records (SongColumns::fromCache()) installed for it and the plan set as by
+// setSortPlan(). The order saved in the cache is taken if it was built with this plan,
+// otherwise the plan runs. The map itself is made when a reader first asks for it. Returns
+// false if the plan had to run. Throws std::runtime_error if the cache records are not
+// laid out the way LibraryCache::write() lays them out.
+INLIMBO_API_CPP auto adoptLibraryCache(TS_SongMap& safeMap,
+                                       std::shared_ptr<const core::LibraryCache> cache,
+                                       const sort::RuntimeSortPlan& plan) -> bool;
+
+} // namespace query::songmap
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "Config.hpp"
+#include "query/Visit.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace query::songmap
+{
+
+// ============================================================
+// Cursor (paginated rows of an artist's album view)
+// ============================================================
+//
+// List views only need what is on screen, not a copy of every song of an artist. A Cursor
+// holds one snapshot (the columns of a published map and their plan order, see
+// query/Columns.hpp) and walks the rows of one artist (or one album of it) in plan order:
+//
+//   Album "A"          <- Row::Kind::Album, index into SongColumns::albums
+//     Disc 1           <- Row::Kind::Disc,  index into SongColumns::discs
+//       01 ...         <- Row::Kind::Song,  index into the song columns
+//       02 ...
+//     Disc 2
+//       ...
+//   Album "B"
+//
+//   query::songmap::Cursor cur(g_songMap);
+//   cur.seek(artist, {}, firstVisibleRow);
+//   cur.next(visibleRows + margin, rows);   // rows is reused from frame to frame
+//
+// seek() is O(albums + discs of the artist), next(n) is O(n): the cost of a frame does not
+// depend on how many songs the artist has.
+//
+// The cursor is tied to the generation (TS_SongMap::version()) it was opened on. stale()
+// tells when a newer map was published (a new sort plan publishes one too), refresh() moves
+// to it and seeks to the same artist / album / offset again (clamped when the range shrank).
+
+struct Row
+{
+  enum class Kind : std::uint8_t
+  {
+    Album,
+    Disc,
+    Song
+  };
+
+  Kind kind;
+  ui32 index;
+};
+
+class INLIMBO_API_CPP Cursor
+{
+public:
+  Cursor() = default;
+  explicit Cursor(const TS_SongMap& safeMap);
+
+  // ---- snapshot ----
+
+  [[nodiscard]] auto generation() const noexcept -> std::uint64_t { return m_generation; }
+  [[nodiscard]] auto stale(const TS_SongMap& safeMap) const noexcept -> bool
+  {
+    return !m_snap || safeMap.version() != m_generation;
+  }
+
+  // reopens on the current map if stale, returns true if it did
+  auto refresh(const TS_SongMap& safeMap) -> bool;
+
+  // the columns rows index into and the order they come in, valid while the cursor is open
+  // on them
+  [[nodiscard]] auto columns() const noexcept -> const SongColumns& { return *m_snap; }
+  [[nodiscard]] auto order() const noexcept -> const SortOrder& { return *m_order; }
+
+  // ---- position ----
+
+  // Rows of `artist` (every album) or of one album of it, starting `offset` rows in. Names
+  // are exact (interned ids). Returns false and leaves an empty range if there is no such
+  // artist / album.
+  auto seek(const Artist& artist, const Album& album = {}, size_t offset = 0) -> bool;
+
+  // up to n rows from the current position into `out` (cleared first), advances past them.
+  // Returns the number of rows written.
+  auto next(size_t n, std::vector<Row>& out) -> size_t;
+
+  [[nodiscard]] auto size() const noexcept -> size_t { return m_rows; }
+  [[nodiscard]] auto offset() const noexcept -> size_t { return m_offset; }
+  [[nodiscard]] auto remaining() const noexcept -> size_t { return m_rows - m_offset; }
+
+  // album / disc group sizes in rows
+  [[nodiscard]] static auto rows(const SongColumns::AlbumGroup& album) noexcept -> size_t
+  {
+    return 1 + album.discCount + album.songCount;
+  }
+  [[nodiscard]] static auto rows(const SongColumns::DiscGroup& disc) noexcept -> size_t
+  {
+    return 1 + disc.songCount;
+  }
+
+private:
+  // before m_snap, read first (see the constructor)
+  std::uint64_t                    m_generation = 0;
+  read::Snapshot                   m_snap;
+  std::shared_ptr<const SortOrder> m_order; // the one of m_snap when it was taken
+
+  Artist m_artist;
+  Album  m_album;
+
+  std::span<const ui32> m_albums; // the album groups in range, into m_order
+
+  size_t m_rows       = 0;
+  size_t m_offset     = 0;
+};
+
+} // namespace query::songmap
@@ -1,10 +1,12 @@
 #pragma once
 
 #include "Config.hpp"
+#include "query/Visit.hpp"
 #include "query/sort/Engine.hpp"
 #include "taglib/Parser.hpp"
 
 #include <functional>
+#include <string_view>
 
 namespace query::songmap
 {
@@ -16,6 +18,9 @@ namespace read
 // Primitive iterations
 // ==--------------------==
 
+// These take a std::function and stay exported for plugins. A lambda picks the templated
+// overload of the same name instead (query/Visit.hpp), which inlines the callback.
+
 // Iterate all artists
 INLIMBO_API_CPP void forEachArtist(const TS_SongMap& safeMap,
                                    const std::function<void(const Artist&, const AlbumMap&)>& fn);
@@ -81,7 +86,11 @@ INLIMBO_API_CPP auto findAllSongsByTitleFuzzy(const TS_SongMap& safeMap, const T
 INLIMBO_API_CPP auto findSongPathByInode(const TS_SongMap& safeMap, const ino_t givenInode)
   -> PathStr;
 
-// Exact title lookup
+// Find song by its file path
+INLIMBO_API_CPP auto findSongObjByPath(const TS_SongMap& safeMap, std::string_view path)
+  -> std::shared_ptr<Song>;
+
+// Exact title lookup (ignoring case)
 INLIMBO_API_CPP auto findSongObjByTitle(const TS_SongMap& safeMap, const Title& songTitle)
   -> std::shared_ptr<Song>;
 
@@ -151,7 +160,9 @@ INLIMBO_API_CPP auto countGenres(const TS_SongMap& safeMap) -> size_t;
 namespace mut
 {
 
-// Sort entire SongMap using runtime plan
+// Orders every reader of safeMap by the runtime plan. The map is left as it is, only the
+// order of its columns is recomputed (see query/sort/Order.hpp); a new version is published
+// if the plan changed.
 INLIMBO_API_CPP void sortSongMap(TS_SongMap&                         safeMap,
                                  const query::sort::RuntimeSortPlan& rtSortPlan);
 
@@ -161,6 +172,25 @@ INLIMBO_API_CPP auto replaceSongObjAndUpdateMetadata(TS_SongMap&
                                                      const std::shared_ptr<Song>& newSong,
                                                      taglib::Parser&              parser) -> bool;
 
+// A batch of on disk changes (see core::LibraryWatcher)
+struct LibraryDelta
+{
+  std::vector<std::string>           removedFiles; // deleted or moved away
+  std::vector<std::string>           removedDirs;  // every song below these is dropped
+  std::vector<std::shared_ptr<Song>> upserts;      // freshly parsed, replace any song at that path
+
+  [[nodiscard]] auto empty() const noexcept -> bool
+  {
+    return removedFiles.empty() && removedDirs.empty() && upserts.empty();
+  }
+};
+
+// Applies the whole delta in ONE SafeMap update, so readers never see a half applied batch,
+// and orders them by the runtime plan. Returns the number of songs dropped (including the old
+// versions of upserted files).
+INLIMBO_API_CPP auto applyLibraryDelta(TS_SongMap& safeMap, const LibraryDelta& delta,
+                                       const query::sort::RuntimeSortPlan& rtSortPlan) -> size_t;
+
 } // namespace mut
 
 } // namespace query::songmap
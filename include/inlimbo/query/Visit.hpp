@@ -0,0 +1,293 @@
+#pragma once
+
+#include "query/Columns.hpp"
+
+#include <concepts>
+#include <memory>
+#include <ranges>
+#include <span>
+#include <utility>
+
+namespace query::songmap::read
+{
+
+// ============================================================
+// Templated visitors and range views over the song columns
+// ============================================================
+//
+// The forEach* declared in query/SongMap.hpp take a const std::function&, every song they
+// visit is an indirect call the compiler cannot see through. The templates below have the
+// same names and callback signatures, so a call with a lambda resolves to them and the
+// callback is inlined into the loop:
+//
+//   forEachSongInAlbum(g_songMap, artist, album,
+//                      [&](Disc, Track, ino_t, const std::shared_ptr<Song>& s) { ... });
+//
+// Passing an actual std::function (plugins, anything that stores the callback) still picks
+// the exported non-template overload, which stays as the ABI stable entry point and is a
+// thin wrapper around these.
+//
+// For anything that filters, stops early or composes, take a snapshot and use the views:
+//
+//   const auto snap = snapshot(g_songMap);
+//   for (const SongRef s : songsOfArtist(*snap, artist)
+//                            | std::views::filter([](SongRef s) { return s.year() > 2000; }))
+//     ...
+//
+// Everything is visited in the order of the runtime sort plan (see SortOrder in
+// query/Columns.hpp). The views and the SongRefs they yield point into the snapshot, keep
+// it alive while using them; a view keeps the order it was made with.
+
+using Snapshot = std::shared_ptr<const SongColumns>;
+
+// the columns of the map safeMap currently publishes
+inline auto snapshot(const TS_SongMap& safeMap) -> Snapshot { return columns(safeMap); }
+
+// One song of a snapshot (a position into its columns), two words, pass it by value.
+class SongRef
+{
+public:
+  SongRef(const SongColumns& c, ui32 i) noexcept : m_c(&c), m_i(i) {}
+
+  [[nodiscard]] auto index() const noexcept -> ui32 { return m_i; }
+
+  [[nodiscard]] auto title() const noexcept -> std::string_view { return m_c->title[m_i]; }
+  [[nodiscard]] auto artist() const noexcept -> const Artist& { return m_c->artist[m_i]; }
+  [[nodiscard]] auto album() const noexcept -> const Album& { return m_c->album[m_i]; }
+  [[nodiscard]] auto genre() const noexcept -> const Genre& { return m_c->genre[m_i]; }
+  [[nodiscard]] auto disc() const noexcept -> Disc { return m_c->disc[m_i]; }
+  [[nodiscard]] auto track() const noexcept -> Track { return m_c->track[m_i]; }
+  [[nodiscard]] auto year() const noexcept -> Year { return m_c->year[m_i]; }
+  [[nodiscard]] auto duration() const noexcept -> float { return m_c->duration[m_i]; }
+  [[nodiscard]] auto bitrate() const noexcept -> int { return m_c->bitrate[m_i]; }
+  [[nodiscard]] auto inode() const noexcept -> ino_t { return m_c->inode[m_i]; }
+  [[nodiscard]] auto song() const noexcept -> const std::shared_ptr<Song>&
+  {
+    return m_c->songAt(m_i);
+  }
+
+private:
+  const SongColumns* m_c;
+  ui32               m_i;
+};
+
+// ==--------------------==
+// Range views
+// ==--------------------==
+
+// songs [first, first + count) of c as SongRefs, in column (map) order
+inline auto songRange(const SongColumns& c, ui32 first, ui32 count)
+{
+  return std::views::iota(first, first + count) |
+         std::views::transform([&c](ui32 i) -> SongRef { return {c, i}; });
+}
+
+// song positions of a slice of `order` as SongRefs, the view holds on to the order
+inline auto orderedSongs(const SongColumns& c, std::shared_ptr<const SortOrder> order,
+                         std::span<const ui32> positions)
+{
+  return positions | std::views::transform([&c, order = std::move(order)](ui32 i) -> SongRef
+                                           { return {c, i}; });
+}
+
+// every song, in plan order
+inline auto songs(const SongColumns& c)
+{
+  auto o = c.order();
+  return orderedSongs(c, o, o->songs);
+}
+
+// songs of one artist / album (exact name), empty if there is none
+inline auto songsOfArtist(const SongColumns& c, const Artist& artist)
+{
+  auto        o = c.order();
+  const auto* a = c.findArtist(artist);
+
+  const auto slice =
+    a ? o->songsOfArtist(c, static_cast<ui32>(a - c.artists.data())) : std::span<const ui32>{};
+  return orderedSongs(c, std::move(o), slice);
+}
+
+inline auto songsOfAlbum(const SongColumns& c, const Artist& artist, const Album& album)
+{
+  auto        o  = c.order();
+  const auto* a  = c.findArtist(artist);
+  const auto* al = a ? c.findAlbum(*a, album) : nullptr;
+
+  const auto slice =
+    al ? o->songsOfAlbum(c, static_cast<ui32>(al - c.albums.data())) : std::span<const ui32>{};
+  return orderedSongs(c, std::move(o), slice);
+}
+
+// songs of one genre group (see SongColumns::matchGenre)
+inline auto songsOfGenre(const SongColumns& c, const SongColumns::GenreGroup& genre)
+{
+  auto       o     = c.order();
+  const auto slice = o->postings(c, static_cast<ui32>(&genre - c.genres.data()));
+  return orderedSongs(c, std::move(o), slice);
+}
+
+// ==--------------------==
+// Templated visitors
+// ==--------------------==
+
+// The visitors handing out map tables make the map of columns built from a library cache
+// (see SongColumns::songMap()). The name only overloads below do not, prefer them when the
+// tables are not needed.
+
+template <typename Fn>
+  requires std::invocable<Fn&, const Artist&, const AlbumMap&>
+void forEachArtist(const TS_SongMap& safeMap, Fn&& fn)
+{
+  const auto c = columns(safeMap);
+
+  for (const ui32 a : c->order()->artists)
+    fn(c->artists[a].name, c->albumMap(c->artists[a]));
+}
+
+template <typename Fn>
+  requires std::invocable<Fn&, const Artist&>
+void forEachArtist(const TS_SongMap& safeMap, Fn&& fn)
+{
+  const auto c = columns(safeMap);
+
+  for (const ui32 a : c->order()->artists)
+    fn(c->artists[a].name);
+}
+
+template <typename Fn>
+  requires std::invocable<Fn&, const Artist&, const Album&, const DiscMap&>
+void forEachAlbum(const TS_SongMap& safeMap, Fn&& fn)
+{
+  const auto c = columns(safeMap);
+
+  for (const ui32 a : c->order()->albums)
+  {
+    const auto& al = c->albums[a];
+    fn(c->artists[al.artist].name, al.name, c->discMap(al));
+  }
+}
+
+template <typename Fn>
+  requires std::invocable<Fn&, const Artist&, const Album&>
+void forEachAlbum(const TS_SongMap& safeMap, Fn&& fn)
+{
+  const auto c = columns(safeMap);
+
+  for (const ui32 a : c->order()->albums)
+  {
+    const auto& al = c->albums[a];
+    fn(c->artists[al.artist].name, al.name);
+  }
+}
+
+template <typename Fn>
+  requires std::invocable<Fn&, const Artist&, const Album&, const Disc, const TrackMap&>
+void forEachDisc(const TS_SongMap& safeMap, Fn&& fn)
+{
+  const auto c = columns(safeMap);
+
+  for (const ui32 di : c->order()->discs)
+  {
+    const auto& d  = c->discs[di];
+    const auto& al = c->albums[d.album];
+    fn(c->artists[al.artist].name, al.name, d.disc, c->trackMap(d));
+  }
+}
+
+template <typename Fn>
+  requires std::invocable<Fn&, const Artist&, const Album&, Disc, Track, ino_t,
+                          const std::shared_ptr<Song>&>
+void forEachSong(const TS_SongMap& safeMap, Fn&& fn)
+{
+  const auto c = columns(safeMap);
+
+  for (const ui32 i : c->order()->songs)
+    fn(c->artist[i], c->album[i], c->disc[i], c->track[i], c->inode[i], c->songAt(i));
+}
+
+template <typename Fn>
+  requires std::invocable<Fn&, const Album&, const Disc, const Track, const ino_t,
+                          const std::shared_ptr<Song>&>
+void forEachSongInArtist(const TS_SongMap& safeMap, const Artist& artistName, Fn&& fn)
+{
+  const auto c = columns(safeMap);
+
+  for (const SongRef s : songsOfArtist(*c, artistName))
+    fn(s.album(), s.disc(), s.track(), s.inode(), s.song());
+}
+
+template <typename Fn>
+  requires std::invocable<Fn&, const Disc, const Track, const ino_t, const std::shared_ptr<Song>&>
+void forEachSongInAlbum(const TS_SongMap& safeMap, const Artist& artistName,
+                        const Album& albumName, Fn&& fn)
+{
+  const auto c = columns(safeMap);
+
+  for (const SongRef s : songsOfAlbum(*c, artistName, albumName))
+    fn(s.disc(), s.track(), s.inode(), s.song());
+}
+
+template <typename Fn>
+  requires std::invocable<Fn&, const Track, const ino_t, const std::shared_ptr<Song>&>
+void forEachSongInDisc(const TS_SongMap& safeMap, const Artist& artistName,
+                       const Album& albumName, Disc discNumber, Fn&& fn)
+{
+  const auto c = columns(safeMap);
+
+  const auto* a = c->findArtist(artistName);
+  if (!a)
+    return;
+
+  const auto* al = c->findAlbum(*a, albumName);
+  if (!al)
+    return;
+
+  const auto o = c->order();
+
+  for (const ui32 d : o->discsOf(*c, static_cast<ui32>(al - c->albums.data())))
+  {
+    if (c->discs[d].disc != discNumber)
+      continue;
+
+    for (const ui32 i : o->songsOfDisc(*c, d))
+      fn(c->track[i], c->inode[i], c->songAt(i));
+    return;
+  }
+}
+
+template <typename Fn>
+  requires std::invocable<Fn&, const Genre&>
+void forEachGenre(const TS_SongMap& safeMap, Fn&& fn)
+{
+  for (const auto& g : columns(safeMap)->genres)
+    fn(g.name);
+}
+
+template <typename Fn>
+  requires std::invocable<Fn&, const Artist&, const Album&, const Disc, const Track,
+                          const ino_t, const std::shared_ptr<Song>&>
+void forEachSongInGenre(const TS_SongMap& safeMap, const Genre& genreName, Fn&& fn)
+{
+  const auto c = columns(safeMap);
+
+  c->forEachSongInGenre(
+    genreName, [&](ui32 i) -> void
+    { fn(c->artist[i], c->album[i], c->disc[i], c->track[i], c->inode[i], c->songAt(i)); });
+}
+
+template <typename Fn>
+  requires std::invocable<Fn&, const Genre&>
+void forEachGenreInArtist(const TS_SongMap& safeMap, const Artist& artistName, Fn&& fn)
+{
+  const auto c = columns(safeMap);
+
+  const auto* a = c->findArtist(artistName);
+  if (!a)
+    return;
+
+  for (size_t g = a->firstGenre; g < a->firstGenre + a->genreCount; ++g)
+    fn(c->artistGenres[g]);
+}
+
+} // namespace query::songmap::read
@@ -1,177 +1,58 @@
 #pragma once
 
-#include "InLimbo-Types.hpp"
-#include "query/sort/Stats.hpp"
 #include "query/sort/metric/Album.hpp"
 #include "query/sort/metric/Artist.hpp"
 #include "query/sort/metric/Base.hpp"
 #include "query/sort/metric/Disc.hpp"
 #include "query/sort/metric/Track.hpp"
 
-#include <algorithm>
-#include <array>
 #include <vector>
 
 namespace query::sort
 {
 
-using SortApplyFn = void (*)(SongMap&);
-
+// What [sort] in config.toml asks for: one metric per level. Artists and albums can list
+// more metrics after the first ("year_asc, lex_asc"), each one orders what the ones
+// before left equal.
 struct RuntimeSortPlan
 {
   metric::ArtistMetric artist = metric::ArtistMetric::LexAsc;
   metric::AlbumMetric  album  = metric::AlbumMetric::LexAsc;
   metric::DiscMetric   disc   = metric::DiscMetric::DiscAsc;
   metric::TrackMetric  track  = metric::TrackMetric::TrackAsc;
-};
-
-template <typename ArtistTag, typename AlbumTag, typename DiscTag, typename TrackTag>
-inline void apply(SongMap& map)
-{
-  auto stats = sort::buildStats(map);
-
-  std::vector<const SongMap::value_type*>  artistBuf;
-  std::vector<const AlbumMap::value_type*> albumBuf;
-  std::vector<const DiscMap::value_type*>  discBuf;
-  std::vector<const TrackMap::value_type*> trackBuf;
-
-  artistBuf.reserve(map.size());
-  for (auto& e : map)
-    artistBuf.push_back(&e);
-
-  std::ranges::sort(artistBuf, [&](auto* A, auto* B) -> bool
-                    { return metric::Comparator<ArtistTag>::cmp(stats, *A, *B); });
-
-  SongMap newMap;
-  newMap.reserve(map.size());
-
-  for (auto* artistPair : artistBuf)
-  {
-    const auto& [artist, albums] = *artistPair;
-
-    albumBuf.clear();
-    albumBuf.reserve(albums.size());
-
-    for (auto& e : albums)
-      albumBuf.push_back(&e);
-
-    std::ranges::sort(albumBuf, [&](auto* A, auto* B) -> bool
-                      { return metric::Comparator<AlbumTag>::cmp(stats, &artist, *A, *B); });
-
-    for (auto* albumPair : albumBuf)
-    {
-      const auto& [album, discs] = *albumPair;
-      auto& newDiscs             = newMap[artist][album];
-
-      discBuf.clear();
-      discBuf.reserve(discs.size());
-
-      for (auto& e : discs)
-        discBuf.push_back(&e);
-
-      std::ranges::sort(discBuf, [&](auto* A, auto* B) -> bool
-                        { return metric::Comparator<DiscTag>::cmp(*A, *B); });
 
-      for (auto* discPair : discBuf)
-      {
-        const auto& [disc, tracks] = *discPair;
-        auto& newTracks            = newDiscs[disc];
+  std::vector<metric::ArtistMetric> artistThen;
+  std::vector<metric::AlbumMetric>  albumThen;
 
-        trackBuf.clear();
-        trackBuf.reserve(tracks.size());
-
-        for (auto& e : tracks)
-          trackBuf.push_back(&e);
-
-        std::ranges::sort(trackBuf, [&](auto* A, auto* B) -> bool
-                          { return metric::Comparator<TrackTag>::cmp(*A, *B); });
-
-        for (auto* trackPair : trackBuf)
-        {
-          const auto& [track, inodeMap] = *trackPair;
-          newTracks[track]              = inodeMap;
-        }
-      }
-    }
-  }
-
-  map = std::move(newMap);
-}
-
-template <metric::ArtistMetric M>
-struct ArtistTagFromEnum;
-template <metric::AlbumMetric M>
-struct AlbumTagFromEnum;
-template <metric::DiscMetric M>
-struct DiscTagFromEnum;
-template <metric::TrackMetric M>
-struct TrackTagFromEnum;
-
-#define X(name, str, tag)                              \
-  template <>                                          \
-  struct ArtistTagFromEnum<metric::ArtistMetric::name> \
-  {                                                    \
-    using type = metric::tag;                          \
-  };
-#include "defs/config/ArtistMetrics.def"
-#undef X
-
-#define X(name, str, tag)                            \
-  template <>                                        \
-  struct AlbumTagFromEnum<metric::AlbumMetric::name> \
-  {                                                  \
-    using type = metric::tag;                        \
-  };
-#include "defs/config/AlbumMetrics.def"
-#undef X
-
-#define X(name, str, tag)                          \
-  template <>                                      \
-  struct DiscTagFromEnum<metric::DiscMetric::name> \
-  {                                                \
-    using type = metric::tag;                      \
-  };
-#include "defs/config/DiscMetrics.def"
-#undef X
-
-#define X(name, str, tag)                            \
-  template <>                                        \
-  struct TrackTagFromEnum<metric::TrackMetric::name> \
-  {                                                  \
-    using type = metric::tag;                        \
-  };
-#include "defs/config/TrackMetrics.def"
-#undef X
-
-constexpr size_t ArtistCount = (size_t)metric::ArtistMetric::COUNT;
-constexpr size_t AlbumCount  = (size_t)metric::AlbumMetric::COUNT;
-constexpr size_t DiscCount   = (size_t)metric::DiscMetric::COUNT;
-constexpr size_t TrackCount  = (size_t)metric::TrackMetric::COUNT;
-
-constexpr size_t TOTAL = ArtistCount * AlbumCount * DiscCount * TrackCount;
+  auto operator==(const RuntimeSortPlan&) const -> bool = default;
+};
 
-template <size_t Index>
-constexpr auto buildOne() -> SortApplyFn
+// ============================================================
+// Sort program (a compiled RuntimeSortPlan)
+// ============================================================
+//
+// The key steps of every level, first key first: which projection of the group tables /
+// song columns to read (metric::Key) and in which direction. buildOrder() in
+// query/sort/Order.hpp runs any program with the same code, so a new metric is a line in
+// its .def file and a projection, not another instantiation per combination of levels.
+//
+// Steps repeating a key already in their level are dropped, whatever their direction: two
+// groups equal on a key stay equal on it.
+
+struct SortProgram
 {
-  constexpr size_t A = Index / (AlbumCount * DiscCount * TrackCount);
-  constexpr size_t B = (Index / (DiscCount * TrackCount)) % AlbumCount;
-  constexpr size_t C = (Index / TrackCount) % DiscCount;
-  constexpr size_t D = Index % TrackCount;
+  std::vector<metric::Step> artist;
+  std::vector<metric::Step> album;
+  std::vector<metric::Step> disc;
+  std::vector<metric::Step> track;
 
-  using AT = typename ArtistTagFromEnum<static_cast<metric::ArtistMetric>(A)>::type;
-  using BT = typename AlbumTagFromEnum<static_cast<metric::AlbumMetric>(B)>::type;
-  using CT = typename DiscTagFromEnum<static_cast<metric::DiscMetric>(C)>::type;
-  using DT = typename TrackTagFromEnum<static_cast<metric::TrackMetric>(D)>::type;
-
-  return +[](SongMap& map) { apply<AT, BT, CT, DT>(map); };
-}
+  auto operator==(const SortProgram&) const -> bool = default;
+};
 
-template <size_t... I>
-constexpr auto buildDispatch(std::index_sequence<I...>)
-{
-  return std::array<SortApplyFn, TOTAL>{buildOne<I>()...};
-}
+auto compile(const RuntimeSortPlan& plan) -> SortProgram;
 
-void applyRuntimeSortPlan(SongMap& map, const RuntimeSortPlan& plan);
+// Stable across runs and builds (it only hashes the steps), never 0. An order saved with
+// one program is valid for another exactly when their hashes match (see core::LibraryCache).
+auto hash(const SortProgram& program) noexcept -> ui64;
 
 } // namespace query::sort
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "query/Columns.hpp"
+#include "query/sort/Engine.hpp"
+
+namespace query::sort
+{
+
+// ============================================================
+// Plan order from packed sort keys
+// ============================================================
+//
+// buildOrder() leaves the map alone and orders the groups of its columns (see
+// query/Columns.hpp) by a compiled plan (SortProgram, see query/sort/Engine.hpp):
+//
+// -> every step of a level projects one integer key per group, once: album / track counts
+//    and years straight from the group tables, names as a rank (the case folded order of
+//    utils::string::icompare, from an 8 byte folded prefix and a full compare only where
+//    two prefixes are equal). Descending steps use the complemented key.
+// -> a level with more than one step ranks its groups by the keys in step order, so every
+//    level ends up with a single key per group again.
+// -> (key << 32 | index) words are sorted level by level, parent by parent, so equal keys
+//    keep the map order and the result is the same on every run.
+//
+// Disc and track keys are read from the columns as the words are packed, nothing is
+// projected for them.
+//
+// Once the artists are sorted, their order fixes where the albums, discs and songs of each
+// one go. Every artist's subtree is then sorted on its own into its own slices, so large
+// libraries spread artists (and the year projection, rank and genre lists) over a
+// utils::threads::WorkStealingPool. No slot depends on which thread wrote it: the order is
+// the same for any thread count.
+//
+// The output is a SortOrder: a handful of index arrays, nothing points into it and nothing
+// it points to is copied.
+
+// threads: 0 picks one per core for large libraries and the calling thread otherwise,
+// 1 never uses a pool. The pool of each thread count is started once and reused by every
+// later call.
+auto buildOrder(const songmap::SongColumns& c, const SortProgram& program, size_t threads = 0)
+  -> songmap::SortOrder;
+
+} // namespace query::sort
@@ -1,12 +1,35 @@
 #pragma once
 
+#include "InLimbo-Types.hpp"
+
 namespace query::sort::metric
 {
 
-template <typename T>
-struct Comparator
+// What a metric sorts its level by. Every metric in defs/config/*Metrics.def is one of
+// these, read off the group tables or the song columns (see query/sort/Order.hpp).
+enum class Key : ui8
+{
+  Name,       // artist / album name, case folded (utils::string::icompare order)
+  AlbumCount, // albums of an artist
+  TrackCount, // songs of an artist / album
+  Year,       // year of an album (of its lowest numbered track that has one)
+  Disc,       // disc number
+  Track,      // track number
+};
+
+enum class Direction : ui8
+{
+  Asc,
+  Desc,
+};
+
+// one sort key of a level and its direction
+struct Step
 {
-  static_assert(sizeof(T) == 0, "Comparator specialization missing for metric");
+  Key       key;
+  Direction dir;
+
+  auto operator==(const Step&) const -> bool = default;
 };
 
 } // namespace query::sort::metric
@@ -7,30 +7,28 @@ namespace query::sort::metric
 
 enum class DiscMetric
 {
-#define X(name, str, tag) name,
+#define X(name, str, key, dir) name,
 #include "defs/config/DiscMetrics.def"
 #undef X
 
   COUNT
 };
 
-struct DiscNumberAsc
+constexpr auto step(DiscMetric m) -> Step
 {
-};
-struct DiscNumberDesc
-{
-};
+  switch (m)
+  {
+#define X(name, str, key, dir) \
+  case DiscMetric::name:       \
+    return {Key::key, Direction::dir};
+#include "defs/config/DiscMetrics.def"
+#undef X
 
-template <>
-struct Comparator<DiscNumberAsc>
-{
-  static auto cmp(auto& A, auto& B) -> bool { return A.first < B.first; }
-};
+    case DiscMetric::COUNT:
+      break;
+  }
 
-template <>
-struct Comparator<DiscNumberDesc>
-{
-  static auto cmp(auto& A, auto& B) -> bool { return A.first > B.first; }
-};
+  return {Key::Name, Direction::Asc};
+}
 
 } // namespace query::sort::metric
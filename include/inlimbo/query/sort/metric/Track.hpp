@@ -7,30 +7,28 @@ namespace query::sort::metric
 
 enum class TrackMetric
 {
-#define X(name, str, tag) name,
+#define X(name, str, key, dir) name,
 #include "defs/config/TrackMetrics.def"
 #undef X
 
   COUNT
 };
 
-struct TrackNumberAsc
+constexpr auto step(TrackMetric m) -> Step
 {
-};
-struct TrackNumberDesc
-{
-};
+  switch (m)
+  {
+#define X(name, str, key, dir) \
+  case TrackMetric::name:       \
+    return {Key::key, Direction::dir};
+#include "defs/config/TrackMetrics.def"
+#undef X
 
-template <>
-struct Comparator<TrackNumberAsc>
-{
-  static auto cmp(auto& A, auto& B) -> bool { return A.first < B.first; }
-};
+    case TrackMetric::COUNT:
+      break;
+  }
 
-template <>
-struct Comparator<TrackNumberDesc>
-{
-  static auto cmp(auto& A, auto& B) -> bool { return A.first > B.first; }
-};
+  return {Key::Name, Direction::Asc};
+}
 
 } // namespace query::sort::metric
@@ -14,11 +14,29 @@ namespace taglib
 struct TagLibConfig
 {
   bool debugLog = false;
+  // try the pread based readers in taglib/fast before TagLib (see fast/Reader.hpp)
+  bool fastPath = true;
+};
+
+// The head of a file a batched scan (helpers::fs, io_uring backend) already opened and read.
+// fd stays owned by the scanner, readers just use it instead of opening the path again.
+struct PrefetchedHead
+{
+  int                  fd   = -1;
+  i64                  size = 0;
+  const unsigned char* data = nullptr;
+  size_t               len  = 0;
 };
 
 struct ParseSession
 {
   int unknownArtistTracks = 0;
+  // only set for the duration of one Parser::parseFile call
+  const PrefetchedHead* prefetched = nullptr;
+
+  // running totals over every parse of this session (the library scan report sums them up)
+  ui64   bytesRead    = 0; // by the native readers, TagLib's own reads are not counted
+  size_t taglibParses = 0; // files the native readers left to TagLib
 };
 
 // a generic parent interface class
@@ -23,10 +23,15 @@ public:
   explicit Parser(TagLibConfig config);
 
   auto parseFile(const Path& filePath, Metadata& metadata) -> bool;
+  // same, but the fast readers start from bytes the scanner already read (see PrefetchedHead)
+  auto parseFile(const Path& filePath, Metadata& metadata, const PrefetchedHead& head) -> bool;
   auto modifyMetadata(const Path& filePath, const Metadata& newData) -> bool;
 
   static auto fillArtUrl(Metadata& meta) -> bool;
 
+  // counters accumulated over every parse so far (bytes read, TagLib fallbacks)
+  [[nodiscard]] auto session() const noexcept -> const ParseSession& { return m_parseSession; }
+
 private:
   TagLibConfig m_config;
   ParseSession m_parseSession;
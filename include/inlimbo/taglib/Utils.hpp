@@ -1,15 +1,37 @@
 #pragma once
 
 #include "InLimbo-Types.hpp"
+#include <filesystem>
+#include <taglib/audioproperties.h>
 #include <taglib/fileref.h>
+#include <taglib/tbytevector.h>
 #include <taglib/tpropertymap.h>
 
 namespace taglib::utils
 {
 
+// NOTE:
+//
+// The extract* helpers take what the caller has already read from an open file
+// (PropertyMap, AudioProperties) instead of the file itself. A source's parse()
+// opens the file ONCE, builds the PropertyMap ONCE and hands it to every helper.
+
 auto parseFractionField(const TagLib::String& text) -> std::pair<int, int>;
-void extractTrackAndTotal(TagLib::FileRef& file, Metadata& metadata);
-void extractDiscAndTotal(TagLib::FileRef& file, Metadata& metadata);
-void extractAudioProperties(TagLib::FileRef& file, Metadata& metadata);
+void extractTrackAndTotal(const TagLib::PropertyMap& props, Metadata& metadata);
+void extractDiscAndTotal(const TagLib::PropertyMap& props, Metadata& metadata);
+void extractAudioProperties(const TagLib::AudioProperties* audioProps, Metadata& metadata);
+
+// Album art lives in core::ArtPack (one content addressed file), the artUrl detail is set to
+// its inlimbo-art:// uri.
+
+// points the artUrl detail to the art stored for metadata.filePath by an earlier scan, as long
+// as the embedded picture still has pictureSize bytes (so it does not have to be read again)
+auto useCachedArt(Metadata& metadata, ui64 pictureSize) -> bool;
+
+// stores the picture (deduplicated against every other song's) and points the artUrl detail to it
+auto writeArt(std::string_view picture, Metadata& metadata) -> bool;
+
+// same, for a picture TagLib already has in memory
+auto storeArt(const TagLib::ByteVector& picture, Metadata& metadata) -> bool;
 
 } // namespace taglib::utils
@@ -0,0 +1,126 @@
+#pragma once
+
+#include "InLimbo-Types.hpp"
+#include "taglib/ITag.hpp"
+#include <array>
+#include <string_view>
+
+namespace taglib::fast
+{
+
+// ============================================================
+// FileWindow
+// ============================================================
+//
+// A tiny pread(2) based view over the head of a file.
+//
+// view(off, len) hands out a pointer to [off, off + len) from an internal
+// buffer and only goes to the file when the range is not buffered yet. Misses
+// read READ_AHEAD bytes at most (or len if bigger), so a file whose tags fit
+// in the first few KB costs exactly one read.
+//
+// Kernel readahead is turned off for the fd (POSIX_FADV_RANDOM), on network
+// storage that readahead is what makes a tag scan pull whole files.
+//
+// If the session carries a PrefetchedHead, the window starts out filled with it and
+// borrows the scanner's fd, so a tag that fits in the prefetched head costs no syscall
+// at all. Whatever the window read (prefetched head included) is added to the session's
+// bytesRead when it goes away.
+
+class FileWindow
+{
+public:
+  static constexpr size_t CAPACITY   = 64 * 1024;
+  static constexpr size_t READ_AHEAD = 16 * 1024;
+
+  explicit FileWindow(const char* path, ParseSession* session = nullptr);
+  ~FileWindow();
+
+  FileWindow(const FileWindow&)                    = delete;
+  auto operator=(const FileWindow&) -> FileWindow& = delete;
+
+  [[nodiscard]] auto ok() const noexcept -> bool { return m_fd >= 0; }
+  [[nodiscard]] auto size() const noexcept -> i64 { return m_size; }
+
+  // nullptr if the range is past EOF, larger than CAPACITY or the read failed
+  auto view(i64 off, size_t len) -> const unsigned char*;
+
+  // reads straight into out (used for pictures, which never go through the window)
+  auto readInto(i64 off, char* out, size_t len) -> bool;
+
+private:
+  int           m_fd      = -1;
+  bool          m_owned   = true; // false when borrowed from a PrefetchedHead
+  i64           m_size    = 0;
+  i64           m_bufOff  = 0;
+  size_t        m_bufLen  = 0;
+  ui64          m_read    = 0;
+  ParseSession* m_session = nullptr;
+
+  std::array<unsigned char, CAPACITY> m_buf;
+};
+
+// ============================================================
+// Text helpers
+// ============================================================
+
+// ID3v2 text encodings (FLAC Vorbis comments are always UTF8)
+enum class Encoding : uint8_t
+{
+  Latin1  = 0,
+  UTF16   = 1, // with BOM
+  UTF16BE = 2,
+  UTF8    = 3
+};
+
+// appends p[0, n) decoded as enc to out (as UTF8). NUL separated values (ID3v2.4 multi
+// value frames) are joined with ' ' like TagLib's StringList::toString does.
+void appendDecoded(Encoding enc, const unsigned char* p, size_t n, std::string& out);
+
+// length of the first NUL terminated string in p[0, n) for enc, *excluding* the terminator.
+// Returns n when there is no terminator.
+auto terminatedLength(Encoding enc, const unsigned char* p, size_t n) -> size_t;
+
+// key -> value, multiple values for the same key are joined with ' '
+void addProperty(Properties& props, std::string_view key, std::string value);
+
+// ============================================================
+// Metadata fill
+// ============================================================
+//
+// Mirrors CommonTag::fillBasic/fillTrackDisc/fillProperties, but on the property map
+// the fast readers produce (TagLib's property keys: TITLE, ARTIST, TRACKNUMBER, ...).
+//
+// comment is passed separately as ID3v2 and Vorbis pick it differently.
+
+void fillMetadata(const Path& filePath, const Properties& props, std::string_view comment,
+                  Metadata& metadata, ParseSession& parseSession);
+
+// big endian / syncsafe readers
+[[nodiscard]] constexpr auto be16(const unsigned char* p) noexcept -> ui32
+{
+  return (ui32(p[0]) << 8) | ui32(p[1]);
+}
+
+[[nodiscard]] constexpr auto be24(const unsigned char* p) noexcept -> ui32
+{
+  return (ui32(p[0]) << 16) | (ui32(p[1]) << 8) | ui32(p[2]);
+}
+
+[[nodiscard]] constexpr auto be32(const unsigned char* p) noexcept -> ui32
+{
+  return (ui32(p[0]) << 24) | (ui32(p[1]) << 16) | (ui32(p[2]) << 8) | ui32(p[3]);
+}
+
+[[nodiscard]] constexpr auto le32(const unsigned char* p) noexcept -> ui32
+{
+  return (ui32(p[3]) << 24) | (ui32(p[2]) << 16) | (ui32(p[1]) << 8) | ui32(p[0]);
+}
+
+[[nodiscard]] constexpr auto syncsafe32(const unsigned char* p) noexcept -> ui32
+{
+  return (ui32(p[0] & 0x7F) << 21) | (ui32(p[1] & 0x7F) << 14) | (ui32(p[2] & 0x7F) << 7) |
+         ui32(p[3] & 0x7F);
+}
+
+} // namespace taglib::fast
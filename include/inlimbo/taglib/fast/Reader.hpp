@@ -0,0 +1,23 @@
+#pragma once
+
+#include "InLimbo-Types.hpp"
+#include "taglib/ITag.hpp"
+
+namespace taglib::fast
+{
+
+// Minimal tag readers for the library scan, used by source::MP3 / source::FLAC before
+// falling back to TagLib.
+//
+// They pread only the tag region (the ID3v2 tag plus the first MPEG frame, or the FLAC
+// metadata blocks) and fill the same Metadata the TagLib path would: basic tags,
+// track/disc, album artist, lyrics, properties, duration/bitrate and the cover art.
+//
+// Anything they do not handle (ID3v2.2, unsynchronisation, compressed/encrypted frames,
+// numeric ID3v1 genres, no ID3v2 tag at all, oversized blocks, ...) makes them return
+// false WITHOUT touching metadata, the caller then takes the TagLib path.
+
+auto readMP3(const Path& filePath, Metadata& metadata, ParseSession& parseSession) -> bool;
+auto readFLAC(const Path& filePath, Metadata& metadata, ParseSession& parseSession) -> bool;
+
+} // namespace taglib::fast
@@ -26,24 +26,23 @@ struct CommonTag
     metadata.genre =
       tag->genre().isEmpty() ? INLIMBO_GENRE_NAME_FALLBACK : tag->genre().to8Bit(true);
 
-    metadata.comment =
+    metadata.details.edit().comment =
       tag->comment().isEmpty() ? INLIMBO_COMMENT_FALLBACK : tag->comment().to8Bit(true);
 
     metadata.year  = tag->year();
     metadata.track = tag->track();
   }
 
-  static inline void fillTrackDisc(TagLib::FileRef& file, Metadata& metadata)
+  static inline void fillTrackDisc(const TagLib::PropertyMap& props, Metadata& metadata)
   {
-    utils::extractDiscAndTotal(file, metadata);
-    utils::extractTrackAndTotal(file, metadata);
+    utils::extractDiscAndTotal(props, metadata);
+    utils::extractTrackAndTotal(props, metadata);
   }
 
-  static inline void fillProperties(TagLib::FileRef& file, Metadata& metadata,
+  static inline void fillProperties(const TagLib::PropertyMap&     props,
+                                    const TagLib::AudioProperties* audioProps, Metadata& metadata,
                                     int& unknownArtistTracks)
   {
-    TagLib::PropertyMap props = file.file()->properties();
-
     // this is required to sort features in a song properly.
     //
     // if a song is indexed as <Song> feat. <Artist B> but it is in
@@ -64,13 +63,18 @@ struct CommonTag
     if (metadata.track == 0 && metadata.artist == INLIMBO_ARTIST_NAME_FALLBACK)
       metadata.track = ++unknownArtistTracks;
 
+    auto& details = metadata.details.edit();
+
     if (hasProp(props, PropKey::Lyrics))
-      metadata.lyrics = getProp(props, PropKey::Lyrics).to8Bit(true);
+      details.lyrics = getProp(props, PropKey::Lyrics).to8Bit(true);
 
+    PropertyBlock::Builder block;
+    block.reserve(props.size());
     for (const auto& [key, val] : props)
-      metadata.additionalProperties[key.to8Bit(true)] = val.toString().to8Bit(true);
+      block.add(key.to8Bit(true), val.toString().to8Bit(true));
+    details.additionalProperties = block.finish();
 
-    utils::extractAudioProperties(file, metadata);
+    utils::extractAudioProperties(audioProps, metadata);
   }
 };
 
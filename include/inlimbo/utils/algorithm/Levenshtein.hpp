@@ -1,10 +1,17 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
 #include <cstdint>
+#include <span>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#if defined(__AVX2__) || defined(__SSE4_1__)
+#include <immintrin.h>
+#endif
+
 /**
  * The Levenshtein distance is a metric for measuring the difference between two strings.
  * It calculates the minimum number of single-character edits (insertions, deletions, or
@@ -20,96 +27,469 @@
  * - **Deletion**: Delete a character from one string.
  * - **Substitution**: Replace a character in one string with another.
  *
- * This implementation uses dynamic programming to compute the Levenshtein distance. A 2D table is
- * constructed, where each entry at [i][j] contains the distance between the first i characters of
- * s1 and the first j characters of s2. The final distance is found at the bottom-right corner of
- * the table. The time complexity of this algorithm is O(m * n), where m and n are the lengths of
- * the two input strings.
+ * This implementation is the bit-parallel algorithm of Myers (1999), in the formulation of
+ * Hyyrö (2003). A column of the dynamic programming table (the distances between every prefix
+ * of the pattern and the text read so far) only ever changes by -1, 0 or +1 from one row to the
+ * next, so it is kept as two bit vectors of those vertical deltas, one bit per pattern byte.
+ * Reading one text byte advances the whole column with a handful of word operations. The time
+ * complexity is O(ceil(m / 64) * n), where m is the length of the pattern and n the one of the
+ * text: a single 64 bit word per text byte for patterns up to 64 bytes.
  */
 
 namespace utils::algorithm
 {
 
-class StringDistance final
+namespace detail
+{
+
+#if defined(__AVX2__)
+
+// 4 texts per step, one 64 bit pattern word each
+struct Lanes
+{
+  static constexpr size_t N = 4;
+  using V                   = __m256i;
+
+  // lane l = word(l), assembled in registers
+  template <typename F>
+  static auto gather(F&& word) noexcept -> V
+  {
+    return _mm256_set_epi64x(static_cast<long long>(word(3)), static_cast<long long>(word(2)),
+                             static_cast<long long>(word(1)), static_cast<long long>(word(0)));
+  }
+  static void store(std::uint64_t* p, V v) noexcept
+  {
+    _mm256_store_si256(reinterpret_cast<V*>(p), v);
+  }
+  static auto set1(std::uint64_t x) noexcept -> V
+  {
+    return _mm256_set1_epi64x(static_cast<long long>(x));
+  }
+
+  static auto bitOr(V a, V b) noexcept -> V { return _mm256_or_si256(a, b); }
+  static auto bitAnd(V a, V b) noexcept -> V { return _mm256_and_si256(a, b); }
+  static auto bitXor(V a, V b) noexcept -> V { return _mm256_xor_si256(a, b); }
+  static auto add(V a, V b) noexcept -> V { return _mm256_add_epi64(a, b); }
+  static auto sub(V a, V b) noexcept -> V { return _mm256_sub_epi64(a, b); }
+  static auto eq(V a, V b) noexcept -> V { return _mm256_cmpeq_epi64(a, b); }
+  static auto shl1(V a) noexcept -> V { return _mm256_slli_epi64(a, 1); }
+};
+
+#elif defined(__SSE4_1__)
+
+// 2 texts per step, one 64 bit pattern word each
+struct Lanes
+{
+  static constexpr size_t N = 2;
+  using V                   = __m128i;
+
+  // lane l = word(l), assembled in registers
+  template <typename F>
+  static auto gather(F&& word) noexcept -> V
+  {
+    return _mm_set_epi64x(static_cast<long long>(word(1)), static_cast<long long>(word(0)));
+  }
+  static void store(std::uint64_t* p, V v) noexcept
+  {
+    _mm_store_si128(reinterpret_cast<V*>(p), v);
+  }
+  static auto set1(std::uint64_t x) noexcept -> V
+  {
+    return _mm_set1_epi64x(static_cast<long long>(x));
+  }
+
+  static auto bitOr(V a, V b) noexcept -> V { return _mm_or_si128(a, b); }
+  static auto bitAnd(V a, V b) noexcept -> V { return _mm_and_si128(a, b); }
+  static auto bitXor(V a, V b) noexcept -> V { return _mm_xor_si128(a, b); }
+  static auto add(V a, V b) noexcept -> V { return _mm_add_epi64(a, b); }
+  static auto sub(V a, V b) noexcept -> V { return _mm_sub_epi64(a, b); }
+  static auto eq(V a, V b) noexcept -> V { return _mm_cmpeq_epi64(a, b); }
+  static auto shl1(V a) noexcept -> V { return _mm_slli_epi64(a, 1); }
+};
+
+#endif
+
+} // namespace detail
+
+// ============================================================
+// LevenshteinPattern (one query, scored against many texts)
+// ============================================================
+//
+// The pattern is preprocessed once into a match mask per byte value (bit i of peq[c] is
+// set when pattern[i] == c), after that scoring a text allocates nothing and reads each of
+// its bytes once. Patterns longer than 64 bytes run the blocked variant, one word per 64
+// pattern bytes.
+//
+// Distances are bounded like the 2-row DP this replaced: anything above maxDistance comes
+// back as maxDistance + 1, a text whose length alone is too far off is never scanned, and a
+// scan stops once the bytes left can no longer bring the score back within maxDistance
+// (the score moves by at most one per byte).
+//
+// distances() scores a batch of texts in SIMD lanes when the pattern fits one word: 4 texts
+// per step with AVX2, 2 with SSE4.1 (whatever the build targets, see -march=native), one at
+// a time otherwise.
+//
+// With foldCase, ASCII letters match case insensitively (the same distances as comparing
+// the tolower_ascii of both strings), without the texts being copied.
+
+class LevenshteinPattern final
 {
 public:
-  StringDistance()  = delete;
-  ~StringDistance() = delete;
+  static constexpr size_t WORD = 64;
 
-  StringDistance(const StringDistance&)                    = delete;
-  auto operator=(const StringDistance&) -> StringDistance& = delete;
+  explicit LevenshteinPattern(std::string_view pattern, bool foldCase = false)
+      : m_size(pattern.size()), m_words(std::max<size_t>((pattern.size() + WORD - 1) / WORD, 1)),
+        m_peq(256 * m_words, 0)
+  {
+    for (size_t i = 0; i < m_size; ++i)
+    {
+      const auto          c   = static_cast<unsigned char>(pattern[i]);
+      const std::uint64_t bit = std::uint64_t{1} << (i % WORD);
 
-  StringDistance(StringDistance&&)                    = delete;
-  auto operator=(StringDistance&&) -> StringDistance& = delete;
+      m_peq[(c * m_words) + (i / WORD)] |= bit;
 
-  static auto levenshteinDistance(const std::string& s1, const std::string& s2,
-                                  size_t maxDistance = SIZE_MAX) -> size_t
+      // 'A'..'Z' and 'a'..'z' only differ in bit 5
+      if (foldCase && ((c | 0x20) >= 'a' && (c | 0x20) <= 'z'))
+        m_peq[((c ^ 0x20) * m_words) + (i / WORD)] |= bit;
+    }
+  }
+
+  [[nodiscard]] auto size() const noexcept -> size_t { return m_size; }
+
+  [[nodiscard]] auto distance(std::string_view text, size_t maxDistance = SIZE_MAX) const
+    -> size_t
+  {
+    size_t d = 0;
+    if (trivial(text, maxDistance, d))
+      return d;
+
+    if (m_words == 1)
+      return scoreWord(text, maxDistance);
+
+    std::vector<std::uint64_t> scratch(2 * m_words);
+    return scoreBlocked(text, maxDistance, scratch);
+  }
+
+  // out[i] = distance(texts[i], maxDistance), out is at least as long as texts
+  void distances(std::span<const std::string_view> texts, size_t maxDistance,
+                 std::span<size_t> out) const
+  {
+    if (m_words > 1)
+    {
+      std::vector<std::uint64_t> scratch(2 * m_words);
+      for (size_t i = 0; i < texts.size(); ++i)
+        if (!trivial(texts[i], maxDistance, out[i]))
+          out[i] = scoreBlocked(texts[i], maxDistance, scratch);
+      return;
+    }
+
+#if defined(__AVX2__) || defined(__SSE4_1__)
+    std::array<size_t, detail::Lanes::N> lanes{};
+    size_t                               used = 0;
+
+    for (size_t i = 0; i < texts.size(); ++i)
+    {
+      if (trivial(texts[i], maxDistance, out[i]))
+        continue;
+
+      lanes[used++] = i;
+      if (used == lanes.size())
+      {
+        scoreLanes(texts, lanes, used, maxDistance, out);
+        used = 0;
+      }
+    }
+
+    if (used != 0)
+      scoreLanes(texts, lanes, used, maxDistance, out);
+#else
+    for (size_t i = 0; i < texts.size(); ++i)
+      if (!trivial(texts[i], maxDistance, out[i]))
+        out[i] = scoreWord(texts[i], maxDistance);
+#endif
+  }
+
+  // fn(i, distance) for every i < count with text(i) within maxDistance, in index order.
+  // Texts are scored in batches through distances().
+  template <typename TextFn, typename Fn>
+  void forEachWithin(size_t count, TextFn&& text, size_t maxDistance, Fn&& fn) const
+  {
+    constexpr size_t BATCH = 256;
+
+    std::array<std::string_view, BATCH> texts;
+    std::array<size_t, BATCH>           d{};
+
+    for (size_t first = 0; first < count; first += BATCH)
+    {
+      const size_t n = std::min(BATCH, count - first);
+
+      for (size_t i = 0; i < n; ++i)
+        texts[i] = text(first + i);
+
+      distances({texts.data(), n}, maxDistance, {d.data(), n});
+
+      for (size_t i = 0; i < n; ++i)
+        if (d[i] <= maxDistance)
+          fn(first + i, d[i]);
+    }
+  }
+
+private:
+  size_t                     m_size;
+  size_t                     m_words;
+  std::vector<std::uint64_t> m_peq; // 256 * m_words, the words of byte c at c * m_words
+
+  static auto bounded(size_t d, size_t maxDistance) noexcept -> size_t
+  {
+    return d <= maxDistance ? d : maxDistance + 1;
+  }
+
+  // the score can no longer end within maxDistance with `left` text bytes to go
+  static auto hopeless(size_t score, size_t left, size_t maxDistance) noexcept -> bool
+  {
+    return score > left && score - left > maxDistance;
+  }
+
+  // the distances known without a scan (band, empty strings), false if text needs one
+  [[nodiscard]] auto trivial(std::string_view text, size_t maxDistance, size_t& d) const noexcept
+    -> bool
+  {
+    const size_t n    = text.size();
+    const size_t diff = n > m_size ? n - m_size : m_size - n;
+
+    if (diff > maxDistance)
+    {
+      d = maxDistance + 1;
+      return true;
+    }
+
+    if (m_size == 0 || n == 0)
+    {
+      d = bounded(m_size + n, maxDistance);
+      return true;
+    }
+
+    return false;
+  }
+
+  // the single word state: vertical +1 / -1 deltas of the column and its last cell
+  struct WordState
+  {
+    std::uint64_t vp    = ~std::uint64_t{0};
+    std::uint64_t vn    = 0;
+    size_t        score = 0;
+  };
+
+  [[nodiscard]] auto scoreWord(std::string_view text, size_t maxDistance) const noexcept
+    -> size_t
+  {
+    return scoreWord(text, 0, {.score = m_size}, maxDistance);
+  }
+
+  // text[from..] on top of the column left by text[0..from)
+  [[nodiscard]] auto scoreWord(std::string_view text, size_t from, WordState s,
+                               size_t maxDistance) const noexcept -> size_t
   {
-    const size_t len1 = s1.size();
-    const size_t len2 = s2.size();
+    const std::uint64_t last = std::uint64_t{1} << (m_size - 1);
+    const size_t        n    = text.size();
 
-    if (maxDistance != SIZE_MAX)
+    for (size_t j = from; j < n; ++j)
     {
-      const size_t diff = (len1 > len2) ? (len1 - len2) : (len2 - len1);
-      if (diff > maxDistance)
+      const std::uint64_t eq = m_peq[static_cast<unsigned char>(text[j])];
+      const std::uint64_t xv = eq | s.vn;
+      const std::uint64_t xh = (((eq & s.vp) + s.vp) ^ s.vp) | eq;
+
+      std::uint64_t hp = s.vn | ~(xh | s.vp);
+      std::uint64_t hn = s.vp & xh;
+
+      s.score += (hp & last) != 0;
+      s.score -= (hn & last) != 0;
+
+      // row 0 of the table is the text position, it grows by one per byte
+      hp = (hp << 1) | 1;
+      hn <<= 1;
+
+      s.vp = hn | ~(xv | hp);
+      s.vn = hp & xv;
+
+      if (hopeless(s.score, n - j - 1, maxDistance))
         return maxDistance + 1;
     }
 
-    if (len1 == 0)
-      return (len2 <= maxDistance) ? len2 : (maxDistance + 1);
-    if (len2 == 0)
-      return (len1 <= maxDistance) ? len1 : (maxDistance + 1);
+    return bounded(s.score, maxDistance);
+  }
+
+  // Myers' advance_block: every word passes its horizontal delta at the top bit (+1, 0, -1)
+  // on to the next one, which also stands in for the carry of the addition across words
+  [[nodiscard]] auto scoreBlocked(std::string_view text, size_t maxDistance,
+                                  std::span<std::uint64_t> scratch) const noexcept -> size_t
+  {
+    const std::uint64_t top  = std::uint64_t{1} << (WORD - 1);
+    const std::uint64_t last = std::uint64_t{1} << ((m_size - 1) % WORD);
+    const size_t        n    = text.size();
+
+    std::uint64_t* vp = scratch.data();
+    std::uint64_t* vn = scratch.data() + m_words;
 
-    // 2-row DP (less memory than 2D table)
-    std::vector<size_t> prev(len2 + 1);
-    std::vector<size_t> cur(len2 + 1);
+    std::fill_n(vp, m_words, ~std::uint64_t{0});
+    std::fill_n(vn, m_words, 0);
 
-    for (size_t j = 0; j <= len2; ++j)
-      prev[j] = j;
+    size_t score = m_size;
 
-    for (size_t i = 1; i <= len1; ++i)
+    for (size_t j = 0; j < n; ++j)
     {
-      cur[0] = i;
+      const std::uint64_t* peq = &m_peq[static_cast<unsigned char>(text[j]) * m_words];
 
-      size_t jStart = 1;
-      size_t jEnd   = len2;
+      int h = 1;
 
-      if (maxDistance != SIZE_MAX)
+      for (size_t b = 0; b < m_words; ++b)
       {
-        jStart = (i > maxDistance) ? (i - maxDistance) : 1;
-        jEnd   = std::min(len2, i + maxDistance);
+        const std::uint64_t high = b + 1 == m_words ? last : top;
 
-        for (size_t j = 1; j < jStart; ++j)
-          cur[j] = maxDistance + 1;
-        for (size_t j = jEnd + 1; j <= len2; ++j)
-          cur[j] = maxDistance + 1;
-      }
+        std::uint64_t       eq = peq[b];
+        const std::uint64_t xv = eq | vn[b];
 
-      size_t rowMin = SIZE_MAX;
+        if (h < 0)
+          eq |= 1;
 
-      for (size_t j = jStart; j <= jEnd; ++j)
-      {
-        const size_t cost = (s1[i - 1] == s2[j - 1]) ? 0 : 1;
+        const std::uint64_t xh = (((eq & vp[b]) + vp[b]) ^ vp[b]) | eq;
+
+        std::uint64_t hp = vn[b] | ~(xh | vp[b]);
+        std::uint64_t hn = vp[b] & xh;
+
+        const int out = (hp & high) != 0 ? 1 : ((hn & high) != 0 ? -1 : 0);
 
-        const size_t del = prev[j] + 1;
-        const size_t ins = cur[j - 1] + 1;
-        const size_t sub = prev[j - 1] + cost;
+        hp <<= 1;
+        hn <<= 1;
 
-        const size_t v = std::min({del, ins, sub});
-        cur[j]         = v;
+        if (h < 0)
+          hn |= 1;
+        else if (h > 0)
+          hp |= 1;
 
-        if (v < rowMin)
-          rowMin = v;
+        vp[b] = hn | ~(xv | hp);
+        vn[b] = hp & xv;
+
+        h = out;
       }
 
-      if (maxDistance != SIZE_MAX && rowMin > maxDistance)
+      score = h > 0 ? score + 1 : (h < 0 ? score - 1 : score);
+
+      if (hopeless(score, n - j - 1, maxDistance))
         return maxDistance + 1;
+    }
+
+    return bounded(score, maxDistance);
+  }
+
+#if defined(__AVX2__) || defined(__SSE4_1__)
+  // scoreWord on texts[lanes[0..used)] at once, for as many bytes as the shortest of them
+  // has (unused lanes repeat the first text), then every lane finishes its own tail on
+  // scoreWord from the state it got to. Texts within the band differ in length by at most
+  // 2 * maxDistance, so the tails stay short.
+  void scoreLanes(std::span<const std::string_view> texts,
+                  const std::array<size_t, detail::Lanes::N>& lanes, size_t used,
+                  size_t maxDistance, std::span<size_t> out) const noexcept
+  {
+    using L = detail::Lanes;
+    using V = L::V;
+
+    constexpr size_t N = L::N;
+
+    std::array<const unsigned char*, N> bytes{};
+    std::array<size_t, N>               len{};
 
-      std::swap(prev, cur);
+    for (size_t l = 0; l < N; ++l)
+    {
+      const auto t = texts[lanes[l < used ? l : 0]];
+      bytes[l]     = reinterpret_cast<const unsigned char*>(t.data());
+      len[l]       = t.size();
+    }
+
+    const size_t shortest = *std::ranges::min_element(len);
+
+    const V ones = L::set1(~std::uint64_t{0});
+    const V one  = L::set1(1);
+    const V last = L::set1(std::uint64_t{1} << (m_size - 1));
+
+    V vp    = ones;
+    V vn    = L::set1(0);
+    V score = L::set1(m_size);
+
+    alignas(sizeof(V)) std::array<std::uint64_t, N> scores{};
+
+    size_t j = 0;
+    for (; j < shortest; ++j)
+    {
+      const V eq = L::gather([&](size_t l) -> std::uint64_t { return m_peq[bytes[l][j]]; });
+
+      const V xv = L::bitOr(eq, vn);
+      const V xh = L::bitOr(L::bitXor(L::add(L::bitAnd(eq, vp), vp), vp), eq);
+
+      V hp = L::bitOr(vn, L::bitXor(L::bitOr(xh, vp), ones));
+      V hn = L::bitAnd(vp, xh);
+
+      // all ones (-1) in the lanes whose last bit is set
+      score = L::add(L::sub(score, L::eq(L::bitAnd(hp, last), last)),
+                     L::eq(L::bitAnd(hn, last), last));
+
+      hp = L::bitOr(L::shl1(hp), one);
+      hn = L::shl1(hn);
+
+      vp = L::bitOr(hn, L::bitXor(L::bitOr(xv, hp), ones));
+      vn = L::bitAnd(hp, xv);
+
+      if ((j & 7) == 7)
+      {
+        L::store(scores.data(), score);
+
+        bool open = false;
+        for (size_t l = 0; l < used && !open; ++l)
+          open = !hopeless(scores[l], len[l] - j - 1, maxDistance);
+
+        if (!open)
+        {
+          for (size_t l = 0; l < used; ++l)
+            out[lanes[l]] = maxDistance + 1;
+          return;
+        }
+      }
     }
 
-    const size_t result = prev[len2];
-    return (maxDistance != SIZE_MAX && result > maxDistance) ? (maxDistance + 1) : result;
+    alignas(sizeof(V)) std::array<std::uint64_t, N> vps{};
+    alignas(sizeof(V)) std::array<std::uint64_t, N> vns{};
+
+    L::store(vps.data(), vp);
+    L::store(vns.data(), vn);
+    L::store(scores.data(), score);
+
+    for (size_t l = 0; l < used; ++l)
+      out[lanes[l]] = scoreWord(texts[lanes[l]], j, {vps[l], vns[l], scores[l]}, maxDistance);
+  }
+#endif
+};
+
+class StringDistance final
+{
+public:
+  StringDistance()  = delete;
+  ~StringDistance() = delete;
+
+  StringDistance(const StringDistance&)                    = delete;
+  auto operator=(const StringDistance&) -> StringDistance& = delete;
+
+  StringDistance(StringDistance&&)                    = delete;
+  auto operator=(StringDistance&&) -> StringDistance& = delete;
+
+  // one off distance, build a LevenshteinPattern instead to score one string against many
+  static auto levenshteinDistance(std::string_view s1, std::string_view s2,
+                                  size_t maxDistance = SIZE_MAX) -> size_t
+  {
+    // the shorter one as the pattern, fewer words per byte
+    if (s1.size() > s2.size())
+      std::swap(s1, s2);
+
+    return LevenshteinPattern(s1).distance(s2, maxDistance);
   }
 
   static auto bestCandidate(const std::vector<std::string>& candidates, const std::string& query)
@@ -118,6 +498,8 @@ public:
     if (candidates.empty() || query.empty())
       return {};
 
+    const LevenshteinPattern pattern(query);
+
     size_t      bestDist = SIZE_MAX;
     std::string best;
 
@@ -126,7 +508,7 @@ public:
       if (c.empty())
         continue;
 
-      const size_t d = levenshteinDistance(c, query);
+      const size_t d = pattern.distance(c);
       if (d < bestDist)
       {
         bestDist = d;
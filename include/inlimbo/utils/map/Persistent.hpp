@@ -0,0 +1,166 @@
+#pragma once
+
+#include <ankerl/unordered_dense.h>
+#include <memory>
+#include <utility>
+
+namespace utils::map
+{
+
+/*
+utils::map::PersistentMap is an ankerl::unordered_dense::map behind a shared, copy on write
+pointer. Copying one copies the pointer, the table is only duplicated when a copy is
+written to while another copy still refers to it.
+
+Nested as the value type of each other (like the SongMap levels) this gives path copying:
+
+  SongMap next = published;            // O(1), next shares every table with published
+  next[artist][album][disc][track][inode] = song;
+                                       // copies the artist table, that artist's album
+                                       // table, ... down to one inode table. Every
+                                       // other table stays shared.
+
+Const access never copies. Non-const access (operator[], find, begin, erase, ...) on a
+shared table detaches it first, so:
+
+- iterate with `std::as_const(map)` (or through a const&) when only reading, a non-const
+  range-for over a whole level detaches every table below it as well
+- a table that is not shared (use_count 1) is written in place, building a map from
+  scratch costs the same as with a plain ankerl map
+
+Thread safety is the one of std::shared_ptr: a table is only ever modified when the
+modifying map is its sole owner, so readers holding other copies (a published snapshot
+in utils::threads::SafeMap) never observe a change.
+*/
+
+template <typename K, typename V>
+class PersistentMap
+{
+public:
+  using table_type     = ankerl::unordered_dense::map<K, V>;
+  using key_type       = K;
+  using mapped_type    = V;
+  using value_type     = typename table_type::value_type;
+  using size_type      = typename table_type::size_type;
+  using iterator       = typename table_type::iterator;
+  using const_iterator = typename table_type::const_iterator;
+
+  PersistentMap() noexcept = default;
+
+  // -------------------------------------------------
+  // READERS (never copy)
+  // -------------------------------------------------
+
+  [[nodiscard]] auto begin() const noexcept -> const_iterator { return table().begin(); }
+  [[nodiscard]] auto end() const noexcept -> const_iterator { return table().end(); }
+  [[nodiscard]] auto cbegin() const noexcept -> const_iterator { return begin(); }
+  [[nodiscard]] auto cend() const noexcept -> const_iterator { return end(); }
+
+  [[nodiscard]] auto size() const noexcept -> size_type { return m_table ? m_table->size() : 0; }
+  [[nodiscard]] auto empty() const noexcept -> bool { return size() == 0; }
+
+  [[nodiscard]] auto find(const K& key) const -> const_iterator { return table().find(key); }
+  [[nodiscard]] auto contains(const K& key) const -> bool { return table().contains(key); }
+  [[nodiscard]] auto count(const K& key) const -> size_type { return table().count(key); }
+  [[nodiscard]] auto at(const K& key) const -> const V& { return table().at(key); }
+
+  // true if both maps currently share one table (nothing was written since they were copied)
+  [[nodiscard]] auto shares(const PersistentMap& other) const noexcept -> bool
+  {
+    return m_table == other.m_table;
+  }
+
+  // -------------------------------------------------
+  // WRITERS (detach a shared table first)
+  // -------------------------------------------------
+
+  [[nodiscard]] auto begin() -> iterator { return mut().begin(); }
+  [[nodiscard]] auto end() -> iterator { return mut().end(); }
+
+  [[nodiscard]] auto find(const K& key) -> iterator { return mut().find(key); }
+  [[nodiscard]] auto at(const K& key) -> V& { return mut().at(key); }
+
+  auto operator[](const K& key) -> V& { return mut()[key]; }
+  auto operator[](K&& key) -> V& { return mut()[std::move(key)]; }
+
+  template <typename... Args>
+  auto try_emplace(const K& key, Args&&... args) -> std::pair<iterator, bool>
+  {
+    return mut().try_emplace(key, std::forward<Args>(args)...);
+  }
+
+  template <typename... Args>
+  auto emplace(Args&&... args) -> std::pair<iterator, bool>
+  {
+    return mut().emplace(std::forward<Args>(args)...);
+  }
+
+  template <typename M>
+  auto insert_or_assign(const K& key, M&& value) -> std::pair<iterator, bool>
+  {
+    return mut().insert_or_assign(key, std::forward<M>(value));
+  }
+
+  // a missing key does not detach
+  auto erase(const K& key) -> size_type { return contains(key) ? mut().erase(key) : 0; }
+
+  void reserve(size_type n)
+  {
+    if (n > size())
+      mut().reserve(n);
+  }
+
+  void clear() noexcept { m_table.reset(); }
+
+  // -------------------------------------------------
+  // SERIALIZATION (same stream as a plain ankerl map)
+  // -------------------------------------------------
+
+  template <class Archive>
+  void save(Archive& ar) const
+  {
+    const size_t n = size();
+    ar(n);
+    for (const auto& [k, v] : *this)
+      ar(k, v);
+  }
+
+  template <class Archive>
+  void load(Archive& ar)
+  {
+    size_t n = 0;
+    ar(n);
+
+    clear();
+    reserve(n);
+
+    for (size_t i = 0; i < n; ++i)
+    {
+      K k;
+      V v;
+      ar(k, v);
+      emplace(std::move(k), std::move(v));
+    }
+  }
+
+private:
+  std::shared_ptr<table_type> m_table; // null: empty
+
+  [[nodiscard]] auto table() const noexcept -> const table_type&
+  {
+    static const table_type none;
+    return m_table ? *m_table : none;
+  }
+
+  auto mut() -> table_type&
+  {
+    if (!m_table)
+      m_table = std::make_shared<table_type>();
+    else if (m_table.use_count() != 1)
+      m_table = std::make_shared<table_type>(*m_table);
+
+    return *m_table;
+  }
+};
+
+} // namespace utils::map
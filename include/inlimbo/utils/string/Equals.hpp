@@ -2,16 +2,17 @@
 
 #include "Config.hpp"
 #include <string>
+#include <string_view>
 
 namespace utils::string
 {
 
 auto icompare(std::string_view a, std::string_view b) -> bool;
 
-INLIMBO_API_CPP auto isEquals(const std::string& a, const std::string& b) noexcept -> bool;
+INLIMBO_API_CPP auto isEquals(std::string_view a, std::string_view b) noexcept -> bool;
 
 // Optimized "contains-like" equality for situations where you already know one side is lowercase
-INLIMBO_API_CPP auto isEqualsPrelowered(const std::string& lowerA, const std::string& b) noexcept
+INLIMBO_API_CPP auto isEqualsPrelowered(std::string_view lowerA, std::string_view b) noexcept
   -> bool;
 
 } // namespace utils::string
@@ -0,0 +1,243 @@
+#pragma once
+
+#include <ankerl/unordered_dense.h>
+#include <array>
+#include <atomic>
+#include <compare>
+#include <concepts>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+// A library wide, arena backed string interner.
+//
+// Artist, album and genre names repeat a lot: a 400k track library has a few thousand
+// distinct ones, but every Metadata and every SongMap level used to hold its own copy.
+// InternedString is a 32 bit id into one process wide pool instead:
+//
+// -> the characters of each distinct string live once, in 64 KiB arena blocks
+//    (NUL terminated, so c_str() is free)
+// -> id -> string is an array index (lock free, pages are never moved or freed)
+// -> string -> id is a hash lookup under a shared lock, only done when a string is
+//    turned into an InternedString (parse, cache load, user input)
+//
+// Equality and hashing only look at the id, ordering compares the characters (sort plans
+// and std::set<Artist> still see names in lexicographic order). The string itself is
+// resolved only where it is displayed (view(), c_str(), implicit string_view).
+//
+// Id 0 is always the empty string, a default constructed InternedString never touches
+// the pool.
+//
+// Limitations:
+// - Interned strings are never released (fine for tag values, not for arbitrary text).
+// - At most MAX_PAGES * PAGE_SIZE distinct strings per process.
+
+namespace utils::string
+{
+
+class InternPool
+{
+public:
+  static constexpr uint32_t PAGE_BITS = 16;
+  static constexpr uint32_t PAGE_SIZE = 1u << PAGE_BITS;
+  static constexpr uint32_t MAX_PAGES = 1024;
+
+  struct Entry
+  {
+    const char* data;
+    uint32_t    size;
+  };
+
+  // id of s, adding it to the pool the first time (thread safe)
+  static auto intern(std::string_view s) -> uint32_t;
+
+  // id of s if it was interned before, never adds
+  static auto find(std::string_view s) -> std::optional<uint32_t>;
+
+  static auto entry(uint32_t id) noexcept -> const Entry&
+  {
+    const Entry* page = s_pages[id >> PAGE_BITS].load(std::memory_order_acquire);
+    return page[id & (PAGE_SIZE - 1)];
+  }
+
+  static auto count() -> size_t; // distinct strings, including ""
+  static auto bytes() -> size_t; // arena + index memory
+
+private:
+  friend struct InternPoolState;
+
+  static inline constinit std::array<std::atomic<const Entry*>, MAX_PAGES> s_pages{};
+};
+
+class InternedString;
+
+template <typename S>
+concept InternSource = std::convertible_to<const S&, std::string_view> &&
+                       !std::same_as<std::remove_cvref_t<S>, InternedString>;
+
+class InternedString
+{
+public:
+  constexpr InternedString() noexcept = default;
+
+  template <InternSource S>
+  InternedString(const S& s) : m_id(intern(std::string_view(s)))
+  {
+  }
+
+  template <InternSource S>
+  auto operator=(const S& s) -> InternedString&
+  {
+    m_id = intern(std::string_view(s));
+    return *this;
+  }
+
+  // the interned string equal to s, without adding it to the pool
+  static auto find(std::string_view s) -> std::optional<InternedString>
+  {
+    if (s.empty())
+      return InternedString{};
+    if (auto id = InternPool::find(s))
+      return fromId(*id);
+    return std::nullopt;
+  }
+
+  static auto fromId(uint32_t id) noexcept -> InternedString
+  {
+    InternedString s;
+    s.m_id = id;
+    return s;
+  }
+
+  [[nodiscard]] constexpr auto id() const noexcept -> uint32_t { return m_id; }
+
+  [[nodiscard]] auto view() const noexcept -> std::string_view
+  {
+    if (m_id == 0)
+      return {};
+    const auto& e = InternPool::entry(m_id);
+    return {e.data, e.size};
+  }
+
+  [[nodiscard]] auto c_str() const noexcept -> const char*
+  {
+    return m_id == 0 ? "" : InternPool::entry(m_id).data;
+  }
+
+  [[nodiscard]] auto data() const noexcept -> const char* { return c_str(); }
+  [[nodiscard]] auto str() const -> std::string { return std::string(view()); }
+  [[nodiscard]] auto size() const noexcept -> size_t { return view().size(); }
+  [[nodiscard]] auto length() const noexcept -> size_t { return size(); }
+  [[nodiscard]] constexpr auto empty() const noexcept -> bool { return m_id == 0; }
+
+  operator std::string_view() const noexcept { return view(); }
+  operator std::string() const { return str(); }
+
+  void clear() noexcept { m_id = 0; }
+
+  // ------------------------------------------------------------
+  // comparison: == by id, ordering by characters
+  // ------------------------------------------------------------
+  friend constexpr auto operator==(InternedString a, InternedString b) noexcept -> bool
+  {
+    return a.m_id == b.m_id;
+  }
+
+  friend auto operator<=>(InternedString a, InternedString b) noexcept -> std::strong_ordering
+  {
+    if (a.m_id == b.m_id)
+      return std::strong_ordering::equal;
+    return a.view() <=> b.view();
+  }
+
+  template <InternSource S>
+  friend auto operator==(InternedString a, const S& b) noexcept -> bool
+  {
+    return a.view() == std::string_view(b);
+  }
+
+  template <InternSource S>
+  friend auto operator<=>(InternedString a, const S& b) noexcept -> std::strong_ordering
+  {
+    return a.view() <=> std::string_view(b);
+  }
+
+  // ------------------------------------------------------------
+  // concatenation always gives a plain std::string
+  // ------------------------------------------------------------
+  friend auto operator+(InternedString a, InternedString b) -> std::string
+  {
+    std::string out(a.view());
+    out += b.view();
+    return out;
+  }
+
+  template <InternSource S>
+  friend auto operator+(InternedString a, const S& b) -> std::string
+  {
+    std::string out(a.view());
+    out += std::string_view(b);
+    return out;
+  }
+
+  template <InternSource S>
+  friend auto operator+(const S& a, InternedString b) -> std::string
+  {
+    std::string out(std::string_view{a});
+    out += b.view();
+    return out;
+  }
+
+  friend auto operator<<(std::ostream& os, InternedString s) -> std::ostream&
+  {
+    return os << s.view();
+  }
+
+  // serialized as the plain string, ids are only meaningful inside one process
+  template <class Archive>
+  void save(Archive& ar) const
+  {
+    ar(str());
+  }
+
+  template <class Archive>
+  void load(Archive& ar)
+  {
+    std::string tmp;
+    ar(tmp);
+    *this = tmp;
+  }
+
+private:
+  uint32_t m_id = 0;
+
+  static auto intern(std::string_view s) -> uint32_t
+  {
+    return s.empty() ? 0 : InternPool::intern(s);
+  }
+};
+
+} // namespace utils::string
+
+template <>
+struct ankerl::unordered_dense::hash<utils::string::InternedString>
+{
+  using is_avalanching = void;
+
+  auto operator()(utils::string::InternedString s) const noexcept -> uint64_t
+  {
+    return ankerl::unordered_dense::hash<uint32_t>{}(s.id());
+  }
+};
+
+template <>
+struct std::hash<utils::string::InternedString>
+{
+  auto operator()(utils::string::InternedString s) const noexcept -> size_t
+  {
+    return std::hash<uint32_t>{}(s.id());
+  }
+};
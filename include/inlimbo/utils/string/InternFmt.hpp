@@ -0,0 +1,14 @@
+#pragma once
+
+#include "utils/string/Intern.hpp"
+#include <spdlog/fmt/fmt.h>
+
+template <>
+struct fmt::formatter<utils::string::InternedString> : fmt::formatter<std::string_view>
+{
+  template <typename FormatContext>
+  auto format(const utils::string::InternedString& s, FormatContext& ctx) const
+  {
+    return fmt::formatter<std::string_view>::format(s.view(), ctx);
+  }
+};
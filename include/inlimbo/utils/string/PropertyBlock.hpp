@@ -0,0 +1,188 @@
+#pragma once
+
+#include "utils/string/Intern.hpp"
+
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// The free form tag properties of one song (ENCODER, REPLAYGAIN_TRACK_GAIN, ...).
+//
+// A hash map of std::string -> std::string per song costs a table plus two heap strings
+// per property, while the keys are the same few dozen across the whole library. A
+// PropertyBlock is one allocation instead:
+//
+//   [count][key id, value offset, value size] x count [values ...]
+//
+// -> keys are InternedString ids (the library wide pool, see Intern.hpp), so each key is
+//    stored once per process and compared as an integer
+// -> entries are sorted by key id, find() is a binary search
+// -> values are packed back to back behind the entry table
+//
+// A block is immutable once built (see Builder). Iteration is in key id order, which is
+// stable within a process but not alphabetical.
+
+namespace utils::string
+{
+
+class PropertyBlock
+{
+public:
+  struct Property
+  {
+    InternedString   key;
+    std::string_view value;
+  };
+
+  class Builder
+  {
+  public:
+    void reserve(size_t n) { m_items.reserve(n); }
+
+    // repeated keys keep every value, joined with ' ' (like multi value tags)
+    void add(std::string_view key, std::string_view value);
+
+    [[nodiscard]] auto finish() -> PropertyBlock;
+
+  private:
+    struct Item
+    {
+      uint32_t key;
+      uint32_t offset; // into m_values
+      uint32_t size;
+    };
+
+    std::vector<Item> m_items;
+    std::string       m_values;
+  };
+
+  class const_iterator
+  {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type        = Property;
+    using difference_type   = std::ptrdiff_t;
+    using pointer           = void;
+    using reference         = Property;
+
+    const_iterator() = default;
+
+    auto operator*() const noexcept -> Property { return m_block->at(m_index); }
+
+    auto operator++() noexcept -> const_iterator&
+    {
+      ++m_index;
+      return *this;
+    }
+
+    auto operator++(int) noexcept -> const_iterator
+    {
+      auto tmp = *this;
+      ++m_index;
+      return tmp;
+    }
+
+    friend auto operator==(const const_iterator&, const const_iterator&) -> bool = default;
+
+  private:
+    friend class PropertyBlock;
+
+    const_iterator(const PropertyBlock* block, uint32_t index) : m_block(block), m_index(index)
+    {
+    }
+
+    const PropertyBlock* m_block = nullptr;
+    uint32_t             m_index = 0;
+  };
+
+  PropertyBlock() noexcept = default;
+
+  PropertyBlock(const PropertyBlock& other);
+  auto operator=(const PropertyBlock& other) -> PropertyBlock&;
+
+  PropertyBlock(PropertyBlock&&) noexcept                    = default;
+  auto operator=(PropertyBlock&&) noexcept -> PropertyBlock& = default;
+
+  [[nodiscard]] auto size() const noexcept -> size_t { return m_words ? m_words[0] : 0; }
+  [[nodiscard]] auto empty() const noexcept -> bool { return size() == 0; }
+
+  [[nodiscard]] auto find(InternedString key) const noexcept -> std::optional<std::string_view>;
+
+  // keys that were never interned cannot be in any block, the lookup never adds them
+  template <InternSource S>
+  [[nodiscard]] auto find(const S& key) const -> std::optional<std::string_view>
+  {
+    return findKey(std::string_view(key));
+  }
+
+  template <InternSource S>
+  [[nodiscard]] auto contains(const S& key) const -> bool
+  {
+    return findKey(std::string_view(key)).has_value();
+  }
+
+  [[nodiscard]] auto at(uint32_t index) const noexcept -> Property;
+
+  [[nodiscard]] auto begin() const noexcept -> const_iterator { return {this, 0}; }
+  [[nodiscard]] auto end() const noexcept -> const_iterator
+  {
+    return {this, static_cast<uint32_t>(size())};
+  }
+
+  // heap bytes of this block
+  [[nodiscard]] auto bytes() const noexcept -> size_t { return wordCount() * sizeof(uint32_t); }
+
+  // same layout on the wire as the map it replaces: size, then (key, value) pairs
+  template <class Archive>
+  void save(Archive& ar) const
+  {
+    const size_t n = size();
+    ar(n);
+    for (const auto& [key, value] : *this)
+      ar(key.str(), std::string(value));
+  }
+
+  template <class Archive>
+  void load(Archive& ar)
+  {
+    size_t n = 0;
+    ar(n);
+
+    Builder builder;
+    builder.reserve(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+      std::string key, value;
+      ar(key, value);
+      builder.add(key, value);
+    }
+
+    *this = builder.finish();
+  }
+
+private:
+  static constexpr size_t ENTRY_WORDS = 3; // key id, value offset, value size
+
+  // [0] count, then the entry table, then the value bytes
+  std::unique_ptr<uint32_t[]> m_words;
+
+  [[nodiscard]] auto entry(uint32_t index) const noexcept -> const uint32_t*
+  {
+    return m_words.get() + 1 + index * ENTRY_WORDS;
+  }
+
+  [[nodiscard]] auto values() const noexcept -> const char*
+  {
+    return reinterpret_cast<const char*>(entry(static_cast<uint32_t>(size())));
+  }
+
+  [[nodiscard]] auto wordCount() const noexcept -> size_t;
+  [[nodiscard]] auto findKey(std::string_view key) const -> std::optional<std::string_view>;
+};
+
+} // namespace utils::string
@@ -432,10 +432,13 @@ private:
 
   constexpr void move_from(SmallString& other) noexcept
   {
+    // taken before other is reset below (init_sso zeroes its size)
+    const uint32_t size = other.m_size;
+
     if (other.is_sso())
     {
       init_sso();
-      std::memcpy(m_sso, other.m_sso, other.m_size + 1);
+      std::memcpy(m_sso, other.m_sso, size + 1);
     }
     else
     {
@@ -443,7 +446,7 @@ private:
       m_capacity = other.m_capacity;
       other.init_sso();
     }
-    m_size = other.m_size;
+    m_size = size;
     other.clear();
   }
 
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace utils::threads
+{
+
+/*
+threads::Epoch is a process wide epoch based reclamation domain: readers announce that
+they are looking at shared data, writers find out when everything they unlinked can no
+longer be seen by anyone.
+
+Reader Behavior
+- Epoch::Guard on the stack around the access (nestable, per thread)
+- Entering stores the current global epoch into the thread's own slot (one cache line,
+  never shared with another thread), leaving clears it
+- No refcounts, no locks, no writes to shared cache lines
+
+Writer Behavior
+- Unlink the object (swap in the replacement) first
+- advance() returns the epoch the object is retired in
+- The object may be freed once quiescent(epoch) is true: every reader still inside a
+  guard entered after the unlink, so none of them can hold the old object
+
+Limitations:
+- At most MAX_THREADS threads can be inside a guard at once (a slot is claimed on a
+  thread's first guard and given back when the thread exits), more throws
+- A reader that stays inside a guard for a long time delays reclamation (never blocks a
+  writer, the retired objects just live longer)
+*/
+
+class Epoch
+{
+public:
+  static constexpr size_t MAX_THREADS = 256;
+
+  class Guard
+  {
+  public:
+    Guard() { Epoch::enter(); }
+    ~Guard() { Epoch::leave(); }
+
+    Guard(const Guard&)                    = delete;
+    auto operator=(const Guard&) -> Guard& = delete;
+  };
+
+  static void enter();
+  static void leave() noexcept;
+
+  // bumps the global epoch, returns the epoch everything unlinked so far is retired in
+  static auto advance() noexcept -> std::uint64_t;
+
+  // true if no thread is inside a guard it entered before `retired`
+  [[nodiscard]] static auto quiescent(std::uint64_t retired) noexcept -> bool;
+};
+
+} // namespace utils::threads
@@ -1,28 +1,41 @@
 #pragma once
 
+#include "utils/threads/Epoch.hpp"
+
 #include <atomic>
+#include <cstdint>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <optional>
+#include <utility>
+#include <vector>
 
 namespace utils::threads
 {
 
 /*
-threads::SafeMap is a thread-safe wrapper around a map-like container using an atomic
-std::shared_ptr. Readers access immutable snapshots without locking, while
-writers modify a private copy and atomically publish it.
+threads::SafeMap is a thread-safe wrapper around a map-like container. Readers access
+immutable snapshots without locking, while writers modify a private copy and atomically
+publish it.
 
 Reader Behavior
 - Lock-free
-- Atomic snapshot load
+- Atomic snapshot load inside an epoch guard (utils/threads/Epoch.hpp): no refcount
+  traffic on the published map, a read only writes to the thread's own epoch slot
 - Always see consistent data
 - No read/write blocking
 
 Writer Behavior:
-- Copy current map (most expensive downside)
+- Copy current map (most expensive downside for a plain map, see below)
 - Apply modifications
 - Atomically replace snapshot
-- Old data stays alive while readers use it
+- Old data stays alive while readers use it: a replaced snapshot is retired with the
+  current epoch and released by a later write once every reader that could still see it
+  has left its guard
+
+Writers are serialized on a mutex (readers never take it). transaction() holds it across
+any number of mutations and publishes them once, update() is a transaction of one.
 
 Advantages:
 - Very fast reads
@@ -37,9 +50,22 @@ Limitations:
 - Requires copyable map type
 - Not ideal for write-heavy workloads
 
+The first two only hold for maps that copy their contents. With a persistent TMap
+(utils/map/Persistent.hpp, which SongMap is built from) the copy in update() is O(1) and
+only the tables the write goes through are duplicated, everything else stays shared with
+the published snapshot.
+
 Optimized for many readers and few writers. Trades write cost for safe,
 lock-free read performance.
 
+Every publish (replace, clear, update, commit) bumps version(), so anything that caches
+data derived from the map (UI lists, counters, ...) can poll it cheaply to know when to
+rebuild.
+
+replaceDeferred() publishes a map that is only made when something first reads or copies
+it. Whoever only polls version() (or keeps data derived from the map some other way, see
+query::songmap::adoptLibraryCache) never builds it.
+
 */
 
 template <typename TMap>
@@ -48,26 +74,125 @@ class SafeMap
 private:
   static_assert(std::is_copy_constructible_v<TMap>);
 
-  mutable std::atomic<std::shared_ptr<TMap>> m_mapPtr;
+  // published snapshot, only dereferenced inside an epoch guard
+  struct Node
+  {
+    mutable std::shared_ptr<TMap> map;         // read through get()
+    std::uint64_t                 version = 0; // version() that published it
+
+    // replaceDeferred(): map is made by the first get()
+    std::function<std::shared_ptr<TMap>()> make = {};
+    mutable std::once_flag                 made{};
+
+    [[nodiscard]] auto get() const -> const std::shared_ptr<TMap>&
+    {
+      if (make)
+        std::call_once(made, [this]() -> void { map = make(); });
+      return map;
+    }
+  };
+
+  struct Retired
+  {
+    std::unique_ptr<Node> node;
+    std::uint64_t         epoch;
+  };
+
+  std::atomic<Node*>         m_current;
+  std::atomic<std::uint64_t> m_version{0};
+
+  std::mutex           m_writeMtx;
+  std::vector<Retired> m_retired; // under m_writeMtx
+
+  // with m_writeMtx held
+  void reclaim()
+  {
+    std::erase_if(m_retired, [](const Retired& r) -> bool { return Epoch::quiescent(r.epoch); });
+  }
+
+  // with m_writeMtx held, returns the version it published
+  auto publish(std::shared_ptr<TMap> newPtr, std::function<std::shared_ptr<TMap>()> make = {})
+    -> std::uint64_t
+  {
+    const auto version = m_version.load(std::memory_order_relaxed) + 1;
+
+    auto* old = m_current.exchange(new Node{std::move(newPtr), version, std::move(make)},
+                                   std::memory_order_seq_cst);
+    m_version.store(version, std::memory_order_release);
+
+    m_retired.push_back({std::unique_ptr<Node>(old), Epoch::advance()});
+    reclaim();
+    return version;
+  }
+
+  // readers: inside an Epoch::Guard, writers: with m_writeMtx held
+  [[nodiscard]] auto current() const noexcept -> const Node&
+  {
+    return *m_current.load(std::memory_order_seq_cst);
+  }
 
 public:
-  SafeMap() { m_mapPtr.store(std::make_shared<TMap>(), std::memory_order_relaxed); }
+  // -------------------------------------------------
+  // TRANSACTION
+  // -------------------------------------------------
+
+  // A private copy of the map plus the write lock. Mutate map() as often as needed,
+  // commit() publishes everything at once. Dropped without commit() nothing is published.
+  class Transaction
+  {
+  public:
+    Transaction(Transaction&&) noexcept                    = default;
+    auto operator=(Transaction&&) noexcept -> Transaction& = default;
+
+    [[nodiscard]] auto map() noexcept -> TMap& { return *m_map; }
+    auto               operator->() noexcept -> TMap* { return m_map.get(); }
+    auto               operator*() noexcept -> TMap& { return *m_map; }
+
+    void commit()
+    {
+      if (!m_lock.owns_lock())
+        return;
+
+      m_owner->publish(std::move(m_map));
+      m_lock.unlock();
+    }
+
+  private:
+    friend class SafeMap;
+
+    explicit Transaction(SafeMap& owner)
+        : m_owner(&owner), m_lock(owner.m_writeMtx),
+          m_map(std::make_shared<TMap>(*owner.current().get()))
+    {
+    }
+
+    SafeMap*                     m_owner;
+    std::unique_lock<std::mutex> m_lock;
+    std::shared_ptr<TMap>        m_map;
+  };
+
+  SafeMap() { m_current.store(new Node{std::make_shared<TMap>()}, std::memory_order_relaxed); }
+
+  // no reader or writer may still be using the map
+  ~SafeMap() { delete m_current.load(std::memory_order_relaxed); }
 
   SafeMap(const SafeMap&)                    = delete;
   auto operator=(const SafeMap&) -> SafeMap& = delete;
 
   SafeMap(SafeMap&& other) noexcept
   {
-    auto ptr = other.m_mapPtr.load(std::memory_order_acquire);
-    m_mapPtr.store(std::move(ptr), std::memory_order_release);
+    m_current.store(new Node{std::const_pointer_cast<TMap>(other.pin())},
+                    std::memory_order_release);
   }
 
   auto operator=(SafeMap&& other) noexcept -> SafeMap&
   {
     if (this != &other)
     {
-      auto ptr = other.m_mapPtr.load(std::memory_order_acquire);
-      m_mapPtr.store(std::move(ptr), std::memory_order_release);
+      auto ptr = std::const_pointer_cast<TMap>(other.pin());
+
+      std::lock_guard lock(m_writeMtx);
+      publish(std::move(ptr));
     }
     return *this;
   }
@@ -76,16 +201,49 @@ public:
   // WRITERS
   // -------------------------------------------------
 
+  [[nodiscard]] auto transaction() -> Transaction { return Transaction(*this); }
+
   void replace(TMap newMap)
   {
-    auto newPtr = std::make_shared<TMap>(std::move(newMap));
-    m_mapPtr.store(std::move(newPtr), std::memory_order_release);
+    auto ptr = std::make_shared<TMap>(std::move(newMap));
+
+    std::lock_guard lock(m_writeMtx);
+    publish(std::move(ptr));
+  }
+
+  // make runs once, on the thread that first needs the map (a reader, or a writer copying
+  // it), returns the version it published
+  auto replaceDeferred(std::function<std::shared_ptr<TMap>()> make) -> std::uint64_t
+  {
+    std::lock_guard lock(m_writeMtx);
+    return publish(nullptr, std::move(make));
   }
 
   void clear()
   {
-    auto newPtr = std::make_shared<TMap>();
-    m_mapPtr.store(std::move(newPtr), std::memory_order_release);
+    auto ptr = std::make_shared<TMap>();
+
+    std::lock_guard lock(m_writeMtx);
+    publish(std::move(ptr));
+  }
+
+  template <typename Fn>
+  auto update(Fn&& fn) -> decltype(auto)
+  {
+    auto txn = transaction();
+
+    if constexpr (std::is_void_v<std::invoke_result_t<Fn, TMap&>>)
+    {
+      fn(txn.map());
+      txn.commit();
+      return;
+    }
+    else
+    {
+      auto result = fn(txn.map());
+      txn.commit();
+      return result;
+    }
   }
 
   // -------------------------------------------------
@@ -95,55 +253,71 @@ public:
   template <typename LookupFn>
   auto get(LookupFn&& fn) const -> std::optional<typename TMap::mapped_type>
   {
-    auto ptr = m_mapPtr.load(std::memory_order_acquire);
-    return fn(*ptr);
+    Epoch::Guard guard;
+    return fn(std::as_const(*current().get()));
   }
 
   auto snapshot() const -> TMap
   {
-    auto ptr = m_mapPtr.load(std::memory_order_acquire);
-    return *ptr;
+    Epoch::Guard guard;
+    return *current().get();
   }
 
-  [[nodiscard]] auto empty() const -> bool
+  // Shares the currently published map instead of copying it. Writers never touch a
+  // published map (they copy, modify and swap), so the pinned map stays valid and
+  // unchanged for as long as the pointer is held, no matter how many updates follow.
+  //
+  // This is the one reader that takes a reference, use it to keep a snapshot beyond a
+  // single call (read() is cheaper for anything that fits in a callback).
+  [[nodiscard]] auto pin() const -> std::shared_ptr<const TMap>
   {
-    auto ptr = m_mapPtr.load(std::memory_order_acquire);
-    return ptr->empty();
+    Epoch::Guard guard;
+    return current().get();
   }
 
-  template <typename Fn>
-  auto read(Fn&& fn) const -> decltype(auto)
+  struct Pinned
   {
-    auto ptr = m_mapPtr.load(std::memory_order_acquire);
+    std::shared_ptr<const TMap> map;
+    std::uint64_t               version;
+  };
 
-    if constexpr (std::is_void_v<std::invoke_result_t<Fn, const TMap&>>)
-    {
-      fn(*ptr);
-      return;
-    }
-    else
-    {
-      return fn(*ptr);
-    }
+  // pin() plus the version() that published the pinned map, read together (a pin() and a
+  // version() call may see two different publishes)
+  [[nodiscard]] auto pinWithVersion() const -> Pinned
+  {
+    Epoch::Guard guard;
+    const Node&  node = current();
+    return {node.get(), node.version};
   }
 
+  // number of maps published so far (monotonic, never reset)
+  [[nodiscard]] auto version() const noexcept -> std::uint64_t
+  {
+    return m_version.load(std::memory_order_acquire);
+  }
+
+  [[nodiscard]] auto empty() const -> bool
+  {
+    Epoch::Guard guard;
+    return current().get()->empty();
+  }
+
+  // fn sees the snapshot published when read() was entered, references into it must not
+  // outlive the call
   template <typename Fn>
-  auto update(Fn&& fn) -> decltype(auto)
+  auto read(Fn&& fn) const -> decltype(auto)
   {
-    auto oldPtr = m_mapPtr.load(std::memory_order_acquire);
-    auto newPtr = std::make_shared<TMap>(*oldPtr);
+    Epoch::Guard guard;
+    const TMap&  map = *current().get();
 
-    if constexpr (std::is_void_v<std::invoke_result_t<Fn, TMap&>>)
+    if constexpr (std::is_void_v<std::invoke_result_t<Fn, const TMap&>>)
     {
-      fn(*newPtr);
-      m_mapPtr.store(std::move(newPtr), std::memory_order_release);
+      fn(map);
       return;
     }
     else
     {
-      auto result = fn(*newPtr);
-      m_mapPtr.store(std::move(newPtr), std::memory_order_release);
-      return result;
+      return fn(map);
     }
   }
 };
@@ -0,0 +1,209 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace utils::threads
+{
+
+/*
+threads::WorkStealingPool is a fixed size pool of workers where every worker owns a
+task deque. It is meant for short, independent and mostly uniform jobs (like parsing
+tags of thousands of audio files) where a single shared queue would become the hot spot.
+
+Submission
+- Tasks are distributed round robin across the worker deques
+- Any thread can submit, including the workers themselves
+
+Worker Behavior
+- Pops from the BACK of its own deque (LIFO, cache friendly)
+- When empty, steals from the FRONT of other deques (FIFO, oldest work first)
+- Sleeps on a condition variable only when every deque is empty
+
+Task contract
+- A task receives the index of the worker running it ([0, size()))
+  so callers can keep per-worker state (shards) without any locking.
+- Tasks MUST NOT throw. Anything escaping a task is swallowed to keep
+  the pool's bookkeeping consistent.
+
+wait() blocks until every task submitted so far has finished, the pool
+stays alive and can be reused afterwards. The destructor drains and joins.
+
+*/
+
+class WorkStealingPool
+{
+public:
+  using Task = std::function<void(size_t workerIndex)>;
+
+  explicit WorkStealingPool(size_t threadCount = 0)
+  {
+    if (threadCount == 0)
+      threadCount = defaultThreadCount();
+
+    m_queues.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; ++i)
+      m_queues.push_back(std::make_unique<Queue>());
+
+    m_workers.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; ++i)
+      m_workers.emplace_back([this, i]() -> void { workerLoop(i); });
+  }
+
+  ~WorkStealingPool()
+  {
+    wait();
+
+    {
+      std::lock_guard<std::mutex> lk(m_sleepMtx);
+      m_stop.store(true, std::memory_order_release);
+    }
+    m_sleepCv.notify_all();
+
+    for (auto& t : m_workers)
+      if (t.joinable())
+        t.join();
+  }
+
+  WorkStealingPool(const WorkStealingPool&)                    = delete;
+  auto operator=(const WorkStealingPool&) -> WorkStealingPool& = delete;
+
+  WorkStealingPool(WorkStealingPool&&)                    = delete;
+  auto operator=(WorkStealingPool&&) -> WorkStealingPool& = delete;
+
+  [[nodiscard]] static auto defaultThreadCount() noexcept -> size_t
+  {
+    return std::max<size_t>(1, std::thread::hardware_concurrency());
+  }
+
+  [[nodiscard]] auto size() const noexcept -> size_t { return m_workers.size(); }
+
+  void submit(Task task)
+  {
+    const size_t idx = m_next.fetch_add(1, std::memory_order_relaxed) % m_queues.size();
+
+    m_pending.fetch_add(1, std::memory_order_acq_rel);
+    m_queued.fetch_add(1, std::memory_order_acq_rel);
+
+    {
+      std::lock_guard<std::mutex> lk(m_queues[idx]->mtx);
+      m_queues[idx]->tasks.push_back(std::move(task));
+    }
+
+    // taking the sleep mutex here guarantees that a worker which just evaluated
+    // the wait predicate cannot miss this notification.
+    {
+      std::lock_guard<std::mutex> lk(m_sleepMtx);
+    }
+    m_sleepCv.notify_one();
+  }
+
+  void wait()
+  {
+    std::unique_lock<std::mutex> lk(m_sleepMtx);
+    m_doneCv.wait(lk, [&]() -> bool { return m_pending.load(std::memory_order_acquire) == 0; });
+  }
+
+private:
+  struct alignas(64) Queue
+  {
+    std::mutex       mtx;
+    std::deque<Task> tasks;
+  };
+
+  std::vector<std::unique_ptr<Queue>> m_queues;
+  std::vector<std::thread>            m_workers;
+
+  std::atomic<size_t> m_next{0};
+  std::atomic<size_t> m_queued{0};
+  std::atomic<size_t> m_pending{0};
+  std::atomic<bool>   m_stop{false};
+
+  std::mutex              m_sleepMtx;
+  std::condition_variable m_sleepCv;
+  std::condition_variable m_doneCv;
+
+  auto popOwn(size_t idx, Task& out) -> bool
+  {
+    auto&                       q = *m_queues[idx];
+    std::lock_guard<std::mutex> lk(q.mtx);
+    if (q.tasks.empty())
+      return false;
+
+    out = std::move(q.tasks.back());
+    q.tasks.pop_back();
+    return true;
+  }
+
+  auto steal(size_t idx, Task& out) -> bool
+  {
+    const size_t n = m_queues.size();
+
+    for (size_t k = 1; k < n; ++k)
+    {
+      auto& victim = *m_queues[(idx + k) % n];
+
+      std::unique_lock<std::mutex> lk(victim.mtx, std::try_to_lock);
+      if (!lk.owns_lock() || victim.tasks.empty())
+        continue;
+
+      out = std::move(victim.tasks.front());
+      victim.tasks.pop_front();
+      return true;
+    }
+
+    return false;
+  }
+
+  void workerLoop(size_t idx)
+  {
+    while (true)
+    {
+      Task task;
+
+      if (popOwn(idx, task) || steal(idx, task))
+      {
+        m_queued.fetch_sub(1, std::memory_order_acq_rel);
+
+        try
+        {
+          task(idx);
+        }
+        catch (...)
+        {
+        }
+
+        if (m_pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+          std::lock_guard<std::mutex> lk(m_sleepMtx);
+          m_doneCv.notify_all();
+        }
+        continue;
+      }
+
+      std::unique_lock<std::mutex> lk(m_sleepMtx);
+
+      // try_lock based stealing can skip a busy victim, so never sleep
+      // while the global counter still says there is queued work.
+      m_sleepCv.wait(lk,
+                     [&]() -> bool
+                     {
+                       return m_stop.load(std::memory_order_acquire) ||
+                              m_queued.load(std::memory_order_acquire) > 0;
+                     });
+
+      if (m_stop.load(std::memory_order_acquire) && m_queued.load(std::memory_order_acquire) == 0)
+        return;
+    }
+  }
+};
+
+} // namespace utils::threads
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <linux/io_uring.h>
+
+#include <algorithm>
+#include <bitset>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+namespace utils::unix
+{
+
+// ============================================================
+// IoUring (minimal io_uring ring, raw syscalls)
+// ============================================================
+//
+// Just enough of io_uring for batching the library scan: get SQEs, submit them in
+// one io_uring_enter and reap the completions. Talks to the kernel directly through
+// <linux/io_uring.h>, so there is no liburing dependency.
+//
+// Not thread safe, one ring per thread.
+//
+// The constructor throws IoUringUnavailable when the kernel (or a seccomp profile,
+// container runtime, ...) does not give us a ring, callers are expected to fall back
+// to plain syscalls. A ring can also lack single opcodes (IORING_OP_STATX came with 5.6,
+// ...), the ones the kernel supports are probed once at setup, see supports().
+//
+// When the kernel refuses to take or complete work on a ring that has requests in flight,
+// the ring is torn down (usable() turns false): that stops anything else from being
+// submitted on top of it or reaped out of it, callers finish with plain syscalls.
+
+struct IoUringUnavailable : public std::runtime_error
+{
+  explicit IoUringUnavailable(const std::string& msg) : std::runtime_error(msg) {}
+};
+
+class IoUring
+{
+public:
+  explicit IoUring(unsigned entries);
+  ~IoUring();
+
+  IoUring(const IoUring&)                    = delete;
+  auto operator=(const IoUring&) -> IoUring& = delete;
+
+  [[nodiscard]] auto capacity() const noexcept -> unsigned { return m_sqEntries; }
+  [[nodiscard]] auto usable() const noexcept -> bool { return m_fd >= 0; }
+
+  // true if the kernel runs opcode (IORING_OP_*) on this ring, from IORING_REGISTER_PROBE
+  [[nodiscard]] auto supports(unsigned opcode) const noexcept -> bool
+  {
+    return opcode < m_ops.size() && m_ops.test(opcode);
+  }
+
+  // zeroed SQE to fill in, nullptr when the submission queue is full
+  [[nodiscard]] auto sqe() noexcept -> io_uring_sqe*;
+
+  // submits every SQE handed out so far and waits for at least waitNr completions.
+  // Returns the number submitted or -errno.
+  auto submitAndWait(unsigned waitNr) noexcept -> int;
+
+  // submits every SQE handed out so far and calls fn(user_data, res) for the completion
+  // of each request in flight, waiting for the last one. false if the kernel failed
+  // either step, the ring is torn down then (usable() is false).
+  template <typename Fn>
+  auto drain(Fn&& fn) noexcept(noexcept(fn(std::uint64_t{}, std::int32_t{}))) -> bool
+  {
+    if (submitAndWait(0) < 0)
+    {
+      release();
+      return false;
+    }
+
+    while (m_inflight != 0)
+    {
+      reap(fn);
+      if (m_inflight != 0 && waitOne() < 0)
+      {
+        release();
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  // calls fn(user_data, res) for every completion available right now, returns how many
+  template <typename Fn>
+  auto reap(Fn&& fn) noexcept(noexcept(fn(std::uint64_t{}, std::int32_t{}))) -> unsigned
+  {
+    if (!usable())
+      return 0;
+
+    unsigned       head  = *m_cqHead;
+    const unsigned tail  = __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE);
+    unsigned       count = 0;
+
+    while (head != tail)
+    {
+      const io_uring_cqe& cqe = m_cqes[head & m_cqMask];
+      fn(cqe.user_data, cqe.res);
+      ++head;
+      ++count;
+    }
+
+    __atomic_store_n(m_cqHead, head, __ATOMIC_RELEASE);
+    m_inflight -= std::min(count, m_inflight);
+    return count;
+  }
+
+private:
+  int m_fd = -1;
+
+  void*  m_sqRing     = nullptr;
+  void*  m_cqRing     = nullptr;
+  size_t m_sqRingSize = 0;
+  size_t m_cqRingSize = 0;
+
+  io_uring_sqe* m_sqes     = nullptr;
+  size_t        m_sqesSize = 0;
+
+  unsigned* m_sqHead  = nullptr;
+  unsigned* m_sqTail  = nullptr;
+  unsigned* m_sqArray = nullptr;
+  unsigned  m_sqMask  = 0;
+
+  unsigned      m_sqEntries = 0;
+  unsigned      m_sqeTail   = 0; // local tail, published on submit
+  unsigned      m_submitted = 0; // local tail at the last submit
+  unsigned*     m_cqHead    = nullptr;
+  unsigned*     m_cqTail    = nullptr;
+  unsigned      m_cqMask    = 0;
+  io_uring_cqe* m_cqes      = nullptr;
+
+  unsigned         m_inflight = 0; // submitted, completion not reaped yet
+  std::bitset<256> m_ops;          // supported opcodes
+
+  void probe() noexcept;
+  void release() noexcept;
+
+  // waits for one more completion, -errno if the kernel will not deliver one
+  auto waitOne() noexcept -> int;
+};
+
+} // namespace utils::unix
@@ -1,6 +1,7 @@
 #include "Context.hpp"
 #include "Logger.hpp"
 #include "config/sort/Model.hpp"
+#include "core/LibraryWatcher.hpp"
 #include "frontend/Interface.hpp"
 #include "helpers/cmdline/Display.hpp"
 #include "helpers/fs/Directory.hpp"
@@ -127,7 +128,8 @@ void setupArgs(CLI::App& app, Args& args)
 AppContext::AppContext(CLI::App& cliApp)
     : m_taglibDbgLog(config::Config::getBool("debug", "taglib_parser_log")),
       m_telemetryCtx(config::Config::getInt("telemetry", "min_playback_event_time", 30)),
-      m_tagLibParser({.debugLog = m_taglibDbgLog})
+      m_tagLibParser({.debugLog = m_taglibDbgLog,
+                      .fastPath = config::Config::getBool("library", "fast_tag_reader", true)})
 {
   setupArgs(cliApp, args);
 }
@@ -193,12 +195,17 @@ auto resolvePrintAction(const Args& a) -> PrintAction
   if (!a.name.empty())                    \
     return PrintAction::SongsByGenre;
 
+#define CHECK_PRINT_ScanReport(a, name) \
+  if (a.name)                           \
+    return PrintAction::ScanReport;
+
 #define ARG(name, type, kind, cli, desc, action) CHECK_PRINT_##action(a, name)
 #define OPTIONAL_ARG(name, type, cli, desc, action) \
   if (a.name.has_value())                           \
     return PrintAction::action;
 
 #include "defs/args/General.def"
+#include "defs/args/Modify.def"
 #include "defs/args/Query.def"
 
 #undef ARG
@@ -354,6 +361,15 @@ auto maybeHandlePrintActions(AppContext& ctx) -> bool
       break;
     }
 
+    case PrintAction::ScanReport:
+    {
+      // the cache write is the last stage, wait for it so the report is complete
+      ctx.m_libraryWriter.flush();
+      ctx.m_scanReport.saveMs = ctx.m_libraryWriter.lastWriteMs();
+      helpers::cmdline::printScanReport(ctx.m_scanReport);
+      break;
+    }
+
     default:
       break;
   }
@@ -429,8 +445,8 @@ auto maybeHandleEditActions(AppContext& ctx) -> bool
         return true;
       }
 
-      edited->metadata.lyrics = *lyrics.plainLyrics;
-      touched                 = true;
+      edited->metadata.details.edit().lyrics = *lyrics.plainLyrics;
+      touched                                = true;
 
       LOG_INFO("Lyrics fetched successfully from LRCLIB and cached to file path: '{}'", path);
       break;
@@ -438,7 +454,11 @@ auto maybeHandleEditActions(AppContext& ctx) -> bool
 
     case EditAction::Lyrics:
     {
-      apply(ctx.args.editLyrics, &Metadata::lyrics);
+      if (!ctx.args.editLyrics.empty())
+      {
+        edited->metadata.details.edit().lyrics = ctx.args.editLyrics;
+        touched                                = true;
+      }
       break;
     }
 
@@ -459,11 +479,9 @@ auto maybeHandleEditActions(AppContext& ctx) -> bool
     return true;
   }
 
-  // Persist updated SongMap to disk
-  SongLibrarySnapshot tempSongLib;
-  tempSongLib.clear();
-  tempSongLib.newSongMap(g_songMap.snapshot());
-  tempSongLib.saveToFile(ctx.m_binPath);
+  // Persist updated SongMap to disk with its plan order, like every other write (the writer
+  // is flushed when ctx goes out of scope)
+  ctx.m_libraryWriter.request(ctx.m_binPath, query::songmap::columns(g_songMap), ctx.m_musicDir);
 
   LOG_DEBUG("Song object metadata updated successfully. Exiting app...");
   return true;
@@ -541,11 +559,33 @@ auto initializeContext(int argc, char** argv) -> AppContext
   return ctx;
 }
 
+static auto loadScanOptions() -> helpers::fs::ScanOptions
+{
+  helpers::fs::ScanOptions options;
+
+  // 0 (or anything invalid) lets the scanner size its parse pool to the machine
+  const auto threads = config::Config::getInt("library", "scan_threads", 0);
+  const auto depth   = config::Config::getInt("library", "io_uring_depth", 64);
+
+  options.threads    = threads > 0 ? static_cast<size_t>(threads) : 0;
+  options.backend    = helpers::fs::scanBackendFromString(
+    config::Config::getString("library", "scan_backend", "auto"));
+  options.queueDepth = depth > 0 ? static_cast<unsigned>(std::min<i64>(depth, 4096)) : 64;
+
+  return options;
+}
+
 void buildOrLoadLibrary(AppContext& ctx)
 {
   SongLibrarySnapshot tempSongLib;
   bool                rebuild = ctx.args.rebuildLibrary;
 
+  helpers::fs::StageTimer totalTimer;
+  totalTimer.start();
+
+  auto& report = ctx.m_scanReport;
+  report       = {};
+
   try
   {
     tempSongLib.loadFromFile(ctx.m_binPath);
@@ -557,13 +597,77 @@ void buildOrLoadLibrary(AppContext& ctx)
     rebuild = true;
   }
 
+  const auto scanOptions = loadScanOptions();
+
   if (!rebuild)
   {
+    bool failed = false;
+
+    // stat only walk over the music dir, re-parses just the files that are new or whose
+    // (dev, inode, mtime, size) stamp moved since the cache was written
+    if (config::Config::getBool("library", "incremental_scan", true))
+    {
+      utils::Timer<> timer;
+      timer.start();
+
+      const auto summary = helpers::fs::dirWalkProcessChanged(
+        ctx.m_musicDir, ctx.m_tagLibParser, tempSongLib, scanOptions, &report);
+
+      failed = summary.failed > 0;
+
+      LOG_INFO("Library rescan: {} unchanged, {} added, {} updated, {} removed, {} failed "
+               "({:.3f} ms)",
+               summary.unchanged, summary.added, summary.updated, summary.removed,
+               summary.failed + summary.knownFailed, timer.elapsed_ms());
+    }
+
+    // files that failed to parse go into every save, so they are not parsed again next time
+    ctx.m_libraryWriter.setFailedFiles(tempSongLib.moveFailedFiles());
+
     LOG_INFO("No song map rebuild. Loading song map and sorting...");
-    g_songMap.replace(tempSongLib.moveSongMap());
     // loads any changes in sorting plan from config
+    helpers::fs::StageTimer sortTimer;
+    sortTimer.start();
     const auto plan = config::sort::loadRuntimeSortPlan();
-    query::songmap::mut::sortSongMap(g_songMap, plan);
+
+    // a rescan that changed nothing leaves the snapshot on its cache: the columns are built
+    // from the records (no Song is made until asked for) and take the order the cache saved
+    // if the plan is still the same, instead of sorting again
+    bool adopted   = false;
+    bool reordered = true;
+    if (const auto cache = tempSongLib.cache())
+    {
+      try
+      {
+        reordered = !query::songmap::adoptLibraryCache(g_songMap, cache, plan);
+        adopted   = true;
+      }
+      catch (const std::exception& e)
+      {
+        LOG_WARN("Library cache records out of order ({}), loading the song map instead",
+                 e.what());
+      }
+    }
+
+    if (!adopted)
+    {
+      g_songMap.replace(tempSongLib.moveSongMap());
+      query::songmap::mut::sortSongMap(g_songMap, plan);
+    }
+
+    const auto columns = query::songmap::columns(g_songMap);
+    report.sortMs      = sortTimer.elapsed_ms();
+
+    LOG_DEBUG("Library order {} ({:.3f} ms)", reordered ? "sorted" : "taken from the cache",
+              report.sortMs);
+
+    // a new order is saved as well, the next startup takes it from the cache. So is a file
+    // that newly failed to parse, or the next startup tries it again
+    if (reordered || failed)
+      ctx.m_libraryWriter.request(ctx.m_binPath, columns, ctx.m_musicDir);
+
+    report.totalMs = totalTimer.elapsed_ms();
+    LOG_INFO("Scan report: {}", report.toJson());
     return;
   }
 
@@ -571,9 +675,11 @@ void buildOrLoadLibrary(AppContext& ctx)
   timer.start();
   tempSongLib.clear();
 
-  helpers::fs::dirWalkProcessAll(ctx.m_musicDir, ctx.m_tagLibParser, tempSongLib);
+  helpers::fs::dirWalkProcessAll(ctx.m_musicDir, ctx.m_tagLibParser, tempSongLib, scanOptions,
+                                 &report);
 
   tempSongLib.setMusicPath(ctx.m_musicDir);
+  ctx.m_libraryWriter.setFailedFiles(tempSongLib.moveFailedFiles());
   g_songMap.replace(tempSongLib.moveSongMap());
   // the fresh song map is unordered so lets sort it
   //
@@ -588,15 +694,23 @@ void buildOrLoadLibrary(AppContext& ctx)
   //
   // We can change this sort logic via config.toml
   // (check out examples/config/config.toml for more!)
+  helpers::fs::StageTimer sortTimer;
+  sortTimer.start();
   const auto plan = config::sort::loadRuntimeSortPlan();
   query::songmap::mut::sortSongMap(g_songMap, plan);
+  const auto columns = query::songmap::columns(g_songMap);
+  report.sortMs      = sortTimer.elapsed_ms();
 
-  // now let us save the newly sorted song map to disk
-  tempSongLib.newSongMap(g_songMap.snapshot());
-  tempSongLib.saveToFile(ctx.m_binPath);
+  // now let us save the newly sorted song map (and its order) to disk, in the background:
+  // the frontend only needs g_songMap, so it comes up while the cache is still being written
+  ctx.m_libraryWriter.request(ctx.m_binPath, columns, ctx.m_musicDir);
 
   // SongLibrarySnapshot has destructor so mem shud clear here
   LOG_INFO("Library rebuilt in {:.3f} ms", timer.elapsed_ms());
+
+  // save is still running at this point, --scan-report waits for it and fills saveMs
+  report.totalMs = totalTimer.elapsed_ms();
+  LOG_INFO("Scan report: {}", report.toJson());
 }
 
 void runFrontend(AppContext& ctx)
@@ -661,6 +775,33 @@ void runFrontend(AppContext& ctx)
 
     LOG_INFO("---- Frontend Plugin Loaded ----");
 
+    // ---------------------------------------------------------
+    // Watch the library for changes while the frontend runs
+    // ---------------------------------------------------------
+    core::LibraryWatcher libraryWatcher(
+      ctx.m_musicDir, g_songMap, ctx.m_tagLibParser, loadScanOptions(),
+      config::Config::getInt("library", "watch_settle_ms", 300),
+      [&ctx](const FailedFiles& failed) -> void
+      {
+        ctx.m_libraryWriter.setFailedFiles(failed);
+        ctx.m_libraryWriter.request(ctx.m_binPath, query::songmap::columns(g_songMap),
+                                    ctx.m_musicDir);
+      });
+    libraryWatcher.setFailedFiles(ctx.m_libraryWriter.failedFiles());
+
+    if (config::Config::getBool("library", "watch", true))
+    {
+      try
+      {
+        libraryWatcher.start();
+      }
+      catch (const std::exception& e)
+      {
+        LOG_WARN("Library watcher unavailable, changes are picked up on next launch: {}",
+                 e.what());
+      }
+    }
+
     // ---------------------------------------------------------
     // Initialize backend
     // ---------------------------------------------------------
@@ -689,6 +830,7 @@ void runFrontend(AppContext& ctx)
     // ---------------------------------------------------------
     // Clean shutdown
     // ---------------------------------------------------------
+    libraryWatcher.stop();
     audio.shutdown();
     ui.destroy();
 
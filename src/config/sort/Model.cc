@@ -11,11 +11,16 @@ auto loadRuntimeSortPlan() -> query::sort::RuntimeSortPlan
 
   query::sort::RuntimeSortPlan plan;
 
-  plan.artist = loadMetricOrFallback("sort", "artist", "lex_asc", DefaultArtistMetric,
-                                     config::sort::parseArtistPlan, "artist");
-
-  plan.album = loadMetricOrFallback("sort", "album", "lex_asc", DefaultAlbumMetric,
-                                    config::sort::parseAlbumPlan, "album");
+  // artists and albums take a chain of metrics, the first one sorts and the rest break ties
+  auto artist = loadMetricChainOrFallback("sort", "artist", "lex_asc", DefaultArtistMetric,
+                                          config::sort::parseArtistPlan, "artist");
+  plan.artist = artist.front();
+  plan.artistThen.assign(artist.begin() + 1, artist.end());
+
+  auto album = loadMetricChainOrFallback("sort", "album", "lex_asc", DefaultAlbumMetric,
+                                         config::sort::parseAlbumPlan, "album");
+  plan.album = album.front();
+  plan.albumThen.assign(album.begin() + 1, album.end());
 
   plan.disc = loadMetricOrFallback("sort", "disc", "disc_asc", DefaultDiscMetric,
                                    config::sort::parseDiscPlan, "disc");
@@ -12,7 +12,7 @@ using namespace query::sort::metric;
 
 static const ankerl::unordered_dense::map<std::string_view, ArtistMetric> ARTIST_MAP = {
 
-#define X(name, str, tag) {str, ArtistMetric::name},
+#define X(name, str, key, dir) {str, ArtistMetric::name},
 #include "defs/config/ArtistMetrics.def"
 #undef X
 
@@ -20,7 +20,7 @@ static const ankerl::unordered_dense::map<std::string_view, ArtistMetric> ARTIST
 
 static const ankerl::unordered_dense::map<std::string_view, AlbumMetric> ALBUM_MAP = {
 
-#define X(name, str, tag) {str, AlbumMetric::name},
+#define X(name, str, key, dir) {str, AlbumMetric::name},
 #include "defs/config/AlbumMetrics.def"
 #undef X
 
@@ -28,7 +28,7 @@ static const ankerl::unordered_dense::map<std::string_view, AlbumMetric> ALBUM_M
 
 static const ankerl::unordered_dense::map<std::string_view, TrackMetric> TRACK_MAP = {
 
-#define X(name, str, tag) {str, TrackMetric::name},
+#define X(name, str, key, dir) {str, TrackMetric::name},
 #include "defs/config/TrackMetrics.def"
 #undef X
 
@@ -36,7 +36,7 @@ static const ankerl::unordered_dense::map<std::string_view, TrackMetric> TRACK_M
 
 static const ankerl::unordered_dense::map<std::string_view, DiscMetric> DISC_MAP = {
 
-#define X(name, str, tag) {str, DiscMetric::name},
+#define X(name, str, key, dir) {str, DiscMetric::name},
 #include "defs/config/DiscMetrics.def"
 #undef X
 
@@ -0,0 +1,430 @@
+#include "core/ArtPack.hpp"
+#include "Logger.hpp"
+#include "utils/fs/FileUri.hpp"
+#include "utils/fs/Paths.hpp"
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <thread>
+
+namespace core
+{
+
+namespace
+{
+
+constexpr auto align8(ui64 n) noexcept -> ui64 { return (n + 7) & ~ui64{7}; }
+
+// exclusive flock for the duration of an append (other inLimbo processes share the pack)
+struct FileLock
+{
+  int fd;
+
+  explicit FileLock(int f) : fd(f)
+  {
+    while (::flock(fd, LOCK_EX) != 0 && errno == EINTR)
+    {
+    }
+  }
+  ~FileLock() { ::flock(fd, LOCK_UN); }
+
+  FileLock(const FileLock&)                    = delete;
+  auto operator=(const FileLock&) -> FileLock& = delete;
+};
+
+auto writeAll(int fd, const char* data, size_t len, ui64 offset) -> bool
+{
+  size_t done = 0;
+  while (done < len)
+  {
+    const ssize_t n = ::pwrite(fd, data + done, len - done, static_cast<off_t>(offset + done));
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return false;
+    done += static_cast<size_t>(n);
+  }
+  return true;
+}
+
+auto readAll(int fd, char* out, size_t len, ui64 offset) -> bool
+{
+  size_t done = 0;
+  while (done < len)
+  {
+    const ssize_t n = ::pread(fd, out + done, len - done, static_cast<off_t>(offset + done));
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return false;
+    done += static_cast<size_t>(n);
+  }
+  return true;
+}
+
+auto imageExtension(std::string_view bytes) -> const char*
+{
+  if (bytes.size() >= 3 && static_cast<unsigned char>(bytes[0]) == 0xFF &&
+      static_cast<unsigned char>(bytes[1]) == 0xD8 && static_cast<unsigned char>(bytes[2]) == 0xFF)
+    return ".jpg";
+  if (bytes.size() >= 8 && std::memcmp(bytes.data(), "\x89PNG\r\n\x1a\n", 8) == 0)
+    return ".png";
+  return ".img";
+}
+
+auto toHex(ArtId id) -> std::string
+{
+  char buf[16];
+  for (int i = 15; i >= 0; --i, id >>= 4)
+    buf[i] = "0123456789abcdef"[id & 0xF];
+  return {buf, sizeof(buf)};
+}
+
+} // namespace
+
+ArtPack::ArtPack(std::filesystem::path file) : m_file(std::move(file)) { open(); }
+
+ArtPack::~ArtPack()
+{
+  if (m_fd >= 0)
+    ::close(m_fd);
+}
+
+auto ArtPack::global() -> ArtPack&
+{
+  static ArtPack pack(utils::fs::getAppCachePathWithFile("art.pack"));
+  return pack;
+}
+
+// MurmurHash3 style mixing over 8 byte words, only used to tell pictures apart (the size is
+// compared as well), not for anything that has to resist crafted input
+auto ArtPack::hashBytes(std::string_view bytes) noexcept -> ui64
+{
+  constexpr ui64 C1 = 0x87c37b91114253d5ULL;
+  constexpr ui64 C2 = 0x4cf5ad432745937fULL;
+
+  const auto rotl = [](ui64 x, int r) -> ui64 { return (x << r) | (x >> (64 - r)); };
+
+  ui64        h = 0x9e3779b97f4a7c15ULL ^ (bytes.size() * C1);
+  const char* p = bytes.data();
+  size_t      n = bytes.size();
+
+  for (; n >= 8; p += 8, n -= 8)
+  {
+    ui64 w;
+    std::memcpy(&w, p, 8);
+    w *= C1;
+    w = rotl(w, 31);
+    w *= C2;
+    h ^= w;
+    h = rotl(h, 27) * 5 + 0x52dce729;
+  }
+
+  ui64 tail = 0;
+  std::memcpy(&tail, p, n);
+  h ^= rotl(tail * C1, 31) * C2;
+
+  // fmix64
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+void ArtPack::open()
+{
+  std::error_code ec;
+  std::filesystem::create_directories(m_file.parent_path(), ec);
+
+  m_fd = ::open(m_file.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  if (m_fd < 0)
+  {
+    LOG_WARN("ArtPack: Unable to open '{}', album art will not be cached", m_file.string());
+    return;
+  }
+
+  FileLock lock(m_fd);
+
+  PackHeader header{};
+  struct stat st{};
+
+  const bool valid =
+    ::fstat(m_fd, &st) == 0 && st.st_size >= static_cast<off_t>(sizeof(header)) &&
+    readAll(m_fd, reinterpret_cast<char*>(&header), sizeof(header), 0) &&
+    std::memcmp(header.magic, INLIMBO_ART_PACK_MAGIC, 8) == 0 &&
+    header.version == INLIMBO_ART_PACK_VERSION && header.headerSize == sizeof(PackHeader);
+
+  if (!valid)
+  {
+    if (st.st_size > 0)
+      LOG_WARN("ArtPack: '{}' is not a version {} art pack, starting a new one", m_file.string(),
+               INLIMBO_ART_PACK_VERSION);
+
+    header = {};
+    std::memcpy(header.magic, INLIMBO_ART_PACK_MAGIC, 8);
+    header.version    = INLIMBO_ART_PACK_VERSION;
+    header.headerSize = sizeof(PackHeader);
+
+    if (::ftruncate(m_fd, 0) != 0 ||
+        !writeAll(m_fd, reinterpret_cast<const char*>(&header), sizeof(header), 0))
+    {
+      LOG_WARN("ArtPack: Unable to initialize '{}', album art will not be cached",
+               m_file.string());
+      ::close(m_fd);
+      m_fd = -1;
+      return;
+    }
+  }
+
+  m_end = align8(sizeof(PackHeader));
+  indexFrom(m_end);
+
+  LOG_DEBUG("ArtPack: Opened '{}': {} picture(s), {} song link(s)", m_file.string(), m_arts.size(),
+            m_links.size());
+}
+
+void ArtPack::indexFrom(ui64 offset)
+{
+  struct stat st{};
+  if (::fstat(m_fd, &st) != 0 || static_cast<ui64>(st.st_size) <= offset)
+    return;
+
+  const auto size = static_cast<ui64>(st.st_size);
+
+  void* map = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, m_fd, 0);
+  if (map == MAP_FAILED)
+    return;
+
+  const auto* base = static_cast<const unsigned char*>(map);
+  ui64        pos  = offset;
+
+  while (pos + sizeof(RecordHeader) <= size)
+  {
+    RecordHeader rec;
+    std::memcpy(&rec, base + pos, sizeof(rec));
+
+    const ui64 payload = pos + sizeof(RecordHeader);
+    const ui64 next    = align8(payload + rec.size);
+    if (next > size)
+      break; // torn tail
+
+    if (rec.type == static_cast<ui32>(RecordType::Art))
+      m_arts.try_emplace(rec.key, ArtEntry{.offset = payload, .size = rec.size});
+    else if (rec.type == static_cast<ui32>(RecordType::Link) && rec.size == sizeof(LinkPayload))
+    {
+      LinkPayload link;
+      std::memcpy(&link, base + payload, sizeof(link));
+      m_links[rec.key] = link;
+    }
+    else
+      break; // garbage, everything from here on is dropped by the next append
+
+    pos = next;
+  }
+
+  m_end = pos;
+  ::munmap(map, size);
+}
+
+auto ArtPack::append(RecordType type, ui64 key, std::string_view payload) -> std::optional<ui64>
+{
+  const RecordHeader rec{.type = static_cast<ui32>(type),
+                         .size = static_cast<ui32>(payload.size()),
+                         .key  = key};
+
+  std::string buf;
+  buf.reserve(align8(sizeof(rec) + payload.size()));
+  buf.append(reinterpret_cast<const char*>(&rec), sizeof(rec));
+  buf.append(payload);
+  buf.resize(align8(buf.size()), '\0');
+
+  // a torn record left by a crash sits past m_end, overwrite it
+  if (!writeAll(m_fd, buf.data(), buf.size(), m_end) ||
+      ::ftruncate(m_fd, static_cast<off_t>(m_end + buf.size())) != 0)
+  {
+    LOG_WARN("ArtPack: Failed to append to '{}'", m_file.string());
+    return std::nullopt;
+  }
+
+  const ui64 payloadOffset = m_end + sizeof(rec);
+  m_end += buf.size();
+  return payloadOffset;
+}
+
+auto ArtPack::lookup(std::string_view songPath, std::optional<ui64> pictureSize)
+  -> std::optional<ArtId>
+{
+  const ui64 key = hashBytes(songPath);
+
+  std::lock_guard<std::mutex> lk(m_mtx);
+
+  auto it = m_links.find(key);
+  if (it == m_links.end() || (pictureSize && it->second.pictureSize != *pictureSize))
+    return std::nullopt;
+
+  if (!m_arts.contains(it->second.art))
+    return std::nullopt;
+
+  return it->second.art;
+}
+
+auto ArtPack::put(std::string_view songPath, std::string_view picture) -> std::optional<ArtId>
+{
+  if (picture.empty() || picture.size() > UINT32_MAX)
+    return std::nullopt;
+
+  const ui64 hash = hashBytes(picture);
+  const ui64 key  = hashBytes(songPath);
+  const ui64 size = picture.size();
+
+  std::lock_guard<std::mutex> lk(m_mtx);
+
+  if (m_fd < 0)
+    return std::nullopt;
+
+  const auto resolve = [&]() -> std::pair<ArtId, bool>
+  {
+    // two different pictures with the same hash get consecutive ids
+    ArtId id = hash;
+    for (auto it = m_arts.find(id); it != m_arts.end(); it = m_arts.find(++id))
+      if (it->second.size == size)
+        return {id, true};
+    return {id, false};
+  };
+
+  const auto linked = [&](ArtId id) -> bool
+  {
+    auto it = m_links.find(key);
+    return it != m_links.end() && it->second.art == id && it->second.pictureSize == size;
+  };
+
+  // common case (same song, same picture as the last scan), no flock and no I/O
+  if (auto [id, found] = resolve(); found && linked(id))
+    return id;
+
+  FileLock lock(m_fd);
+  indexFrom(m_end); // whatever other processes appended since
+
+  auto [id, found] = resolve();
+
+  if (!found)
+  {
+    const auto offset = append(RecordType::Art, id, picture);
+    if (!offset)
+      return std::nullopt;
+    m_arts.emplace(id, ArtEntry{.offset = *offset, .size = size});
+  }
+
+  if (!linked(id))
+  {
+    const LinkPayload link{.art = id, .pictureSize = size};
+    if (append(RecordType::Link, key, {reinterpret_cast<const char*>(&link), sizeof(link)}))
+      m_links[key] = link;
+  }
+
+  return id;
+}
+
+auto ArtPack::read(ArtId id) -> std::optional<std::string>
+{
+  ArtEntry entry{};
+  {
+    std::lock_guard<std::mutex> lk(m_mtx);
+    auto                        it = m_arts.find(id);
+    if (m_fd < 0 || it == m_arts.end())
+      return std::nullopt;
+    entry = it->second;
+  }
+
+  std::string out(entry.size, '\0');
+  if (!readAll(m_fd, out.data(), out.size(), entry.offset))
+    return std::nullopt;
+
+  return out;
+}
+
+auto ArtPack::exportFile(ArtId id) -> std::filesystem::path
+{
+  const auto dir = utils::fs::getAppCacheArtPath();
+
+  for (const char* ext : {".jpg", ".png", ".img"})
+    if (auto path = dir / (toHex(id) + ext); std::filesystem::exists(path))
+      return path;
+
+  const auto bytes = read(id);
+  if (!bytes)
+    return {};
+
+  std::error_code ec;
+  std::filesystem::create_directories(dir, ec);
+
+  const auto path = dir / (toHex(id) + imageExtension(*bytes));
+  auto       tmp  = path;
+  tmp += ".tmp" + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+
+  {
+    std::ofstream out(tmp, std::ios::binary);
+    out.write(bytes->data(), static_cast<std::streamsize>(bytes->size()));
+    if (!out)
+      return {};
+  }
+
+  std::filesystem::rename(tmp, path, ec);
+  if (ec)
+  {
+    std::filesystem::remove(tmp, ec);
+    return {};
+  }
+
+  return path;
+}
+
+auto ArtPack::artCount() -> size_t
+{
+  std::lock_guard<std::mutex> lk(m_mtx);
+  return m_arts.size();
+}
+
+auto ArtPack::linkCount() -> size_t
+{
+  std::lock_guard<std::mutex> lk(m_mtx);
+  return m_links.size();
+}
+
+auto ArtPack::toUri(ArtId id) -> PathStr { return INLIMBO_ART_URI_SCHEME + toHex(id); }
+
+auto ArtPack::fromUri(std::string_view uri) -> std::optional<ArtId>
+{
+  constexpr std::string_view scheme = INLIMBO_ART_URI_SCHEME;
+  if (!uri.starts_with(scheme))
+    return std::nullopt;
+
+  uri.remove_prefix(scheme.size());
+
+  ArtId      id  = 0;
+  const auto res = std::from_chars(uri.data(), uri.data() + uri.size(), id, 16);
+  if (res.ec != std::errc{} || res.ptr != uri.data() + uri.size())
+    return std::nullopt;
+
+  return id;
+}
+
+auto ArtPack::resolveFile(std::string_view artUrl) -> PathStr
+{
+  if (auto id = fromUri(artUrl))
+    return global().exportFile(*id).string();
+
+  // caches written before the pack point straight at a file
+  return utils::fs::fromAbsFilePathUri(std::string(artUrl)).c_str();
+}
+
+} // namespace core
@@ -0,0 +1,577 @@
+#include "core/LibraryCache.hpp"
+#include "Logger.hpp"
+#include "StackTrace.hpp"
+#include "query/Columns.hpp"
+
+#include <array>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace core
+{
+
+namespace
+{
+
+constexpr auto align8(ui64 v) noexcept -> ui64 { return (v + 7) & ~ui64{7}; }
+
+// deduplicating string pool. The index only holds (offset, size) refs and hashes them through
+// the pool itself, so the strings written may be temporaries (details peeked off a song).
+class PoolWriter
+{
+public:
+  PoolWriter() : m_index(0, RefHash{&m_pool}, RefEq{&m_pool}) {}
+
+  PoolWriter(const PoolWriter&)                    = delete;
+  auto operator=(const PoolWriter&) -> PoolWriter& = delete;
+
+  auto intern(std::string_view s) -> StrRef
+  {
+    if (auto it = m_index.find(s); it != m_index.end())
+      return *it;
+
+    if (m_pool.size() + s.size() > std::numeric_limits<ui32>::max())
+      throw std::runtime_error("LibraryCache::write: String pool exceeds 4 GiB.");
+
+    const StrRef ref{.offset = static_cast<ui32>(m_pool.size()),
+                     .size   = static_cast<ui32>(s.size())};
+    m_pool.append(s);
+    m_index.insert(ref);
+    return ref;
+  }
+
+  [[nodiscard]] auto data() const noexcept -> const std::string& { return m_pool; }
+
+private:
+  static auto view(const std::string* pool, StrRef ref) noexcept -> std::string_view
+  {
+    return {pool->data() + ref.offset, ref.size};
+  }
+
+  struct RefHash
+  {
+    using is_transparent = void;
+    using is_avalanching = void;
+
+    const std::string* pool;
+
+    auto operator()(std::string_view s) const noexcept -> ui64
+    {
+      return ankerl::unordered_dense::hash<std::string_view>{}(s);
+    }
+    auto operator()(StrRef ref) const noexcept -> ui64 { return (*this)(view(pool, ref)); }
+  };
+
+  struct RefEq
+  {
+    using is_transparent = void;
+
+    const std::string* pool;
+
+    auto operator()(StrRef a, StrRef b) const noexcept -> bool
+    {
+      return view(pool, a) == view(pool, b);
+    }
+    auto operator()(std::string_view a, StrRef b) const noexcept -> bool
+    {
+      return a == view(pool, b);
+    }
+    auto operator()(StrRef a, std::string_view b) const noexcept -> bool
+    {
+      return view(pool, a) == b;
+    }
+  };
+
+  std::string                                           m_pool; // before m_index
+  ankerl::unordered_dense::set<StrRef, RefHash, RefEq> m_index;
+};
+
+void writeAll(int fd, const void* data, size_t bytes)
+{
+  const auto* p = static_cast<const char*>(data);
+
+  while (bytes > 0)
+  {
+    const ssize_t n = ::write(fd, p, bytes);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      throw std::runtime_error("LibraryCache::write: Failed to write library cache.");
+    p += n;
+    bytes -= static_cast<size_t>(n);
+  }
+}
+
+void writeSection(int fd, ui64& pos, const void* data, size_t bytes)
+{
+  static constexpr char ZEROS[8] = {};
+
+  writeAll(fd, data, bytes);
+  pos += bytes;
+
+  const ui64 padded = align8(pos);
+  writeAll(fd, ZEROS, padded - pos);
+  pos = padded;
+}
+
+using query::songmap::SortOrder;
+
+// the SortOrder arrays, in the order they are saved
+constexpr std::array<std::vector<ui32> SortOrder::*, 11> ORDER_ARRAYS = {
+  &SortOrder::artists,
+  &SortOrder::albums,
+  &SortOrder::discs,
+  &SortOrder::songs,
+  &SortOrder::rank,
+  &SortOrder::artistAlbum,
+  &SortOrder::artistSong,
+  &SortOrder::albumDisc,
+  &SortOrder::albumSong,
+  &SortOrder::discSong,
+  &SortOrder::genreSongs,
+};
+
+auto packOrder(const SortOrder& order) -> std::vector<ui32>
+{
+  size_t words = 0;
+  for (const auto member : ORDER_ARRAYS)
+    words += 1 + (order.*member).size();
+
+  std::vector<ui32> packed;
+  packed.reserve(words);
+
+  for (const auto member : ORDER_ARRAYS)
+  {
+    const auto& array = order.*member;
+    packed.push_back(static_cast<ui32>(array.size()));
+    packed.insert(packed.end(), array.begin(), array.end());
+  }
+
+  return packed;
+}
+
+} // namespace
+
+// ------------------------------------------------------------
+// Writing
+// ------------------------------------------------------------
+void LibraryCache::write(const Path& file, const SongMap& songMap, const Path& musicPath,
+                         const SortOrder* order, const FailedFiles& failed)
+{
+  RECORD_FUNC_TO_BACKTRACE("LibraryCache::write");
+
+  PoolWriter                pool;
+  std::vector<SongRecord>   songs;
+  std::vector<PropRecord>   props;
+  std::vector<AlbumRecord>  albums;
+  std::vector<ArtistRecord> artists;
+
+  const StrRef musicPathRef = pool.intern(musicPath.view());
+
+  for (const auto& [artistName, albumMap] : songMap)
+  {
+    ArtistRecord artist{.name       = pool.intern(artistName),
+                        .firstAlbum = static_cast<ui32>(albums.size()),
+                        .albumCount = 0};
+
+    for (const auto& [albumName, discMap] : albumMap)
+    {
+      AlbumRecord album{.name      = pool.intern(albumName),
+                        .firstSong = static_cast<ui32>(songs.size()),
+                        .songCount = 0};
+
+      for (const auto& [disc, trackMap] : discMap)
+        for (const auto& [track, inodeMap] : trackMap)
+          for (const auto& [inode, song] : inodeMap)
+          {
+            const auto& md = song->metadata;
+            // details not loaded yet are read straight from the old cache, without keeping them
+            const auto details = md.details.peek();
+
+            SongRecord rec{};
+            rec.inode        = static_cast<ui64>(inode);
+            rec.stampDev     = song->stamp.dev;
+            rec.stampInode   = song->stamp.inode;
+            rec.stampMtimeNs = song->stamp.mtimeNs;
+            rec.stampSize    = song->stamp.size;
+            rec.title        = pool.intern(md.title);
+            rec.artist       = pool.intern(md.artist);
+            rec.album        = pool.intern(md.album);
+            rec.genre        = pool.intern(md.genre);
+            rec.comment      = pool.intern(details->comment);
+            rec.lyrics       = pool.intern(details->lyrics);
+            rec.filePath     = pool.intern(md.filePath);
+            rec.artUrl       = pool.intern(details->artUrl);
+            rec.year         = md.year;
+            rec.track        = md.track;
+            rec.trackTotal   = md.trackTotal;
+            rec.discNumber   = md.discNumber;
+            rec.discTotal    = md.discTotal;
+            rec.bitrate      = md.bitrate;
+            rec.duration     = md.duration;
+            rec.propFirst    = static_cast<ui32>(props.size());
+            rec.propCount    = static_cast<ui32>(details->additionalProperties.size());
+            rec.discKey      = disc;
+            rec.trackKey     = track;
+            rec.reserved     = 0;
+
+            for (const auto& [key, value] : details->additionalProperties)
+              props.push_back({.key = pool.intern(key), .value = pool.intern(value)});
+
+            songs.push_back(rec);
+          }
+
+      album.songCount = static_cast<ui32>(songs.size()) - album.firstSong;
+      albums.push_back(album);
+      ++artist.albumCount;
+    }
+
+    artists.push_back(artist);
+  }
+
+  std::vector<FailedRecord> failedRecs;
+  failedRecs.reserve(failed.size());
+  for (const auto& [path, stamp] : failed)
+    failedRecs.push_back({.path         = pool.intern(path.view()),
+                          .stampDev     = stamp.dev,
+                          .stampInode   = stamp.inode,
+                          .stampMtimeNs = stamp.mtimeNs,
+                          .stampSize    = stamp.size});
+
+  CacheHeader header{};
+  std::memcpy(header.magic, INLIMBO_LIBRARY_CACHE_MAGIC, sizeof(INLIMBO_LIBRARY_CACHE_MAGIC));
+  header.version    = INLIMBO_LIBRARY_CACHE_VERSION;
+  header.headerSize = sizeof(CacheHeader);
+  header.musicPath  = musicPathRef;
+
+  ui64 pos = align8(sizeof(CacheHeader));
+
+  auto place = [&](Section& s, ui64 count, size_t elemSize) -> void
+  {
+    s.offset = pos;
+    s.count  = count;
+    pos      = align8(pos + count * elemSize);
+  };
+
+  place(header.strings, pool.data().size(), 1);
+  place(header.songs, songs.size(), sizeof(SongRecord));
+  place(header.props, props.size(), sizeof(PropRecord));
+  place(header.albums, albums.size(), sizeof(AlbumRecord));
+  place(header.artists, artists.size(), sizeof(ArtistRecord));
+
+  const auto orderWords = order ? packOrder(*order) : std::vector<ui32>{};
+  place(header.order, orderWords.size(), sizeof(ui32));
+  header.sortPlanHash = order ? order->planHash : 0;
+
+  place(header.failed, failedRecs.size(), sizeof(FailedRecord));
+
+  header.fileSize = pos;
+
+  // written next to the target and renamed over it once it is on disk: readers (and a crash
+  // halfway through) only ever see the old or the new cache, never a torn one
+  const std::string tmp = std::string(file.c_str()) + ".tmp." + std::to_string(::getpid());
+
+  const int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0)
+    throw std::runtime_error("LibraryCache::write: Failed to open file for saving.");
+
+  try
+  {
+    ui64 written = 0;
+    writeSection(fd, written, &header, sizeof(header));
+    writeSection(fd, written, pool.data().data(), pool.data().size());
+    writeSection(fd, written, songs.data(), songs.size() * sizeof(SongRecord));
+    writeSection(fd, written, props.data(), props.size() * sizeof(PropRecord));
+    writeSection(fd, written, albums.data(), albums.size() * sizeof(AlbumRecord));
+    writeSection(fd, written, artists.data(), artists.size() * sizeof(ArtistRecord));
+    writeSection(fd, written, orderWords.data(), orderWords.size() * sizeof(ui32));
+    writeSection(fd, written, failedRecs.data(), failedRecs.size() * sizeof(FailedRecord));
+
+    if (written != header.fileSize || ::fsync(fd) != 0)
+      throw std::runtime_error("LibraryCache::write: Failed to write library cache.");
+  }
+  catch (...)
+  {
+    ::close(fd);
+    ::unlink(tmp.c_str());
+    throw;
+  }
+
+  ::close(fd);
+
+  if (::rename(tmp.c_str(), file.c_str()) != 0)
+  {
+    ::unlink(tmp.c_str());
+    throw std::runtime_error("LibraryCache::write: Failed to move library cache into place.");
+  }
+
+  // make the rename itself durable
+  const auto dir   = std::filesystem::path(file.c_str()).parent_path();
+  const int  dirFd = ::open(dir.empty() ? "." : dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (dirFd >= 0)
+  {
+    ::fsync(dirFd);
+    ::close(dirFd);
+  }
+
+  LOG_DEBUG("LibraryCache::write: {} song(s), {} album(s), {} artist(s), {} failed file(s), {} "
+            "byte string pool",
+            songs.size(), albums.size(), artists.size(), failedRecs.size(), pool.data().size());
+}
+
+// ------------------------------------------------------------
+// Reading
+// ------------------------------------------------------------
+LibraryCache::LibraryCache(const Path& file)
+{
+  RECORD_FUNC_TO_BACKTRACE("LibraryCache::LibraryCache");
+
+  const int fd = ::open(file.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    throw std::runtime_error("LibraryCache: Failed to open file for loading.");
+
+  struct stat st{};
+  if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(CacheHeader))
+  {
+    ::close(fd);
+    throw std::runtime_error("LibraryCache: File is too small to be a library cache.");
+  }
+
+  m_size = static_cast<size_t>(st.st_size);
+
+  void* base = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+
+  if (base == MAP_FAILED)
+    throw std::runtime_error("LibraryCache: mmap failed.");
+
+  m_base   = static_cast<const char*>(base);
+  m_header = reinterpret_cast<const CacheHeader*>(m_base);
+
+  auto fail = [&](const char* why) -> void
+  {
+    ::munmap(const_cast<char*>(m_base), m_size);
+    m_base = nullptr;
+    throw std::runtime_error(std::string("LibraryCache: ") + why);
+  };
+
+  if (std::memcmp(m_header->magic, INLIMBO_LIBRARY_CACHE_MAGIC,
+                  sizeof(INLIMBO_LIBRARY_CACHE_MAGIC)) != 0)
+    fail("Not a library cache (bad magic).");
+
+  if (m_header->version != INLIMBO_LIBRARY_CACHE_VERSION ||
+      m_header->headerSize != sizeof(CacheHeader))
+    fail("Unsupported library cache version.");
+
+  if (m_header->fileSize != m_size)
+    fail("Truncated library cache.");
+
+  auto inBounds = [&](const Section& s, size_t elemSize) -> bool
+  {
+    return s.offset % 8 == 0 && s.offset <= m_size && s.count <= (m_size - s.offset) / elemSize;
+  };
+
+  if (!inBounds(m_header->strings, 1) || !inBounds(m_header->songs, sizeof(SongRecord)) ||
+      !inBounds(m_header->props, sizeof(PropRecord)) ||
+      !inBounds(m_header->albums, sizeof(AlbumRecord)) ||
+      !inBounds(m_header->artists, sizeof(ArtistRecord)) ||
+      !inBounds(m_header->order, sizeof(ui32)) ||
+      !inBounds(m_header->failed, sizeof(FailedRecord)))
+    fail("Corrupt section table.");
+}
+
+LibraryCache::~LibraryCache()
+{
+  if (m_base)
+    ::munmap(const_cast<char*>(m_base), m_size);
+}
+
+// out of range references (corruption) read as empty instead of faulting
+auto LibraryCache::str(StrRef ref) const noexcept -> std::string_view
+{
+  const auto& pool = m_header->strings;
+  if (static_cast<ui64>(ref.offset) + ref.size > pool.count)
+    return {};
+  return {m_base + pool.offset + ref.offset, ref.size};
+}
+
+auto LibraryCache::musicPath() const noexcept -> std::string_view
+{
+  return str(m_header->musicPath);
+}
+
+auto LibraryCache::songs() const noexcept -> std::span<const SongRecord>
+{
+  return section<SongRecord>(m_header->songs);
+}
+
+auto LibraryCache::artists() const noexcept -> std::span<const ArtistRecord>
+{
+  return section<ArtistRecord>(m_header->artists);
+}
+
+auto LibraryCache::albums(const ArtistRecord& artist) const noexcept
+  -> std::span<const AlbumRecord>
+{
+  const auto all = section<AlbumRecord>(m_header->albums);
+  if (static_cast<ui64>(artist.firstAlbum) + artist.albumCount > all.size())
+    return {};
+  return all.subspan(artist.firstAlbum, artist.albumCount);
+}
+
+auto LibraryCache::songs(const AlbumRecord& album) const noexcept -> std::span<const SongRecord>
+{
+  const auto all = songs();
+  if (static_cast<ui64>(album.firstSong) + album.songCount > all.size())
+    return {};
+  return all.subspan(album.firstSong, album.songCount);
+}
+
+auto LibraryCache::props(const SongRecord& song) const noexcept -> std::span<const PropRecord>
+{
+  const auto all = section<PropRecord>(m_header->props);
+  if (static_cast<ui64>(song.propFirst) + song.propCount > all.size())
+    return {};
+  return all.subspan(song.propFirst, song.propCount);
+}
+
+// only the framing is checked here, whether the arrays fit the columns is up to
+// query::songmap::adoptLibraryCache
+auto LibraryCache::sortOrder() const -> std::shared_ptr<const SortOrder>
+{
+  RECORD_FUNC_TO_BACKTRACE("LibraryCache::sortOrder");
+
+  const auto words = section<ui32>(m_header->order);
+  if (m_header->sortPlanHash == 0 || words.empty())
+    return nullptr;
+
+  auto order      = std::make_shared<SortOrder>();
+  order->planHash = m_header->sortPlanHash;
+
+  size_t at = 0;
+  for (const auto member : ORDER_ARRAYS)
+  {
+    if (at >= words.size() || words[at] > words.size() - at - 1)
+      return nullptr;
+
+    const auto count = words[at++];
+    (*order).*member = std::vector<ui32>(words.begin() + static_cast<std::ptrdiff_t>(at),
+                                         words.begin() + static_cast<std::ptrdiff_t>(at + count));
+    at += count;
+  }
+
+  if (at != words.size())
+    return nullptr;
+
+  return order;
+}
+
+auto LibraryCache::failedFiles() const -> FailedFiles
+{
+  const auto recs = section<FailedRecord>(m_header->failed);
+
+  FailedFiles failed;
+  failed.reserve(recs.size());
+  for (const auto& rec : recs)
+    failed.push_back({.path  = Path(str(rec.path)),
+                      .stamp = {.dev     = rec.stampDev,
+                                .inode   = rec.stampInode,
+                                .mtimeNs = rec.stampMtimeNs,
+                                .size    = rec.stampSize}});
+
+  return failed;
+}
+
+// ------------------------------------------------------------
+// Materialization
+// ------------------------------------------------------------
+auto LibraryCache::materialize(const SongRecord& rec) const -> std::shared_ptr<Song>
+{
+  auto song = std::make_shared<Song>(static_cast<ino_t>(rec.inode));
+
+  song->stamp = {.dev     = rec.stampDev,
+                 .inode   = rec.stampInode,
+                 .mtimeNs = rec.stampMtimeNs,
+                 .size    = rec.stampSize};
+
+  auto& md      = song->metadata;
+  md.title      = str(rec.title);
+  md.artist     = str(rec.artist);
+  md.album      = str(rec.album);
+  md.genre      = str(rec.genre);
+  md.filePath   = str(rec.filePath);
+  md.year       = rec.year;
+  md.track      = rec.track;
+  md.trackTotal = rec.trackTotal;
+  md.discNumber = rec.discNumber;
+  md.discTotal  = rec.discTotal;
+  md.bitrate    = rec.bitrate;
+  md.duration   = rec.duration;
+
+  const auto index = static_cast<ui32>(&rec - songs().data());
+
+  // details stay in the mapping if the songs can keep it alive, otherwise copy them now
+  if (auto self = weak_from_this().lock())
+    md.details.bind(std::move(self), index);
+  else
+    md.details.edit() = loadDetails(index);
+
+  return song;
+}
+
+auto LibraryCache::loadDetails(ui32 index) const -> MetadataDetails
+{
+  const auto all = songs();
+  if (index >= all.size())
+    return {};
+
+  const auto& rec = all[index];
+
+  MetadataDetails details;
+  details.comment = str(rec.comment);
+  details.lyrics  = str(rec.lyrics);
+  details.artUrl  = str(rec.artUrl);
+
+  const auto p = props(rec);
+
+  PropertyBlock::Builder block;
+  block.reserve(p.size());
+  for (const auto& prop : p)
+    block.add(str(prop.key), str(prop.value));
+  details.additionalProperties = block.finish();
+
+  return details;
+}
+
+// rebuilds the nested map group by group: every artist/album key is created once and
+// songs land in the order they were written (the sorted order of the saved map).
+auto LibraryCache::toSongMap() const -> SongMap
+{
+  RECORD_FUNC_TO_BACKTRACE("LibraryCache::toSongMap");
+
+  SongMap map;
+  map.reserve(artists().size());
+
+  for (const auto& artist : artists())
+  {
+    const auto albumRecs = albums(artist);
+    auto&      albumMap  = map[Artist(str(artist.name))];
+    albumMap.reserve(albumRecs.size());
+
+    for (const auto& album : albumRecs)
+    {
+      auto& discMap = albumMap[Album(str(album.name))];
+
+      for (const auto& rec : songs(album))
+        discMap[rec.discKey][rec.trackKey][static_cast<ino_t>(rec.inode)] = materialize(rec);
+    }
+  }
+
+  return map;
+}
+
+} // namespace core
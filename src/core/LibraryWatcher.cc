@@ -0,0 +1,442 @@
+#include "core/LibraryWatcher.hpp"
+#include "Logger.hpp"
+#include "config/sort/Model.hpp"
+#include "core/SongLibrarySnapshot.hpp"
+#include "helpers/fs/Directory.hpp"
+#include "query/SongMap.hpp"
+#include "utils/DirectoryWalker.hpp"
+#include "utils/threads/WorkStealingPool.hpp"
+#include "utils/timer/Timer.hpp"
+
+#include <ankerl/unordered_dense.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iterator>
+#include <stdexcept>
+
+namespace core
+{
+
+namespace
+{
+
+constexpr ui32 DIR_MASK = IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE | IN_DELETE |
+                          IN_DELETE_SELF | IN_ONLYDIR | IN_DONT_FOLLOW;
+
+// an endless stream of events (say a torrent writing into the library) still gets published
+constexpr auto MAX_BURST = std::chrono::seconds(5);
+constexpr int  POLL_MS   = 100;
+
+auto joinPath(std::string_view dir, std::string_view name) -> std::string
+{
+  std::string path;
+  path.reserve(dir.size() + 1 + name.size());
+  path += dir;
+  if (path.empty() || path.back() != '/')
+    path += '/';
+  path += name;
+  return path;
+}
+
+auto isUnder(std::string_view path, std::string_view dir) -> bool
+{
+  return path.size() > dir.size() && path.starts_with(dir) && path[dir.size()] == '/';
+}
+
+auto isAudioFile(const std::string& path) -> bool
+{
+  return taglib::findSource(Path(std::string_view(path)).extension().c_str()) != nullptr;
+}
+
+} // namespace
+
+struct LibraryWatcher::State
+{
+  using Clock = std::chrono::steady_clock;
+
+  int fd = -1;
+
+  ankerl::unordered_dense::map<int, std::string> dirs; // watch descriptor -> directory
+
+  // the burst being collected
+  ankerl::unordered_dense::set<std::string> changed; // (re)parse
+  ankerl::unordered_dense::set<std::string> removed; // drop
+  std::vector<std::string>                  removedDirs;
+  bool                                      resync = false;
+  Clock::time_point                         firstEvent;
+  Clock::time_point                         lastEvent;
+
+  [[nodiscard]] auto pending() const noexcept -> bool
+  {
+    return resync || !changed.empty() || !removed.empty() || !removedDirs.empty();
+  }
+
+  void touch()
+  {
+    const auto now = Clock::now();
+    if (!pending())
+      firstEvent = now;
+    lastEvent = now;
+  }
+
+  void markChanged(std::string path)
+  {
+    if (!isAudioFile(path))
+      return;
+
+    touch();
+    removed.erase(path);
+    changed.insert(std::move(path));
+  }
+
+  void markRemoved(std::string path)
+  {
+    touch();
+    changed.erase(path);
+    removed.insert(std::move(path));
+  }
+
+  void addWatch(const std::string& dir)
+  {
+    const int wd = inotify_add_watch(fd, dir.c_str(), DIR_MASK);
+    if (wd < 0)
+    {
+      LOG_WARN("LibraryWatcher: Unable to watch '{}'", dir);
+      return;
+    }
+
+    dirs[wd] = dir;
+  }
+
+  // watches dir and everything below it, queueFiles is set for directories that appeared
+  // after startup (copied or moved in), their files are not in the library yet
+  void addTree(const std::string& dir, bool queueFiles)
+  {
+    addWatch(dir);
+
+    try
+    {
+      utils::DirectoryWalker walker{Path(std::string_view(dir))};
+      walker.walk(
+        [&](const char* name, const struct stat& st, [[maybe_unused]] int parentFd,
+            std::string_view dirPath) -> void
+        {
+          if (S_ISDIR(st.st_mode))
+            addWatch(joinPath(dirPath, name));
+          else if (queueFiles && S_ISREG(st.st_mode))
+            markChanged(joinPath(dirPath, name));
+        });
+    }
+    catch (const std::exception& e)
+    {
+      // the directory can be gone again by now, its delete events follow
+      LOG_WARN("LibraryWatcher: Unable to walk '{}': {}", dir, e.what());
+    }
+  }
+
+  // the kernel keeps the watches of a moved directory (with stale paths on our side), drop
+  // them, a move inside the library brings them back through IN_MOVED_TO
+  void removeTree(const std::string& dir)
+  {
+    std::vector<int> gone;
+    for (const auto& [wd, path] : dirs)
+      if (path == dir || isUnder(path, dir))
+        gone.push_back(wd);
+
+    for (const auto wd : gone)
+    {
+      inotify_rm_watch(fd, wd);
+      dirs.erase(wd);
+    }
+
+    std::vector<std::string> stale;
+    for (const auto& path : changed)
+      if (isUnder(path, dir))
+        stale.push_back(path);
+    for (const auto& path : stale)
+      changed.erase(path);
+
+    touch();
+    removedDirs.push_back(dir);
+  }
+
+  void handle(const inotify_event& ev)
+  {
+    if (ev.mask & IN_Q_OVERFLOW)
+    {
+      LOG_WARN("LibraryWatcher: inotify queue overflowed, rescanning library");
+      touch();
+      resync = true;
+      return;
+    }
+
+    if (ev.mask & IN_IGNORED)
+    {
+      dirs.erase(ev.wd);
+      return;
+    }
+
+    auto it = dirs.find(ev.wd);
+    if (it == dirs.end())
+      return;
+
+    if (ev.mask & IN_DELETE_SELF)
+      return; // IN_IGNORED follows, the parent reported the delete already
+
+    if (ev.len == 0)
+      return;
+
+    std::string path = joinPath(it->second, ev.name);
+
+    if (ev.mask & IN_ISDIR)
+    {
+      if (ev.mask & (IN_CREATE | IN_MOVED_TO))
+        addTree(path, true);
+      else if (ev.mask & (IN_DELETE | IN_MOVED_FROM))
+        removeTree(path);
+      return;
+    }
+
+    // IN_CREATE alone is a file still being written, IN_CLOSE_WRITE follows
+    if (ev.mask & (IN_CLOSE_WRITE | IN_MOVED_TO))
+      markChanged(std::move(path));
+    else if (ev.mask & (IN_DELETE | IN_MOVED_FROM))
+      markRemoved(std::move(path));
+  }
+
+  void drain()
+  {
+    alignas(inotify_event) char buf[16 * 1024];
+
+    while (true)
+    {
+      const ssize_t n = ::read(fd, buf, sizeof(buf));
+      if (n <= 0)
+        break;
+
+      ssize_t i = 0;
+      while (i < n)
+      {
+        const auto* ev = reinterpret_cast<const inotify_event*>(buf + i);
+        handle(*ev);
+        i += static_cast<ssize_t>(sizeof(inotify_event) + ev->len);
+      }
+    }
+  }
+
+  [[nodiscard]] auto settled(int settleMs) const -> bool
+  {
+    const auto now = Clock::now();
+    return now - lastEvent >= std::chrono::milliseconds(settleMs) || now - firstEvent >= MAX_BURST;
+  }
+
+  void reset()
+  {
+    changed.clear();
+    removed.clear();
+    removedDirs.clear();
+    resync = false;
+  }
+};
+
+LibraryWatcher::LibraryWatcher(const Directory& root, TS_SongMap& songMap,
+                               const taglib::Parser&    tagParser,
+                               helpers::fs::ScanOptions scanOptions, int settleMs,
+                               std::function<void(const FailedFiles&)> onPublish)
+    : m_root(root), m_songMap(songMap), m_tagParser(tagParser), m_scanOptions(scanOptions),
+      m_settleMs(settleMs > 0 ? settleMs : 300), m_onPublish(std::move(onPublish)),
+      m_state(std::make_unique<State>())
+{
+}
+
+LibraryWatcher::~LibraryWatcher() { stop(); }
+
+void LibraryWatcher::start()
+{
+  RECORD_FUNC_TO_BACKTRACE("LibraryWatcher::start");
+
+  if (m_running.load())
+    return;
+
+  m_state->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (m_state->fd < 0)
+    throw std::runtime_error("core::LibraryWatcher: inotify_init1 failed");
+
+  utils::Timer<> timer;
+  timer.start();
+
+  // watches go in BEFORE the thread runs, anything that changes from here on is seen
+  m_state->addTree(std::string(m_root.c_str()), false);
+
+  LOG_INFO("LibraryWatcher: Watching {} directories below '{}' ({:.3f} ms)",
+           m_state->dirs.size(), m_root, timer.elapsed_ms());
+
+  m_running = true;
+  m_thread  = std::thread(&LibraryWatcher::run, this);
+}
+
+void LibraryWatcher::stop()
+{
+  m_running = false;
+
+  if (m_thread.joinable())
+    m_thread.join();
+
+  if (m_state && m_state->fd >= 0)
+  {
+    ::close(m_state->fd); // drops every watch with it
+    m_state->fd = -1;
+    m_state->dirs.clear();
+  }
+}
+
+void LibraryWatcher::run()
+{
+  auto& st = *m_state;
+
+  pollfd pfd{.fd = st.fd, .events = POLLIN, .revents = 0};
+
+  while (m_running.load())
+  {
+    if (::poll(&pfd, 1, POLL_MS) > 0 && (pfd.revents & POLLIN))
+      st.drain();
+
+    if (!st.pending() || !st.settled(m_settleMs))
+      continue;
+
+    try
+    {
+      utils::Timer<> timer;
+      timer.start();
+
+      if (st.resync)
+      {
+        // events were lost, directories created meanwhile have no watch yet (adding one
+        // that exists gives back the same wd)
+        st.addTree(std::string(m_root.c_str()), false);
+
+        // then compare the whole tree against the current map (stat only)
+        core::SongLibrarySnapshot snapshot;
+        snapshot.newSongMap(m_songMap.snapshot());
+        snapshot.setFailedFiles(std::move(m_failedFiles));
+
+        const auto summary =
+          helpers::fs::dirWalkProcessChanged(m_root, m_tagParser, snapshot, m_scanOptions);
+
+        m_failedFiles = snapshot.moveFailedFiles();
+
+        if (summary.changed())
+        {
+          m_songMap.replace(snapshot.moveSongMap());
+          query::songmap::setSortPlan(m_songMap, config::sort::loadRuntimeSortPlan());
+        }
+
+        // a new failure alone is persisted too, so the next startup does not retry it
+        if ((summary.changed() || summary.failed > 0) && m_onPublish)
+          m_onPublish(m_failedFiles);
+
+        LOG_INFO("LibraryWatcher: Resync: {} added, {} updated, {} removed, {} failed ({:.3f} ms)",
+                 summary.added, summary.updated, summary.removed,
+                 summary.failed + summary.knownFailed, timer.elapsed_ms());
+        st.reset();
+        continue;
+      }
+
+      query::songmap::mut::LibraryDelta delta;
+      delta.removedFiles.assign(st.removed.begin(), st.removed.end());
+      delta.removedDirs = std::move(st.removedDirs);
+
+      std::vector<std::string> paths(st.changed.begin(), st.changed.end());
+      std::vector<FailedFiles> failed; // per worker
+      st.reset();
+
+      if (!paths.empty())
+      {
+        const size_t limit =
+          m_scanOptions.threads ? m_scanOptions.threads
+                                : utils::threads::WorkStealingPool::defaultThreadCount();
+        utils::threads::WorkStealingPool pool(std::min(limit, paths.size()));
+
+        std::vector<taglib::Parser>                     parsers(pool.size(), m_tagParser);
+        std::vector<std::vector<std::shared_ptr<Song>>> shards(pool.size());
+        failed.resize(pool.size());
+
+        for (const auto& path : paths)
+        {
+          pool.submit(
+            [&](size_t worker) -> void
+            {
+              struct stat sb{};
+              if (::stat(path.c_str(), &sb) != 0 || !S_ISREG(sb.st_mode))
+                return; // gone again before we got to it
+
+              try
+              {
+                Metadata md;
+                if (!parsers[worker].parseFile(Path(std::string_view(path)), md))
+                {
+                  LOG_WARN("LibraryWatcher: Unable to parse metadata for path: '{}'", path);
+                  failed[worker].push_back(
+                    {.path = Path(std::string_view(path)), .stamp = FileStamp::fromStat(sb)});
+                  return;
+                }
+
+                shards[worker].push_back(
+                  std::make_shared<Song>(sb.st_ino, std::move(md), FileStamp::fromStat(sb)));
+              }
+              catch (const std::exception& e)
+              {
+                LOG_ERROR("LibraryWatcher: Exception while parsing '{}': {}", path, e.what());
+                failed[worker].push_back(
+                  {.path = Path(std::string_view(path)), .stamp = FileStamp::fromStat(sb)});
+              }
+            });
+        }
+
+        pool.wait();
+
+        for (auto& shard : shards)
+          for (auto& song : shard)
+            delta.upserts.push_back(std::move(song));
+
+        // a rewrite that no longer parses must not leave its old version behind
+        delta.removedFiles.insert(delta.removedFiles.end(), paths.begin(), paths.end());
+      }
+
+      // whatever the batch removed or parsed again replaces what was known to fail before
+      if (!m_failedFiles.empty())
+      {
+        const ankerl::unordered_dense::set<std::string_view> touched(delta.removedFiles.begin(),
+                                                                     delta.removedFiles.end());
+        std::erase_if(m_failedFiles, [&](const FailedFile& file) -> bool
+                      { return touched.contains(file.path.view()); });
+      }
+
+      for (auto& shard : failed)
+        std::ranges::move(shard, std::back_inserter(m_failedFiles));
+
+      if (delta.empty())
+        continue;
+
+      const auto dropped = query::songmap::mut::applyLibraryDelta(
+        m_songMap, delta, config::sort::loadRuntimeSortPlan());
+
+      LOG_INFO("LibraryWatcher: Applied batch: {} parsed, {} dropped ({:.3f} ms)",
+               delta.upserts.size(), dropped, timer.elapsed_ms());
+
+      if (m_onPublish)
+        m_onPublish(m_failedFiles);
+    }
+    catch (const std::exception& e)
+    {
+      LOG_ERROR("LibraryWatcher: Failed to apply library changes: {}", e.what());
+      st.reset();
+    }
+  }
+}
+
+} // namespace core
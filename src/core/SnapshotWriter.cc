@@ -0,0 +1,171 @@
+#include "core/SnapshotWriter.hpp"
+#include "Logger.hpp"
+#include "core/LibraryCache.hpp"
+#include "query/Columns.hpp"
+#include "utils/timer/Timer.hpp"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace core
+{
+
+struct SnapshotWriter::State
+{
+  std::mutex              mtx;
+  std::condition_variable cv;     // worker: new request or stop
+  std::condition_variable doneCv; // flush(): a write finished
+  std::thread             worker;
+
+  // the latest request, older pending ones are simply overwritten (coalescing)
+  Path                                             file;
+  Path                                             musicPath;
+  std::shared_ptr<const SongMap>                     pending;
+  std::shared_ptr<const query::songmap::SongColumns> pendingColumns; // stand for pending
+  std::shared_ptr<const query::songmap::SortOrder>   pendingOrder;   // of pending, may be null
+
+  // setFailedFiles(), goes into every write (shared, a write keeps the list it started with)
+  std::shared_ptr<const FailedFiles> failed = std::make_shared<const FailedFiles>();
+
+  ui64   requested   = 0; // generation of the latest request
+  ui64   written     = 0; // generation of the latest finished (or failed) write
+  double lastWriteMs = 0.0;
+  bool   stop        = false;
+
+  void run()
+  {
+    std::unique_lock<std::mutex> lk(mtx);
+
+    while (true)
+    {
+      cv.wait(lk, [&]() -> bool { return stop || pending || pendingColumns; });
+
+      if (!pending && !pendingColumns)
+        return; // stop requested and nothing left to write
+
+      auto       map         = std::move(pending);
+      auto       columns     = std::move(pendingColumns);
+      auto       order       = std::move(pendingOrder);
+      const auto failedFiles = failed;
+      const Path target      = file;
+      const Path music       = musicPath;
+      const ui64 generation  = requested;
+
+      lk.unlock();
+
+      utils::Timer<> timer;
+      timer.start();
+
+      try
+      {
+        // columns of a library cache make their map here, not on the requesting thread
+        if (columns)
+          map = columns->songMap();
+
+        LibraryCache::write(target, *map, music, order.get(), *failedFiles);
+        LOG_DEBUG("SnapshotWriter: Library cache saved in {:.3f} ms", timer.elapsed_ms());
+      }
+      catch (const std::exception& e)
+      {
+        LOG_ERROR("SnapshotWriter: Failed to save library cache: {}", e.what());
+      }
+
+      // drop our reference before reporting, the old map may be the last owner
+      map.reset();
+      columns.reset();
+      order.reset();
+
+      lk.lock();
+      written     = generation;
+      lastWriteMs = timer.elapsed_ms();
+      doneCv.notify_all();
+    }
+  }
+};
+
+SnapshotWriter::SnapshotWriter() : m_state(std::make_unique<State>()) {}
+
+SnapshotWriter::SnapshotWriter(SnapshotWriter&&) noexcept                    = default;
+auto SnapshotWriter::operator=(SnapshotWriter&&) noexcept -> SnapshotWriter& = default;
+
+SnapshotWriter::~SnapshotWriter()
+{
+  if (!m_state)
+    return;
+
+  {
+    std::lock_guard<std::mutex> lk(m_state->mtx);
+    m_state->stop = true;
+  }
+  m_state->cv.notify_one();
+
+  // the worker drains the pending request before it sees stop
+  if (m_state->worker.joinable())
+    m_state->worker.join();
+}
+
+void SnapshotWriter::request(const Path& file, std::shared_ptr<const SongMap> songMap,
+                             const Path& musicPath)
+{
+  enqueue(file, std::move(songMap), nullptr, nullptr, musicPath);
+}
+
+void SnapshotWriter::request(const Path&                                              file,
+                             const std::shared_ptr<const query::songmap::SongColumns>& columns,
+                             const Path&                                              musicPath)
+{
+  enqueue(file, nullptr, columns, columns->order(), musicPath);
+}
+
+void SnapshotWriter::enqueue(const Path& file, std::shared_ptr<const SongMap> songMap,
+                             std::shared_ptr<const query::songmap::SongColumns> columns,
+                             std::shared_ptr<const query::songmap::SortOrder>   order,
+                             const Path&                                        musicPath)
+{
+  {
+    std::lock_guard<std::mutex> lk(m_state->mtx);
+
+    m_state->file           = file;
+    m_state->musicPath      = musicPath;
+    m_state->pending        = std::move(songMap);
+    m_state->pendingColumns = std::move(columns);
+    m_state->pendingOrder   = std::move(order);
+    ++m_state->requested;
+
+    if (!m_state->worker.joinable())
+      m_state->worker = std::thread([state = m_state.get()]() -> void { state->run(); });
+  }
+
+  m_state->cv.notify_one();
+}
+
+void SnapshotWriter::setFailedFiles(FailedFiles failed)
+{
+  auto shared = std::make_shared<const FailedFiles>(std::move(failed));
+
+  std::lock_guard<std::mutex> lk(m_state->mtx);
+  m_state->failed = std::move(shared);
+}
+
+auto SnapshotWriter::failedFiles() const -> FailedFiles
+{
+  std::lock_guard<std::mutex> lk(m_state->mtx);
+  return *m_state->failed;
+}
+
+void SnapshotWriter::flush()
+{
+  std::unique_lock<std::mutex> lk(m_state->mtx);
+
+  const ui64 target = m_state->requested;
+  m_state->doneCv.wait(lk, [&]() -> bool { return m_state->written >= target; });
+}
+
+auto SnapshotWriter::lastWriteMs() const -> double
+{
+  std::lock_guard<std::mutex> lk(m_state->mtx);
+  return m_state->lastWriteMs;
+}
+
+} // namespace core
@@ -1,6 +1,6 @@
 #include "core/SongLibrarySnapshot.hpp"
 #include "Logger.hpp"
-#include <fstream>
+#include "core/LibraryCache.hpp"
 
 namespace core
 {
@@ -9,41 +9,71 @@ namespace core
 // SongLibrarySnapshot Implementations
 // ============================================================
 
-void SongLibrarySnapshot::addSong(const Song& song)
+void SongLibrarySnapshot::addSong(const Song& song) { addSong(std::make_shared<Song>(song)); }
+
+// ------------------------------------------------------------
+void SongLibrarySnapshot::addSong(std::shared_ptr<Song> song)
 {
-  auto& artistMap = m_songMap[song.metadata.artist];
-  auto& albumMap  = artistMap[song.metadata.album];
-  auto& discMap   = albumMap[song.metadata.discNumber];
-  auto& trackMap  = discMap[song.metadata.track];
+  materialize();
+
+  const auto& md    = song->metadata;
+  const ino_t inode = song->inode;
+
+  auto& artistMap = m_songMap[md.artist];
+  auto& albumMap  = artistMap[md.album];
+  auto& discMap   = albumMap[md.discNumber];
+  auto& trackMap  = discMap[md.track];
+
+  LOG_TRACE("Added song '{}' by '{}' [Album: {}, Disc: {}, Track: {}, inode: {}]", md.title,
+            md.artist, md.album, md.discNumber, md.track, inode);
 
   // Insert song by inode
-  trackMap[song.inode] = std::make_shared<Song>(song);
+  trackMap[inode] = std::move(song);
+}
+
+// ------------------------------------------------------------
+void SongLibrarySnapshot::materialize()
+{
+  if (!m_cache)
+    return;
 
-  LOG_TRACE("Added song '{}' by '{}' [Album: {}, Disc: {}, Track: {}, inode: {}]",
-            song.metadata.title, song.metadata.artist, song.metadata.album,
-            song.metadata.discNumber, song.metadata.track, song.inode);
+  m_songMap = m_cache->toSongMap();
+  m_cache.reset();
 }
 
 // ------------------------------------------------------------
-void SongLibrarySnapshot::saveToFile(const utils::string::SmallString& filename) const
+auto SongLibrarySnapshot::returnSongMap() -> const SongMap&
 {
-  std::ofstream file(filename.c_str(), std::ios::binary);
-  if (!file)
-    throw std::runtime_error("SongLibrarySnapshot::saveToFile: Failed to open file for saving.");
+  RECORD_FUNC_TO_BACKTRACE("SongLibrarySnapshot::returnSongMap");
+  materialize();
+  return m_songMap;
+}
 
-  cereal::BinaryOutputArchive archive(file);
-  archive(*this);
+// ------------------------------------------------------------
+auto SongLibrarySnapshot::moveSongMap() -> SongMap
+{
+  RECORD_FUNC_TO_BACKTRACE("SongLibrarySnapshot::moveSongMap");
+  materialize();
+  return std::move(m_songMap);
+}
+
+// ------------------------------------------------------------
+void SongLibrarySnapshot::saveToFile(const utils::string::SmallString& filename) const
+{
+  LibraryCache::write(filename, m_cache ? m_cache->toSongMap() : m_songMap, m_musicPath, nullptr,
+                      m_failedFiles);
 }
 
 // ------------------------------------------------------------
 void SongLibrarySnapshot::loadFromFile(const utils::string::SmallString& filename)
 {
-  std::ifstream file(filename.c_str(), std::ios::binary);
-  if (!file)
-    throw std::runtime_error("SongLibrarySnapshot::loadFromFile: Failed to open file for loading.");
+  // shared, the songs made from it read their details from it on demand and keep it mapped
+  auto cache = std::make_shared<const LibraryCache>(filename);
 
-  cereal::BinaryInputArchive archive(file);
-  archive(*this);
+  m_musicPath   = Path(cache->musicPath());
+  m_songMap.clear();
+  m_failedFiles = cache->failedFiles();
+  m_cache       = std::move(cache);
 }
 
 } // namespace core
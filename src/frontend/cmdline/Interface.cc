@@ -63,8 +63,7 @@ void Interface::loadConfig()
   {
     config::Config::load();
 
-    auto plan = config::sort::loadRuntimeSortPlan();
-    m_songMapTS->update([&](auto& map) -> void { query::sort::applyRuntimeSortPlan(map, plan); });
+    query::songmap::mut::sortSongMap(*m_songMapTS, config::sort::loadRuntimeSortPlan());
 
     config::colors::ConfigLoader   colorsCfg(FRONTEND_NAME);
     config::keybinds::ConfigLoader keysCfg(FRONTEND_NAME);
@@ -187,9 +186,9 @@ void Interface::statusLoop(audio::Service& audio)
     {
       LOG_DEBUG("Configuration file changed, reloading...");
       loadConfig();
-      const auto title = audio.getCurrentMetadata()->title;
+      const auto path = audio.getCurrentMetadata()->filePath;
       audio.clearPlaylist();
-      auto songObj = query::songmap::read::findSongObjByTitle(*m_songMapTS, title);
+      auto songObj = query::songmap::read::findSongObjByPath(*m_songMapTS, path);
       auto h       = audio.registerTrack(songObj);
       audio.addToPlaylist(h);
 
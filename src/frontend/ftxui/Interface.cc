@@ -88,6 +88,8 @@ void Interface::run(audio::Service& audio)
 
   m_threadManager.setOnConfigReload([this]() -> void
                                     { m_needsRebuild.store(true, std::memory_order_release); });
+  m_threadManager.setOnLibraryChange([this]() -> void
+                                     { m_needsRebuild.store(true, std::memory_order_release); });
 
   m_threadManager.start();
 
@@ -253,7 +255,7 @@ auto Interface::renderStatusBarFull() -> Element
            text("  ·  ") | dim,
            text(marquee(meta->album, TITLE_WIDTH, tick)) | color(Color::GreenLight),
            text("  ·  ") | dim,
-           text(meta->genre.empty() ? "Unknown" : meta->genre) | color(Color::MagentaLight),
+           text(meta->genre.empty() ? "Unknown" : meta->genre.str()) | color(Color::MagentaLight),
            text("  "),
            separatorLight(),
            text("  "),
@@ -47,6 +47,11 @@ void ThreadManager::setOnConfigReload(std::function<void()> fn)
   m_onConfigReload = std::move(fn);
 }
 
+void ThreadManager::setOnLibraryChange(std::function<void()> fn)
+{
+  m_onLibraryChange = std::move(fn);
+}
+
 void ThreadManager::loadMiscConfig(MiscConfig& miscCfg)
 {
   config::misc::ConfigLoader loader(FRONTEND_NAME);
@@ -61,8 +66,7 @@ void ThreadManager::loadConfig()
   {
     config::Config::load();
 
-    auto plan = config::sort::loadRuntimeSortPlan();
-    m_songMap->update([&](auto& map) -> void { query::sort::applyRuntimeSortPlan(map, plan); });
+    query::songmap::mut::sortSongMap(*m_songMap, config::sort::loadRuntimeSortPlan());
 
     config::colors::ConfigLoader   colorsCfg(FRONTEND_NAME);
     config::keybinds::ConfigLoader keysCfg(FRONTEND_NAME);
@@ -139,9 +143,9 @@ void ThreadManager::statusLoop()
       if (m_onConfigReload)
         m_onConfigReload();
 
-      const auto title = m_audioPtr->getCurrentMetadata()->title;
+      const auto path = m_audioPtr->getCurrentMetadata()->filePath;
       m_audioPtr->clearPlaylist();
-      auto songObj = query::songmap::read::findSongObjByTitle(*m_songMap, title);
+      auto songObj = query::songmap::read::findSongObjByPath(*m_songMap, path);
       auto h       = m_audioPtr->registerTrack(songObj);
       m_audioPtr->addToPlaylist(h);
 
@@ -160,6 +164,13 @@ void ThreadManager::statusLoop()
         });
     }
 
+    if (const auto version = m_songMap->version(); version != m_libraryVersion)
+    {
+      m_libraryVersion = version;
+      if (m_onLibraryChange)
+        m_onLibraryChange();
+    }
+
     if (auto info = m_audioPtr->getCurrentTrackInfo())
     {
       if ((info->lengthSec > 0 && info->positionSec >= info->lengthSec) ||
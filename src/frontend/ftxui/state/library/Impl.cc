@@ -39,9 +39,13 @@ void LibraryState::rebuild()
     return;
 
   query::songmap::read::forEachArtist(*m_songMapTS,
-                                      [&](const Artist& artist, const AlbumMap&) -> void
+                                      [&](const Artist& artist) -> void
                                       { artists.push_back(artist); });
 
+  // the song map can shrink under us (files removed while running)
+  if (selected_artist >= static_cast<int>(artists.size()))
+    selected_artist = artists.empty() ? 0 : static_cast<int>(artists.size()) - 1;
+
   if (!artists.empty())
     buildAlbumViewForArtist(artists[selected_artist]);
 }
@@ -122,9 +122,9 @@ void NowPlayingState::loadLyrics(const Metadata& meta, int wrap_width, const boo
 
   std::string raw_lyrics;
 
-  if (!meta.lyrics.empty())
+  if (const auto& lyrics = meta.details.get().lyrics; !lyrics.empty())
   {
-    raw_lyrics    = meta.lyrics;
+    raw_lyrics    = lyrics;
     m_source      = LyricsSource::Metadata;
     m_source_info = "Source: Embedded metadata";
   }
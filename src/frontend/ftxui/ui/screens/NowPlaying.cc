@@ -1,5 +1,5 @@
 #include "frontend/ftxui/ui/screens/NowPlaying.hpp"
-#include "utils/fs/FileUri.hpp"
+#include "core/ArtPack.hpp"
 
 using namespace ftxui;
 
@@ -53,10 +53,10 @@ auto NowPlayingScreen::render() -> Element
     m_now.loadLyrics(*meta, wrap_width);
   }
 
-  if (meta->artUrl != last_art_url)
+  if (const auto& artUrl = meta->details.get().artUrl; artUrl != last_art_url)
   {
-    last_art_url = meta->artUrl;
-    m_art.load(utils::fs::fromAbsFilePathUri(meta->artUrl).c_str());
+    last_art_url = artUrl;
+    m_art.load(core::ArtPack::resolveFile(artUrl));
     m_now.loadLyrics(*meta, wrap_width);
   }
 
@@ -1,5 +1,4 @@
 #include "frontend/ftxui/ui/screens/Queue.hpp"
-#include "utils/fs/FileUri.hpp"
 #include "utils/timer/Timer.hpp"
 #include <ftxui/component/event.hpp>
 
@@ -85,16 +84,16 @@ QueueScreen::QueueScreen(state::queue::QueueState& state) : m_state(state)
       rows.push_back(text("Year      : " + std::to_string(m.year)));
       rows.push_back(text("Duration  : " + utils::timer::fmtTime(m.duration)));
       rows.push_back(text("Bitrate   : " + std::to_string(m.bitrate) + " kbps"));
-      rows.push_back(text("HasLyrics : " + yesno(!m.lyrics.empty())));
+      rows.push_back(text("HasLyrics : " + yesno(!m.details.get().lyrics.empty())));
 
       rows.push_back(separator());
 
       rows.push_back(text("File") | bold | color(Color::Cyan));
       rows.push_back(text("Path:") | bold);
       rows.push_back(text(m.filePath) | dim);
-      rows.push_back(text("Cache Art File Path:") | bold);
-      if (!m.artUrl.empty())
-        rows.push_back(text(utils::fs::fromAbsFilePathUri(m.artUrl).c_str()) | dim);
+      rows.push_back(text("Cache Art:") | bold);
+      if (const auto& artUrl = m.details.get().artUrl; !artUrl.empty())
+        rows.push_back(text(artUrl) | dim);
       else
         rows.push_back(text("<none>") | dim);
 
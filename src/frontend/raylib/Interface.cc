@@ -87,6 +87,11 @@ void Interface::statusLoop(audio::Service& audio)
       LOG_DEBUG("Configuration file changed, reloading...");
       loadConfig();
     }
+
+    // a new song map got published (say by the library watcher)
+    if (m_songMap->version() != m_libraryVersion)
+      reloadArtists();
+
     autoNextIfFinished(audio, *m_mpris);
     std::this_thread::sleep_for(std::chrono::milliseconds(100));
   }
@@ -99,11 +104,9 @@ void Interface::loadConfig()
 {
   try
   {
-    m_library.artists.clear();
     config::Config::load();
 
-    auto plan = config::sort::loadRuntimeSortPlan();
-    m_songMap->update([&](auto& map) -> void { query::sort::applyRuntimeSortPlan(map, plan); });
+    query::songmap::mut::sortSongMap(*m_songMap, config::sort::loadRuntimeSortPlan());
 
     colors::ConfigLoader           colorsCfg(FRONTEND_NAME);
     config::keybinds::ConfigLoader keysCfg(FRONTEND_NAME);
@@ -117,9 +120,7 @@ void Interface::loadConfig()
     LOG_INFO("Configuration loaded for {}'s keybinds and colors, and song map sort plans.",
              FRONTEND_NAME);
 
-    query::songmap::read::forEachArtist(*m_songMap,
-                                        [&](const Artist& artist, const AlbumMap&) -> void
-                                        { m_library.artists.push_back(artist); });
+    reloadArtists();
   }
   catch (const std::exception& e)
   {
@@ -127,6 +128,16 @@ void Interface::loadConfig()
   }
 }
 
+void Interface::reloadArtists()
+{
+  m_libraryVersion = m_songMap->version();
+
+  m_library.artists.clear();
+  query::songmap::read::forEachArtist(*m_songMap,
+                                      [&](const Artist& artist) -> void
+                                      { m_library.artists.push_back(artist); });
+}
+
 void Interface::run(audio::Service& audio)
 {
   InitWindow(WIN_W, WIN_H, "InLimbo Player");
@@ -1,5 +1,5 @@
 #include "frontend/raylib/media/AlbumArtCache.hpp"
-#include "utils/fs/FileUri.hpp"
+#include "core/ArtPack.hpp"
 
 namespace frontend::raylib::media
 {
@@ -16,7 +16,9 @@ void AlbumArtCache::clear()
 
 auto AlbumArtCache::get(const Metadata& meta) -> Texture2D*
 {
-  if (meta.artUrl == m_url)
+  const auto& artUrl = meta.details.get().artUrl;
+
+  if (artUrl == m_url)
     return m_loaded ? &m_tex : nullptr;
 
   if (m_loaded)
@@ -26,10 +28,10 @@ auto AlbumArtCache::get(const Metadata& meta) -> Texture2D*
   }
 
   m_url.clear();
-  if (meta.artUrl.empty())
+  if (artUrl.empty())
     return nullptr;
 
-  const auto truePath = utils::fs::fromAbsFilePathUri(meta.artUrl);
+  const auto truePath = core::ArtPack::resolveFile(artUrl);
 
   Image img = LoadImage(truePath.c_str());
   if (!img.data)
@@ -37,7 +39,7 @@ auto AlbumArtCache::get(const Metadata& meta) -> Texture2D*
 
   m_tex    = LoadTextureFromImage(img);
   m_loaded = true;
-  m_url    = meta.artUrl;
+  m_url    = artUrl;
 
   UnloadImage(img);
   return &m_tex;
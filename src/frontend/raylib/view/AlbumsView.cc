@@ -2,9 +2,10 @@
 #include "frontend/raylib/Constants.hpp"
 #include "frontend/raylib/ui/TextUtils.hpp"
 #include "query/SongMap.hpp"
-#include "utils/string/Equals.hpp"
 #include "utils/timer/Timer.hpp"
 
+#include <optional>
+
 namespace frontend::raylib::view
 {
 
@@ -40,35 +41,106 @@ static void drawHoverRow(const Rectangle& r, bool hover)
                        {255, 255, 255, 20});
 }
 
-static auto getContentHeight(TS_SongMap& songs, const Artist& artist) -> float
+// row heights of the album pane, a gap closes every disc and every album
+static constexpr float ALBUM_H   = 36;
+static constexpr float DISC_H    = 18;
+static constexpr float SONG_H    = 22;
+static constexpr float DISC_GAP  = 12;
+static constexpr float ALBUM_GAP = 20;
+static constexpr float TOP_PAD   = 16;
+
+static auto discHeight(const query::songmap::SongColumns::DiscGroup& d) -> float
 {
-  float h = 0.0f;
+  return DISC_H + d.songCount * SONG_H + DISC_GAP;
+}
+
+static auto albumHeight(const query::songmap::SongColumns& c,
+                        const query::songmap::SongColumns::AlbumGroup& al) -> float
+{
+  float h = ALBUM_H + ALBUM_GAP;
+  for (ui32 d = al.firstDisc; d < al.firstDisc + al.discCount; ++d)
+    h += discHeight(c.discs[d]);
+  return h;
+}
 
-  query::songmap::read::forEachAlbum(
-    songs,
-    [&](const Artist& a, const Album&, const DiscMap& discs) -> void
+struct Window
+{
+  size_t firstRow = 0; // cursor offset of the first visible row
+  float  y        = 0; // its top, in content coordinates
+  float  height   = 0; // the whole content
+};
+
+// Finds the first row visible at content height `top`. Walks the album and disc groups
+// only (in the cursor's plan order), never the songs: O(albums + discs) whatever the size
+// of the artist.
+static auto locate(const query::songmap::SongColumns& c, const query::songmap::SortOrder& o,
+                   const Artist& artist, float top) -> Window
+{
+  Window w;
+
+  const auto* a = c.findArtist(artist);
+  if (!a)
+    return w;
+
+  bool found = false;
+
+  for (const ui32 ai : o.albumsOf(c, static_cast<ui32>(a - c.artists.data())))
+  {
+    const auto& al = c.albums[ai];
+    const float h  = albumHeight(c, al);
+
+    if (found || w.height + h <= top)
     {
-      if (!utils::string::isEquals(a, artist))
-        return;
+      if (!found)
+        w.firstRow += query::songmap::Cursor::rows(al);
+      w.height += h;
+      continue;
+    }
+
+    found = true;
+    w.y   = w.height;
 
-      h += 36; // album header
+    // inside this album: its header, or a disc header, or a song of a disc
+    if (w.y + ALBUM_H <= top)
+    {
+      w.y += ALBUM_H;
+      ++w.firstRow;
+
+      const auto discs = o.discsOf(c, ai);
 
-      for (auto& [disc, tracks] : discs)
+      size_t k = 0;
+      for (; k < discs.size(); ++k)
       {
-        h += 18; // disc header
+        const auto& d = c.discs[discs[k]];
 
-        for (auto& [_, inodeMap] : tracks)
+        if (w.y + discHeight(d) <= top)
         {
-          h += inodeMap.size() * 22; // tracks
+          w.y += discHeight(d);
+          w.firstRow += query::songmap::Cursor::rows(d);
+          continue;
         }
 
-        h += 12; // gap after disc
+        if (w.y + DISC_H <= top)
+        {
+          w.y += DISC_H;
+          ++w.firstRow;
+
+          const auto skip = std::min<size_t>(d.songCount - 1, (top - w.y) / SONG_H);
+          w.y += skip * SONG_H;
+          w.firstRow += skip;
+        }
+        break;
       }
 
-      h += 20; // gap after album
-    });
+      // top is in the gap after the last disc, the window starts at the next album
+      if (k == discs.size())
+        w.y += ALBUM_GAP;
+    }
 
-  return h;
+    w.height += h;
+  }
+
+  return w;
 }
 
 static constexpr int RIGHT_X = LEFT_W + 10;
@@ -84,84 +156,113 @@ void AlbumsView::draw(const ui::Fonts& fonts, state::Library& lib, audio::Servic
 
   const Artist& artist = lib.artists[lib.selectedArtist];
 
-  const auto contentHeight = getContentHeight(songs, artist);
+  // one cursor kept across frames, reopened only when a new map was published
+  if (m_cursor.stale(songs))
+    m_cursor = query::songmap::Cursor(songs);
+
+  const auto& c = m_cursor.columns();
+  const auto& o = m_cursor.order();
+
+  // content starts TOP_PAD below the pane, the first row drawn is the one at the pane top
+  auto w = locate(c, o, artist, -lib.albumScrollY - TOP_PAD);
 
   if (CheckCollisionPointRec(mouse, pane))
   {
     lib.albumScrollY += GetMouseWheelMove() * 30;
 
     float viewHeight = pane.height;
-    float minScroll  = std::min(0.0f, viewHeight - contentHeight);
+    float minScroll  = std::min(0.0f, viewHeight - w.height);
 
     lib.albumScrollY = std::clamp(lib.albumScrollY, minScroll, 0.0f);
+
+    w = locate(c, o, artist, -lib.albumScrollY - TOP_PAD);
   }
 
+  // the visible window plus a row of margin, every row is at least DISC_H high
+  const auto visibleRows = static_cast<size_t>(pane.height / DISC_H) + 2;
+
+  m_cursor.seek(artist, {}, w.firstRow);
+  m_cursor.next(visibleRows, m_rows);
+
   BeginScissorMode(pane.x, pane.y, pane.width, pane.height);
 
   int x = RIGHT_X + 20;
-  int y = HEADER_H + 16 + lib.albumScrollY;
+  int y = HEADER_H + TOP_PAD + lib.albumScrollY + w.y;
 
-  query::songmap::read::forEachAlbum(
-    songs,
-    [&](const Artist& a, const Album& album, const DiscMap& discs) -> void
-    {
-      if (!utils::string::isEquals(a, artist))
-        return;
+  using Kind = query::songmap::Row::Kind;
+
+  std::optional<Kind> prev;
+
+  for (const auto& row : m_rows)
+  {
+    if (y > pane.y + pane.height)
+      break;
+
+    // the gaps that close the previous disc / album
+    if (prev && *prev == Kind::Song && row.kind != Kind::Song)
+      y += DISC_GAP;
+    if (prev && row.kind == Kind::Album)
+      y += ALBUM_GAP;
+    prev = row.kind;
 
+    switch (row.kind)
+    {
       /* ---------------- Album header ---------------- */
-      ui::text::drawTruncated(fonts.bold, album.c_str(), {(float)x, (float)y}, 22, 1, TEXT_MAIN,
-                              1200 - RIGHT_X - 40);
+      case Kind::Album:
+      {
+        const auto& album = c.albums[row.index].name;
+
+        ui::text::drawTruncated(fonts.bold, album.c_str(), {(float)x, (float)y}, 22, 1,
+                                TEXT_MAIN, 1200 - RIGHT_X - 40);
 
-      // Accent underline
-      DrawRectangle(x, y + 26, 48, 2, ACCENT);
+        // Accent underline
+        DrawRectangle(x, y + 26, 48, 2, ACCENT);
 
-      y += 36;
+        y += ALBUM_H;
+        break;
+      }
 
       /* ---------------- Discs ---------------- */
-      for (auto& [disc, tracks] : discs)
-      {
-        DrawTextEx(fonts.regular, TextFormat("Disc %d", disc), {(float)x + 4, (float)y}, 14, 1,
-                   TEXT_DIM);
+      case Kind::Disc:
+        DrawTextEx(fonts.regular, TextFormat("Disc %d", c.discs[row.index].disc),
+                   {(float)x + 4, (float)y}, 14, 1, TEXT_DIM);
 
-        y += 18;
+        y += DISC_H;
+        break;
 
-        /* ---------------- Tracks ---------------- */
-        for (auto& [_, inodeMap] : tracks)
-        {
-          for (auto& [__, song] : inodeMap)
-          {
-            Rectangle row = {(float)x, (float)y, pane.width - 40, 20};
+      /* ---------------- Tracks ---------------- */
+      case Kind::Song:
+      {
+        const auto& song = c.songAt(row.index);
 
-            bool hover = CheckCollisionPointRec(mouse, row);
-            drawHoverRow(row, hover);
+        Rectangle r = {(float)x, (float)y, pane.width - 40, 20};
 
-            if (hover && IsMouseButtonPressed(MOUSE_LEFT_BUTTON))
-              playSongWithAlbumQueue(audio, songs, song, mpris);
+        bool hover = CheckCollisionPointRec(mouse, r);
+        drawHoverRow(r, hover);
 
-            // Track title (left)
-            std::string title =
-              TextFormat("%02d  %s", song->metadata.track, song->metadata.title.c_str());
+        if (hover && IsMouseButtonPressed(MOUSE_LEFT_BUTTON))
+          playSongWithAlbumQueue(audio, songs, song, mpris);
 
-            ui::text::drawTruncated(fonts.regular, title.c_str(), {row.x + 8, row.y + 2}, 16, 1,
-                                    hover ? ACCENT : TEXT_MAIN, row.width - 80);
+        // Track title (left)
+        std::string title =
+          TextFormat("%02d  %s", song->metadata.track, song->metadata.title.c_str());
 
-            // Duration (right)
-            std::string dur = utils::timer::fmtTime(song->metadata.duration);
+        ui::text::drawTruncated(fonts.regular, title.c_str(), {r.x + 8, r.y + 2}, 16, 1,
+                                hover ? ACCENT : TEXT_MAIN, r.width - 80);
 
-            int dw = MeasureTextEx(fonts.regular, dur.c_str(), 14, 1).x;
+        // Duration (right)
+        std::string dur = utils::timer::fmtTime(song->metadata.duration);
 
-            DrawTextEx(fonts.regular, dur.c_str(), {row.x + row.width - dw - 8, row.y + 2}, 14, 1,
-                       TEXT_DIM);
+        int dw = MeasureTextEx(fonts.regular, dur.c_str(), 14, 1).x;
 
-            y += 22;
-          }
-        }
+        DrawTextEx(fonts.regular, dur.c_str(), {r.x + r.width - dw - 8, r.y + 2}, 14, 1,
+                   TEXT_DIM);
 
-        y += 12;
+        y += SONG_H;
+        break;
       }
-
-      y += 20;
-    });
+    }
+  }
 
   EndScissorMode();
 }
@@ -46,7 +46,7 @@ void MetadataOverlay::draw(const ui::Fonts& fonts, const Metadata& meta)
   DrawLine(labelX, y, box.x + box.width - 24, y, {50, 50, 50, 255});
   y += 16;
 
-  row("Genre", meta.genre.empty() ? "—" : meta.genre);
+  row("Genre", meta.genre.empty() ? "—" : meta.genre.str());
   row("Year", std::to_string(meta.year));
   row("Track #", std::to_string(meta.track));
   row("Duration", utils::timer::fmtTime(meta.duration));
@@ -32,7 +32,7 @@ void StatusBar::draw(const ui::Fonts& fonts, audio::Service& audio)
   DrawTextEx(fonts.regular, time.c_str(),
              {(float)(WIN_W / 2 - tw / 2), (float)WIN_H - STATUS_H + 16}, 16, 1, TEXT_DIM);
 
-  const Genre genre = meta->genre.empty() ? "" : ("• " + meta->genre);
+  const std::string genre = meta->genre.empty() ? "" : ("• " + meta->genre);
 
   int genreW = MeasureTextEx(fonts.regular, genre.c_str(), 14, 1).x;
 
@@ -4,6 +4,7 @@
 #include "config/Config.hpp"
 #include "helpers/fs/LRC.hpp"
 #include "lrc/Client.hpp"
+#include "query/Columns.hpp"
 #include "query/SongMap.hpp"
 #include "telemetry/Analysis.hpp"
 #include "utils/string/Equals.hpp"
@@ -11,7 +12,6 @@
 
 #include <iostream>
 #include <map>
-#include <set>
 
 namespace helpers::cmdline
 {
@@ -67,7 +67,7 @@ void printArtists(const TS_SongMap& safeMap)
   std::cout << "\nArtists:\n";
   std::cout << "────────────────────────────\n";
 
-  query::songmap::read::forEachArtist(safeMap, [&](const Artist& artist, const AlbumMap&) -> void
+  query::songmap::read::forEachArtist(safeMap, [&](const Artist& artist) -> void
                                       { std::cout << "• " << artist << "\n"; });
 }
 
@@ -96,6 +96,8 @@ void printSongInfoByTitle(const TS_SongMap& safeMap, const std::optional<Title>&
     std::cout << "Song Information\n";
     std::cout << "────────────────────────────\n";
 
+    const auto& details = song->metadata.details.get();
+
     std::cout << "INODE " << song->inode << ":\n\n";
     std::cout << "Title       : " << song->metadata.title << "\n";
     std::cout << "Artist      : " << song->metadata.artist << "\n";
@@ -103,8 +105,8 @@ void printSongInfoByTitle(const TS_SongMap& safeMap, const std::optional<Title>&
     std::cout << "Genre       : " << song->metadata.genre << "\n";
     std::cout << "Duration    : " << song->metadata.duration << "s\n";
     std::cout << "Bitrate     : " << song->metadata.bitrate << "kbps\n";
-    std::cout << "HasLyrics   : " << (song->metadata.lyrics.empty() ? "NO" : "YES") << "\n";
-    std::cout << "HasArt      : " << (song->metadata.artUrl.empty() ? "NO" : "YES") << "\n";
+    std::cout << "HasLyrics   : " << (details.lyrics.empty() ? "NO" : "YES") << "\n";
+    std::cout << "HasArt      : " << (details.artUrl.empty() ? "NO" : "YES") << "\n";
 
     if (song->metadata.track > 0)
       std::cout << "Track       : " << song->metadata.track << "\n";
@@ -124,11 +126,11 @@ void printSongInfoByTitle(const TS_SongMap& safeMap, const std::optional<Title>&
     if (!song->metadata.filePath.empty())
       std::cout << "File Path   : " << song->metadata.filePath.c_str() << "\n";
 
-    if (!song->metadata.artUrl.empty())
-      std::cout << "Album Art   : " << song->metadata.artUrl.c_str() << "\n";
+    if (!details.artUrl.empty())
+      std::cout << "Album Art   : " << details.artUrl.c_str() << "\n";
 
-    if (!song->metadata.comment.empty())
-      std::cout << "Comment     : " << song->metadata.comment << "\n";
+    if (!details.comment.empty())
+      std::cout << "Comment     : " << details.comment << "\n";
 
     std::cout << "\n";
   }
@@ -157,9 +159,9 @@ void printSongLyrics(const TS_SongMap& safeMap, const Title& songTitle)
             << ":\n";
   std::cout << "────────────────────────────\n";
 
-  if (!song->metadata.lyrics.empty())
+  if (const auto& embedded = song->metadata.details.get().lyrics; !embedded.empty())
   {
-    std::cout << song->metadata.lyrics << "\n";
+    std::cout << embedded << "\n";
     return;
   }
 
@@ -205,7 +207,7 @@ void printAlbums(const TS_SongMap& safeMap, const std::optional<Artist>& artist)
 
   query::songmap::read::forEachAlbum(
     safeMap,
-    [&](const Artist& a, const Album& album, const DiscMap&) -> void
+    [&](const Artist& a, const Album& album) -> void
     {
       if (artist && !artist->empty() && !utils::string::isEquals(a, *artist))
         return;
@@ -384,29 +386,15 @@ void printSongPaths(const TS_SongMap& safeMap)
 // ------------------------------------------------------------
 void printSummary(const TS_SongMap& safeMap, const telemetry::Context& telemetryCtx)
 {
-  std::set<Artist> artists;
-  std::set<Album>  albums;
-  std::set<Genre>  genres;
-  size_t           songs = 0;
-
-  query::songmap::read::forEachSong(safeMap,
-                                    [&](const Artist& artist, const Album& album, const Disc,
-                                        const Track, const ino_t,
-                                        const std::shared_ptr<Song> song) -> void
-                                    {
-                                      ++songs;
-                                      artists.insert(artist);
-                                      albums.insert(album);
-                                      if (!song->metadata.genre.empty())
-                                        genres.insert(song->metadata.genre);
-                                    });
+  // counted once per published map, see query/Columns.hpp
+  const auto totals = query::songmap::columns(safeMap)->totals;
 
   std::cout << "\nLibrary Summary\n"
             << "────────────────────────────\n"
-            << "Artists Count      : " << artists.size() << "\n"
-            << "Albums Count       : " << albums.size() << "\n"
-            << "Songs Count        : " << songs << "\n"
-            << "Genres Count       : " << genres.size() << "\n\n"
+            << "Artists Count      : " << totals.artists << "\n"
+            << "Albums Count       : " << totals.albums << "\n"
+            << "Songs Count        : " << totals.tracks << "\n"
+            << "Genres Count       : " << totals.genres << "\n\n"
             << "Library Name       : " << config::Config::getString("library", "name") << "\n"
             << "Directory          : " << config::Config::getString("library", "directory")
             << "\n\n";
@@ -467,4 +455,10 @@ void printSummary(const TS_SongMap& safeMap, const telemetry::Context& telemetry
     std::cout << "Not enough telemetry data\n";
 }
 
+// the JSON goes to stdout as is, so it can be piped straight into jq or a regression script
+void printScanReport(const helpers::fs::ScanReport& report)
+{
+  std::cout << report.toJson(2) << "\n";
+}
+
 } // namespace helpers::cmdline
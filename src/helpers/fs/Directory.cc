@@ -1,31 +1,426 @@
 #include "helpers/fs/Directory.hpp"
 #include "Logger.hpp"
+#include "core/LibraryCache.hpp"
+#include "taglib/fast/Common.hpp"
 #include "utils/DirectoryWalker.hpp"
+#include "utils/threads/WorkStealingPool.hpp"
+#include "utils/unix/IoUring.hpp"
+#include <ankerl/unordered_dense.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fcntl.h>
+#include <iterator>
+#include <semaphore>
+#include <unistd.h>
 
 namespace helpers::fs
 {
 
-// does a singular pass over the given directory, parses any plausible audio files (mp3, flac, ogg,
-// ...) then creates a Song obj (with inode and song file metadata) and stores in
-// songLibrarySnapshot object.
+namespace
+{
+
+// ============================================================
+// ParseFeeder (walk -> parse pool hand off)
+// ============================================================
+//
+// Syscalls: every file becomes a parse job right away, the worker opens and reads it.
+//
+// IoUring : files are collected into batches of queueDepth. The walking thread opens a
+//           batch (OPENAT) and reads every head (FADVISE(RANDOM) linked to a READ of the
+//           same size the fast readers read first) through the ring, so the whole batch
+//           costs two io_uring_enter round trips. Each file then becomes a job that
+//           starts parsing from memory (taglib::PrefetchedHead).
+//
+//           A semaphore caps the prefetched files waiting for a worker, which bounds the
+//           open fds and head buffers no matter how far the walk runs ahead.
+//
+// The walker shares the ring (DirectoryWalker::useIoUring), both only use it from the
+// walking thread and always reap everything they submitted before returning. A ring
+// without one of the opcodes either of them needs is not used at all, and one that fails
+// mid scan is torn down (IoUring::drain), the rest of the scan runs on syscalls.
+
+constexpr size_t        HEAD_BYTES     = taglib::fast::FileWindow::READ_AHEAD;
+constexpr std::uint64_t FADVISE_MARKER = std::uint64_t{1} << 63;
+
+class ParseFeeder
+{
+public:
+  using Job = std::function<void(size_t worker, const Path& path, const struct stat& st,
+                                 bool update, const taglib::PrefetchedHead* head)>;
+
+  ParseFeeder(const ScanOptions& options, utils::threads::WorkStealingPool& pool, Job job)
+      : m_pool(pool), m_job(std::move(job)), m_depth(std::max(1u, options.queueDepth)),
+        m_slots(static_cast<std::ptrdiff_t>(m_depth) * 4)
+  {
+    if (options.backend == ScanBackend::Syscalls)
+      return;
+
+    try
+    {
+      // open + (fadvise, read) per file, a full batch fits without waiting for room
+      m_ring = std::make_unique<utils::unix::IoUring>(m_depth * 2);
+
+      for (const unsigned op :
+           {IORING_OP_STATX, IORING_OP_OPENAT, IORING_OP_READ, IORING_OP_FADVISE})
+        if (!m_ring->supports(op))
+          throw utils::unix::IoUringUnavailable("kernel lacks io_uring opcode " +
+                                                std::to_string(op));
+    }
+    catch (const utils::unix::IoUringUnavailable& e)
+    {
+      m_ring.reset();
+
+      if (options.backend == ScanBackend::IoUring)
+        LOG_WARN("helpers::fs: io_uring scan backend unavailable, using syscalls: {}", e.what());
+      else
+        LOG_DEBUG("helpers::fs: io_uring unavailable, using syscalls: {}", e.what());
+    }
+  }
+
+  ~ParseFeeder() { finish(); }
+
+  ParseFeeder(const ParseFeeder&)                    = delete;
+  auto operator=(const ParseFeeder&) -> ParseFeeder& = delete;
+
+  [[nodiscard]] auto ring() noexcept -> utils::unix::IoUring* { return m_ring.get(); }
+
+  void submit(Path path, const struct stat& st, bool update = false)
+  {
+    // files without a tag source are rejected by the parser before any I/O anyway
+    if (!m_ring || !m_ring->usable() || !taglib::findSource(path.extension().c_str()))
+    {
+      m_pool.submit([this, path = std::move(path), st, update](size_t worker) -> void
+                    { m_job(worker, path, st, update, nullptr); });
+      return;
+    }
+
+    m_slots.acquire();
+
+    auto entry    = std::make_shared<Entry>();
+    entry->path   = std::move(path);
+    entry->st     = st;
+    entry->update = update;
+    m_batch.push_back(std::move(entry));
+
+    if (m_batch.size() >= m_depth)
+      flush();
+  }
+
+  // hands out the last (partial) batch and waits for every job
+  void finish()
+  {
+    flush();
+    m_pool.wait();
+  }
+
+private:
+  struct Entry
+  {
+    Path        path;
+    struct stat st{};
+    bool        update = false;
+
+    int                              fd = -1;
+    std::unique_ptr<unsigned char[]> head;
+    taglib::PrefetchedHead           prefetched;
+
+    ~Entry()
+    {
+      if (fd >= 0)
+        ::close(fd);
+    }
+  };
+
+  utils::threads::WorkStealingPool&    m_pool;
+  Job                                  m_job;
+  unsigned                             m_depth;
+  std::counting_semaphore<>            m_slots;
+  std::unique_ptr<utils::unix::IoUring> m_ring;
+
+  std::vector<std::shared_ptr<Entry>> m_batch;
+
+  // submits what was queued and reaps every completion of it, false if the ring failed
+  template <typename Fn>
+  auto complete(Fn&& onCqe) -> bool
+  {
+    if (m_ring->drain(onCqe))
+      return true;
+
+    LOG_ERROR("helpers::fs: io_uring failed while prefetching, using syscalls from here on");
+    return false;
+  }
+
+  void flush()
+  {
+    if (m_batch.empty())
+      return;
+
+    for (size_t i = 0; i < m_batch.size(); ++i)
+    {
+      io_uring_sqe* sqe = m_ring->sqe();
+      if (!sqe)
+        break;
+
+      sqe->opcode     = IORING_OP_OPENAT;
+      sqe->fd         = AT_FDCWD;
+      sqe->addr       = reinterpret_cast<std::uint64_t>(m_batch[i]->path.c_str());
+      sqe->open_flags = O_RDONLY | O_CLOEXEC;
+      sqe->user_data  = i;
+    }
+
+    // entries without an fd (not queued, or the ring failed) are parsed from their path
+    const bool opened =
+      m_ring->usable() &&
+      complete([&](std::uint64_t idx, std::int32_t res) -> void { m_batch[idx]->fd = res; });
+
+    for (size_t i = 0; opened && i < m_batch.size(); ++i)
+    {
+      auto& e = *m_batch[i];
+      if (e.fd < 0)
+        continue;
+
+      const size_t len = std::min<size_t>(HEAD_BYTES, static_cast<size_t>(e.st.st_size));
+      e.head           = std::make_unique<unsigned char[]>(std::max<size_t>(len, 1));
+
+      io_uring_sqe* advise = m_ring->sqe();
+      io_uring_sqe* read   = m_ring->sqe();
+      if (!advise || !read)
+        break; // cannot happen with 2 * depth entries, the rest simply parses unprefetched
+
+      advise->opcode         = IORING_OP_FADVISE;
+      advise->fd             = e.fd;
+      advise->fadvise_advice = POSIX_FADV_RANDOM;
+      advise->flags          = IOSQE_IO_LINK;
+      advise->user_data      = i | FADVISE_MARKER;
+
+      read->opcode    = IORING_OP_READ;
+      read->fd        = e.fd;
+      read->addr      = reinterpret_cast<std::uint64_t>(e.head.get());
+      read->len       = static_cast<ui32>(len);
+      read->off       = 0;
+      read->user_data = i;
+    }
+
+    if (opened)
+      complete(
+        [&](std::uint64_t idx, std::int32_t res) -> void
+        {
+          if (idx & FADVISE_MARKER)
+            return;
+
+          auto& e = *m_batch[idx];
+          // a cancelled / failed read still leaves a usable fd, the reader preads itself
+          e.prefetched = {.fd   = e.fd,
+                          .size = static_cast<i64>(e.st.st_size),
+                          .data = e.head.get(),
+                          .len  = res > 0 ? static_cast<size_t>(res) : 0};
+        });
+
+    for (auto& entry : m_batch)
+    {
+      m_pool.submit(
+        [this, entry](size_t worker) -> void
+        {
+          const auto* head = entry->prefetched.fd >= 0 ? &entry->prefetched : nullptr;
+          m_job(worker, entry->path, entry->st, entry->update, head);
+
+          // close the fd and drop the buffer before handing the slot back
+          entry->head.reset();
+          if (entry->fd >= 0)
+          {
+            ::close(entry->fd);
+            entry->fd = -1;
+          }
+          m_slots.release();
+        });
+    }
+
+    m_batch.clear();
+  }
+};
+
+// A worker's share of the ScanReport, only touched by that worker, summed up by
+// collectStats once the pool is drained.
+struct WorkerStats
+{
+  double parseCpuMs = 0.0;
+  size_t parsed     = 0;
+  size_t failed     = 0;
+  size_t artHits    = 0;
+  size_t artMisses  = 0;
+
+  // min heap on ms, the fastest of the slowest files sits on top
+  std::vector<ScanReport::SlowFile> slowest;
+
+  void record(const Path& path, double ms)
+  {
+    parseCpuMs += ms;
+
+    const auto faster = [](const ScanReport::SlowFile& a, const ScanReport::SlowFile& b) -> bool
+    { return a.ms > b.ms; };
+
+    if (slowest.size() == ScanReport::SLOWEST_FILES)
+    {
+      if (ms <= slowest.front().ms)
+        return;
+
+      std::ranges::pop_heap(slowest, faster);
+      slowest.pop_back();
+    }
+
+    slowest.push_back({.path = std::string(path.c_str()), .ms = ms});
+    std::ranges::push_heap(slowest, faster);
+  }
+};
+
+auto parse(taglib::Parser& parser, const Path& path, Metadata& md,
+           const taglib::PrefetchedHead* head, WorkerStats& stats) -> bool
+{
+  const auto start = std::chrono::steady_clock::now();
+
+  const bool ok = head ? parser.parseFile(path, md, *head) : parser.parseFile(path, md);
+
+  stats.record(path, std::chrono::duration<double, std::milli>(
+                       std::chrono::steady_clock::now() - start)
+                       .count());
+
+  if (ok)
+  {
+    ++stats.parsed;
+    ++(md.details.get().artUrl.empty() ? stats.artMisses : stats.artHits);
+  }
+
+  return ok;
+}
+
+// parsers are copies of base, only what they added on top of it belongs to this scan
+void collectStats(ScanReport& report, std::vector<WorkerStats>& stats,
+                  const std::vector<taglib::Parser>& parsers, const taglib::Parser& base)
+{
+  for (size_t w = 0; w < stats.size(); ++w)
+  {
+    report.parseCpuMs += stats[w].parseCpuMs;
+    report.filesParsed += stats[w].parsed;
+    report.parseFailures += stats[w].failed;
+    report.artHits += stats[w].artHits;
+    report.artMisses += stats[w].artMisses;
+    report.mergeSlowest(stats[w].slowest);
+
+    report.bytesRead += parsers[w].session().bytesRead - base.session().bytesRead;
+    report.taglibParses += parsers[w].session().taglibParses - base.session().taglibParses;
+  }
+}
+
+// files we do not manage to parse are remembered with their stamp (see FailedFile)
+void rememberFailed(FailedFiles& failed, const Path& path, const struct stat& st)
+{
+  failed.push_back({.path = path, .stamp = FileStamp::fromStat(st)});
+}
+
+auto mergeFailed(FailedFiles merged, std::vector<FailedFiles>& perWorker) -> FailedFiles
+{
+  for (auto& failed : perWorker)
+  {
+    std::ranges::move(failed, std::back_inserter(merged));
+    failed.clear();
+  }
+
+  return merged;
+}
+
+// A song of the rescanned snapshot: shared if the snapshot holds a map, the record of its
+// library cache if it is still backed by one (made into a Song only if the rescan changes
+// anything)
+struct CachedSong
+{
+  FileStamp               stamp;
+  std::shared_ptr<Song>   song;
+  const core::SongRecord* rec = nullptr;
+};
+
+} // namespace
+
+auto scanBackendFromString(std::string_view name) -> ScanBackend
+{
+  if (name == "syscalls")
+    return ScanBackend::Syscalls;
+  if (name == "io_uring")
+    return ScanBackend::IoUring;
+  return ScanBackend::Auto;
+}
+
+// walks the given directory recursively (Artist/Album/... nesting is fine), parses any plausible
+// audio files (mp3, flac, ogg, ...) then creates a Song obj (with inode and song file metadata)
+// and stores in songLibrarySnapshot object.
+//
+// The walk itself is cheap and stays on the calling thread, every regular file found becomes a
+// parse job on a work stealing pool (through ParseFeeder, which may prefetch file heads with
+// io_uring). Each worker owns its own taglib::Parser and its own shard of songs, so nothing is
+// shared (or locked) while parsing. Shards are merged into the snapshot once the pool is drained.
 //
 // Note that we arent immediately populating the SongMap as we are still yet to serialize to the
-// cache file via cereal.
+// library cache file (core::LibraryCache).
 void dirWalkProcessAll(const Directory& directory, taglib::Parser& tagParser,
-                       core::SongLibrarySnapshot& songLibrarySnapshot)
+                       core::SongLibrarySnapshot& songLibrarySnapshot, const ScanOptions& options,
+                       ScanReport* report)
 {
   RECORD_FUNC_TO_BACKTRACE("helpers::fs::dirWalkProcessAll");
 
+  utils::threads::WorkStealingPool pool(options.threads);
+
+  std::vector<taglib::Parser>    parsers(pool.size(), tagParser);
+  std::vector<std::vector<Song>> shards(pool.size());
+  std::vector<FailedFiles>       failed(pool.size());
+  std::vector<WorkerStats>       stats(pool.size());
+  size_t                         seen = 0;
+
+  ParseFeeder feeder(
+    options, pool,
+    [&](size_t worker, const Path& path, const struct stat& st, bool,
+        const taglib::PrefetchedHead* head) -> void
+    {
+      try
+      {
+        Metadata md;
+        if (!parse(parsers[worker], path, md, head, stats[worker]))
+        {
+          LOG_WARN("Unable to parse metadata for path: '{}'", path);
+          rememberFailed(failed[worker], path, st);
+          ++stats[worker].failed;
+          return;
+        }
+
+        shards[worker].emplace_back(st.st_ino, std::move(md), FileStamp::fromStat(st));
+      }
+      catch (const std::exception& e)
+      {
+        LOG_ERROR("Exception while parsing '{}': {}", path, e.what());
+        rememberFailed(failed[worker], path, st);
+        ++stats[worker].failed;
+      }
+    });
+
+  LOG_DEBUG("helpers::fs::dirWalkProcessAll: Parsing with {} worker(s), {} backend", pool.size(),
+            feeder.ring() ? "io_uring" : "syscalls");
+
+  StageTimer parseTimer;
+  StageTimer walkTimer;
+
   utils::DirectoryWalker walker(directory);
+  walker.useIoUring(feeder.ring());
 
   walker.walk(
-    [&](const char* name, const struct stat& st, [[maybe_unused]] int parentFd) -> void
+    [&](const char* name, const struct stat& st, [[maybe_unused]] int parentFd,
+        std::string_view dirPath) -> void
     {
       if (!S_ISREG(st.st_mode))
         return;
 
+      ++seen;
+
       Path path;
-      path += directory;
+      path += dirPath;
       path += '/';
       path += name;
 
@@ -35,16 +430,260 @@ void dirWalkProcessAll(const Directory& directory, taglib::Parser& tagParser,
         return;
       }
 
-      Metadata md;
-      if (!tagParser.parseFile(path, md))
+      feeder.submit(std::move(path), st);
+    });
+
+  const double walkMs = walkTimer.elapsed_ms();
+  feeder.finish();
+  const double parseMs = parseTimer.elapsed_ms();
+
+  StageTimer insertTimer;
+
+  size_t total = 0;
+  for (auto& shard : shards)
+  {
+    total += shard.size();
+    for (auto& song : shard)
+      songLibrarySnapshot.addSong(song);
+    shard.clear();
+  }
+
+  songLibrarySnapshot.setFailedFiles(mergeFailed({}, failed));
+
+  LOG_DEBUG("helpers::fs::dirWalkProcessAll: Merged {} song(s) from {} shard(s), {} failed",
+            total, shards.size(), songLibrarySnapshot.failedFiles().size());
+
+  if (!report)
+    return;
+
+  report->mode      = "full";
+  report->backend   = feeder.ring() ? "io_uring" : "syscalls";
+  report->threads   = pool.size();
+  report->walkMs    = walkMs;
+  report->parseMs   = parseMs;
+  report->insertMs  = insertTimer.elapsed_ms();
+  report->filesSeen = seen;
+  collectStats(*report, stats, parsers, tagParser);
+}
+
+// Incremental counterpart of dirWalkProcessAll.
+//
+// The cached songs are indexed by file path, then the directory is walked with stat only (which
+// DirectoryWalker gives us for free). For every regular file:
+//
+// -> same path, same FileStamp : the cached Song (shared_ptr or cache record) is carried over
+// -> same path, other stamp    : the file was rewritten (or replaced), parse it again
+// -> unknown path              : a new file, parse it, unless it already failed to parse with
+//                                the same stamp (see FailedFile), those are not retried
+//
+// Whatever is left in the index after the walk no longer exists on disk and is dropped. Parsing
+// reuses the same pool + per worker shard layout as a full rebuild, so a library that gained one
+// album only pays for that album's tag reads on top of the walk.
+//
+// If nothing changed, the snapshot is not touched at all (it keeps its library cache and no
+// Song is made).
+auto dirWalkProcessChanged(const Directory& directory, taglib::Parser& tagParser,
+                           core::SongLibrarySnapshot& songLibrarySnapshot,
+                           const ScanOptions& options, ScanReport* report) -> RescanSummary
+{
+  RECORD_FUNC_TO_BACKTRACE("helpers::fs::dirWalkProcessChanged");
+
+  RescanSummary summary;
+
+  // views point into the cached songs' filePath (or the cache's string pool), they stay valid
+  // as long as the snapshot's song map (or cache) is alive, it is only replaced at the end
+  const auto cache = songLibrarySnapshot.cache();
+
+  ankerl::unordered_dense::map<std::string_view, CachedSong> cached;
+  if (cache)
+  {
+    cached.reserve(cache->songs().size());
+    for (const auto& rec : cache->songs())
+      cached.emplace(cache->str(rec.filePath),
+                     CachedSong{.stamp = {.dev     = rec.stampDev,
+                                          .inode   = rec.stampInode,
+                                          .mtimeNs = rec.stampMtimeNs,
+                                          .size    = rec.stampSize},
+                                .song  = nullptr,
+                                .rec   = &rec});
+  }
+  else
+  {
+    for (const auto& [artist, albums] : songLibrarySnapshot.returnSongMap())
+      for (const auto& [album, discs] : albums)
+        for (const auto& [disc, tracks] : discs)
+          for (const auto& [track, inodes] : tracks)
+            for (const auto& [inode, song] : inodes)
+              cached.emplace(std::string_view(song->metadata.filePath),
+                             CachedSong{.stamp = song->stamp, .song = song, .rec = nullptr});
+  }
+
+  // views point into the snapshot's failed files, which are only replaced at the end as well
+  ankerl::unordered_dense::map<std::string_view, FileStamp> knownFailed;
+  for (const auto& [path, stamp] : songLibrarySnapshot.failedFiles())
+    knownFailed.emplace(path.view(), stamp);
+
+  utils::threads::WorkStealingPool pool(options.threads);
+
+  std::vector<taglib::Parser>    parsers(pool.size(), tagParser);
+  std::vector<std::vector<Song>> shards(pool.size());
+  std::vector<FailedFiles>       failed(pool.size());
+  FailedFiles                    stillFailed; // not retried, stamp unchanged
+  std::vector<size_t>            failedAdds(pool.size(), 0);
+  std::vector<size_t>            failedUpdates(pool.size(), 0);
+  std::vector<WorkerStats>       stats(pool.size());
+  size_t                         seen = 0;
+
+  std::vector<CachedSong> kept;
+  kept.reserve(cached.size());
+
+  ParseFeeder feeder(
+    options, pool,
+    [&](size_t worker, const Path& path, const struct stat& st, bool update,
+        const taglib::PrefetchedHead* head) -> void
+    {
+      try
+      {
+        Metadata md;
+        if (!parse(parsers[worker], path, md, head, stats[worker]))
+        {
+          LOG_WARN("Unable to parse metadata for path: '{}'", path);
+          rememberFailed(failed[worker], path, st);
+          ++(update ? failedUpdates : failedAdds)[worker];
+          ++stats[worker].failed;
+          return;
+        }
+
+        shards[worker].emplace_back(st.st_ino, std::move(md), FileStamp::fromStat(st));
+      }
+      catch (const std::exception& e)
       {
-        LOG_WARN("Unable to parse metadata for path: '{}'", path);
+        LOG_ERROR("Exception while parsing '{}': {}", path, e.what());
+        rememberFailed(failed[worker], path, st);
+        ++(update ? failedUpdates : failedAdds)[worker];
+        ++stats[worker].failed;
+      }
+    });
+
+  StageTimer parseTimer;
+  StageTimer walkTimer;
+
+  utils::DirectoryWalker walker(directory);
+  walker.useIoUring(feeder.ring());
+
+  walker.walk(
+    [&](const char* name, const struct stat& st, [[maybe_unused]] int parentFd,
+        std::string_view dirPath) -> void
+    {
+      if (!S_ISREG(st.st_mode))
         return;
+
+      ++seen;
+
+      Path path;
+      path += dirPath;
+      path += '/';
+      path += name;
+
+      const auto stamp  = FileStamp::fromStat(st);
+      bool       update = false;
+
+      if (auto it = cached.find(path.view()); it != cached.end())
+      {
+        if (it->second.stamp == stamp)
+        {
+          kept.push_back(std::move(it->second));
+          cached.erase(it);
+          ++summary.unchanged;
+          return;
+        }
+
+        cached.erase(it);
+        update = true;
+        ++summary.updated;
       }
+      else
+      {
+        // files we cannot parse anyway were never cached, dont retry them on every startup
+        if (!taglib::findSource(path.extension().c_str()))
+          return;
 
-      Song song{st.st_ino, md};
-      songLibrarySnapshot.addSong(song);
+        // nor the ones that failed to parse, until they are touched
+        if (auto it = knownFailed.find(path.view()); it != knownFailed.end() && it->second == stamp)
+        {
+          stillFailed.push_back({.path = std::move(path), .stamp = stamp});
+          ++summary.knownFailed;
+          return;
+        }
+
+        ++summary.added;
+      }
+
+      LOG_DEBUG("helpers::fs::dirWalkProcessChanged: Queueing '{}'", path);
+
+      feeder.submit(std::move(path), st, update);
     });
+
+  const double walkMs = walkTimer.elapsed_ms();
+  feeder.finish();
+  const double parseMs = parseTimer.elapsed_ms();
+
+  if (report)
+  {
+    report->mode         = "incremental";
+    report->backend      = feeder.ring() ? "io_uring" : "syscalls";
+    report->threads      = pool.size();
+    report->walkMs       = walkMs;
+    report->parseMs      = parseMs;
+    report->filesSeen    = seen;
+    report->filesSkipped = summary.unchanged + summary.knownFailed;
+    collectStats(*report, stats, parsers, tagParser);
+  }
+
+  // deleted (or moved away) since the cache was written
+  summary.removed = cached.size();
+  for (const auto& [path, song] : cached)
+    LOG_DEBUG("helpers::fs::dirWalkProcessChanged: Dropping '{}'", path);
+
+  // a re-parse that failed leaves the song out, account it as removed rather than updated
+  for (size_t w = 0; w < pool.size(); ++w)
+  {
+    summary.added -= failedAdds[w];
+    summary.updated -= failedUpdates[w];
+    summary.removed += failedUpdates[w];
+    summary.failed += failedAdds[w] + failedUpdates[w];
+  }
+
+  // failures of files no longer on disk are simply not carried over
+  knownFailed.clear();
+  songLibrarySnapshot.setFailedFiles(mergeFailed(std::move(stillFailed), failed));
+
+  if (!summary.changed())
+    return summary;
+
+  StageTimer insertTimer;
+
+  core::SongLibrarySnapshot fresh;
+
+  for (auto& entry : kept)
+    fresh.addSong(entry.song ? std::move(entry.song) : cache->materialize(*entry.rec));
+
+  for (auto& shard : shards)
+  {
+    for (auto& song : shard)
+      fresh.addSong(std::make_shared<Song>(std::move(song)));
+    shard.clear();
+  }
+
+  cached.clear();
+  kept.clear();
+
+  songLibrarySnapshot.newSongMap(fresh.moveSongMap());
+
+  if (report)
+    report->insertMs = insertTimer.elapsed_ms();
+
+  return summary;
 }
 
 } // namespace helpers::fs
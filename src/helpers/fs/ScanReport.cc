@@ -0,0 +1,65 @@
+#include "helpers/fs/ScanReport.hpp"
+
+#include <algorithm>
+#include <nlohmann/json.hpp>
+
+namespace helpers::fs
+{
+
+auto ScanReport::filesPerSecond() const noexcept -> double
+{
+  return parseMs > 0.0 ? static_cast<double>(filesParsed) * 1000.0 / parseMs : 0.0;
+}
+
+void ScanReport::mergeSlowest(std::vector<SlowFile>& other)
+{
+  slowest.insert(slowest.end(), std::make_move_iterator(other.begin()),
+                 std::make_move_iterator(other.end()));
+  other.clear();
+
+  const auto byTime = [](const SlowFile& a, const SlowFile& b) -> bool { return a.ms > b.ms; };
+
+  if (slowest.size() > SLOWEST_FILES)
+  {
+    std::nth_element(slowest.begin(), slowest.begin() + SLOWEST_FILES, slowest.end(), byTime);
+    slowest.resize(SLOWEST_FILES);
+  }
+
+  std::ranges::sort(slowest, byTime);
+}
+
+auto ScanReport::toJson(int indent) const -> std::string
+{
+  nlohmann::json slow = nlohmann::json::array();
+  for (const auto& f : slowest)
+    slow.push_back({{"path", f.path}, {"ms", f.ms}});
+
+  const nlohmann::json j = {
+    {"mode", mode},
+    {"backend", backend},
+    {"threads", threads},
+    {"stages_ms",
+     {{"walk", walkMs},
+      {"parse", parseMs},
+      {"parse_cpu", parseCpuMs},
+      {"insert", insertMs},
+      {"sort", sortMs},
+      {"save", saveMs},
+      {"total", totalMs}}},
+    {"files",
+     {{"seen", filesSeen},
+      {"parsed", filesParsed},
+      {"skipped", filesSkipped},
+      {"failed", parseFailures},
+      {"taglib", taglibParses},
+      {"per_second", filesPerSecond()}}},
+    {"bytes_read", bytesRead},
+    {"art", {{"hits", artHits}, {"misses", artMisses}}},
+    {"slowest", std::move(slow)},
+  };
+
+  // paths are whatever the filesystem has, dont let a stray byte throw
+  return j.dump(indent, ' ', false, nlohmann::json::error_handler_t::replace);
+}
+
+} // namespace helpers::fs
@@ -0,0 +1,886 @@
+#include "query/Columns.hpp"
+#include "StackTrace.hpp"
+#include "core/LibraryCache.hpp"
+#include "query/sort/Order.hpp"
+#include "utils/string/Unicode.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <utility>
+
+namespace query::songmap
+{
+
+namespace strhelp = utils::string;
+
+auto SongColumns::findArtist(const Artist& name) const -> const ArtistGroup*
+{
+  auto it = artistIndex.find(name);
+  return it == artistIndex.end() ? nullptr : &artists[it->second];
+}
+
+auto SongColumns::findAlbum(const ArtistGroup& artist, const Album& name) const
+  -> const AlbumGroup*
+{
+  // an artist has a handful of albums, a linear id compare beats another hash map
+  for (ui32 i = artist.firstAlbum; i < artist.firstAlbum + artist.albumCount; ++i)
+    if (albums[i].name == name)
+      return &albums[i];
+
+  return nullptr;
+}
+
+namespace
+{
+
+// genre groups + posting lists, then the genres of every artist (needs the song columns)
+void buildGenres(SongColumns& c)
+{
+  ankerl::unordered_dense::map<Genre, ui32> group; // genre -> songs, then -> group index
+  for (const auto& g : c.genre)
+    ++group[g];
+
+  c.genres.reserve(group.size());
+  for (const auto& [name, count] : group)
+    c.genres.push_back({.name = name, .firstPosting = 0, .songCount = count});
+
+  std::ranges::sort(c.genres, {}, &SongColumns::GenreGroup::name);
+
+  ui32 offset = 0;
+  for (ui32 gi = 0; gi < c.genres.size(); ++gi)
+  {
+    c.genres[gi].firstPosting = offset;
+    offset += c.genres[gi].songCount;
+    group[c.genres[gi].name] = gi;
+  }
+
+  // filled in map order, so every posting list comes out sorted
+  std::vector<ui32> fill(c.genres.size(), 0);
+  c.genreSongs.resize(c.size());
+  for (ui32 i = 0; i < c.size(); ++i)
+  {
+    const ui32 gi = group[c.genre[i]];
+
+    c.genreSongs[c.genres[gi].firstPosting + fill[gi]++] = i;
+  }
+
+  std::vector<Genre> distinct;
+  for (auto& a : c.artists)
+  {
+    distinct.assign(c.genre.begin() + a.firstSong, c.genre.begin() + a.firstSong + a.songCount);
+    std::erase(distinct, Genre{});
+    std::ranges::sort(distinct);
+    distinct.erase(std::ranges::unique(distinct).begin(), distinct.end());
+
+    a.firstGenre = static_cast<ui32>(c.artistGenres.size());
+    a.genreCount = static_cast<ui32>(distinct.size());
+    c.artistGenres.insert(c.artistGenres.end(), distinct.begin(), distinct.end());
+  }
+}
+
+void countTotals(SongColumns& c)
+{
+  auto& t = c.totals;
+
+  t.tracks  = c.size();
+  t.artists = static_cast<size_t>(std::ranges::count_if(
+    c.artists, [](const SongColumns::ArtistGroup& a) -> bool { return !a.name.empty(); }));
+  t.genres  = static_cast<size_t>(std::ranges::count_if(
+    c.genres, [](const SongColumns::GenreGroup& g) -> bool { return !g.name.empty(); }));
+
+  // the same album name under two artists counts once
+  ankerl::unordered_dense::set<Album> albums;
+  for (const auto& al : c.albums)
+    if (!al.name.empty())
+      albums.insert(al.name);
+  t.albums = albums.size();
+}
+
+// the columns, indexes and groups of one song at a time, in map order (build() and
+// fromCache() differ only in where the values come from)
+class Appender
+{
+public:
+  struct Row
+  {
+    std::string_view title;
+    std::string_view path;
+    Artist           artist;
+    Album            album;
+    Genre            genre;
+    Disc             disc;
+    Track            track;
+    Year             year;
+    float            duration;
+    int              bitrate;
+    ino_t            inode;
+  };
+
+  Appender(SongColumns& c, size_t songs, size_t artists, size_t albums, size_t discs) : m_c(c)
+  {
+    c.title.reserve(songs);
+    c.artist.reserve(songs);
+    c.album.reserve(songs);
+    c.genre.reserve(songs);
+    c.disc.reserve(songs);
+    c.track.reserve(songs);
+    c.year.reserve(songs);
+    c.duration.reserve(songs);
+    c.bitrate.reserve(songs);
+    c.inode.reserve(songs);
+    c.titleNext.reserve(songs);
+
+    c.inodeIndex.reserve(songs);
+    c.titleIndex.reserve(songs);
+    c.pathIndex.reserve(songs);
+
+    c.artists.reserve(artists);
+    c.albums.reserve(albums);
+    c.discs.reserve(discs);
+    c.artistIndex.reserve(artists);
+
+    m_titleTail.reserve(songs);
+  }
+
+  [[nodiscard]] auto pos() const -> ui32 { return static_cast<ui32>(m_c.inode.size()); }
+
+  auto artist(const Artist& name, const AlbumMap* albums) -> ui32
+  {
+    const auto idx = static_cast<ui32>(m_c.artists.size());
+    m_c.artistIndex.emplace(name, idx);
+    m_c.artists.push_back({.name       = name,
+                           .albums     = albums,
+                           .firstAlbum = static_cast<ui32>(m_c.albums.size()),
+                           .albumCount = 0,
+                           .firstSong  = pos(),
+                           .songCount  = 0,
+                           .firstGenre = 0,
+                           .genreCount = 0});
+    return idx;
+  }
+
+  auto album(const Album& name, ui32 artist, const DiscMap* discs) -> ui32
+  {
+    const auto idx = static_cast<ui32>(m_c.albums.size());
+    m_c.albums.push_back({.name      = name,
+                          .artist    = artist,
+                          .discs     = discs,
+                          .firstDisc = static_cast<ui32>(m_c.discs.size()),
+                          .discCount = 0,
+                          .firstSong = pos(),
+                          .songCount = 0});
+    return idx;
+  }
+
+  void disc(Disc disc, ui32 album, const TrackMap* tracks, ui32 firstSong)
+  {
+    m_c.discs.push_back({.disc      = disc,
+                         .album     = album,
+                         .tracks    = tracks,
+                         .firstSong = firstSong,
+                         .songCount = pos() - firstSong});
+  }
+
+  void song(const Row& row)
+  {
+    const ui32 i = pos();
+
+    m_c.inodeIndex.insert_or_assign(row.inode, i);
+    m_c.pathIndex.try_emplace(row.path, i);
+
+    const auto h = SongColumns::foldedHash(row.title);
+    m_c.titleNext.push_back(SongColumns::NONE);
+    if (auto [tail, first] = m_titleTail.try_emplace(h, i); first)
+      m_c.titleIndex.emplace(h, i);
+    else
+      m_c.titleNext[std::exchange(tail->second, i)] = i;
+
+    m_c.title.push_back(row.title);
+    m_c.artist.push_back(row.artist);
+    m_c.album.push_back(row.album);
+    m_c.genre.push_back(row.genre);
+    m_c.disc.push_back(row.disc);
+    m_c.track.push_back(row.track);
+    m_c.year.push_back(row.year);
+    m_c.duration.push_back(row.duration);
+    m_c.bitrate.push_back(row.bitrate);
+    m_c.inode.push_back(row.inode);
+  }
+
+  void closeAlbum(ui32 idx)
+  {
+    auto& al     = m_c.albums[idx];
+    al.discCount = static_cast<ui32>(m_c.discs.size()) - al.firstDisc;
+    al.songCount = pos() - al.firstSong;
+  }
+
+  void closeArtist(ui32 idx)
+  {
+    auto& a      = m_c.artists[idx];
+    a.albumCount = static_cast<ui32>(m_c.albums.size()) - a.firstAlbum;
+    a.songCount  = pos() - a.firstSong;
+  }
+
+private:
+  SongColumns& m_c;
+
+  // last song of each title chain, only needed while building
+  ankerl::unordered_dense::map<std::uint64_t, ui32> m_titleTail;
+};
+
+} // namespace
+
+auto SongColumns::findInode(ino_t id) const -> ui32
+{
+  auto it = inodeIndex.find(id);
+  return it == inodeIndex.end() ? NONE : it->second;
+}
+
+auto SongColumns::findPath(std::string_view path) const -> ui32
+{
+  auto it = pathIndex.find(path);
+  return it == pathIndex.end() ? NONE : it->second;
+}
+
+auto SongColumns::matchGenre(std::string_view genre) const -> std::vector<const GenreGroup*>
+{
+  std::vector<const GenreGroup*> groups;
+
+  for (const auto& g : genres)
+    if (strhelp::isEquals(g.name, genre))
+      groups.push_back(&g);
+
+  return groups;
+}
+
+auto SongColumns::foldedHash(std::string_view s) noexcept -> std::uint64_t
+{
+  // FNV-1a over the lowered codepoints (the same decode + fold isEquals compares), then a
+  // final avalanche so neighbouring titles do not land in neighbouring buckets
+  std::uint64_t h = 0xcbf29ce484222325ULL;
+
+  const char* p = s.data();
+  const char* e = p + s.size();
+
+  while (p < e)
+  {
+    h ^= utils::string::unicode_tolower(utils::string::utf8_decode(p, e));
+    h *= 0x100000001b3ULL;
+  }
+
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  return h;
+}
+
+auto SongColumns::build(std::shared_ptr<const SongMap> map) -> std::shared_ptr<SongColumns>
+{
+  RECORD_FUNC_TO_BACKTRACE("query::songmap::SongColumns::build");
+
+  auto  out = std::make_shared<SongColumns>();
+  auto& c   = *out;
+
+  size_t songCount = 0, albumCount = 0, discCount = 0;
+  for (const auto& [artist, albums] : *map)
+  {
+    albumCount += albums.size();
+    for (const auto& [album, discs] : albums)
+    {
+      discCount += discs.size();
+      for (const auto& [disc, tracks] : discs)
+        for (const auto& [track, inodes] : tracks)
+          songCount += inodes.size();
+    }
+  }
+
+  Appender add(c, songCount, map->size(), albumCount, discCount);
+  c.m_song.reserve(songCount);
+
+  for (const auto& [artist, albums] : *map)
+  {
+    const auto artistIdx = add.artist(artist, &albums);
+
+    for (const auto& [album, discs] : albums)
+    {
+      const auto albumIdx = add.album(album, artistIdx, &discs);
+
+      for (const auto& [disc, tracks] : discs)
+      {
+        const ui32 discStart = add.pos();
+
+        for (const auto& [track, inodes] : tracks)
+          for (const auto& [inode, song] : inodes)
+          {
+            const auto& md = song->metadata;
+
+            add.song({.title    = md.title,
+                      .path     = md.filePath,
+                      .artist   = artist,
+                      .album    = album,
+                      .genre    = md.genre,
+                      .disc     = disc,
+                      .track    = track,
+                      .year     = md.year,
+                      .duration = md.duration,
+                      .bitrate  = md.bitrate,
+                      .inode    = inode});
+            c.m_song.push_back(&song);
+          }
+
+        add.disc(disc, albumIdx, &tracks, discStart);
+      }
+
+      add.closeAlbum(albumIdx);
+    }
+
+    add.closeArtist(artistIdx);
+  }
+
+  buildGenres(c);
+  countTotals(c);
+
+  c.m_map = std::move(map);
+  return out;
+}
+
+// The cache holds the songs in the order write() walked the map: artist by artist, album by
+// album, every disc contiguous. That order is the map order the columns keep, so song
+// position i is record i and a disc group is a run of records with the same disc key.
+auto SongColumns::fromCache(std::shared_ptr<const core::LibraryCache> cache)
+  -> std::shared_ptr<SongColumns>
+{
+  RECORD_FUNC_TO_BACKTRACE("query::songmap::SongColumns::fromCache");
+
+  auto  out = std::make_shared<SongColumns>();
+  auto& c   = *out;
+
+  const auto records = cache->songs();
+  const auto artists = cache->artists();
+
+  size_t albumCount = 0, discCount = 0;
+  for (const auto& artist : artists)
+    for (const auto& album : cache->albums(artist))
+    {
+      ++albumCount;
+      const auto songs = cache->songs(album);
+      for (size_t r = 0; r < songs.size(); ++r)
+        discCount += r == 0 || songs[r].discKey != songs[r - 1].discKey;
+    }
+
+  Appender add(c, records.size(), artists.size(), albumCount, discCount);
+
+  // the pool keeps every distinct string once, so a name is interned once per reference
+  ankerl::unordered_dense::map<ui64, InternedString> interned;
+  const auto intern = [&](core::StrRef ref) -> InternedString
+  {
+    auto [it, fresh] = interned.try_emplace(ui64{ref.offset} << 32 | ref.size);
+    if (fresh)
+      it->second = InternedString(cache->str(ref));
+    return it->second;
+  };
+
+  for (const auto& artistRec : artists)
+  {
+    const auto albums = cache->albums(artistRec);
+    if (artistRec.firstAlbum != c.albums.size() || albums.size() != artistRec.albumCount)
+      throw std::runtime_error("SongColumns: Library cache albums out of order.");
+
+    const Artist artist    = intern(artistRec.name);
+    const auto   artistIdx = add.artist(artist, nullptr);
+
+    for (const auto& albumRec : albums)
+    {
+      const auto songs = cache->songs(albumRec);
+      if (albumRec.firstSong != add.pos() || songs.size() != albumRec.songCount)
+        throw std::runtime_error("SongColumns: Library cache songs out of order.");
+
+      const Album album    = intern(albumRec.name);
+      const auto  albumIdx = add.album(album, artistIdx, nullptr);
+
+      ui32 discStart = add.pos();
+      for (size_t r = 0; r < songs.size(); ++r)
+      {
+        const auto& rec = songs[r];
+
+        add.song({.title    = cache->str(rec.title),
+                  .path     = cache->str(rec.filePath),
+                  .artist   = artist,
+                  .album    = album,
+                  .genre    = intern(rec.genre),
+                  .disc     = rec.discKey,
+                  .track    = rec.trackKey,
+                  .year     = rec.year,
+                  .duration = rec.duration,
+                  .bitrate  = rec.bitrate,
+                  .inode    = static_cast<ino_t>(rec.inode)});
+
+        // the disc ends with the last record of its key
+        if (r + 1 == songs.size() || songs[r + 1].discKey != rec.discKey)
+        {
+          add.disc(rec.discKey, albumIdx, nullptr, discStart);
+          discStart = add.pos();
+        }
+      }
+
+      add.closeAlbum(albumIdx);
+    }
+
+    add.closeArtist(artistIdx);
+  }
+
+  if (add.pos() != records.size())
+    throw std::runtime_error("SongColumns: Library cache has songs outside its albums.");
+
+  buildGenres(c);
+  countTotals(c);
+
+  c.m_cache = std::move(cache);
+  c.m_song.assign(c.size(), nullptr);
+  c.m_made.resize(c.size());
+  return out;
+}
+
+auto SongColumns::makeSong(ui32 i) const -> const std::shared_ptr<Song>&
+{
+  std::lock_guard lock(m_makeMtx[i % m_makeMtx.size()]);
+
+  std::atomic_ref slot(m_song[i]);
+  if (const auto* made = slot.load(std::memory_order_relaxed))
+    return *made;
+
+  m_made[i] = m_cache->materialize(m_cache->songs()[i]);
+  slot.store(&m_made[i], std::memory_order_release);
+  return m_made[i];
+}
+
+auto SongColumns::songMap() const -> const std::shared_ptr<const SongMap>&
+{
+  if (!m_cache)
+    return m_map;
+
+  std::call_once(m_mapMade,
+                 [this]() -> void
+                 {
+                   auto map = std::make_shared<SongMap>();
+                   map->reserve(artists.size());
+
+                   for (const auto& a : artists)
+                   {
+                     auto& albumMap = (*map)[a.name];
+                     for (ui32 al = a.firstAlbum; al < a.firstAlbum + a.albumCount; ++al)
+                     {
+                       auto& discMap = albumMap[albums[al].name];
+                       for (ui32 d = albums[al].firstDisc;
+                            d < albums[al].firstDisc + albums[al].discCount; ++d)
+                       {
+                         auto& trackMap = discMap[discs[d].disc];
+                         for (ui32 i = discs[d].firstSong;
+                              i < discs[d].firstSong + discs[d].songCount; ++i)
+                           trackMap[track[i]][inode[i]] = songAt(i);
+                       }
+                     }
+                   }
+
+                   m_map = std::move(map);
+                 });
+
+  return m_map;
+}
+
+auto SongColumns::albumMap(const ArtistGroup& artist) const -> const AlbumMap&
+{
+  return artist.albums ? *artist.albums : std::as_const(*songMap()).at(artist.name);
+}
+
+auto SongColumns::discMap(const AlbumGroup& album) const -> const DiscMap&
+{
+  return album.discs ? *album.discs : albumMap(artists[album.artist]).at(album.name);
+}
+
+auto SongColumns::trackMap(const DiscGroup& disc) const -> const TrackMap&
+{
+  return disc.tracks ? *disc.tracks : discMap(albums[disc.album]).at(disc.disc);
+}
+
+namespace
+{
+
+// one entry per TS_SongMap (in practice the global one). An entry keeps the last map its
+// columns were built from alive until the next install.
+//
+// g_cacheMtx only guards the entries themselves, nothing O(library) runs under it: the
+// columns of a new version are built by the first reader of it (the other readers of that
+// version wait on its once flag), and a new plan is run on the installed columns next to
+// them.
+//
+// Readers of the installed columns do not take it at all: every install is also published
+// as an Installed node (columns + the version they stand for) behind the atomic pointer of
+// the map's FastEntry. A reader loads it inside an Epoch::Guard and only falls back to the
+// mutex if its version is not the published one. Replaced nodes are retired like SafeMap
+// retires its snapshots.
+struct Installed
+{
+  std::shared_ptr<const SongColumns> columns;
+  std::uint64_t                      version;
+};
+
+// written under g_cacheMtx only, read inside an Epoch::Guard
+struct FastEntry
+{
+  std::atomic<const TS_SongMap*> owner{nullptr};
+  std::atomic<Installed*>        installed{nullptr};
+
+  ~FastEntry() { delete installed.load(std::memory_order_relaxed); }
+};
+
+// the first maps that get columns have an entry, any further one always takes the mutex
+std::array<FastEntry, 4> g_fast;
+
+struct RetiredInstall
+{
+  std::unique_ptr<Installed> node;
+  std::uint64_t              epoch;
+};
+
+struct Build
+{
+  std::shared_ptr<const SongMap> map;
+  std::uint64_t                  version;
+
+  std::once_flag               once;
+  std::shared_ptr<SongColumns> columns;
+};
+
+struct Slot
+{
+  std::shared_ptr<SongColumns> columns;
+  std::uint64_t                version = 0; // TS_SongMap::version() the columns stand for
+  std::shared_ptr<Build>       building;    // columns of a newer version, under way
+
+  sort::RuntimeSortPlan plan;
+  sort::SortProgram     program = sort::compile(plan);
+
+  // a saved order waiting for the columns of seedMap (see adoptSortOrder())
+  std::shared_ptr<const SortOrder> seed;
+  std::shared_ptr<const SongMap>   seedMap;
+
+  FastEntry* fast = nullptr; // claimed by the first install, nullptr if none was left
+};
+
+std::mutex                                            g_cacheMtx;
+ankerl::unordered_dense::map<const TS_SongMap*, Slot> g_cache;
+std::vector<RetiredInstall>                           g_retired; // under g_cacheMtx
+
+// with g_cacheMtx held, after slot.columns / slot.version changed
+void publishInstalled(const TS_SongMap& safeMap, Slot& slot)
+{
+  if (!slot.fast)
+  {
+    for (auto& entry : g_fast)
+      if (!entry.owner.load(std::memory_order_relaxed))
+      {
+        slot.fast = &entry;
+        break;
+      }
+
+    if (!slot.fast)
+      return;
+  }
+
+  auto* old = slot.fast->installed.exchange(new Installed{slot.columns, slot.version},
+                                            std::memory_order_seq_cst);
+  slot.fast->owner.store(&safeMap, std::memory_order_release);
+
+  if (old)
+    g_retired.push_back({std::unique_ptr<Installed>(old), utils::threads::Epoch::advance()});
+
+  std::erase_if(g_retired, [](const RetiredInstall& r) -> bool
+                { return utils::threads::Epoch::quiescent(r.epoch); });
+}
+
+// every index of v below bound
+auto below(const std::vector<ui32>& v, size_t bound) noexcept -> bool
+{
+  return std::ranges::all_of(v, [&](ui32 x) -> bool { return x < bound; });
+}
+
+// Whether o can be an order of c: sizes, index ranges and slice bounds. A saved order that
+// passes may still be a wrong order if it was saved for other columns of the same shape;
+// the cache only hands one back for the map it was written with.
+auto fits(const SongColumns& c, const SortOrder& o) noexcept -> bool
+{
+  const size_t songs = c.size();
+
+  if (o.artists.size() != c.artists.size() || o.albums.size() != c.albums.size() ||
+      o.discs.size() != c.discs.size() || o.songs.size() != songs ||
+      o.rank.size() != songs || o.artistAlbum.size() != c.artists.size() ||
+      o.artistSong.size() != c.artists.size() || o.albumDisc.size() != c.albums.size() ||
+      o.albumSong.size() != c.albums.size() || o.discSong.size() != c.discs.size() ||
+      o.genreSongs.size() != c.genreSongs.size())
+    return false;
+
+  if (!below(o.artists, c.artists.size()) || !below(o.albums, c.albums.size()) ||
+      !below(o.discs, c.discs.size()) || !below(o.songs, songs) || !below(o.rank, songs) ||
+      !below(o.genreSongs, songs))
+    return false;
+
+  for (size_t a = 0; a < c.artists.size(); ++a)
+    if (o.artistAlbum[a] > c.albums.size() - c.artists[a].albumCount ||
+        o.artistSong[a] > songs - c.artists[a].songCount)
+      return false;
+
+  for (size_t al = 0; al < c.albums.size(); ++al)
+    if (o.albumDisc[al] > c.discs.size() - c.albums[al].discCount ||
+        o.albumSong[al] > songs - c.albums[al].songCount)
+      return false;
+
+  for (size_t d = 0; d < c.discs.size(); ++d)
+    if (o.discSong[d] > songs - c.discs[d].songCount)
+      return false;
+
+  return true;
+}
+
+// the seed if it was saved for these columns and the program in use, it is used up either way
+auto takeSeed(Slot& slot, const SongColumns& c) -> std::shared_ptr<const SortOrder>
+{
+  auto seed    = std::move(slot.seed);
+  auto seedMap = std::move(slot.seedMap);
+
+  if (!seed || !seedMap || !c.songMap()->shares(*seedMap) ||
+      seed->planHash != sort::hash(slot.program) || !fits(c, *seed))
+    return nullptr;
+
+  return seed;
+}
+
+// Orders the installed columns of safeMap by the program of its slot, unless they already
+// are or stand for an older version than the published one (the next reader builds new
+// columns with that program anyway). The sort runs without the lock; when the program or
+// the columns changed meanwhile it runs again on what is installed then.
+void reorder(const TS_SongMap& safeMap)
+{
+  while (true)
+  {
+    const auto published = safeMap.version();
+
+    std::shared_ptr<SongColumns> c;
+    sort::SortProgram            program;
+    {
+      std::lock_guard lock(g_cacheMtx);
+
+      const auto& slot = g_cache[&safeMap];
+      if (!slot.columns || slot.version < published ||
+          slot.columns->order()->planHash == sort::hash(slot.program))
+        return;
+
+      c       = slot.columns;
+      program = slot.program;
+    }
+
+    auto order = std::make_shared<const SortOrder>(sort::buildOrder(*c, program));
+
+    std::lock_guard lock(g_cacheMtx);
+
+    const auto& slot = g_cache[&safeMap];
+    if (slot.columns == c && slot.program == program)
+    {
+      c->sorted.store(std::move(order), std::memory_order_release);
+      return;
+    }
+  }
+}
+
+// Columns and order of build.map, installed into the slot unless a newer version was
+// installed first. The order and the install happen under one lock with the program check,
+// so a plan set meanwhile is either seen here or applied by setSortPlan() to these columns.
+void buildAndInstall(const TS_SongMap& safeMap, Build& build)
+{
+  auto c = SongColumns::build(build.map);
+
+  std::shared_ptr<const SortOrder> order;
+  sort::SortProgram                program;
+  {
+    std::lock_guard lock(g_cacheMtx);
+
+    auto& slot = g_cache[&safeMap];
+    program    = slot.program;
+    order      = takeSeed(slot, *c);
+  }
+
+  while (true)
+  {
+    if (!order)
+      order = std::make_shared<const SortOrder>(sort::buildOrder(*c, program));
+
+    std::lock_guard lock(g_cacheMtx);
+
+    auto& slot = g_cache[&safeMap];
+    if (slot.program != program)
+    {
+      program = slot.program;
+      order.reset();
+      continue;
+    }
+
+    c->sorted.store(std::move(order), std::memory_order_release);
+    build.columns = c;
+
+    if (slot.version < build.version)
+    {
+      slot.columns = std::move(c);
+      slot.version = build.version;
+      publishInstalled(safeMap, slot);
+    }
+    if (slot.building.get() == &build)
+      slot.building.reset();
+
+    return;
+  }
+}
+
+} // namespace
+
+auto columns(const TS_SongMap& safeMap) -> std::shared_ptr<const SongColumns>
+{
+  {
+    utils::threads::Epoch::Guard guard;
+
+    const auto published = safeMap.version();
+    for (const auto& entry : g_fast)
+    {
+      if (entry.owner.load(std::memory_order_acquire) != &safeMap)
+        continue;
+
+      const auto* installed = entry.installed.load(std::memory_order_seq_cst);
+      if (installed->version == published)
+        return installed->columns;
+      break;
+    }
+  }
+
+  auto [pinned, version] = safeMap.pinWithVersion();
+
+  std::shared_ptr<Build> build;
+  {
+    std::lock_guard lock(g_cacheMtx);
+
+    auto& slot = g_cache[&safeMap];
+
+    // columns of this version or a newer one are in. A map published without changes (a
+    // new plan, see mut::sortSongMap()) shares its tables with the one the columns were
+    // built from, its order is already the new one.
+    if (slot.columns && (slot.version >= version || slot.columns->songMap()->shares(*pinned)))
+    {
+      if (slot.version < version)
+      {
+        slot.version = version;
+        publishInstalled(safeMap, slot);
+      }
+      return slot.columns;
+    }
+
+    // join the build under way unless it is for an older version
+    if (!slot.building || slot.building->version < version)
+      slot.building = std::make_shared<Build>(std::move(pinned), version);
+
+    build = slot.building;
+  }
+
+  std::call_once(build->once, [&]() -> void { buildAndInstall(safeMap, *build); });
+  return build->columns;
+}
+
+auto setSortPlan(const TS_SongMap& safeMap, const sort::RuntimeSortPlan& plan) -> bool
+{
+  RECORD_FUNC_TO_BACKTRACE("query::songmap::setSortPlan");
+
+  // plans that compile to the same program (a repeated key, say) give the same order
+  auto program = sort::compile(plan);
+  {
+    std::lock_guard lock(g_cacheMtx);
+
+    auto& slot = g_cache[&safeMap];
+    slot.plan  = plan;
+    if (slot.program == program)
+      return false;
+
+    slot.program = std::move(program);
+  }
+
+  reorder(safeMap);
+  return true;
+}
+
+auto adoptSortOrder(const TS_SongMap& safeMap, const sort::RuntimeSortPlan& plan,
+                    std::shared_ptr<const SortOrder> order) -> bool
+{
+  RECORD_FUNC_TO_BACKTRACE("query::songmap::adoptSortOrder");
+
+  auto program = sort::compile(plan);
+  if (!order || order->planHash != sort::hash(program))
+    return false;
+
+  auto pinned = safeMap.pin();
+  {
+    std::lock_guard lock(g_cacheMtx);
+
+    auto& slot   = g_cache[&safeMap];
+    slot.plan    = plan;
+    slot.program = std::move(program);
+    slot.seed    = std::move(order);
+    slot.seedMap = std::move(pinned);
+
+    // columns of this very map already exist (they were built with the old plan): they take
+    // the seed now, otherwise the next build picks it up
+    if (slot.columns && slot.columns->songMap()->shares(*slot.seedMap))
+      if (auto seed = takeSeed(slot, *slot.columns))
+        slot.columns->sorted.store(std::move(seed), std::memory_order_release);
+  }
+
+  // a seed that did not fit: the plan runs instead
+  reorder(safeMap);
+  return true;
+}
+
+auto adoptLibraryCache(TS_SongMap& safeMap, std::shared_ptr<const core::LibraryCache> cache,
+                       const sort::RuntimeSortPlan& plan) -> bool
+{
+  RECORD_FUNC_TO_BACKTRACE("query::songmap::adoptLibraryCache");
+
+  auto c       = SongColumns::fromCache(cache);
+  auto program = sort::compile(plan);
+
+  auto       order = cache->sortOrder();
+  const bool saved = order && order->planHash == sort::hash(program) && fits(*c, *order);
+  if (!saved)
+    order = std::make_shared<const SortOrder>(sort::buildOrder(*c, program));
+
+  c->sorted.store(std::move(order), std::memory_order_release);
+
+  // the map is filed from the columns once a reader pins it
+  const auto version = safeMap.replaceDeferred(
+    [c]() -> std::shared_ptr<SongMap> { return std::const_pointer_cast<SongMap>(c->songMap()); });
+
+  std::lock_guard lock(g_cacheMtx);
+
+  auto& slot   = g_cache[&safeMap];
+  slot.plan    = plan;
+  slot.program = std::move(program);
+  slot.seed.reset();
+  slot.seedMap.reset();
+
+  if (slot.version < version)
+  {
+    slot.columns = std::move(c);
+    slot.version = version;
+    publishInstalled(safeMap, slot);
+  }
+
+  return saved;
+}
+
+} // namespace query::songmap
@@ -0,0 +1,132 @@
+#include "query/Cursor.hpp"
+#include "StackTrace.hpp"
+
+#include <algorithm>
+
+namespace query::songmap
+{
+
+Cursor::Cursor(const TS_SongMap& safeMap)
+    // version first: a publish in between makes the cursor look stale once, never the other
+    // way around
+    : m_generation(safeMap.version()), m_snap(query::songmap::columns(safeMap)),
+      m_order(m_snap->order())
+{
+}
+
+auto Cursor::refresh(const TS_SongMap& safeMap) -> bool
+{
+  if (!stale(safeMap))
+    return false;
+
+  RECORD_FUNC_TO_BACKTRACE("query::songmap::Cursor::refresh");
+
+  const size_t offset = m_offset;
+
+  m_generation = safeMap.version();
+  m_snap       = query::songmap::columns(safeMap);
+  m_order      = m_snap->order();
+
+  seek(m_artist, m_album, offset);
+  return true;
+}
+
+auto Cursor::seek(const Artist& artist, const Album& album, size_t offset) -> bool
+{
+  m_artist = artist;
+  m_album  = album;
+  m_albums = {};
+  m_rows   = 0;
+  m_offset = 0;
+
+  if (!m_snap)
+    return false;
+
+  const auto* a = m_snap->findArtist(artist);
+  if (!a)
+    return false;
+
+  m_albums = m_order->albumsOf(*m_snap, static_cast<ui32>(a - m_snap->artists.data()));
+
+  if (!album.empty())
+  {
+    const auto* al = m_snap->findAlbum(*a, album);
+    if (!al)
+    {
+      m_albums = {};
+      return false;
+    }
+
+    // narrow to the one album, still a slice of the plan order
+    const auto idx = static_cast<ui32>(al - m_snap->albums.data());
+    m_albums       = m_albums.subspan(std::ranges::find(m_albums, idx) - m_albums.begin(), 1);
+  }
+
+  for (const ui32 al : m_albums)
+    m_rows += rows(m_snap->albums[al]);
+
+  m_offset = std::min(offset, m_rows);
+  return true;
+}
+
+auto Cursor::next(size_t n, std::vector<Row>& out) -> size_t
+{
+  out.clear();
+
+  n = std::min(n, remaining());
+  if (n == 0)
+    return 0;
+
+  out.reserve(n);
+
+  // skip whole albums and discs before the position, then emit row by row
+  size_t skip = m_offset;
+
+  for (size_t k = 0; k < m_albums.size() && out.size() < n; ++k)
+  {
+    const ui32  ai = m_albums[k];
+    const auto& al = m_snap->albums[ai];
+
+    if (skip >= rows(al))
+    {
+      skip -= rows(al);
+      continue;
+    }
+
+    if (skip == 0)
+      out.push_back({Row::Kind::Album, ai});
+    else
+      --skip;
+
+    const auto discs = m_order->discsOf(*m_snap, ai);
+
+    for (size_t j = 0; j < discs.size() && out.size() < n; ++j)
+    {
+      const ui32  di = discs[j];
+      const auto& d  = m_snap->discs[di];
+
+      if (skip >= rows(d))
+      {
+        skip -= rows(d);
+        continue;
+      }
+
+      if (skip == 0)
+        out.push_back({Row::Kind::Disc, di});
+      else
+        --skip;
+
+      const auto songs = m_order->songsOfDisc(*m_snap, di);
+
+      for (size_t i = skip; i < songs.size() && out.size() < n; ++i)
+        out.push_back({Row::Kind::Song, songs[i]});
+
+      skip = 0;
+    }
+  }
+
+  m_offset += out.size();
+  return out.size();
+}
+
+} // namespace query::songmap
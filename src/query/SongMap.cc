@@ -2,6 +2,7 @@
 #include "InLimbo-Types.hpp"
 #include "Logger.hpp"
 #include "StackTrace.hpp"
+#include "query/Columns.hpp"
 #include "utils/algorithm/Levenshtein.hpp"
 #include "utils/string/Equals.hpp"
 #include <sys/types.h>
@@ -16,142 +17,64 @@ namespace strhelp = utils::string;
 namespace read
 {
 
+// Everything below runs on the columns of the currently published map (see
+// query/Columns.hpp). Callbacks and song lists follow the runtime sort plan (the SortOrder
+// of the columns); the fuzzy scans go through the columns as stored, ties between equally
+// close matches are not ordered.
+//
+// The std::function forEach* are the exported entry points, each forwards to its template in
+// query/Visit.hpp (the explicit template argument keeps it from picking itself again).
+
 void forEachArtist(const TS_SongMap&                                          safeMap,
                    const std::function<void(const Artist&, const AlbumMap&)>& fn)
 {
-  safeMap.read(
-    [&](const auto& map) -> void
-    {
-      for (const auto& [artist, albums] : map)
-        fn(artist, albums);
-    });
+  forEachArtist<decltype(fn)>(safeMap, fn);
 }
 
 void forEachAlbum(const TS_SongMap&                                                       safeMap,
                   const std::function<void(const Artist&, const Album&, const DiscMap&)>& fn)
 {
-  safeMap.read(
-    [&](const auto& map) -> void
-    {
-      for (const auto& [artist, albums] : map)
-        for (const auto& [album, discs] : albums)
-          fn(artist, album, discs);
-    });
+  forEachAlbum<decltype(fn)>(safeMap, fn);
 }
 
 void forEachDisc(
   const TS_SongMap&                                                                    safeMap,
   const std::function<void(const Artist&, const Album&, const Disc, const TrackMap&)>& fn)
 {
-  safeMap.read(
-    [&](const auto& map) -> void
-    {
-      for (const auto& [artist, albums] : map)
-        for (const auto& [album, discs] : albums)
-          for (const auto& [disc, tracks] : discs)
-            fn(artist, album, disc, tracks);
-    });
+  forEachDisc<decltype(fn)>(safeMap, fn);
 }
 
 void forEachSong(const TS_SongMap&                                        safeMap,
                  const std::function<void(const Artist&, const Album&, Disc, Track, ino_t,
                                           const std::shared_ptr<Song>&)>& fn)
 {
-  safeMap.read(
-    [&](const auto& map) -> void
-    {
-      for (const auto& [artist, albums] : map)
-        for (const auto& [album, discs] : albums)
-          for (const auto& [disc, tracks] : discs)
-            for (const auto& [track, inodeMap] : tracks)
-              for (const auto& [inode, song] : inodeMap)
-                fn(artist, album, disc, track, inode, song);
-    });
+  forEachSong<decltype(fn)>(safeMap, fn);
 }
 
 void forEachSongInArtist(const TS_SongMap& safeMap, const Artist& artistName,
                          const std::function<void(const Album&, const Disc, const Track,
                                                   const ino_t, const std::shared_ptr<Song>&)>& fn)
 {
-  safeMap.read(
-    [&](const auto& map) -> void
-    {
-      auto itArtist = map.find(artistName);
-      if (itArtist == map.end())
-        return;
-
-      for (const auto& [album, discs] : itArtist->second)
-        for (const auto& [disc, tracks] : discs)
-          for (const auto& [track, inodeMap] : tracks)
-            for (auto& [inode, song] : inodeMap)
-              fn(album, disc, track, inode, song);
-    });
+  forEachSongInArtist<decltype(fn)>(safeMap, artistName, fn);
 }
 
 void forEachSongInAlbum(
   const TS_SongMap& safeMap, const Artist& artistName, const Album& albumName,
   const std::function<void(const Disc, const Track, const ino_t, const std::shared_ptr<Song>&)>& fn)
 {
-  safeMap.read(
-    [&](const auto& map) -> void
-    {
-      auto itArtist = map.find(artistName);
-      if (itArtist == map.end())
-        return;
-
-      auto itAlbum = itArtist->second.find(albumName);
-      if (itAlbum == itArtist->second.end())
-        return;
-
-      for (const auto& [disc, tracks] : itAlbum->second)
-        for (const auto& [track, inodeMap] : tracks)
-          for (auto& [inode, song] : inodeMap)
-            fn(disc, track, inode, song);
-    });
+  forEachSongInAlbum<decltype(fn)>(safeMap, artistName, albumName, fn);
 }
 
 void forEachSongInDisc(
   const TS_SongMap& safeMap, const Artist& artistName, const Album& albumName, Disc discNumber,
   const std::function<void(const Track, const ino_t, const std::shared_ptr<Song>&)>& fn)
 {
-  safeMap.read(
-    [&](const auto& map) -> void
-    {
-      auto itArtist = map.find(artistName);
-      if (itArtist == map.end())
-        return;
-
-      auto itAlbum = itArtist->second.find(albumName);
-      if (itAlbum == itArtist->second.end())
-        return;
-
-      auto itDisc = itAlbum->second.find(discNumber);
-      if (itDisc == itAlbum->second.end())
-        return;
-
-      for (const auto& [track, inodeMap] : itDisc->second)
-        for (auto& [inode, song] : inodeMap)
-          fn(track, inode, song);
-    });
+  forEachSongInDisc<decltype(fn)>(safeMap, artistName, albumName, discNumber, fn);
 }
 
 void forEachGenre(const TS_SongMap& safeMap, const std::function<void(const Genre&)>& fn)
 {
-  std::set<Genre> genres;
-
-  safeMap.read(
-    [&](const auto& map) -> void
-    {
-      for (const auto& [artist, albums] : map)
-        for (const auto& [album, discs] : albums)
-          for (const auto& [disc, tracks] : discs)
-            for (const auto& [track, inodeMap] : tracks)
-              for (const auto& [inode, song] : inodeMap)
-                genres.insert(song->metadata.genre);
-    });
-
-  for (const auto& g : genres)
-    fn(g);
+  forEachGenre<decltype(fn)>(safeMap, fn);
 }
 
 void forEachSongInGenre(
@@ -159,43 +82,13 @@ void forEachSongInGenre(
   const std::function<void(const Artist&, const Album&, const Disc, const Track, const ino_t,
                            const std::shared_ptr<Song>&)>& fn)
 {
-  safeMap.read(
-    [&](const auto& map) -> void
-    {
-      for (const auto& [artist, albums] : map)
-        for (const auto& [album, discs] : albums)
-          for (const auto& [disc, tracks] : discs)
-            for (const auto& [track, inodeMap] : tracks)
-              for (auto& [inode, song] : inodeMap)
-                if (strhelp::isEquals(song->metadata.genre, genreName))
-                  fn(artist, album, disc, track, inode, song);
-    });
+  forEachSongInGenre<decltype(fn)>(safeMap, genreName, fn);
 }
 
 void forEachGenreInArtist(const TS_SongMap& safeMap, const Artist& artistName,
                           const std::function<void(const Genre&)>& fn)
 {
-  std::set<Genre> genres;
-
-  safeMap.read(
-    [&](const auto& map) -> void
-    {
-      auto itArtist = map.find(artistName);
-      if (itArtist == map.end())
-        return;
-
-      for (const auto& [album, discs] : itArtist->second)
-        for (const auto& [disc, tracks] : discs)
-          for (const auto& [track, inodeMap] : tracks)
-            for (const auto& [inode, song] : inodeMap)
-            {
-              if (!song->metadata.genre.empty())
-                genres.insert(song->metadata.genre);
-            }
-    });
-
-  for (const auto& g : genres)
-    fn(g);
+  forEachGenreInArtist<decltype(fn)>(safeMap, artistName, fn);
 }
 
 auto findAllSongsByTitle(const TS_SongMap& safeMap, const Title& songTitle) -> Songs
@@ -207,13 +100,14 @@ auto findAllSongsByTitle(const TS_SongMap& safeMap, const Title& songTitle) -> S
   if (songTitle.empty())
     return results;
 
-  forEachSong(
-    safeMap,
-    [&](const Artist&, const Album&, Disc, Track, ino_t, const std::shared_ptr<Song>& song) -> void
-    {
-      if (strhelp::isEquals(song->metadata.title, songTitle))
-        results.push_back(song);
-    });
+  const auto c = columns(safeMap);
+
+  c->forEachTitle(songTitle,
+                  [&](ui32 i) -> bool
+                  {
+                    results.push_back(c->songAt(i));
+                    return true;
+                  });
 
   return results;
 }
@@ -228,28 +122,27 @@ auto findAllSongsByTitleFuzzy(const TS_SongMap& safeMap, const Title& songTitle,
   if (songTitle.empty())
     return results;
 
-  const auto qLower = utils::string::transform::tolower_ascii(songTitle.c_str());
+  const utils::algorithm::LevenshteinPattern query(songTitle, true);
 
   std::vector<std::pair<size_t, std::shared_ptr<Song>>> matches;
 
-  forEachSong(
-    safeMap,
-    [&](const Artist&, const Album&, Disc, Track, ino_t, const std::shared_ptr<Song>& song) -> void
-    {
-      if (song->metadata.title.empty())
-        return;
-
-      const auto tLower = utils::string::transform::tolower_ascii(song->metadata.title.c_str());
-
-      const size_t d = utils::algorithm::StringDistance::levenshteinDistance(
-        tLower.c_str(), qLower.c_str(), maxDistance);
+  const auto c = columns(safeMap);
+  const auto o = c->order();
 
-      if (d <= maxDistance)
-        matches.emplace_back(d, song);
+  // in plan order, a stable sort keeps songs at the same distance in the order the library
+  // is shown in (the map order depends on the scan)
+  query.forEachWithin(
+    o->songs.size(), [&](size_t k) -> std::string_view { return c->title[o->songs[k]]; },
+    maxDistance,
+    [&](size_t k, size_t d) -> void
+    {
+      const ui32 i = o->songs[k];
+      if (!c->title[i].empty())
+        matches.emplace_back(d, c->songAt(i));
     });
 
-  std::ranges::sort(matches,
-                    [](const auto& a, const auto& b) -> bool { return a.first < b.first; });
+  std::ranges::stable_sort(matches,
+                           [](const auto& a, const auto& b) -> bool { return a.first < b.first; });
 
   results.reserve(matches.size());
   for (auto& [_, song] : matches)
@@ -262,34 +155,37 @@ auto findSongPathByInode(const TS_SongMap& safeMap, const ino_t givenInode) -> P
 {
   RECORD_FUNC_TO_BACKTRACE("query::songmap::read::findSongPathByInode");
 
-  PathStr path;
+  const auto c = columns(safeMap);
+  const ui32 i = c->findInode(givenInode);
 
-  forEachSong(safeMap,
-              [&](const Artist&, const Album&, Disc, Track, ino_t inode,
-                  const std::shared_ptr<Song>& song) -> void
-              {
-                if (inode == givenInode)
-                  path = song->metadata.filePath;
-              });
+  return i == SongColumns::NONE ? PathStr{} : (c->songAt(i))->metadata.filePath;
+}
 
-  return path;
+auto findSongObjByPath(const TS_SongMap& safeMap, std::string_view path) -> std::shared_ptr<Song>
+{
+  RECORD_FUNC_TO_BACKTRACE("query::songmap::read::findSongObjByPath");
+
+  const auto c = columns(safeMap);
+  const ui32 i = c->findPath(path);
+
+  return i == SongColumns::NONE ? nullptr : c->songAt(i);
 }
 
 auto findSongObjByTitle(const TS_SongMap& safeMap, const Title& songTitle) -> std::shared_ptr<Song>
 {
   RECORD_FUNC_TO_BACKTRACE("query::songmap::read::findSongByName");
 
-  std::shared_ptr<Song> result;
+  const auto c = columns(safeMap);
 
-  forEachSong(
-    safeMap,
-    [&](const Artist&, const Album&, Disc, Track, ino_t, const std::shared_ptr<Song>& song) -> void
-    {
-      if (!result && strhelp::isEquals(song->metadata.title, songTitle))
-        result = song;
-    });
+  std::shared_ptr<Song> found;
+  c->forEachTitle(songTitle,
+                  [&](ui32 i) -> bool
+                  {
+                    found = c->songAt(i);
+                    return false;
+                  });
 
-  return result;
+  return found;
 }
 
 auto findSongObjByTitleFuzzy(const TS_SongMap& safeMap, const Title& songTitle, size_t maxDistance)
@@ -300,31 +196,29 @@ auto findSongObjByTitleFuzzy(const TS_SongMap& safeMap, const Title& songTitle,
   if (songTitle.empty())
     return {};
 
-  const auto qLower = utils::string::transform::tolower_ascii(songTitle.c_str());
-
-  std::shared_ptr<Song> bestSong;
-  size_t                bestScore = SIZE_MAX;
-
-  forEachSong(
-    safeMap,
-    [&](const Artist&, const Album&, Disc, Track, ino_t, const std::shared_ptr<Song>& song) -> void
-    {
-      if (song->metadata.title.empty())
-        return;
+  const utils::algorithm::LevenshteinPattern query(songTitle, true);
 
-      const auto tLower = utils::string::transform::tolower_ascii(song->metadata.title.c_str());
+  const auto c = columns(safeMap);
+  const auto o = c->order();
 
-      const size_t d = utils::algorithm::StringDistance::levenshteinDistance(
-        tLower.c_str(), qLower.c_str(), maxDistance);
+  size_t best      = SIZE_MAX;
+  size_t bestScore = SIZE_MAX;
 
-      if (d <= maxDistance && d < bestScore)
+  // ties go to the first song in plan order
+  query.forEachWithin(
+    o->songs.size(), [&](size_t k) -> std::string_view { return c->title[o->songs[k]]; },
+    maxDistance,
+    [&](size_t k, size_t d) -> void
+    {
+      const ui32 i = o->songs[k];
+      if (!c->title[i].empty() && d < bestScore)
       {
         bestScore = d;
-        bestSong  = song;
+        best      = i;
       }
     });
 
-  return bestSong;
+  return best == SIZE_MAX ? nullptr : c->songAt(best);
 }
 
 auto findArtistFuzzy(const TS_SongMap& safeMap, const Artist& artistName, size_t maxDistance)
@@ -335,28 +229,28 @@ auto findArtistFuzzy(const TS_SongMap& safeMap, const Artist& artistName, size_t
   if (artistName.empty())
     return {};
 
-  const auto qLower = utils::string::transform::tolower_ascii(artistName.c_str());
+  const utils::algorithm::LevenshteinPattern query(artistName, true);
+
+  const auto c = columns(safeMap);
 
   Artist bestArtist;
   size_t bestScore = SIZE_MAX;
 
-  forEachArtist(safeMap,
-                [&](const Artist& artist, const AlbumMap&) -> void
-                {
-                  if (artist.empty())
-                    return;
-
-                  const auto aLower = utils::string::transform::tolower_ascii(artist.c_str());
+  // ties go to the first artist in plan order
+  for (const ui32 ai : c->order()->artists)
+  {
+    const auto& a = c->artists[ai];
+    if (a.name.empty())
+      continue;
 
-                  const size_t d = utils::algorithm::StringDistance::levenshteinDistance(
-                    aLower.c_str(), qLower.c_str(), maxDistance);
+    const size_t d = query.distance(a.name, maxDistance);
 
-                  if (d <= maxDistance && d < bestScore)
-                  {
-                    bestScore  = d;
-                    bestArtist = artist;
-                  }
-                });
+    if (d <= maxDistance && d < bestScore)
+    {
+      bestScore  = d;
+      bestArtist = a.name;
+    }
+  }
 
   return bestArtist;
 }
@@ -368,31 +262,28 @@ auto findAlbumFuzzy(const TS_SongMap& safeMap, const Album& albumName, size_t ma
   if (albumName.empty())
     return {};
 
-  const auto qLower = utils::string::transform::tolower_ascii(albumName.c_str());
+  const utils::algorithm::LevenshteinPattern query(albumName, true);
+
+  const auto c = columns(safeMap);
 
   Album  bestAlbum;
   size_t bestScore = SIZE_MAX;
 
-  forEachArtist(safeMap,
-                [&](const Artist&, const AlbumMap& albums) -> void
-                {
-                  for (const auto& [album, discs] : albums)
-                  {
-                    if (album.empty())
-                      continue;
-
-                    const auto alLower = utils::string::transform::tolower_ascii(album.c_str());
+  // ties go to the first album in plan order
+  for (const ui32 ali : c->order()->albums)
+  {
+    const auto& al = c->albums[ali];
+    if (al.name.empty())
+      continue;
 
-                    const size_t d = utils::algorithm::StringDistance::levenshteinDistance(
-                      alLower.c_str(), qLower.c_str(), maxDistance);
+    const size_t d = query.distance(al.name, maxDistance);
 
-                    if (d <= maxDistance && d < bestScore)
-                    {
-                      bestScore = d;
-                      bestAlbum = album;
-                    }
-                  }
-                });
+    if (d <= maxDistance && d < bestScore)
+    {
+      bestScore = d;
+      bestAlbum = al.name;
+    }
+  }
 
   return bestAlbum;
 }
@@ -404,30 +295,27 @@ auto findGenreFuzzy(const TS_SongMap& safeMap, const Genre& genreName, size_t ma
   if (genreName.empty())
     return {};
 
-  const auto qLower = utils::string::transform::tolower_ascii(genreName.c_str());
+  const utils::algorithm::LevenshteinPattern query(genreName, true);
+
+  const auto c = columns(safeMap);
 
   Genre  bestGenre;
   size_t bestScore = SIZE_MAX;
 
-  forEachSong(
-    safeMap,
-    [&](const Artist&, const Album&, Disc, Track, ino_t, const std::shared_ptr<Song>& song) -> void
-    {
-      const auto& g = song->metadata.genre;
-      if (g.empty())
-        return;
-
-      const auto gLower = utils::string::transform::tolower_ascii(g.c_str());
+  // every distinct genre once, sorted by name: ties go to the first one
+  for (const auto& g : c->genres)
+  {
+    if (g.name.empty())
+      continue;
 
-      const size_t d = utils::algorithm::StringDistance::levenshteinDistance(
-        gLower.c_str(), qLower.c_str(), maxDistance);
+    const size_t d = query.distance(g.name, maxDistance);
 
-      if (d <= maxDistance && d < bestScore)
-      {
-        bestScore = d;
-        bestGenre = g;
-      }
-    });
+    if (d <= maxDistance && d < bestScore)
+    {
+      bestScore = d;
+      bestGenre = g.name;
+    }
+  }
 
   return bestGenre;
 }
@@ -437,20 +325,20 @@ auto findSongByTitleAndArtist(const TS_SongMap& safeMap, const Artist& artistNam
 {
   RECORD_FUNC_TO_BACKTRACE("query::songmap::read::findSongByNameAndArtist");
 
-  std::shared_ptr<Song> result;
+  const auto c = columns(safeMap);
+  const auto o = c->order();
 
-  forEachSong(safeMap,
-              [&](const Artist&                artist, const Album&, Disc, Track, ino_t,
-                  const std::shared_ptr<Song>& song) -> void
-              {
-                if (!result && strhelp::isEquals(artist, artistName) &&
-                    strhelp::isEquals(song->metadata.title, songTitle))
-                {
-                  result = song;
-                }
-              });
+  for (const ui32 a : o->artists)
+  {
+    if (!strhelp::isEquals(c->artists[a].name, artistName))
+      continue;
 
-  return result;
+    for (const ui32 i : o->songsOfArtist(*c, a))
+      if (strhelp::isEquals(c->title[i], songTitle))
+        return c->songAt(i);
+  }
+
+  return {};
 }
 
 auto findSongByTitleAndArtistFuzzy(const TS_SongMap& safeMap, const Title& songTitle,
@@ -462,30 +350,43 @@ auto findSongByTitleAndArtistFuzzy(const TS_SongMap& safeMap, const Title& songT
   if (songTitle.empty() || songArtist.empty())
     return {};
 
-  std::shared_ptr<Song> bestSong;
-  size_t                bestScoreSong = SIZE_MAX;
+  const utils::algorithm::LevenshteinPattern titleQuery(songTitle);
+  const utils::algorithm::LevenshteinPattern artistQuery(songArtist);
 
-  forEachSong(safeMap,
-              [&](const Artist&                artist, const Album&, Disc, Track, ino_t,
-                  const std::shared_ptr<Song>& song) -> void
-              {
-                if (song->metadata.title.empty() || song->metadata.artist.empty())
-                  return;
+  const auto c = columns(safeMap);
+  const auto o = c->order();
 
-                const size_t sd = utils::algorithm::StringDistance::levenshteinDistance(
-                  song->metadata.title, songTitle, maxDistance);
+  size_t best          = SIZE_MAX;
+  size_t bestScoreSong = SIZE_MAX;
 
-                const size_t ad = utils::algorithm::StringDistance::levenshteinDistance(
-                  artist, songArtist, maxDistance);
+  // plan order, ties go to the first song the library shows
+  for (const ui32 ai : o->artists)
+  {
+    const auto& a = c->artists[ai];
+    if (a.name.empty())
+      continue;
 
-                if (sd <= maxDistance && ad <= maxDistance && sd < bestScoreSong)
-                {
-                  bestScoreSong = sd;
-                  bestSong      = song;
-                }
-              });
+    // the artist distance is the same for every song of the group
+    if (artistQuery.distance(a.name, maxDistance) > maxDistance)
+      continue;
 
-  return bestSong;
+    const auto songs = o->songsOfArtist(*c, ai);
+
+    titleQuery.forEachWithin(
+      songs.size(), [&](size_t j) -> std::string_view { return c->title[songs[j]]; },
+      maxDistance,
+      [&](size_t j, size_t sd) -> void
+      {
+        const ui32 i = songs[j];
+        if (!c->title[i].empty() && sd < bestScoreSong)
+        {
+          bestScoreSong = sd;
+          best          = i;
+        }
+      });
+  }
+
+  return best == SIZE_MAX ? nullptr : c->songAt(best);
 }
 
 auto getSongsByAlbum(const TS_SongMap& safeMap, const Artist& artist, const Album& album)
@@ -495,13 +396,18 @@ auto getSongsByAlbum(const TS_SongMap& safeMap, const Artist& artist, const Albu
 
   Songs songs;
 
-  forEachSong(safeMap,
-              [&](const Artist& a, const Album& al, Disc, Track, ino_t,
-                  const std::shared_ptr<Song>& song) -> void
-              {
-                if (strhelp::isEquals(a, artist) && strhelp::isEquals(al, album))
-                  songs.push_back(song);
-              });
+  const auto c = columns(safeMap);
+  const auto o = c->order();
+
+  for (const ui32 al : o->albums)
+  {
+    if (!strhelp::isEquals(c->artists[c->albums[al].artist].name, artist) ||
+        !strhelp::isEquals(c->albums[al].name, album))
+      continue;
+
+    for (const ui32 i : o->songsOfAlbum(*c, al))
+      songs.push_back(c->songAt(i));
+  }
 
   return songs;
 }
@@ -515,13 +421,17 @@ auto getSongsByArtist(const TS_SongMap& safeMap, const Artist& artist) -> Songs
   if (artist.empty())
     return songs;
 
-  forEachSong(safeMap,
-              [&](const Artist&                a, const Album&, Disc, Track, ino_t,
-                  const std::shared_ptr<Song>& song) -> void
-              {
-                if (strhelp::isEquals(a, artist))
-                  songs.push_back(song);
-              });
+  const auto c = columns(safeMap);
+  const auto o = c->order();
+
+  for (const ui32 a : o->artists)
+  {
+    if (!strhelp::isEquals(c->artists[a].name, artist))
+      continue;
+
+    for (const ui32 i : o->songsOfArtist(*c, a))
+      songs.push_back(c->songAt(i));
+  }
 
   return songs;
 }
@@ -535,13 +445,9 @@ auto getSongsByGenre(const TS_SongMap& safeMap, const Genre& genre) -> Songs
   if (genre.empty())
     return songs;
 
-  forEachSong(
-    safeMap,
-    [&](const Artist&, const Album&, Disc, Track, ino_t, const std::shared_ptr<Song>& song) -> void
-    {
-      if (strhelp::isEquals(song->metadata.genre, genre))
-        songs.push_back(song);
-    });
+  const auto c = columns(safeMap);
+
+  c->forEachSongInGenre(genre, [&](ui32 i) -> void { songs.push_back(c->songAt(i)); });
 
   return songs;
 }
@@ -550,13 +456,7 @@ auto countTracks(const TS_SongMap& safeMap) -> size_t
 {
   RECORD_FUNC_TO_BACKTRACE("query::songmap::read::countTracks");
 
-  size_t total = 0;
-
-  forEachSong(safeMap,
-              [&](const Artist&, const Album&, Disc, Track, ino_t,
-                  const std::shared_ptr<Song>&) -> void { ++total; });
-
-  return total;
+  return columns(safeMap)->totals.tracks;
 }
 
 auto countSongsByArtist(const TS_SongMap& safeMap, const Artist& artist) -> size_t
@@ -568,13 +468,9 @@ auto countSongsByArtist(const TS_SongMap& safeMap, const Artist& artist) -> size
 
   size_t count = 0;
 
-  forEachSong(
-    safeMap,
-    [&](const Artist& a, const Album&, Disc, Track, ino_t, const std::shared_ptr<Song>&) -> void
-    {
-      if (strhelp::isEquals(a, artist))
-        ++count;
-    });
+  for (const auto& a : columns(safeMap)->artists)
+    if (strhelp::isEquals(a.name, artist))
+      count += a.songCount;
 
   return count;
 }
@@ -587,25 +483,14 @@ auto countSongsByAlbum(const TS_SongMap& safeMap, const Artist& artist, const Al
   if (artist.empty() || album.empty())
     return 0;
 
-  size_t count = 0;
-
-  safeMap.read(
-    [&](const auto& map) -> void
-    {
-      auto itArtist = map.find(artist);
-      if (itArtist == map.end())
-        return;
-
-      auto itAlbum = itArtist->second.find(album);
-      if (itAlbum == itArtist->second.end())
-        return;
+  const auto c = columns(safeMap);
 
-      for (const auto& [disc, tracks] : itAlbum->second)
-        for (const auto& [track, inodeMap] : tracks)
-          count += inodeMap.size();
-    });
+  const auto* a = c->findArtist(artist);
+  if (!a)
+    return 0;
 
-  return count;
+  const auto* al = c->findAlbum(*a, album);
+  return al ? al->songCount : 0;
 }
 
 auto countSongsByGenre(const TS_SongMap& safeMap, const Genre& genre) -> size_t
@@ -617,13 +502,8 @@ auto countSongsByGenre(const TS_SongMap& safeMap, const Genre& genre) -> size_t
 
   size_t count = 0;
 
-  forEachSong(
-    safeMap,
-    [&](const Artist&, const Album&, Disc, Track, ino_t, const std::shared_ptr<Song>& song) -> void
-    {
-      if (strhelp::isEquals(song->metadata.genre, genre))
-        ++count;
-    });
+  for (const auto* g : columns(safeMap)->matchGenre(genre))
+    count += g->songCount;
 
   return count;
 }
@@ -632,49 +512,21 @@ auto countArtists(const TS_SongMap& safeMap) -> size_t
 {
   RECORD_FUNC_TO_BACKTRACE("query::songmap::read::countArtists");
 
-  std::set<Artist> artists;
-
-  forEachArtist(safeMap,
-                [&](const Artist& artist, const AlbumMap&) -> void
-                {
-                  if (!artist.empty())
-                    artists.insert(artist);
-                });
-
-  return artists.size();
+  return columns(safeMap)->totals.artists;
 }
 
 auto countAlbums(const TS_SongMap& safeMap) -> size_t
 {
   RECORD_FUNC_TO_BACKTRACE("query::songmap::read::countAlbums");
 
-  std::set<Album> albums;
-
-  forEachAlbum(safeMap,
-               [&](const Artist&, const Album& album, const DiscMap&) -> void
-               {
-                 if (!album.empty())
-                   albums.insert(album);
-               });
-
-  return albums.size();
+  return columns(safeMap)->totals.albums;
 }
 
 auto countGenres(const TS_SongMap& safeMap) -> size_t
 {
   RECORD_FUNC_TO_BACKTRACE("query::songmap::read::countGenres");
 
-  std::set<Genre> genres;
-
-  forEachSong(
-    safeMap,
-    [&](const Artist&, const Album&, Disc, Track, ino_t, const std::shared_ptr<Song>& song) -> void
-    {
-      if (!song->metadata.genre.empty())
-        genres.insert(song->metadata.genre);
-    });
-
-  return genres.size();
+  return columns(safeMap)->totals.genres;
 }
 
 } // namespace read
@@ -686,16 +538,16 @@ void sortSongMap(TS_SongMap& safeMap, const query::sort::RuntimeSortPlan& rtSort
 {
   RECORD_FUNC_TO_BACKTRACE("query::songmap::mut::sortSongMap");
 
-  safeMap.update(
-    [&](auto& map) -> void
-    {
-      LOG_DEBUG("query::songmap::mut::sortSongMap: Provided runtime sort plan: artist={}, "
-                "album={}, track={}",
-                static_cast<int>(rtSortPlan.artist), static_cast<int>(rtSortPlan.album),
-                static_cast<int>(rtSortPlan.track));
+  LOG_DEBUG("query::songmap::mut::sortSongMap: Provided runtime sort plan: artist={}, "
+            "album={}, track={}",
+            static_cast<int>(rtSortPlan.artist), static_cast<int>(rtSortPlan.album),
+            static_cast<int>(rtSortPlan.track));
 
-      query::sort::applyRuntimeSortPlan(map, rtSortPlan);
-    });
+  // only the order of the columns changes. The same map is published again so anything
+  // keyed on version() (cursors, cached lists in the frontends) picks the new order up, its
+  // columns are kept since it shares every table with the previous one.
+  if (setSortPlan(safeMap, rtSortPlan))
+    safeMap.update([](SongMap&) -> void {});
 }
 
 auto replaceSongObjAndUpdateMetadata(TS_SongMap& safeMap, const std::shared_ptr<Song>& oldSong,
@@ -709,18 +561,20 @@ auto replaceSongObjAndUpdateMetadata(TS_SongMap& safeMap, const std::shared_ptr<
   return safeMap.update(
     [&](auto& map) -> bool
     {
-      for (auto& [artist, albums] : map)
-        for (auto& [album, discs] : albums)
-          for (auto& [disc, tracks] : discs)
-            for (auto& [track, inodeMap] : tracks)
-              for (auto& [inodeKey, song] : inodeMap)
+      // look the song up through const (a non-const walk would detach every table of the
+      // persistent map), then write through its path only
+      for (const auto& [artist, albums] : std::as_const(map))
+        for (const auto& [album, discs] : albums)
+          for (const auto& [disc, tracks] : discs)
+            for (const auto& [track, inodeMap] : tracks)
+              for (const auto& [inodeKey, song] : inodeMap)
                 if (inodeKey == oldSong->inode)
                 {
                   LOG_INFO("Match found -> Artist='{}', Title='{}', Album='{}', Disc={}, Track={}, "
                            "Inode={}",
                            artist, song->metadata.title, album, disc, track, inodeKey);
 
-                  song = std::make_shared<Song>(*newSong);
+                  map[artist][album][disc][track][inodeKey] = std::make_shared<Song>(*newSong);
 
                   if (parser.modifyMetadata(newSong->metadata.filePath.c_str(), newSong->metadata))
                     return true;
@@ -733,6 +587,105 @@ auto replaceSongObjAndUpdateMetadata(TS_SongMap& safeMap, const std::shared_ptr<
     });
 }
 
+auto applyLibraryDelta(TS_SongMap& safeMap, const LibraryDelta& delta,
+                       const query::sort::RuntimeSortPlan& rtSortPlan) -> size_t
+{
+  RECORD_FUNC_TO_BACKTRACE("query::songmap::mut::applyLibraryDelta");
+
+  if (delta.empty())
+    return 0;
+
+  // an upserted path drops whatever was filed under it before (tags may have moved the song
+  // to another artist / album, so it is matched by path and not by its old keys)
+  ankerl::unordered_dense::set<std::string_view> drop;
+  for (const auto& path : delta.removedFiles)
+    drop.insert(path);
+  for (const auto& song : delta.upserts)
+    drop.insert(song->metadata.filePath);
+
+  auto dropped = [&](const std::string& path) -> bool
+  {
+    if (drop.contains(path))
+      return true;
+
+    return std::ranges::any_of(delta.removedDirs,
+                               [&](const std::string& dir) -> bool
+                               {
+                                 return path.size() > dir.size() && path.starts_with(dir) &&
+                                        path[dir.size()] == '/';
+                               });
+  };
+
+  const size_t erased = safeMap.update(
+    [&](auto& map) -> size_t
+    {
+      struct Filed
+      {
+        Artist artist;
+        Album  album;
+        Disc   disc;
+        Track  track;
+        ino_t  inode;
+      };
+
+      // find the dropped songs through const first, then erase each along its own path: only
+      // the tables on those paths are copied, and nothing is erased from a level while it is
+      // being iterated
+      std::vector<Filed> gone;
+      for (const auto& [artist, albums] : std::as_const(map))
+        for (const auto& [album, discs] : albums)
+          for (const auto& [disc, tracks] : discs)
+            for (const auto& [track, inodes] : tracks)
+              for (const auto& [inode, song] : inodes)
+                if (dropped(song->metadata.filePath))
+                  gone.push_back({artist, album, disc, track, inode});
+
+      // levels left empty are pruned bottom up
+      for (const auto& f : gone)
+      {
+        auto& albums = map[f.artist];
+        auto& discs  = albums[f.album];
+        auto& tracks = discs[f.disc];
+        auto& inodes = tracks[f.track];
+
+        inodes.erase(f.inode);
+        if (!inodes.empty())
+          continue;
+
+        tracks.erase(f.track);
+        if (!tracks.empty())
+          continue;
+
+        discs.erase(f.disc);
+        if (!discs.empty())
+          continue;
+
+        albums.erase(f.album);
+        if (albums.empty())
+          map.erase(f.artist);
+      }
+
+      const size_t removed = gone.size();
+
+      for (const auto& song : delta.upserts)
+      {
+        const auto& md = song->metadata;
+        map[md.artist][md.album][md.discNumber][md.track][song->inode] = song;
+      }
+
+      LOG_DEBUG("query::songmap::mut::applyLibraryDelta: Dropped {} song(s), upserted {} song(s)",
+                removed, delta.upserts.size());
+
+      return removed;
+    });
+
+  // after the publish: the columns of the replaced map are not re-sorted for nothing, the
+  // ones of the result are built ordered by it
+  setSortPlan(safeMap, rtSortPlan);
+
+  return erased;
+}
+
 } // namespace mut
 
 } // namespace query::songmap
@@ -1,27 +1,61 @@
 #include "query/sort/Engine.hpp"
-#include "Logger.hpp"
-#include "StackTrace.hpp"
+
+#include <algorithm>
 
 namespace query::sort
 {
 
-static auto dispatchTable() -> const auto&
+namespace
+{
+
+void push(std::vector<metric::Step>& steps, metric::Step s)
 {
-  static const auto table = buildDispatch(std::make_index_sequence<TOTAL>{});
-  return table;
+  if (std::ranges::none_of(steps, [&](const metric::Step& x) -> bool { return x.key == s.key; }))
+    steps.push_back(s);
+}
+
+} // namespace
+
+auto compile(const RuntimeSortPlan& plan) -> SortProgram
+{
+  SortProgram p;
+
+  push(p.artist, metric::step(plan.artist));
+  for (const auto m : plan.artistThen)
+    push(p.artist, metric::step(m));
+
+  push(p.album, metric::step(plan.album));
+  for (const auto m : plan.albumThen)
+    push(p.album, metric::step(m));
+
+  push(p.disc, metric::step(plan.disc));
+  push(p.track, metric::step(plan.track));
+
+  return p;
 }
 
-void applyRuntimeSortPlan(SongMap& map, const RuntimeSortPlan& plan)
+auto hash(const SortProgram& program) noexcept -> ui64
 {
-  RECORD_FUNC_TO_BACKTRACE("query::sort::applyRuntimeSortPlan");
+  // FNV-1a over (key, direction) bytes, each level closed by a byte no step uses
+  ui64 h = 14695981039346656037ULL;
 
-  size_t index = static_cast<size_t>(plan.artist) * (AlbumCount * DiscCount * TrackCount) +
-                 static_cast<size_t>(plan.album) * (DiscCount * TrackCount) +
-                 static_cast<size_t>(plan.disc) * TrackCount + static_cast<size_t>(plan.track);
+  const auto mix = [&](ui8 byte) -> void
+  {
+    h ^= byte;
+    h *= 1099511628211ULL;
+  };
 
-  dispatchTable()[index](map);
+  for (const auto* level : {&program.artist, &program.album, &program.disc, &program.track})
+  {
+    for (const auto& step : *level)
+    {
+      mix(static_cast<ui8>(step.key));
+      mix(static_cast<ui8>(step.dir));
+    }
+    mix(0xFF);
+  }
 
-  LOG_DEBUG("query::sort::applyRuntimeSortPlan: Applied sort plan!");
+  return h == 0 ? 1 : h;
 }
 
 } // namespace query::sort
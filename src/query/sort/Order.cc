@@ -0,0 +1,429 @@
+#include "query/sort/Order.hpp"
+#include "StackTrace.hpp"
+#include "utils/string/Unicode.hpp"
+#include "utils/threads/WorkStealingPool.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+namespace query::sort
+{
+
+namespace
+{
+
+using songmap::SongColumns;
+using songmap::SortOrder;
+
+// sorting these orders by key, equal keys by index (the map order)
+constexpr auto pack(ui32 key, ui32 index) noexcept -> ui64
+{
+  return (static_cast<ui64>(key) << 32) | index;
+}
+
+constexpr auto unpack(ui64 word) noexcept -> ui32 { return static_cast<ui32>(word); }
+
+// below this many songs the order is built on the calling thread, handing the work to the
+// pool would cost more than it saves
+constexpr size_t PARALLEL_MIN_SONGS = 50000;
+
+using Pool = utils::threads::WorkStealingPool;
+
+// The pools buildOrder runs on, one per thread count asked for, started on first use and
+// kept for the life of the process: a plan change, a reload or a watcher batch does not
+// start and join threads again. Concurrent orders may share a pool, wait() then also waits
+// for the other's chunks, which is correct, only not as early as it could return.
+auto sharedPool(size_t threads) -> Pool&
+{
+  static std::mutex                                                  mtx;
+  static ankerl::unordered_dense::map<size_t, std::unique_ptr<Pool>> pools;
+
+  std::lock_guard lock(mtx);
+
+  auto& pool = pools[threads];
+  if (!pool)
+    pool = std::make_unique<Pool>(threads);
+  return *pool;
+}
+
+// fn(first, last) over [0, n) in contiguous chunks, on the pool if there is one. Chunks only
+// ever write their own indexes, so the result does not depend on how [0, n) was split.
+template <typename Fn>
+void forChunks(Pool* pool, size_t n, Fn&& fn)
+{
+  if (!pool || n < 2)
+  {
+    fn(size_t{0}, n);
+    return;
+  }
+
+  // a few chunks per worker, stealing evens out the uneven ones
+  const size_t parts = std::min(n, pool->size() * 8);
+
+  for (size_t p = 0; p < parts; ++p)
+  {
+    const size_t first = n * p / parts;
+    const size_t last  = n * (p + 1) / parts;
+
+    if (first < last)
+      pool->submit([&fn, first, last](size_t) -> void { fn(first, last); });
+  }
+
+  pool->wait();
+}
+
+// the words of [first, first + count), sorted
+template <typename KeyFn>
+void sortRange(std::vector<ui64>& words, ui32 first, ui32 count, KeyFn&& key)
+{
+  words.clear();
+  for (ui32 i = first; i < first + count; ++i)
+    words.push_back(pack(key(i), i));
+
+  if (count > 1)
+    std::ranges::sort(words);
+}
+
+// First 8 case folded codepoints, a byte each: ASCII is cp + 1, 0 ends the name and
+// anything else is 0xFF and ends the prefix (two non ASCII codepoints cannot be ordered in
+// a byte). Comparing prefixes agrees with utils::string::icompare wherever they differ.
+auto foldedPrefix(std::string_view s) noexcept -> ui64
+{
+  const char* p = s.data();
+  const char* e = p + s.size();
+
+  ui64 prefix = 0;
+  int  bytes  = 0;
+
+  for (; bytes < 8 && p < e; ++bytes)
+  {
+    const char32_t cp = utils::string::unicode_tolower(utils::string::utf8_decode(p, e));
+
+    prefix = (prefix << 8) | (cp < 0x80 ? cp + 1 : 0xFF);
+    if (cp >= 0x80)
+    {
+      ++bytes;
+      break;
+    }
+  }
+
+  return bytes == 0 ? 0 : prefix << (8 * (8 - bytes));
+}
+
+// rank of every group name in icompare order, names equal ignoring case share a rank
+template <typename Group>
+auto rankNames(const std::vector<Group>& groups) -> std::vector<ui32>
+{
+  const auto name = [&](ui32 i) -> std::string_view { return groups[i].name; };
+
+  std::vector<std::pair<ui64, ui32>> keyed;
+  keyed.reserve(groups.size());
+  for (ui32 i = 0; i < groups.size(); ++i)
+    keyed.emplace_back(foldedPrefix(name(i)), i);
+
+  std::ranges::sort(keyed);
+
+  // runs the prefix could not tell apart, usually none or a few short ones
+  for (size_t b = 0; b < keyed.size();)
+  {
+    size_t e = b + 1;
+    while (e < keyed.size() && keyed[e].first == keyed[b].first)
+      ++e;
+
+    if (e - b > 1)
+      std::sort(keyed.begin() + static_cast<std::ptrdiff_t>(b),
+                keyed.begin() + static_cast<std::ptrdiff_t>(e),
+                [&](const auto& x, const auto& y) -> bool
+                {
+                  if (utils::string::icompare(name(x.second), name(y.second)))
+                    return true;
+                  if (utils::string::icompare(name(y.second), name(x.second)))
+                    return false;
+                  return x.second < y.second;
+                });
+    b = e;
+  }
+
+  std::vector<ui32> rank(groups.size());
+
+  ui32 r = 0;
+  for (size_t k = 0; k < keyed.size(); ++k)
+  {
+    if (k > 0 &&
+        (keyed[k].first != keyed[k - 1].first ||
+         utils::string::icompare(name(keyed[k - 1].second), name(keyed[k].second))))
+      ++r;
+
+    rank[keyed[k].second] = r;
+  }
+
+  return rank;
+}
+
+void complement(std::vector<ui32>& keys)
+{
+  for (auto& k : keys)
+    k = ~k;
+}
+
+// one key per artist group, keys that are not on this level project to 0
+auto artistProjection(const SongColumns& c, metric::Key key) -> std::vector<ui32>
+{
+  using K = metric::Key;
+
+  if (key == K::Name)
+    return rankNames(c.artists);
+
+  std::vector<ui32> keys(c.artists.size());
+
+  for (size_t a = 0; a < keys.size(); ++a)
+    if (key == K::AlbumCount)
+      keys[a] = c.artists[a].albumCount;
+    else if (key == K::TrackCount)
+      keys[a] = c.artists[a].songCount;
+
+  return keys;
+}
+
+auto albumProjection(const SongColumns& c, metric::Key key, Pool* pool) -> std::vector<ui32>
+{
+  using K = metric::Key;
+
+  if (key == K::Name)
+    return rankNames(c.albums);
+
+  std::vector<ui32> keys(c.albums.size());
+
+  if (key == K::TrackCount)
+    for (size_t al = 0; al < keys.size(); ++al)
+      keys[al] = c.albums[al].songCount;
+
+  // the year of the lowest numbered track that has one, reads every song
+  if (key == K::Year)
+    forChunks(pool, keys.size(),
+              [&](size_t first, size_t last) -> void
+              {
+                for (size_t al = first; al < last; ++al)
+                {
+                  const auto& g = c.albums[al];
+
+                  Track best = std::numeric_limits<Track>::max();
+                  Year  year = 0;
+
+                  for (ui32 i = g.firstSong; i < g.firstSong + g.songCount; ++i)
+                    if (c.track[i] < best && c.year[i] > 0)
+                    {
+                      best = c.track[i];
+                      year = c.year[i];
+                    }
+
+                  keys[al] = year;
+                }
+              });
+
+  return keys;
+}
+
+// One key per group for all the steps of a level. A single step is its projection, more
+// steps rank the groups by their keys in step order (groups equal on every key share a
+// rank).
+template <typename Project>
+auto levelKeys(size_t groups, const std::vector<metric::Step>& steps, Project&& project)
+  -> std::vector<ui32>
+{
+  std::vector<std::vector<ui32>> keys;
+  keys.reserve(steps.size());
+
+  for (const auto& step : steps)
+  {
+    keys.push_back(project(step.key));
+    if (step.dir == metric::Direction::Desc)
+      complement(keys.back());
+  }
+
+  if (keys.empty())
+    return std::vector<ui32>(groups, 0);
+  if (keys.size() == 1)
+    return std::move(keys.front());
+
+  const auto equal = [&](ui32 x, ui32 y) -> bool
+  { return std::ranges::all_of(keys, [&](const auto& k) -> bool { return k[x] == k[y]; }); };
+
+  std::vector<ui32> byKeys(groups);
+  for (ui32 g = 0; g < groups; ++g)
+    byKeys[g] = g;
+
+  std::ranges::sort(byKeys,
+                    [&](ui32 x, ui32 y) -> bool
+                    {
+                      for (const auto& k : keys)
+                        if (k[x] != k[y])
+                          return k[x] < k[y];
+                      return false;
+                    });
+
+  std::vector<ui32> rank(groups);
+
+  ui32 r = 0;
+  for (size_t k = 0; k < groups; ++k)
+  {
+    if (k > 0 && !equal(byKeys[k - 1], byKeys[k]))
+      ++r;
+
+    rank[byKeys[k]] = r;
+  }
+
+  return rank;
+}
+
+// xor mask of a disc / track level: compile() gives them one step on their own column
+auto directionMask(const std::vector<metric::Step>& steps) noexcept -> ui32
+{
+  return !steps.empty() && steps.front().dir == metric::Direction::Desc ? ~ui32{0} : 0;
+}
+
+} // namespace
+
+auto buildOrder(const SongColumns& c, const SortProgram& program, size_t threads) -> SortOrder
+{
+  RECORD_FUNC_TO_BACKTRACE("query::sort::buildOrder");
+
+  if (threads == 0)
+    threads = c.size() < PARALLEL_MIN_SONGS ? 1 : Pool::defaultThreadCount();
+
+  Pool* pool = threads > 1 ? &sharedPool(threads) : nullptr;
+
+  SortOrder o;
+  o.planHash = hash(program);
+
+  // every slot is written exactly once, by whoever owns its artist
+  o.artists.resize(c.artists.size());
+  o.albums.resize(c.albums.size());
+  o.discs.resize(c.discs.size());
+  o.songs.resize(c.size());
+
+  o.artistAlbum.resize(c.artists.size());
+  o.artistSong.resize(c.artists.size());
+  o.albumDisc.resize(c.albums.size());
+  o.albumSong.resize(c.albums.size());
+  o.discSong.resize(c.discs.size());
+
+  const auto artistKey = levelKeys(c.artists.size(), program.artist,
+                                   [&](metric::Key k) -> std::vector<ui32>
+                                   { return artistProjection(c, k); });
+  const auto albumKey  = levelKeys(c.albums.size(), program.album,
+                                   [&](metric::Key k) -> std::vector<ui32>
+                                   { return albumProjection(c, k, pool); });
+
+  const ui32 discMask  = directionMask(program.disc);
+  const ui32 trackMask = directionMask(program.track);
+
+  // artists first, their order fixes where each artist's albums / discs / songs start
+  std::vector<ui64> artistWords;
+  sortRange(artistWords, 0, static_cast<ui32>(c.artists.size()),
+            [&](ui32 a) -> ui32 { return artistKey[a]; });
+
+  std::vector<ui32> artistDisc(c.artists.size()); // per artist group, into discs
+
+  ui32 albumAt = 0, discAt = 0, songAt = 0;
+  for (size_t k = 0; k < artistWords.size(); ++k)
+  {
+    const ui32  a  = unpack(artistWords[k]);
+    const auto& ag = c.artists[a];
+
+    o.artists[k]     = a;
+    o.artistAlbum[a] = albumAt;
+    o.artistSong[a]  = songAt;
+    artistDisc[a]    = discAt;
+
+    albumAt += ag.albumCount;
+    songAt += ag.songCount;
+    for (ui32 al = ag.firstAlbum; al < ag.firstAlbum + ag.albumCount; ++al)
+      discAt += c.albums[al].discCount;
+  }
+
+  // Every artist's subtree is sorted on its own and written to its own slices, so artists
+  // can be split over the pool in any way and the order is the one the serial walk gives.
+  // Scratch buffers are per chunk, reused for every parent in it.
+  forChunks(pool, o.artists.size(),
+            [&](size_t first, size_t last) -> void
+            {
+              std::vector<ui64> albumWords, discWords, songWords;
+
+              for (size_t k = first; k < last; ++k)
+              {
+                const ui32  a  = o.artists[k];
+                const auto& ag = c.artists[a];
+
+                ui32 album = o.artistAlbum[a];
+                ui32 disc  = artistDisc[a];
+                ui32 song  = o.artistSong[a];
+
+                sortRange(albumWords, ag.firstAlbum, ag.albumCount,
+                          [&](ui32 al) -> ui32 { return albumKey[al]; });
+
+                for (const ui64 alw : albumWords)
+                {
+                  const ui32  al  = unpack(alw);
+                  const auto& alg = c.albums[al];
+
+                  o.albums[album++] = al;
+                  o.albumDisc[al]   = disc;
+                  o.albumSong[al]   = song;
+
+                  sortRange(discWords, alg.firstDisc, alg.discCount,
+                            [&](ui32 d) -> ui32 { return c.discs[d].disc ^ discMask; });
+
+                  for (const ui64 dw : discWords)
+                  {
+                    const ui32  d  = unpack(dw);
+                    const auto& dg = c.discs[d];
+
+                    o.discs[disc++] = d;
+                    o.discSong[d]   = song;
+
+                    // songs of one track number keep their inode map order
+                    sortRange(songWords, dg.firstSong, dg.songCount,
+                              [&](ui32 i) -> ui32 { return c.track[i] ^ trackMask; });
+
+                    for (const ui64 sw : songWords)
+                      o.songs[song++] = unpack(sw);
+                  }
+                }
+              }
+            });
+
+  o.rank.resize(o.songs.size());
+  forChunks(pool, o.songs.size(),
+            [&](size_t first, size_t last) -> void
+            {
+              for (size_t k = first; k < last; ++k)
+                o.rank[o.songs[k]] = static_cast<ui32>(k);
+            });
+
+  // posting lists in plan order: sort the ranks of each list and map them back
+  o.genreSongs.resize(c.genreSongs.size());
+  forChunks(pool, c.genres.size(),
+            [&](size_t first, size_t last) -> void
+            {
+              for (size_t gi = first; gi < last; ++gi)
+              {
+                const auto& g = c.genres[gi];
+
+                auto from = o.genreSongs.begin() + g.firstPosting;
+                auto to   = from + g.songCount;
+
+                std::ranges::transform(c.postings(g), from,
+                                       [&](ui32 i) -> ui32 { return o.rank[i]; });
+                std::sort(from, to);
+                std::transform(from, to, from, [&](ui32 r) -> ui32 { return o.songs[r]; });
+              }
+            });
+
+  return o;
+}
+
+} // namespace query::sort
@@ -1,7 +1,10 @@
 #include "taglib/Parser.hpp"
 #include "Logger.hpp"
-#include "utils/fs/FileUri.hpp"
+#include "core/ArtPack.hpp"
+#include "taglib/Utils.hpp"
 #include "utils/fs/Paths.hpp"
+#include <fstream>
+#include <sstream>
 #include <string_view>
 #include <taglib/flacfile.h>
 #include <taglib/id3v2.h>
@@ -31,18 +34,29 @@ auto Parser::parseFile(const Path& filePath, Metadata& metadata) -> bool
 
   metadata.filePath = filePath;
 
+  // the source fills artUrl itself (same pass, same open file)
   if (!source->parse(filePath, metadata, m_config, m_parseSession))
     return false;
 
-  if (!fillArtUrl(metadata))
-  {
+  if (metadata.details.get().artUrl.empty())
     LOG_WARN("No embedded art found for file: {}", filePath);
-    metadata.artUrl = "";
-  }
 
   return true;
 }
 
+auto Parser::parseFile(const Path& filePath, Metadata& metadata, const PrefetchedHead& head)
+  -> bool
+{
+  struct Reset
+  {
+    ParseSession& session;
+    ~Reset() { session.prefetched = nullptr; }
+  } reset{m_parseSession};
+
+  m_parseSession.prefetched = &head;
+  return parseFile(filePath, metadata);
+}
+
 auto Parser::modifyMetadata(const Path& filePath, const Metadata& newData) -> bool
 {
   auto* source = findSource(filePath.extension().c_str());
@@ -67,28 +81,43 @@ auto Parser::modifyMetadata(const Path& filePath, const Metadata& newData) -> bo
   }
 }
 
+// only meant for songs whose art was not produced while parsing (parseFile already does this in
+// its single pass): reuses what the art pack has for the song, otherwise re-opens the file
+// through the source's extractThumbnail
 auto Parser::fillArtUrl(Metadata& meta) -> bool
 {
-  const auto cacheDir = ::utils::fs::getAppCacheArtPath();
-  std::filesystem::create_directories(cacheDir.c_str());
+  auto& pack = core::ArtPack::global();
 
-  const std::string     hash   = std::to_string(std::hash<std::string>{}(meta.filePath.c_str()));
-  std::filesystem::path outImg = cacheDir / (hash + ".jpg");
+  if (const auto id = pack.lookup(meta.filePath, std::nullopt))
+  {
+    meta.details.edit().artUrl = core::ArtPack::toUri(*id);
+    return true;
+  }
+
+  meta.details.edit().artUrl.clear();
 
   auto* source = findSource(std::filesystem::path(meta.filePath).extension().string());
   if (!source)
     return false;
 
-  // [TODO] Replace filesystem with DB to avoid cache explosion for large libraries
-  if (std::filesystem::exists(outImg) ||
-      source->extractThumbnail(meta.filePath.c_str(), outImg.c_str()))
+  // extractThumbnail writes a file, it only lives until the picture is in the pack
+  const auto tmp = ::utils::fs::getAppCacheArtPathWithFile(
+    ".extract-" + std::to_string(std::hash<std::string>{}(meta.filePath)));
+
+  std::error_code ec;
+  std::filesystem::create_directories(tmp.parent_path(), ec);
+
+  bool ok = false;
+  if (source->extractThumbnail(meta.filePath.c_str(), tmp.c_str()))
   {
-    meta.artUrl = ::utils::fs::toAbsFilePathUri(outImg);
-    return true;
+    std::ifstream     in(tmp, std::ios::binary);
+    std::stringstream bytes;
+    bytes << in.rdbuf();
+    ok = utils::writeArt(bytes.str(), meta);
   }
 
-  meta.artUrl.clear();
-  return false;
+  std::filesystem::remove(tmp, ec);
+  return ok;
 }
 
 } // namespace taglib
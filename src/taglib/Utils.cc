@@ -1,4 +1,5 @@
 #include "taglib/Utils.hpp"
+#include "core/ArtPack.hpp"
 #include "taglib/Properties.hpp"
 
 namespace taglib::utils
@@ -16,10 +17,8 @@ auto parseFractionField(const TagLib::String& text) -> std::pair<int, int>
   return {a, b};
 }
 
-void extractTrackAndTotal(TagLib::FileRef& file, Metadata& metadata)
+void extractTrackAndTotal(const TagLib::PropertyMap& props, Metadata& metadata)
 {
-  TagLib::PropertyMap props = file.file()->properties();
-
   metadata.track      = 0;
   metadata.trackTotal = 0;
 
@@ -45,10 +44,8 @@ void extractTrackAndTotal(TagLib::FileRef& file, Metadata& metadata)
   }
 }
 
-void extractDiscAndTotal(TagLib::FileRef& file, Metadata& metadata)
+void extractDiscAndTotal(const TagLib::PropertyMap& props, Metadata& metadata)
 {
-  TagLib::PropertyMap props = file.file()->properties();
-
   metadata.discNumber = 0;
   metadata.discTotal  = 0;
 
@@ -74,17 +71,43 @@ void extractDiscAndTotal(TagLib::FileRef& file, Metadata& metadata)
   }
 }
 
-void extractAudioProperties(TagLib::FileRef& file, Metadata& metadata)
+void extractAudioProperties(const TagLib::AudioProperties* audioProps, Metadata& metadata)
 {
-  if (!file.isNull())
+  if (audioProps)
   {
-    auto* audioProps = file.audioProperties();
-    if (audioProps)
-    {
-      metadata.duration = audioProps->lengthInSeconds();
-      metadata.bitrate  = audioProps->bitrate();
-    }
+    metadata.duration = audioProps->lengthInSeconds();
+    metadata.bitrate  = audioProps->bitrate();
   }
 }
 
+auto useCachedArt(Metadata& metadata, ui64 pictureSize) -> bool
+{
+  const auto id = core::ArtPack::global().lookup(metadata.filePath, pictureSize);
+  if (!id)
+    return false;
+
+  metadata.details.edit().artUrl = core::ArtPack::toUri(*id);
+  return true;
+}
+
+auto writeArt(std::string_view picture, Metadata& metadata) -> bool
+{
+  const auto id = core::ArtPack::global().put(metadata.filePath, picture);
+  if (!id)
+    return false;
+
+  metadata.details.edit().artUrl = core::ArtPack::toUri(*id);
+  return true;
+}
+
+auto storeArt(const TagLib::ByteVector& picture, Metadata& metadata) -> bool
+{
+  metadata.details.edit().artUrl.clear();
+
+  if (picture.isEmpty())
+    return false;
+
+  return writeArt({picture.data(), picture.size()}, metadata);
+}
+
 } // namespace taglib::utils
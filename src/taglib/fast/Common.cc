@@ -0,0 +1,330 @@
+#include "taglib/fast/Common.hpp"
+#include "taglib/Properties.hpp"
+#include <charconv>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace taglib::fast
+{
+
+// ============================================================
+// FileWindow
+// ============================================================
+
+FileWindow::FileWindow(const char* path, ParseSession* session) : m_session(session)
+{
+  const PrefetchedHead* head = session ? session->prefetched : nullptr;
+
+  if (head && head->fd >= 0)
+  {
+    m_fd     = head->fd;
+    m_owned  = false;
+    m_size   = head->size;
+    m_bufLen = std::min(head->len, CAPACITY);
+    m_read   = m_bufLen;
+    std::memcpy(m_buf.data(), head->data, m_bufLen);
+    return;
+  }
+
+  m_fd = ::open(path, O_RDONLY | O_CLOEXEC);
+  if (m_fd < 0)
+    return;
+
+  struct stat st{};
+  if (::fstat(m_fd, &st) != 0)
+  {
+    ::close(m_fd);
+    m_fd = -1;
+    return;
+  }
+
+  m_size = st.st_size;
+  ::posix_fadvise(m_fd, 0, 0, POSIX_FADV_RANDOM);
+}
+
+FileWindow::~FileWindow()
+{
+  if (m_session)
+    m_session->bytesRead += m_read;
+
+  if (m_fd >= 0 && m_owned)
+    ::close(m_fd);
+}
+
+auto FileWindow::view(i64 off, size_t len) -> const unsigned char*
+{
+  if (off < 0 || len > CAPACITY || off + static_cast<i64>(len) > m_size)
+    return nullptr;
+
+  if (off >= m_bufOff && off + static_cast<i64>(len) <= m_bufOff + static_cast<i64>(m_bufLen))
+    return m_buf.data() + (off - m_bufOff);
+
+  const size_t want = std::min<size_t>(std::max(len, READ_AHEAD), m_size - off);
+
+  size_t got = 0;
+  while (got < want)
+  {
+    const ssize_t r = ::pread(m_fd, m_buf.data() + got, want - got, off + got);
+    if (r < 0 && errno == EINTR)
+      continue;
+    if (r <= 0)
+      break;
+    got += static_cast<size_t>(r);
+  }
+
+  m_bufOff = off;
+  m_bufLen = got;
+  m_read += got;
+
+  return got >= len ? m_buf.data() : nullptr;
+}
+
+auto FileWindow::readInto(i64 off, char* out, size_t len) -> bool
+{
+  if (off < 0 || off + static_cast<i64>(len) > m_size)
+    return false;
+
+  size_t got = 0;
+  while (got < len)
+  {
+    const ssize_t r = ::pread(m_fd, out + got, len - got, off + got);
+    if (r < 0 && errno == EINTR)
+      continue;
+    if (r <= 0)
+      return false;
+    got += static_cast<size_t>(r);
+  }
+
+  m_read += got;
+  return true;
+}
+
+// ============================================================
+// Text helpers
+// ============================================================
+
+namespace
+{
+
+void appendUtf8(ui32 cp, std::string& out)
+{
+  if (cp < 0x80)
+  {
+    out += static_cast<char>(cp);
+  }
+  else if (cp < 0x800)
+  {
+    out += static_cast<char>(0xC0 | (cp >> 6));
+    out += static_cast<char>(0x80 | (cp & 0x3F));
+  }
+  else if (cp < 0x10000)
+  {
+    out += static_cast<char>(0xE0 | (cp >> 12));
+    out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+    out += static_cast<char>(0x80 | (cp & 0x3F));
+  }
+  else
+  {
+    out += static_cast<char>(0xF0 | (cp >> 18));
+    out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+    out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+    out += static_cast<char>(0x80 | (cp & 0x3F));
+  }
+}
+
+void appendUtf16(const unsigned char* p, size_t n, bool bigEndian, std::string& out)
+{
+  auto unit = [&](size_t i) -> ui32
+  { return bigEndian ? (ui32(p[i]) << 8) | p[i + 1] : (ui32(p[i + 1]) << 8) | p[i]; };
+
+  for (size_t i = 0; i + 1 < n; i += 2)
+  {
+    ui32 cp = unit(i);
+
+    if (cp >= 0xD800 && cp < 0xDC00 && i + 3 < n)
+    {
+      const ui32 lo = unit(i + 2);
+      if (lo >= 0xDC00 && lo < 0xE000)
+      {
+        cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+        i += 2;
+      }
+    }
+
+    appendUtf8(cp, out);
+  }
+}
+
+// one value (no NULs inside) of the given encoding
+void appendValue(Encoding enc, const unsigned char* p, size_t n, std::string& out)
+{
+  switch (enc)
+  {
+    case Encoding::Latin1:
+      for (size_t i = 0; i < n; ++i)
+        appendUtf8(p[i], out);
+      break;
+
+    case Encoding::UTF8:
+      out.append(reinterpret_cast<cstr>(p), n);
+      break;
+
+    case Encoding::UTF16:
+      // every value carries its own BOM, none means little endian (what most writers emit)
+      if (n >= 2 && p[0] == 0xFE && p[1] == 0xFF)
+        appendUtf16(p + 2, n - 2, true, out);
+      else if (n >= 2 && p[0] == 0xFF && p[1] == 0xFE)
+        appendUtf16(p + 2, n - 2, false, out);
+      else
+        appendUtf16(p, n, false, out);
+      break;
+
+    case Encoding::UTF16BE:
+      appendUtf16(p, n, true, out);
+      break;
+  }
+}
+
+auto leadingInt(std::string_view s) -> int
+{
+  while (!s.empty() && s.front() == ' ')
+    s.remove_prefix(1);
+
+  int v = 0;
+  std::from_chars(s.data(), s.data() + s.size(), v);
+  return v;
+}
+
+auto fraction(std::string_view s) -> std::pair<int, int>
+{
+  const auto slash = s.find('/');
+  if (slash == std::string_view::npos)
+    return {leadingInt(s), 0};
+  return {leadingInt(s.substr(0, slash)), leadingInt(s.substr(slash + 1))};
+}
+
+} // namespace
+
+auto terminatedLength(Encoding enc, const unsigned char* p, size_t n) -> size_t
+{
+  if (enc == Encoding::UTF16 || enc == Encoding::UTF16BE)
+  {
+    for (size_t i = 0; i + 1 < n; i += 2)
+      if (p[i] == 0 && p[i + 1] == 0)
+        return i;
+    return n;
+  }
+
+  for (size_t i = 0; i < n; ++i)
+    if (p[i] == 0)
+      return i;
+  return n;
+}
+
+void appendDecoded(Encoding enc, const unsigned char* p, size_t n, std::string& out)
+{
+  const size_t termSize = (enc == Encoding::UTF16 || enc == Encoding::UTF16BE) ? 2 : 1;
+  bool         first    = true;
+
+  while (n > 0)
+  {
+    const size_t len = terminatedLength(enc, p, n);
+
+    if (len > 0)
+    {
+      if (!first)
+        out += ' ';
+      appendValue(enc, p, len, out);
+      first = false;
+    }
+
+    const size_t step = std::min(n, len + termSize);
+    p += step;
+    n -= step;
+  }
+}
+
+void addProperty(Properties& props, std::string_view key, std::string value)
+{
+  auto [it, inserted] = props.try_emplace(std::string(key), std::move(value));
+  if (!inserted)
+  {
+    it->second += ' ';
+    it->second += value;
+  }
+}
+
+// ============================================================
+// Metadata fill
+// ============================================================
+
+void fillMetadata(const Path& filePath, const Properties& props, std::string_view comment,
+                  Metadata& metadata, ParseSession& parseSession)
+{
+  auto get = [&](PropKey k) -> const std::string*
+  {
+    auto it = props.find(std::string(propText(k)));
+    return it == props.end() ? nullptr : &it->second;
+  };
+
+  auto getOr = [&](std::string_view key, std::string_view fallback) -> std::string
+  {
+    auto it = props.find(std::string(key));
+    return (it == props.end() || it->second.empty()) ? std::string(fallback) : it->second;
+  };
+
+  metadata.title   = getOr("TITLE", filePath.filename().c_str());
+  metadata.artist  = getOr("ARTIST", INLIMBO_ARTIST_NAME_FALLBACK);
+  metadata.album   = getOr("ALBUM", INLIMBO_ALBUM_NAME_FALLBACK);
+  metadata.genre   = getOr("GENRE", INLIMBO_GENRE_NAME_FALLBACK);
+
+  auto& details   = metadata.details.edit();
+  details.comment = comment.empty() ? INLIMBO_COMMENT_FALLBACK : std::string(comment);
+
+  if (auto it = props.find(std::string("DATE")); it != props.end())
+    metadata.year = leadingInt(it->second);
+
+  // same precedence as utils::extractTrackAndTotal / extractDiscAndTotal
+  metadata.track      = 0;
+  metadata.trackTotal = 0;
+  if (const auto* v = get(PropKey::TrackNumber))
+    std::tie(metadata.track, metadata.trackTotal) = fraction(*v);
+  if (metadata.trackTotal == 0)
+  {
+    if (const auto* v = get(PropKey::TrackTotal))
+      metadata.trackTotal = leadingInt(*v);
+    else if (const auto* v = get(PropKey::TotalTracks))
+      metadata.trackTotal = leadingInt(*v);
+  }
+
+  metadata.discNumber = 0;
+  metadata.discTotal  = 0;
+  if (const auto* v = get(PropKey::DiscNumber))
+    std::tie(metadata.discNumber, metadata.discTotal) = fraction(*v);
+  if (metadata.discTotal == 0)
+  {
+    if (const auto* v = get(PropKey::DiscTotal))
+      metadata.discTotal = leadingInt(*v);
+    else if (const auto* v = get(PropKey::TotalDiscs))
+      metadata.discTotal = leadingInt(*v);
+  }
+
+  // see CommonTag::fillProperties for why ALBUMARTIST wins
+  if (const auto* v = get(PropKey::AlbumArtist))
+    metadata.artist = *v;
+
+  if (metadata.track == 0 && metadata.artist == INLIMBO_ARTIST_NAME_FALLBACK)
+    metadata.track = ++parseSession.unknownArtistTracks;
+
+  if (const auto* v = get(PropKey::Lyrics))
+    details.lyrics = *v;
+
+  PropertyBlock::Builder block;
+  block.reserve(props.size());
+  for (const auto& [key, value] : props)
+    block.add(key, value);
+  details.additionalProperties = block.finish();
+}
+
+} // namespace taglib::fast
@@ -0,0 +1,213 @@
+#include "taglib/Utils.hpp"
+#include "taglib/fast/Common.hpp"
+#include "taglib/fast/Reader.hpp"
+#include <cstring>
+
+namespace taglib::fast
+{
+
+namespace
+{
+
+enum BlockType : ui8
+{
+  STREAMINFO     = 0,
+  VORBIS_COMMENT = 4,
+  PICTURE        = 6,
+};
+
+struct Picture
+{
+  i64    offset = 0;
+  size_t size   = 0;
+};
+
+// VORBIS_COMMENT (little endian): vendor length, vendor, count, { length, "KEY=value" }...
+auto readVorbisComment(const unsigned char* b, size_t n, Properties& props) -> bool
+{
+  size_t pos = 0;
+
+  auto take32 = [&](ui32& v) -> bool
+  {
+    if (pos + 4 > n)
+      return false;
+    v = le32(b + pos);
+    pos += 4;
+    return true;
+  };
+
+  ui32 vendorLen = 0;
+  if (!take32(vendorLen) || pos + vendorLen > n)
+    return false;
+  pos += vendorLen;
+
+  ui32 count = 0;
+  if (!take32(count))
+    return false;
+
+  for (ui32 i = 0; i < count; ++i)
+  {
+    ui32 len = 0;
+    if (!take32(len) || pos + len > n)
+      return false;
+
+    const std::string_view field(reinterpret_cast<cstr>(b + pos), len);
+    pos += len;
+
+    const auto eq = field.find('=');
+    if (eq == std::string_view::npos || eq == 0)
+      continue;
+
+    std::string key(field.substr(0, eq));
+    for (auto& c : key)
+      if (c >= 'a' && c <= 'z')
+        c = static_cast<char>(c - 'a' + 'A');
+
+    // covers stored inside the comment (base64), TagLib turns these into pictures
+    if (key == "METADATA_BLOCK_PICTURE" || key == "COVERART")
+      return false;
+
+    addProperty(props, key, std::string(field.substr(eq + 1)));
+  }
+
+  return true;
+}
+
+// PICTURE: type, mime length, mime, description length, description,
+//          width, height, depth, colors, data length, data (all big endian)
+auto locatePicture(FileWindow& f, i64 body, ui32 size, Picture& pic) -> bool
+{
+  const auto* b = f.view(body, 8);
+  if (!b || size < 32)
+    return false;
+
+  i64 pos = body + 8 + be32(b + 4); // type + mime length + mime
+
+  const auto* d = f.view(pos, 4);
+  if (!d)
+    return false;
+  pos += 4 + be32(d) + 16; // description + width/height/depth/colors
+
+  const auto* l = f.view(pos, 4);
+  if (!l)
+    return false;
+
+  const ui32 dataLen = be32(l);
+  pos += 4;
+
+  if (pos + dataLen > body + size)
+    return false;
+
+  pic.offset = pos;
+  pic.size   = dataLen;
+  return true;
+}
+
+} // namespace
+
+auto readFLAC(const Path& filePath, Metadata& metadata, ParseSession& parseSession) -> bool
+{
+  FileWindow f(filePath.c_str(), &parseSession);
+  if (!f.ok())
+    return false;
+
+  // files with an ID3v2 tag glued in front are left to TagLib
+  const auto* magic = f.view(0, 4);
+  if (!magic || std::memcmp(magic, "fLaC", 4) != 0)
+    return false;
+
+  Properties props;
+  Picture    pic;
+  i64        totalSamples = 0;
+  int        sampleRate   = 0;
+  bool       haveInfo     = false;
+  bool       haveComment  = false;
+  i64        pos          = 4;
+  bool       last         = false;
+
+  while (!last)
+  {
+    const auto* h = f.view(pos, 4);
+    if (!h)
+      return false;
+
+    last              = (h[0] & 0x80) != 0;
+    const ui8  type   = h[0] & 0x7F;
+    const ui32 length = be24(h + 1);
+    const i64  body   = pos + 4;
+
+    pos = body + length;
+    if (pos > f.size())
+      return false;
+
+    switch (type)
+    {
+      case STREAMINFO:
+      {
+        const auto* b = f.view(body, 18);
+        if (!b || length < 34)
+          return false;
+
+        sampleRate   = static_cast<int>((ui32(b[10]) << 12) | (ui32(b[11]) << 4) | (b[12] >> 4));
+        totalSamples = (static_cast<i64>(b[13] & 0x0F) << 32) | be32(b + 14);
+        haveInfo     = true;
+        break;
+      }
+
+      case VORBIS_COMMENT:
+      {
+        // TagLib only reads the first one as well
+        if (haveComment)
+          break;
+
+        const auto* b = f.view(body, length);
+        if (!b || !readVorbisComment(b, length, props))
+          return false;
+
+        haveComment = true;
+        break;
+      }
+
+      case PICTURE:
+        // only remember where it is, the bytes are read later (and only if not cached yet)
+        if (pic.size == 0 && !locatePicture(f, body, length, pic))
+          return false;
+        break;
+
+      default: // padding, seektable, application, cuesheet: skipped without reading
+        break;
+    }
+  }
+
+  if (!haveInfo || sampleRate == 0)
+    return false;
+
+  const i64 lengthMs     = totalSamples * 1000 / sampleRate;
+  const i64 streamLength = f.size() - pos; // audio frames start right after the last block
+
+  Metadata md;
+  md.filePath = metadata.filePath;
+
+  // XiphComment::comment() prefers DESCRIPTION over COMMENT
+  std::string comment;
+  if (auto it = props.find(std::string("DESCRIPTION")); it != props.end())
+    comment = it->second;
+  else if (auto it = props.find(std::string("COMMENT")); it != props.end())
+    comment = it->second;
+
+  fillMetadata(filePath, props, comment, md, parseSession);
+  md.duration = static_cast<float>(lengthMs / 1000);
+  md.bitrate  = lengthMs > 0 ? static_cast<int>(streamLength * 8 / lengthMs) : 0;
+
+  if (pic.size > 0 && !utils::useCachedArt(md, pic.size))
+  {
+    std::string bytes(pic.size, '\0');
+    if (f.readInto(pic.offset, bytes.data(), bytes.size()))
+      utils::writeArt(bytes, md);
+  }
+
+  metadata = std::move(md);
+  return true;
+}
+
+} // namespace taglib::fast
@@ -0,0 +1,476 @@
+#include "taglib/Utils.hpp"
+#include "taglib/fast/Common.hpp"
+#include "taglib/fast/Reader.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace taglib::fast
+{
+
+namespace
+{
+
+// ID3v2 text frame -> TagLib property key (the subset TagLib translates that we care about)
+struct FrameKey
+{
+  std::string_view id;
+  std::string_view key;
+};
+
+constexpr std::array TEXT_FRAMES = {
+  FrameKey{.id = "TIT2", .key = "TITLE"},
+  FrameKey{.id = "TPE1", .key = "ARTIST"},
+  FrameKey{.id = "TALB", .key = "ALBUM"},
+  FrameKey{.id = "TCON", .key = "GENRE"},
+  FrameKey{.id = "TDRC", .key = "DATE"},
+  FrameKey{.id = "TYER", .key = "DATE"},
+  FrameKey{.id = "TRCK", .key = "TRACKNUMBER"},
+  FrameKey{.id = "TPOS", .key = "DISCNUMBER"},
+  FrameKey{.id = "TPE2", .key = "ALBUMARTIST"},
+  FrameKey{.id = "TPE3", .key = "CONDUCTOR"},
+  FrameKey{.id = "TPE4", .key = "REMIXER"},
+  FrameKey{.id = "TCOM", .key = "COMPOSER"},
+  FrameKey{.id = "TEXT", .key = "LYRICIST"},
+  FrameKey{.id = "TBPM", .key = "BPM"},
+  FrameKey{.id = "TCOP", .key = "COPYRIGHT"},
+  FrameKey{.id = "TENC", .key = "ENCODEDBY"},
+  FrameKey{.id = "TSSE", .key = "ENCODING"},
+  FrameKey{.id = "TPUB", .key = "LABEL"},
+  FrameKey{.id = "TSRC", .key = "ISRC"},
+  FrameKey{.id = "TIT3", .key = "SUBTITLE"},
+  FrameKey{.id = "TKEY", .key = "INITIALKEY"},
+  FrameKey{.id = "TLAN", .key = "LANGUAGE"},
+  FrameKey{.id = "TMED", .key = "MEDIA"},
+  FrameKey{.id = "TMOO", .key = "MOOD"},
+  FrameKey{.id = "TDOR", .key = "ORIGINALDATE"},
+  FrameKey{.id = "TORY", .key = "ORIGINALDATE"},
+  FrameKey{.id = "TDRL", .key = "RELEASEDATE"},
+  FrameKey{.id = "TOAL", .key = "ORIGINALALBUM"},
+  FrameKey{.id = "TOPE", .key = "ORIGINALARTIST"},
+  FrameKey{.id = "TSOA", .key = "ALBUMSORT"},
+  FrameKey{.id = "TSOP", .key = "ARTISTSORT"},
+  FrameKey{.id = "TSOT", .key = "TITLESORT"},
+  FrameKey{.id = "TSO2", .key = "ALBUMARTISTSORT"},
+  FrameKey{.id = "TSOC", .key = "COMPOSERSORT"},
+  FrameKey{.id = "TCMP", .key = "COMPILATION"},
+};
+
+auto textFrameKey(std::string_view id) -> std::string_view
+{
+  for (const auto& f : TEXT_FRAMES)
+    if (f.id == id)
+      return f.key;
+  return {};
+}
+
+// TXXX description (uppercased) -> TagLib property key, the same table ID3v2::Frame::txxxToKey
+// uses. Anything not in here ends up under the uppercased description.
+struct TxxxKey
+{
+  std::string_view desc;
+  std::string_view key;
+};
+
+constexpr std::array TXXX_KEYS = {
+  TxxxKey{.desc = "MUSICBRAINZ ALBUM ID", .key = "MUSICBRAINZ_ALBUMID"},
+  TxxxKey{.desc = "MUSICBRAINZ ARTIST ID", .key = "MUSICBRAINZ_ARTISTID"},
+  TxxxKey{.desc = "MUSICBRAINZ ALBUM ARTIST ID", .key = "MUSICBRAINZ_ALBUMARTISTID"},
+  TxxxKey{.desc = "MUSICBRAINZ ALBUM RELEASE COUNTRY", .key = "RELEASECOUNTRY"},
+  TxxxKey{.desc = "MUSICBRAINZ ALBUM STATUS", .key = "RELEASESTATUS"},
+  TxxxKey{.desc = "MUSICBRAINZ ALBUM TYPE", .key = "RELEASETYPE"},
+  TxxxKey{.desc = "MUSICBRAINZ RELEASE GROUP ID", .key = "MUSICBRAINZ_RELEASEGROUPID"},
+  TxxxKey{.desc = "MUSICBRAINZ RELEASE TRACK ID", .key = "MUSICBRAINZ_RELEASETRACKID"},
+  TxxxKey{.desc = "MUSICBRAINZ WORK ID", .key = "MUSICBRAINZ_WORKID"},
+  TxxxKey{.desc = "ACOUSTID ID", .key = "ACOUSTID_ID"},
+  TxxxKey{.desc = "ACOUSTID FINGERPRINT", .key = "ACOUSTID_FINGERPRINT"},
+  TxxxKey{.desc = "MUSICIP PUID", .key = "MUSICIP_PUID"},
+};
+
+auto txxxKey(std::string_view desc) -> std::string_view
+{
+  for (const auto& t : TXXX_KEYS)
+    if (t.desc == desc)
+      return t.key;
+  return desc;
+}
+
+auto isFrameIdChar(unsigned char c) -> bool
+{
+  return (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9');
+}
+
+// "(17)", "(17)Rock" or "17", TagLib maps these through the ID3v1 genre table
+auto isNumericGenre(std::string_view g) -> bool
+{
+  if (g.empty())
+    return false;
+  return g.front() == '(' ||
+         std::ranges::all_of(g, [](char c) -> bool { return c >= '0' && c <= '9'; });
+}
+
+void toUpper(std::string& s)
+{
+  for (auto& c : s)
+    if (c >= 'a' && c <= 'z')
+      c = static_cast<char>(c - 'a' + 'A');
+}
+
+struct Picture
+{
+  i64    offset = 0;
+  size_t size   = 0;
+};
+
+// ------------------------------------------------------------
+// MPEG audio frame header
+// ------------------------------------------------------------
+
+struct FrameHeader
+{
+  int  version    = 0; // 0: MPEG1, 1: MPEG2, 2: MPEG2.5
+  int  layer      = 0; // 1..3
+  int  bitrate    = 0; // kbps
+  int  sampleRate = 0;
+  int  samples    = 0; // per frame
+  bool mono       = false;
+  ui32 length     = 0; // bytes, header included
+};
+
+constexpr int BITRATES[2][3][15] = {
+  {{0, 32, 64, 96, 128, 160, 192, 224, 256, 288, 320, 352, 384, 416, 448},
+   {0, 32, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384},
+   {0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320}},
+  {{0, 32, 48, 56, 64, 80, 96, 112, 128, 144, 160, 176, 192, 224, 256},
+   {0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160},
+   {0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160}},
+};
+
+constexpr int SAMPLE_RATES[3][3] = {
+  {44100, 48000, 32000}, {22050, 24000, 16000}, {11025, 12000, 8000}};
+
+auto parseFrameHeader(const unsigned char* p, FrameHeader& h) -> bool
+{
+  if (p[0] != 0xFF || (p[1] & 0xE0) != 0xE0)
+    return false;
+
+  const int versionBits = (p[1] >> 3) & 0x03;
+  const int layerBits   = (p[1] >> 1) & 0x03;
+  const int bitrateIdx  = p[2] >> 4;
+  const int rateIdx     = (p[2] >> 2) & 0x03;
+
+  if (versionBits == 1 || layerBits == 0 || bitrateIdx == 0 || bitrateIdx == 15 || rateIdx == 3)
+    return false;
+
+  h.version    = versionBits == 3 ? 0 : (versionBits == 2 ? 1 : 2);
+  h.layer      = 4 - layerBits;
+  h.bitrate    = BITRATES[h.version == 0 ? 0 : 1][h.layer - 1][bitrateIdx];
+  h.sampleRate = SAMPLE_RATES[h.version][rateIdx];
+  h.mono       = (p[3] >> 6) == 3;
+
+  const int padding = (p[2] >> 1) & 0x01;
+
+  if (h.layer == 1)
+  {
+    h.samples = 384;
+    h.length  = static_cast<ui32>((12000 * h.bitrate / h.sampleRate + padding) * 4);
+  }
+  else
+  {
+    h.samples = (h.layer == 3 && h.version != 0) ? 576 : 1152;
+    h.length  = static_cast<ui32>(h.samples / 8 * 1000 * h.bitrate / h.sampleRate + padding);
+  }
+
+  return h.length > 4;
+}
+
+// finds the first frame after the tag (checking the one after it too, like TagLib does) and
+// takes the length from a Xing/Info or VBRI header, or assumes CBR otherwise.
+auto readMpegProperties(FileWindow& f, i64 audioStart, int& durationSec, int& bitrate) -> bool
+{
+  constexpr i64 MAX_SCAN = 4096;
+
+  for (i64 off = audioStart; off < audioStart + MAX_SCAN; ++off)
+  {
+    const auto* p = f.view(off, 4);
+    if (!p)
+      return false;
+
+    FrameHeader h;
+    if (!parseFrameHeader(p, h))
+      continue;
+
+    FrameHeader next;
+    const auto* q = f.view(off + h.length, 4);
+    if (!q || !parseFrameHeader(q, next) || next.version != h.version || next.layer != h.layer ||
+        next.sampleRate != h.sampleRate)
+      continue;
+
+    ui32 frames = 0;
+    ui32 bytes  = 0;
+
+    if (h.layer == 3)
+    {
+      const size_t xingOff = h.version == 0 ? (h.mono ? 21 : 36) : (h.mono ? 13 : 21);
+
+      const auto* x = f.view(off, xingOff + 16);
+
+      if (x && (std::memcmp(x + xingOff, "Xing", 4) == 0 ||
+                std::memcmp(x + xingOff, "Info", 4) == 0))
+      {
+        const ui32 flags = be32(x + xingOff + 4);
+        size_t     idx   = xingOff + 8;
+        if (flags & 0x01)
+        {
+          frames = be32(x + idx);
+          idx += 4;
+        }
+        if (flags & 0x02)
+          bytes = be32(x + idx);
+      }
+      else if (const auto* v = f.view(off, 36 + 18); v && std::memcmp(v + 36, "VBRI", 4) == 0)
+      {
+        bytes  = be32(v + 36 + 10);
+        frames = be32(v + 36 + 14);
+      }
+    }
+
+    i64 lengthMs = 0;
+
+    if (frames > 0)
+    {
+      lengthMs = static_cast<i64>(frames) * h.samples * 1000 / h.sampleRate;
+      bitrate =
+        (bytes > 0 && lengthMs > 0) ? static_cast<int>(bytes * 8LL / lengthMs) : h.bitrate;
+    }
+    else
+    {
+      // an ID3v1 tag sits after the last frame, it is not part of the stream
+      i64 streamEnd = f.size();
+      if (streamEnd - 128 >= off + h.length)
+        if (const auto* v1 = f.view(streamEnd - 128, 3); v1 && std::memcmp(v1, "TAG", 3) == 0)
+          streamEnd -= 128;
+
+      lengthMs = (streamEnd - off) * 8 / h.bitrate;
+      bitrate  = h.bitrate;
+    }
+
+    durationSec = static_cast<int>(lengthMs / 1000);
+    return true;
+  }
+
+  return false;
+}
+
+// APIC: encoding, mime (latin1, NUL), picture type, description (encoding, NUL), data
+auto locatePicture(FileWindow& f, i64 body, ui32 size, Picture& pic) -> bool
+{
+  // mime + description are short, dont pull the image itself into the window
+  const size_t n = std::min<size_t>(size, 1024);
+  const auto*  b = f.view(body, n);
+  if (!b || n < 4 || b[0] > 3)
+    return false;
+
+  const auto enc      = static_cast<Encoding>(b[0]);
+  const auto termSize = (enc == Encoding::UTF16 || enc == Encoding::UTF16BE) ? 2 : 1;
+
+  size_t pos = 1;
+  pos += terminatedLength(Encoding::Latin1, b + pos, n - pos) + 1; // mime
+  pos += 1;                                                        // picture type
+  if (pos >= n)
+    return false;
+  pos += terminatedLength(enc, b + pos, n - pos) + termSize; // description
+  if (pos >= n)
+    return false;
+
+  pic.offset = body + static_cast<i64>(pos);
+  pic.size   = size - pos;
+  return true;
+}
+
+} // namespace
+
+auto readMP3(const Path& filePath, Metadata& metadata, ParseSession& parseSession) -> bool
+{
+  FileWindow f(filePath.c_str(), &parseSession);
+  if (!f.ok())
+    return false;
+
+  // ------------------------------------------------------------
+  // ID3v2 header
+  // ------------------------------------------------------------
+  const auto* h = f.view(0, 10);
+  if (!h || std::memcmp(h, "ID3", 3) != 0)
+    return false;
+
+  const ui8 major = h[3];
+  const ui8 flags = h[5];
+
+  // v2.2 has 3 char frame ids, tag wide unsynchronisation rewrites every frame
+  if ((major != 3 && major != 4) || (flags & 0x80) || ((h[6] | h[7] | h[8] | h[9]) & 0x80))
+    return false;
+
+  const i64 tagEnd     = 10 + static_cast<i64>(syncsafe32(h + 6));
+  const i64 audioStart = tagEnd + ((major == 4 && (flags & 0x10)) ? 10 : 0);
+  i64       pos        = 10;
+
+  if (tagEnd > f.size())
+    return false;
+
+  if (flags & 0x40)
+  {
+    const auto* e = f.view(pos, 4);
+    if (!e)
+      return false;
+    pos += major == 4 ? syncsafe32(e) : 4 + be32(e);
+  }
+
+  // ------------------------------------------------------------
+  // frames
+  // ------------------------------------------------------------
+  Properties  props;
+  std::string comment;
+  bool        anyComment   = false;
+  bool        plainComment = false; // COMM without description, TagLib prefers that one
+  Picture     pic;
+
+  while (pos + 10 <= tagEnd)
+  {
+    const auto* fh = f.view(pos, 10);
+    if (!fh)
+      return false;
+
+    if (fh[0] == 0) // padding
+      break;
+
+    if (!std::all_of(fh, fh + 4, isFrameIdChar))
+      return false;
+
+    const std::string_view id(reinterpret_cast<cstr>(fh), 4);
+
+    // v2.4 sizes are syncsafe, some writers put plain ones in there: leave those to TagLib
+    if (major == 4 && ((fh[4] | fh[5] | fh[6] | fh[7]) & 0x80))
+      return false;
+
+    const ui32 size = major == 4 ? syncsafe32(fh + 4) : be32(fh + 4);
+
+    // compression, encryption, grouping, per frame unsynchronisation, data length indicator
+    if (major == 4 ? (fh[9] & 0x4F) : (fh[9] & 0xE0))
+      return false;
+
+    const i64 body = pos + 10;
+    if (body + size > tagEnd)
+      return false;
+
+    pos = body + size;
+
+    if (size == 0)
+      continue;
+
+    if (id == "APIC")
+    {
+      // only remember where it is, the bytes are read later (and only if not cached yet)
+      if (pic.size == 0 && !locatePicture(f, body, size, pic))
+        return false;
+      continue;
+    }
+
+    const bool isText = id.front() == 'T';
+    if (!isText && id != "COMM" && id != "USLT")
+      continue;
+
+    const auto* b = f.view(body, size);
+    if (!b || b[0] > 3)
+      return false;
+
+    const auto   enc      = static_cast<Encoding>(b[0]);
+    const size_t termSize = (enc == Encoding::UTF16 || enc == Encoding::UTF16BE) ? 2 : 1;
+
+    if (id == "TXXX")
+    {
+      const size_t descLen = terminatedLength(enc, b + 1, size - 1);
+      const size_t valPos  = std::min<size_t>(size, 1 + descLen + termSize);
+
+      std::string desc;
+      std::string value;
+      appendDecoded(enc, b + 1, descLen, desc);
+      appendDecoded(enc, b + valPos, size - valPos, value);
+
+      toUpper(desc);
+      if (!desc.empty())
+        addProperty(props, txxxKey(desc), std::move(value));
+      continue;
+    }
+
+    if (id == "COMM" || id == "USLT")
+    {
+      // encoding, language[3], description (NUL), text
+      if (size < 4)
+        continue;
+
+      const size_t descLen = terminatedLength(enc, b + 4, size - 4);
+      const size_t textPos = std::min<size_t>(size, 4 + descLen + termSize);
+
+      std::string desc;
+      std::string text;
+      appendDecoded(enc, b + 4, descLen, desc);
+      appendDecoded(enc, b + textPos, size - textPos, text);
+
+      std::string key(id == "COMM" ? "COMMENT" : "LYRICS");
+      if (!desc.empty())
+      {
+        toUpper(desc);
+        key += ':';
+        key += desc;
+      }
+
+      if (id == "COMM" && !plainComment && (desc.empty() || !anyComment))
+      {
+        comment      = text;
+        anyComment   = true;
+        plainComment = desc.empty();
+      }
+
+      addProperty(props, key, std::move(text));
+      continue;
+    }
+
+    const auto key = textFrameKey(id);
+    if (key.empty())
+      continue;
+
+    std::string value;
+    appendDecoded(enc, b + 1, size - 1, value);
+
+    if (id == "TCON" && isNumericGenre(value))
+      return false;
+
+    addProperty(props, key, std::move(value));
+  }
+
+  // ------------------------------------------------------------
+  // audio properties
+  // ------------------------------------------------------------
+  int durationSec = 0;
+  int bitrate     = 0;
+  if (!readMpegProperties(f, audioStart, durationSec, bitrate))
+    return false;
+
+  Metadata md;
+  md.filePath = metadata.filePath;
+
+  fillMetadata(filePath, props, comment, md, parseSession);
+  md.duration = static_cast<float>(durationSec);
+  md.bitrate  = bitrate;
+
+  if (pic.size > 0 && !utils::useCachedArt(md, pic.size))
+  {
+    std::string bytes(pic.size, '\0');
+    if (f.readInto(pic.offset, bytes.data(), bytes.size()))
+      utils::writeArt(bytes, md);
+  }
+
+  metadata = std::move(md);
+  return true;
+}
+
+} // namespace taglib::fast
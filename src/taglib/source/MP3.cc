@@ -1,5 +1,6 @@
 #include "taglib/source/MP3.hpp"
 #include "taglib/Properties.hpp"
+#include "taglib/fast/Reader.hpp"
 #include "taglib/source/Common.hpp"
 #include <fstream>
 #include <taglib/attachedpictureframe.h>
@@ -9,21 +10,39 @@
 namespace taglib::source
 {
 
-auto MP3::parse(const Path& filePath, Metadata& metadata, TagLibConfig&, ParseSession& parseSession)
-  -> bool
+auto MP3::parse(const Path& filePath, Metadata& metadata, TagLibConfig& config,
+                ParseSession& parseSession) -> bool
 {
-  TagLib::FileRef file(filePath.c_str());
-  if (file.isNull())
+  if (config.fastPath && fast::readMP3(filePath, metadata, parseSession))
+    return true;
+
+  ++parseSession.taglibParses;
+
+  // one open and one PropertyMap per file: tags, track/disc, audio properties, lyrics
+  // and the embedded picture are all taken from this single MPEG::File
+  TagLib::MPEG::File file(filePath.c_str(), true, TagLib::AudioProperties::Average);
+  if (!file.isValid())
     return false;
 
-  if (!file.tag())
+  TagLib::Tag* tag = file.tag();
+  if (!tag)
     return true;
 
-  TagLib::Tag* tag = file.tag();
+  const TagLib::PropertyMap props = file.properties();
 
   CommonTag::fillBasic(tag, filePath, metadata);
-  CommonTag::fillTrackDisc(file, metadata);
-  CommonTag::fillProperties(file, metadata, parseSession.unknownArtistTracks);
+  CommonTag::fillTrackDisc(props, metadata);
+  CommonTag::fillProperties(props, file.audioProperties(), metadata,
+                            parseSession.unknownArtistTracks);
+
+  // the ID3v2 frames are already parsed, so the cover is just a lookup
+  if (auto* id3 = file.ID3v2Tag())
+  {
+    const auto& frames = id3->frameListMap()["APIC"];
+    if (!frames.isEmpty())
+      if (auto* pic = dynamic_cast<TagLib::ID3v2::AttachedPictureFrame*>(frames.front()))
+        utils::storeArt(pic->picture(), metadata);
+  }
 
   return true;
 }
@@ -38,6 +57,8 @@ auto MP3::modify(const Path& filePath, const Metadata& newData, TagLibConfig&) -
   if (!tag)
     return false;
 
+  const auto& details = newData.details.get();
+
   if (!newData.title.empty())
     tag->setTitle(TagLib::String(newData.title, TagLib::String::UTF8));
   if (!newData.artist.empty())
@@ -46,18 +67,18 @@ auto MP3::modify(const Path& filePath, const Metadata& newData, TagLibConfig&) -
     tag->setAlbum(TagLib::String(newData.album, TagLib::String::UTF8));
   if (!newData.genre.empty())
     tag->setGenre(TagLib::String(newData.genre, TagLib::String::UTF8));
-  if (!newData.comment.empty())
-    tag->setComment(TagLib::String(newData.comment, TagLib::String::UTF8));
+  if (!details.comment.empty())
+    tag->setComment(TagLib::String(details.comment, TagLib::String::UTF8));
   if (newData.year != 0)
     tag->setYear(newData.year);
   if (newData.track != 0)
     tag->setTrack(newData.track);
 
-  if (!newData.lyrics.empty())
+  if (!details.lyrics.empty())
   {
     auto props = file.properties();
     props.replace(propTagString(PropKey::Lyrics),
-                  TagLib::StringList(TagLib::String(newData.lyrics, TagLib::String::UTF8)));
+                  TagLib::StringList(TagLib::String(details.lyrics, TagLib::String::UTF8)));
     file.setProperties(props);
   }
 
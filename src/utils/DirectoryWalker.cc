@@ -1,20 +1,58 @@
 #include "utils/DirectoryWalker.hpp"
 #include "Logger.hpp"
 #include "StackTrace.hpp"
+#include "utils/unix/IoUring.hpp"
 
 #include <dirent.h>
 #include <fcntl.h>
+#include <limits>
 #include <stdexcept>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
 #include <unistd.h>
+#include <vector>
 
 namespace utils
 {
 
+namespace
+{
+
+// result slot of an entry that never made it into the ring
+constexpr int NOT_QUEUED = std::numeric_limits<int>::min();
+
+inline auto isDotOrDotDot(const char* name) -> bool
+{
+  return name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'));
+}
+
+void fromStatx(const struct statx& sx, struct stat& st)
+{
+  st.st_dev          = makedev(sx.stx_dev_major, sx.stx_dev_minor);
+  st.st_ino          = sx.stx_ino;
+  st.st_mode         = sx.stx_mode;
+  st.st_nlink        = sx.stx_nlink;
+  st.st_uid          = sx.stx_uid;
+  st.st_gid          = sx.stx_gid;
+  st.st_rdev         = makedev(sx.stx_rdev_major, sx.stx_rdev_minor);
+  st.st_size         = static_cast<off_t>(sx.stx_size);
+  st.st_blksize      = static_cast<blksize_t>(sx.stx_blksize);
+  st.st_blocks       = static_cast<blkcnt_t>(sx.stx_blocks);
+  st.st_atim.tv_sec  = sx.stx_atime.tv_sec;
+  st.st_atim.tv_nsec = sx.stx_atime.tv_nsec;
+  st.st_mtim.tv_sec  = sx.stx_mtime.tv_sec;
+  st.st_mtim.tv_nsec = sx.stx_mtime.tv_nsec;
+  st.st_ctim.tv_sec  = sx.stx_ctime.tv_sec;
+  st.st_ctim.tv_nsec = sx.stx_ctime.tv_nsec;
+}
+
+} // namespace
+
 auto DirectoryWalker::walk(const EntryCallback& cb) -> bool
 {
   RECORD_FUNC_TO_BACKTRACE("DirectoryWalker::walk");
 
-  int fd = open(m_root.c_str(), O_RDONLY | O_DIRECTORY);
+  int fd = open(m_root.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
   if (fd < 0)
   {
     const std::string errMsg = "Failed to open directory: '" + m_root + "'";
@@ -22,13 +60,47 @@ auto DirectoryWalker::walk(const EntryCallback& cb) -> bool
     throw std::runtime_error(errMsg);
   }
 
-  walkFd(fd, cb);
-  close(fd);
+  // paths handed to the callback are always built as <dirPath>/<name>
+  std::string dirPath = m_root;
+  while (dirPath.size() > 1 && dirPath.back() == '/')
+    dirPath.pop_back();
+
+  // walkFd owns the fd from here (closedir closes it)
+  walkFd(fd, cb, dirPath);
   return true;
 }
 
-void DirectoryWalker::walkFd(int dirFd, const EntryCallback& cb)
+void DirectoryWalker::descend(int parentFd, const char* name, const EntryCallback& cb,
+                              std::string& dirPath)
 {
+  // openat keeps the lookup relative to the already open parent, so the kernel never
+  // re-resolves the full path for every level of Artist/Album/... nesting.
+  int childFd = openat(parentFd, name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (childFd < 0)
+  {
+    LOG_WARN("Unable to open sub directory '{}/{}'", dirPath, name);
+    return;
+  }
+
+  const size_t prevLen = dirPath.size();
+  if (dirPath.size() != 1 || dirPath[0] != '/')
+    dirPath += '/';
+  dirPath += name;
+
+  walkFd(childFd, cb, dirPath);
+
+  dirPath.resize(prevLen);
+}
+
+void DirectoryWalker::walkFd(int dirFd, const EntryCallback& cb, std::string& dirPath)
+{
+  // a ring torn down on an error earlier in the walk is not used again
+  if (m_ring && m_ring->usable())
+  {
+    walkFdBatched(dirFd, cb, dirPath);
+    return;
+  }
+
   DIR* dir = fdopendir(dirFd);
   if (!dir)
   {
@@ -40,62 +112,147 @@ void DirectoryWalker::walkFd(int dirFd, const EntryCallback& cb)
   struct dirent* ent;
   while ((ent = readdir(dir)) != nullptr)
   {
-    if (ent->d_name[0] == '.' &&
-        (ent->d_name[1] == '\0' || (ent->d_name[1] == '.' && ent->d_name[2] == '\0')))
+    if (isDotOrDotDot(ent->d_name))
       continue;
 
     struct stat st = {};
     if (fstatat(dirFd, ent->d_name, &st, AT_SYMLINK_NOFOLLOW) != 0)
       continue;
 
-    if (S_ISLNK(st.st_mode))
+    visit(dirFd, ent->d_name, st, cb, dirPath);
+  }
+
+  closedir(dir); // closes dirFd
+}
+
+// Same walk, but the entries of a directory are read first and then stat'ed as batches of
+// IORING_OP_STATX (relative to dirFd, so no path resolution from the root either). One
+// io_uring_enter covers up to capacity() entries, which turns a directory worth of round
+// trips into one on latency bound storage.
+//
+// Every batch is drained (all of its completions reaped) before the next one or the
+// return, the ring is shared with the parse feeder. Entries whose STATX was not queued or
+// did not succeed are stat'ed with fstatat.
+void DirectoryWalker::walkFdBatched(int dirFd, const EntryCallback& cb, std::string& dirPath)
+{
+  DIR* dir = fdopendir(dirFd);
+  if (!dir)
+  {
+    LOG_ERROR("fdopendir failed");
+    close(dirFd);
+    return;
+  }
+
+  std::vector<std::string> names;
+
+  struct dirent* ent;
+  while ((ent = readdir(dir)) != nullptr)
+    if (!isDotOrDotDot(ent->d_name))
+      names.emplace_back(ent->d_name);
+
+  std::vector<struct statx> stx(names.size());
+  std::vector<int>          res(names.size(), NOT_QUEUED);
+
+  for (size_t first = 0; first < names.size();)
+  {
+    size_t queued = 0;
+
+    while (first + queued < names.size())
     {
+      io_uring_sqe* sqe = m_ring->sqe();
+      if (!sqe)
+        break;
+
+      const size_t i = first + queued;
 
-      // default symlink policy is set to ignore, metadata can be retrived with this and
-      // will not follow the symlink.
-      //
-      // If ignore policy doesnt work, try to use report or follow but unlikely that this will help.
-      //
-      // Report: records symlink paths but doesnt recurse thru it and the caller (cb) will decide
-      // what to do. this can be used to showcase ALL the symlinks and do something about it.
-      //
-      // Follow: (NOT RECOMMENDED!) This follows the symlink and recursively walks thru it if
-      // directory else callback is invoked. there *shouldnt* be a need for this as this can cause
-      // infinite recursion and a whole lotta problems.
-      if (m_symlinkPolicy == SymlinkPolicy::Ignore)
-        continue;
-
-      if (m_symlinkPolicy == SymlinkPolicy::Report)
-      {
-        cb(ent->d_name, st, dirFd);
-        continue;
-      }
-
-      if (m_symlinkPolicy == SymlinkPolicy::Follow)
-      {
-        struct stat target = {};
-        if (fstatat(dirFd, ent->d_name, &target, 0) != 0)
-          continue;
-
-        if (S_ISDIR(target.st_mode))
-        {
-          int childFd = openat(dirFd, ent->d_name, O_RDONLY | O_DIRECTORY);
-          if (childFd >= 0)
-            walkFd(childFd, cb);
-        }
-        else
-        {
-          cb(ent->d_name, target, dirFd);
-        }
-
-        continue;
-      }
+      sqe->opcode      = IORING_OP_STATX;
+      sqe->fd          = dirFd;
+      sqe->addr        = reinterpret_cast<std::uint64_t>(names[i].c_str());
+      sqe->len         = STATX_BASIC_STATS;
+      sqe->off         = reinterpret_cast<std::uint64_t>(&stx[i]);
+      sqe->statx_flags = AT_SYMLINK_NOFOLLOW;
+      sqe->user_data   = i;
+      ++queued;
     }
 
-    cb(ent->d_name, st, dirFd);
+    // a ring that cannot take anything is broken, stat the rest the old way
+    if (queued == 0)
+      break;
+
+    if (!m_ring->drain([&](std::uint64_t idx, std::int32_t r) -> void
+                       { res[static_cast<size_t>(idx)] = r; }))
+    {
+      LOG_WARN("io_uring failed while stat'ing '{}', walking on with fstatat", dirPath);
+      break;
+    }
+
+    first += queued;
+  }
+
+  for (size_t i = 0; i < names.size(); ++i)
+  {
+    struct stat st = {};
+
+    // anything but 0 (NOT_QUEUED, -EINVAL from a kernel without STATX, ...) gets a second
+    // chance through fstatat
+    if (res[i] == 0)
+      fromStatx(stx[i], st);
+    else if (fstatat(dirFd, names[i].c_str(), &st, AT_SYMLINK_NOFOLLOW) != 0)
+      continue;
+
+    visit(dirFd, names[i].c_str(), st, cb, dirPath);
   }
 
   closedir(dir); // closes dirFd
 }
 
+void DirectoryWalker::visit(int dirFd, const char* name, const struct stat& st,
+                            const EntryCallback& cb, std::string& dirPath)
+{
+  if (S_ISLNK(st.st_mode))
+  {
+
+    // default symlink policy is set to ignore, metadata can be retrived with this and
+    // will not follow the symlink.
+    //
+    // If ignore policy doesnt work, try to use report or follow but unlikely that this will help.
+    //
+    // Report: records symlink paths but doesnt recurse thru it and the caller (cb) will decide
+    // what to do. this can be used to showcase ALL the symlinks and do something about it.
+    //
+    // Follow: (NOT RECOMMENDED!) This follows the symlink and recursively walks thru it if
+    // directory else callback is invoked. there *shouldnt* be a need for this as this can cause
+    // infinite recursion and a whole lotta problems.
+    if (m_symlinkPolicy == SymlinkPolicy::Ignore)
+      return;
+
+    if (m_symlinkPolicy == SymlinkPolicy::Report)
+    {
+      cb(name, st, dirFd, dirPath);
+      return;
+    }
+
+    if (m_symlinkPolicy == SymlinkPolicy::Follow)
+    {
+      struct stat target = {};
+      if (fstatat(dirFd, name, &target, 0) != 0)
+        return;
+
+      if (S_ISDIR(target.st_mode))
+        descend(dirFd, name, cb, dirPath);
+      else
+        cb(name, target, dirFd, dirPath);
+
+      return;
+    }
+  }
+
+  cb(name, st, dirFd, dirPath);
+
+  // plain sub directories (Artist/Album/...) are walked depth first. Symlinked
+  // directories are handled above as per the symlink policy.
+  if (m_recursive && S_ISDIR(st.st_mode))
+    descend(dirFd, name, cb, dirPath);
+}
+
 } // namespace utils
@@ -31,7 +31,7 @@ auto icompare(std::string_view a, std::string_view b) -> bool
   return ap == ae;
 }
 
-auto isEquals(const std::string& a, const std::string& b) noexcept -> bool
+auto isEquals(std::string_view a, std::string_view b) noexcept -> bool
 {
   const char* ap = a.data();
   const char* bp = b.data();
@@ -53,7 +53,7 @@ auto isEquals(const std::string& a, const std::string& b) noexcept -> bool
 }
 
 // Optimized "contains-like" equality for situations where you already know one side is lowercase
-auto isEqualsPrelowered(const std::string& lowerA, const std::string& b) noexcept -> bool
+auto isEqualsPrelowered(std::string_view lowerA, std::string_view b) noexcept -> bool
 {
   if (lowerA.size() != b.size())
     return false;
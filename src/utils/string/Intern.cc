@@ -0,0 +1,137 @@
+#include "utils/string/Intern.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <vector>
+
+namespace utils::string
+{
+
+struct InternPoolState
+{
+  static constexpr size_t BLOCK_SIZE = 64 * 1024;
+
+  std::shared_mutex                                        mtx;
+  ankerl::unordered_dense::map<std::string_view, uint32_t> ids; // views into the arena
+  std::vector<std::unique_ptr<char[]>>                     blocks;
+  char*                                                    cur        = nullptr;
+  size_t                                                   left       = 0;
+  uint32_t                                                 next       = 1; // 0 is ""
+  size_t                                                   arenaBytes = 0;
+
+  // never destroyed: InternedStrings in other statics (g_songMap) may outlive it
+  static auto get() -> InternPoolState&
+  {
+    static auto* state = new InternPoolState();
+    return *state;
+  }
+
+  // with mtx held exclusively
+  auto store(std::string_view s) -> const char*
+  {
+    const size_t need = s.size() + 1;
+
+    if (need > left)
+    {
+      // oversized strings get a block of their own, the current one stays open
+      const size_t size = std::max(need, BLOCK_SIZE);
+      blocks.push_back(std::make_unique<char[]>(size));
+      arenaBytes += size;
+
+      if (size != BLOCK_SIZE)
+      {
+        char* out = blocks.back().get();
+        std::memcpy(out, s.data(), s.size());
+        return out;
+      }
+
+      cur  = blocks.back().get();
+      left = size;
+    }
+
+    char* out = cur;
+    std::memcpy(out, s.data(), s.size());
+    out[s.size()] = '\0';
+    cur += need;
+    left -= need;
+    return out;
+  }
+
+  // with mtx held exclusively
+  auto add(std::string_view s) -> uint32_t
+  {
+    const uint32_t id   = next;
+    const uint32_t page = id >> InternPool::PAGE_BITS;
+
+    if (page >= InternPool::MAX_PAGES)
+      throw std::runtime_error("InternPool: too many distinct strings");
+
+    auto& slot    = InternPool::s_pages[page];
+    auto* entries = const_cast<InternPool::Entry*>(slot.load(std::memory_order_relaxed));
+    if (!entries)
+    {
+      entries = new InternPool::Entry[InternPool::PAGE_SIZE]{};
+      slot.store(entries, std::memory_order_release);
+    }
+
+    const char* data = store(s);
+    entries[id & (InternPool::PAGE_SIZE - 1)] = {.data = data,
+                                                 .size = static_cast<uint32_t>(s.size())};
+
+    ids.emplace(std::string_view{data, s.size()}, id);
+    ++next;
+    return id;
+  }
+};
+
+auto InternPool::intern(std::string_view s) -> uint32_t
+{
+  auto& st = InternPoolState::get();
+
+  {
+    std::shared_lock lock(st.mtx);
+    if (auto it = st.ids.find(s); it != st.ids.end())
+      return it->second;
+  }
+
+  std::unique_lock lock(st.mtx);
+  if (auto it = st.ids.find(s); it != st.ids.end())
+    return it->second;
+
+  return st.add(s);
+}
+
+auto InternPool::find(std::string_view s) -> std::optional<uint32_t>
+{
+  auto& st = InternPoolState::get();
+
+  std::shared_lock lock(st.mtx);
+  if (auto it = st.ids.find(s); it != st.ids.end())
+    return it->second;
+
+  return std::nullopt;
+}
+
+auto InternPool::count() -> size_t
+{
+  auto& st = InternPoolState::get();
+
+  std::shared_lock lock(st.mtx);
+  return st.next;
+}
+
+auto InternPool::bytes() -> size_t
+{
+  auto& st = InternPoolState::get();
+
+  std::shared_lock lock(st.mtx);
+  const size_t pages = (st.next >> PAGE_BITS) + 1;
+  return st.arenaBytes + pages * PAGE_SIZE * sizeof(Entry) +
+         st.ids.size() * (sizeof(std::string_view) + sizeof(uint32_t));
+}
+
+} // namespace utils::string
@@ -0,0 +1,147 @@
+#include "utils/string/PropertyBlock.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace utils::string
+{
+
+// ------------------------------------------------------------
+// Builder
+// ------------------------------------------------------------
+void PropertyBlock::Builder::add(std::string_view key, std::string_view value)
+{
+  if (m_values.size() + value.size() > std::numeric_limits<uint32_t>::max())
+    throw std::runtime_error("PropertyBlock: Values exceed 4 GiB.");
+
+  m_items.push_back({.key    = InternedString(key).id(),
+                     .offset = static_cast<uint32_t>(m_values.size()),
+                     .size   = static_cast<uint32_t>(value.size())});
+  m_values.append(value);
+}
+
+auto PropertyBlock::Builder::finish() -> PropertyBlock
+{
+  PropertyBlock block;
+  if (m_items.empty())
+    return block;
+
+  // stable: repeated keys keep the order they were added in
+  std::ranges::stable_sort(m_items, {}, &Item::key);
+
+  size_t keys = 0, valueBytes = 0;
+  for (size_t i = 0; i < m_items.size(); ++i)
+  {
+    if (i > 0 && m_items[i].key == m_items[i - 1].key)
+      ++valueBytes; // the ' ' joining it to the previous value
+    else
+      ++keys;
+    valueBytes += m_items[i].size;
+  }
+
+  const size_t words = 1 + keys * ENTRY_WORDS + (valueBytes + 3) / sizeof(uint32_t);
+  block.m_words      = std::make_unique<uint32_t[]>(words);
+  block.m_words[0]   = static_cast<uint32_t>(keys);
+
+  uint32_t* table = block.m_words.get() + 1;
+  char*     out   = reinterpret_cast<char*>(table + keys * ENTRY_WORDS);
+  uint32_t  pos   = 0;
+
+  for (size_t i = 0; i < m_items.size(); ++i)
+  {
+    const auto& item = m_items[i];
+
+    if (i > 0 && item.key == m_items[i - 1].key)
+    {
+      out[pos++] = ' ';
+      table[-1] += 1 + item.size; // size of the previous entry
+    }
+    else
+    {
+      table[0] = item.key;
+      table[1] = pos;
+      table[2] = item.size;
+      table += ENTRY_WORDS;
+    }
+
+    std::memcpy(out + pos, m_values.data() + item.offset, item.size);
+    pos += item.size;
+  }
+
+  m_items.clear();
+  m_values.clear();
+  return block;
+}
+
+// ------------------------------------------------------------
+// PropertyBlock
+// ------------------------------------------------------------
+PropertyBlock::PropertyBlock(const PropertyBlock& other)
+{
+  if (const size_t words = other.wordCount())
+  {
+    m_words = std::make_unique<uint32_t[]>(words);
+    std::memcpy(m_words.get(), other.m_words.get(), words * sizeof(uint32_t));
+  }
+}
+
+auto PropertyBlock::operator=(const PropertyBlock& other) -> PropertyBlock&
+{
+  if (this != &other)
+    *this = PropertyBlock(other);
+  return *this;
+}
+
+auto PropertyBlock::wordCount() const noexcept -> size_t
+{
+  const size_t n = size();
+  if (n == 0)
+    return m_words ? 1 : 0;
+
+  // values are packed in entry order, the last entry ends them
+  const uint32_t* last       = entry(static_cast<uint32_t>(n - 1));
+  const size_t    valueBytes = size_t{last[1]} + last[2];
+  return 1 + n * ENTRY_WORDS + (valueBytes + 3) / sizeof(uint32_t);
+}
+
+auto PropertyBlock::at(uint32_t index) const noexcept -> Property
+{
+  const uint32_t* e = entry(index);
+  return {.key = InternedString::fromId(e[0]), .value = {values() + e[1], e[2]}};
+}
+
+auto PropertyBlock::find(InternedString key) const noexcept -> std::optional<std::string_view>
+{
+  uint32_t lo = 0, hi = static_cast<uint32_t>(size());
+
+  while (lo < hi)
+  {
+    const uint32_t mid = lo + (hi - lo) / 2;
+    const uint32_t id  = entry(mid)[0];
+
+    if (id == key.id())
+      return at(mid).value;
+
+    if (id < key.id())
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  return std::nullopt;
+}
+
+auto PropertyBlock::findKey(std::string_view key) const -> std::optional<std::string_view>
+{
+  if (empty())
+    return std::nullopt;
+
+  if (auto interned = InternedString::find(key))
+    return find(*interned);
+
+  return std::nullopt;
+}
+
+} // namespace utils::string
@@ -0,0 +1,102 @@
+#include "utils/threads/Epoch.hpp"
+
+#include <array>
+#include <stdexcept>
+
+namespace utils::threads
+{
+
+namespace
+{
+
+struct alignas(64) Slot
+{
+  std::atomic<std::uint64_t> epoch{0}; // 0: not inside a guard
+  std::atomic<bool>          used{false};
+};
+
+// 0 is reserved for "inactive"
+constinit std::atomic<std::uint64_t> g_epoch{1};
+
+constinit std::array<Slot, Epoch::MAX_THREADS> g_slots{};
+
+// the calling thread's slot, claimed on first use and released when the thread exits
+struct ThreadSlot
+{
+  Slot*  slot  = nullptr;
+  size_t depth = 0;
+
+  auto get() -> Slot&
+  {
+    if (slot)
+      return *slot;
+
+    for (auto& s : g_slots)
+    {
+      bool expected = false;
+      if (!s.used.load(std::memory_order_relaxed) &&
+          s.used.compare_exchange_strong(expected, true, std::memory_order_acquire))
+      {
+        slot = &s;
+        return s;
+      }
+    }
+
+    throw std::runtime_error("Epoch: More than MAX_THREADS reader threads.");
+  }
+
+  ~ThreadSlot()
+  {
+    if (slot)
+    {
+      slot->epoch.store(0, std::memory_order_release);
+      slot->used.store(false, std::memory_order_release);
+    }
+  }
+};
+
+thread_local ThreadSlot t_slot;
+
+} // namespace
+
+void Epoch::enter()
+{
+  if (t_slot.depth++ > 0)
+    return;
+
+  try
+  {
+    // seq_cst store: the shared pointer loaded after this is ordered after the announcement
+    t_slot.get().epoch.store(g_epoch.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+  }
+  catch (...)
+  {
+    --t_slot.depth;
+    throw;
+  }
+}
+
+void Epoch::leave() noexcept
+{
+  if (--t_slot.depth == 0)
+    t_slot.slot->epoch.store(0, std::memory_order_release);
+}
+
+auto Epoch::advance() noexcept -> std::uint64_t
+{
+  return g_epoch.fetch_add(1, std::memory_order_seq_cst) + 1;
+}
+
+auto Epoch::quiescent(std::uint64_t retired) noexcept -> bool
+{
+  for (const auto& s : g_slots)
+  {
+    const auto e = s.epoch.load(std::memory_order_seq_cst);
+    if (e != 0 && e < retired)
+      return false;
+  }
+
+  return true;
+}
+
+} // namespace utils::threads
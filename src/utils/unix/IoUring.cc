@@ -0,0 +1,216 @@
+#include "utils/unix/IoUring.hpp"
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+namespace utils::unix
+{
+
+namespace
+{
+
+auto setup(unsigned entries, io_uring_params& params) -> int
+{
+  return static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+}
+
+auto enter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags) -> int
+{
+  return static_cast<int>(
+    ::syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0));
+}
+
+auto registerOp(int fd, unsigned opcode, void* arg, unsigned nrArgs) -> int
+{
+  return static_cast<int>(::syscall(__NR_io_uring_register, fd, opcode, arg, nrArgs));
+}
+
+template <typename T>
+auto at(void* base, unsigned offset) -> T*
+{
+  return reinterpret_cast<T*>(static_cast<char*>(base) + offset);
+}
+
+} // namespace
+
+IoUring::IoUring(unsigned entries)
+{
+  io_uring_params params{};
+
+  m_fd = setup(entries, params);
+  if (m_fd < 0)
+    throw IoUringUnavailable(std::string("io_uring_setup failed: ") + std::strerror(errno));
+
+  m_sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  m_cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+  // since 5.4 both rings live in one mapping
+  const bool single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (single)
+    m_sqRingSize = m_cqRingSize = std::max(m_sqRingSize, m_cqRingSize);
+
+  m_sqRing = ::mmap(nullptr, m_sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd,
+                    IORING_OFF_SQ_RING);
+  if (m_sqRing == MAP_FAILED)
+  {
+    m_sqRing = nullptr;
+    release();
+    throw IoUringUnavailable("io_uring: mapping the submission ring failed");
+  }
+
+  if (single)
+    m_cqRing = m_sqRing;
+  else
+  {
+    m_cqRing = ::mmap(nullptr, m_cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      m_fd, IORING_OFF_CQ_RING);
+    if (m_cqRing == MAP_FAILED)
+    {
+      m_cqRing = nullptr;
+      release();
+      throw IoUringUnavailable("io_uring: mapping the completion ring failed");
+    }
+  }
+
+  m_sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+  void* sqes = ::mmap(nullptr, m_sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd,
+                      IORING_OFF_SQES);
+  if (sqes == MAP_FAILED)
+  {
+    release();
+    throw IoUringUnavailable("io_uring: mapping the SQE array failed");
+  }
+  m_sqes = static_cast<io_uring_sqe*>(sqes);
+
+  m_sqHead    = at<unsigned>(m_sqRing, params.sq_off.head);
+  m_sqTail    = at<unsigned>(m_sqRing, params.sq_off.tail);
+  m_sqArray   = at<unsigned>(m_sqRing, params.sq_off.array);
+  m_sqMask    = *at<unsigned>(m_sqRing, params.sq_off.ring_mask);
+  m_sqEntries = params.sq_entries;
+  m_sqeTail   = *m_sqTail;
+  m_submitted = m_sqeTail;
+
+  m_cqHead = at<unsigned>(m_cqRing, params.cq_off.head);
+  m_cqTail = at<unsigned>(m_cqRing, params.cq_off.tail);
+  m_cqMask = *at<unsigned>(m_cqRing, params.cq_off.ring_mask);
+  m_cqes   = at<io_uring_cqe>(m_cqRing, params.cq_off.cqes);
+
+  probe();
+}
+
+void IoUring::probe() noexcept
+{
+  constexpr unsigned OPS = 256;
+
+  alignas(io_uring_probe) unsigned char buf[sizeof(io_uring_probe) +
+                                            (OPS * sizeof(io_uring_probe_op))] = {};
+
+  auto* p = reinterpret_cast<io_uring_probe*>(buf);
+
+  // no IORING_REGISTER_PROBE before 5.6 (no STATX / OPENAT / READ either): nothing supported
+  if (registerOp(m_fd, IORING_REGISTER_PROBE, p, OPS) < 0)
+    return;
+
+  for (unsigned i = 0; i < p->ops_len && i < OPS; ++i)
+    if ((p->ops[i].flags & IO_URING_OP_SUPPORTED) != 0)
+      m_ops.set(p->ops[i].op);
+}
+
+IoUring::~IoUring() { release(); }
+
+void IoUring::release() noexcept
+{
+  if (m_sqes)
+    ::munmap(m_sqes, m_sqesSize);
+  if (m_cqRing && m_cqRing != m_sqRing)
+    ::munmap(m_cqRing, m_cqRingSize);
+  if (m_sqRing)
+    ::munmap(m_sqRing, m_sqRingSize);
+  if (m_fd >= 0)
+    ::close(m_fd);
+
+  m_sqes     = nullptr;
+  m_cqRing   = nullptr;
+  m_sqRing   = nullptr;
+  m_fd       = -1;
+  m_inflight = 0;
+}
+
+auto IoUring::sqe() noexcept -> io_uring_sqe*
+{
+  if (!usable())
+    return nullptr;
+
+  const unsigned head = __atomic_load_n(m_sqHead, __ATOMIC_ACQUIRE);
+  if (m_sqeTail - head >= m_sqEntries)
+    return nullptr;
+
+  const unsigned idx  = m_sqeTail & m_sqMask;
+  io_uring_sqe*  next = &m_sqes[idx];
+
+  std::memset(next, 0, sizeof(*next));
+  m_sqArray[idx] = idx;
+  ++m_sqeTail;
+
+  return next;
+}
+
+auto IoUring::submitAndWait(unsigned waitNr) noexcept -> int
+{
+  if (!usable())
+    return -EBADF;
+
+  const unsigned toSubmit = m_sqeTail - m_submitted;
+
+  // the kernel may only see the new tail after the SQEs themselves
+  __atomic_store_n(m_sqTail, m_sqeTail, __ATOMIC_RELEASE);
+  m_submitted = m_sqeTail;
+
+  if (toSubmit == 0 && waitNr == 0)
+    return 0;
+
+  // the kernel may take fewer SQEs than offered, the rest is offered again
+  unsigned left = toSubmit;
+
+  while (true)
+  {
+    const int r = enter(m_fd, left, waitNr, waitNr ? IORING_ENTER_GETEVENTS : 0);
+    if (r < 0)
+    {
+      if (errno == EINTR)
+        continue;
+      return -errno;
+    }
+
+    m_inflight += static_cast<unsigned>(r);
+    left -= std::min(static_cast<unsigned>(r), left);
+
+    if (left == 0)
+      return static_cast<int>(toSubmit);
+    if (r == 0)
+      return -EAGAIN;
+  }
+}
+
+auto IoUring::waitOne() noexcept -> int
+{
+  while (true)
+  {
+    const int r = enter(m_fd, 0, 1, IORING_ENTER_GETEVENTS);
+    if (r >= 0)
+      return r;
+
+    // EBUSY: completions overflowed the CQ ring, drain() reaps and comes back
+    if (errno == EBUSY || errno == EAGAIN)
+      return 0;
+    if (errno != EINTR)
+      return -errno;
+  }
+}
+
+} // namespace utils::unix
@@ -0,0 +1,211 @@
+#include "InLimbo-Types.hpp"
+#include "common.hpp"
+#include "query/Columns.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+// SafeMap read side under a concurrent writer.
+//
+// READERS threads look up an artist in a loop while one writer publishes a new map every
+// WRITE_EVERY_US microseconds. Three read paths over the same map:
+//
+// -> atomic shared_ptr : what SafeMap did before the epoch scheme, an atomic
+//                        std::shared_ptr load (and refcount round trip) per read
+// -> SafeMap::pin()    : epoch guard + one refcount increment (kept for long lived pins)
+// -> SafeMap::read()   : epoch guard only
+//
+// Then the columns readers (query::songmap::columns, the installed columns of the published
+// version) against the same map, without a writer: every publish is a rebuild there, the
+// case measures the read path of the installed columns.
+//
+// Then N single edits published one by one vs the same N edits in one transaction.
+//
+// usage: bench_safemap_read [readers=8] [ms=1000] [artists=2000] [edits=1000]
+
+namespace
+{
+
+constexpr int ALBUMS_PER_ARTIST = 4;
+constexpr int TRACKS_PER_ALBUM  = 10;
+constexpr int WRITE_EVERY_US    = 500;
+
+auto buildMap(int artists) -> SongMap
+{
+  SongMap map;
+  ino_t   inode = 1;
+
+  for (int a = 0; a < artists; ++a)
+    for (int al = 0; al < ALBUMS_PER_ARTIST; ++al)
+      for (int t = 1; t <= TRACKS_PER_ALBUM; ++t)
+      {
+        Metadata md;
+        md.artist     = "Artist " + std::to_string(a);
+        md.album      = "Album " + std::to_string(al);
+        md.title      = "Track " + std::to_string(t);
+        md.track      = t;
+        md.discNumber = 1;
+
+        map[md.artist][md.album][1][t][inode] = std::make_shared<Song>(inode, md);
+        ++inode;
+      }
+
+  return map;
+}
+
+// runs `readers` threads calling lookup(i) for `ms` while `write` is called in a loop,
+// returns million reads per second summed over all readers
+template <typename Lookup, typename Write>
+auto run(int readers, int ms, Lookup&& lookup, Write&& write) -> double
+{
+  std::atomic<bool>   stop{false};
+  std::atomic<size_t> total{0};
+  std::atomic<size_t> hits{0}; // keeps the lookups observable
+
+  std::vector<std::thread> threads;
+  threads.reserve(readers);
+
+  for (int r = 0; r < readers; ++r)
+    threads.emplace_back(
+      [&, r]() -> void
+      {
+        size_t n = 0, found = 0;
+        while (!stop.load(std::memory_order_relaxed))
+        {
+          found += lookup(static_cast<size_t>(r) + n) ? 1 : 0;
+          ++n;
+        }
+        total.fetch_add(n, std::memory_order_relaxed);
+        hits.fetch_add(found, std::memory_order_relaxed);
+      });
+
+  Timer t;
+  while (t.elapsed_ms() < ms)
+  {
+    write();
+    std::this_thread::sleep_for(std::chrono::microseconds(WRITE_EVERY_US));
+  }
+
+  stop = true;
+  for (auto& th : threads)
+    th.join();
+
+  if (hits.load() == 0)
+    std::cout << "    (no lookup hit, check the keys)\n";
+
+  return static_cast<double>(total.load()) / (t.elapsed_ms() * 1000.0);
+}
+
+void printRate(const char* name, double mrps)
+{
+  std::cout << std::setw(20) << name << " : " << mrps << " M reads/s\n";
+}
+
+} // namespace
+
+auto main(int argc, char** argv) -> int
+{
+  const int readers = argc > 1 ? std::atoi(argv[1]) : 8;
+  const int ms      = argc > 2 ? std::atoi(argv[2]) : 1000;
+  const int artists = argc > 3 ? std::atoi(argv[3]) : 2000;
+  const int edits   = argc > 4 ? std::atoi(argv[4]) : 1000;
+
+  std::cout << "Building " << artists * ALBUMS_PER_ARTIST * TRACKS_PER_ALBUM << " songs, "
+            << readers << " reader(s), 1 writer...\n";
+
+  const SongMap base = buildMap(artists);
+
+  std::vector<Artist> keys;
+  keys.reserve(artists);
+  for (int a = 0; a < artists; ++a)
+    keys.emplace_back("Artist " + std::to_string(a));
+
+  auto key = [&](size_t i) -> const Artist& { return keys[i % keys.size()]; };
+
+  ino_t next  = 1u << 30;
+  auto  touch = [&](SongMap& map) -> void
+  {
+    map[key(next)][Album("Album 0")][1][1][next] = std::make_shared<Song>(next, Metadata{});
+    ++next;
+  };
+
+  // ---- previous reader path ----
+  {
+    std::atomic<std::shared_ptr<const SongMap>> ptr{std::make_shared<const SongMap>(base)};
+
+    const double mrps = run(
+      readers, ms,
+      [&](size_t i) -> bool
+      {
+        auto p = ptr.load(std::memory_order_acquire);
+        return p->contains(key(i));
+      },
+      [&]() -> void
+      {
+        auto copy = std::make_shared<SongMap>(*ptr.load());
+        touch(*copy);
+        ptr.store(std::move(copy), std::memory_order_release);
+      });
+
+    printRate("atomic shared_ptr", mrps);
+  }
+
+  // ---- SafeMap ----
+  {
+    TS_SongMap safeMap;
+    safeMap.replace(base);
+
+    const double pinned = run(
+      readers, ms, [&](size_t i) -> bool { return safeMap.pin()->contains(key(i)); },
+      [&]() -> void { safeMap.update(touch); });
+
+    printRate("SafeMap::pin", pinned);
+
+    const double read = run(
+      readers, ms,
+      [&](size_t i) -> bool
+      { return safeMap.read([&](const SongMap& map) -> bool { return map.contains(key(i)); }); },
+      [&]() -> void { safeMap.update(touch); });
+
+    printRate("SafeMap::read", read);
+  }
+
+  // ---- query::songmap ----
+  {
+    TS_SongMap safeMap;
+    safeMap.replace(base);
+
+    const double columns = run(
+      readers, ms,
+      [&](size_t i) -> bool
+      { return query::songmap::columns(safeMap)->findArtist(key(i)) != nullptr; },
+      []() -> void {});
+
+    printRate("songmap::columns", columns);
+  }
+
+  std::cout << "(summed over all readers)\n\n";
+
+  // ---- publishes per batch ----
+  {
+    TS_SongMap safeMap;
+    safeMap.replace(base);
+
+    Timer single;
+    for (int i = 0; i < edits; ++i)
+      safeMap.update(touch);
+    printResult("update() x N", single.elapsed_ms());
+
+    Timer batched;
+    auto  txn = safeMap.transaction();
+    for (int i = 0; i < edits; ++i)
+      touch(txn.map());
+    txn.commit();
+    printResult("transaction", batched.elapsed_ms());
+  }
+
+  return 0;
+}
@@ -0,0 +1,176 @@
+#include "Logger.hpp"
+#include "common.hpp"
+#include "core/SongLibrarySnapshot.hpp"
+#include "helpers/fs/Directory.hpp"
+#include "taglib/Parser.hpp"
+
+#include <cstdlib>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+
+// io_uring scan backend vs plain syscalls.
+//
+// Builds a synthetic Artist/Album/track tree of small tagged mp3s (ID3v2.3 text frames
+// + silent CBR frames, enough for the fast reader) and runs a full dirWalkProcessAll with
+// each backend, twice:
+//
+// -> warm : everything in the page cache, measures the syscall / submission overhead
+// -> cold : file data evicted first (POSIX_FADV_DONTNEED), closer to a first scan. Inode
+//           and dentry caches are NOT dropped, for a truly cold run do
+//           `echo 3 > /proc/sys/vm/drop_caches` as root before each half.
+//
+// On NFS or spinning disks the cold numbers are the interesting ones.
+//
+// usage: bench_scan_backend [files=20000] [tree dir=/tmp/inlimbo-bench-tree] [depth=64]
+
+namespace fs = std::filesystem;
+
+namespace
+{
+
+constexpr int TRACKS_PER_ALBUM  = 12;
+constexpr int ALBUMS_PER_ARTIST = 8;
+constexpr int FRAMES_PER_FILE   = 32;
+
+void putBE32(std::string& out, uint32_t v)
+{
+  out += static_cast<char>(v >> 24);
+  out += static_cast<char>(v >> 16);
+  out += static_cast<char>(v >> 8);
+  out += static_cast<char>(v);
+}
+
+void textFrame(std::string& out, const char* id, const std::string& value)
+{
+  out.append(id, 4);
+  putBE32(out, static_cast<uint32_t>(value.size() + 1));
+  out += '\0';
+  out += '\0';
+  out += '\0'; // Latin1
+  out += value;
+}
+
+void writeTrack(const fs::path& path, int artist, int album, int track)
+{
+  std::string frames;
+  textFrame(frames, "TIT2", "Title " + std::to_string(track));
+  textFrame(frames, "TPE1", "Artist " + std::to_string(artist));
+  textFrame(frames, "TALB", "Album " + std::to_string(album));
+  textFrame(frames, "TRCK", std::to_string(track + 1) + "/" + std::to_string(TRACKS_PER_ALBUM));
+  textFrame(frames, "TYER", std::to_string(1990 + album));
+
+  const auto size = static_cast<uint32_t>(frames.size());
+
+  std::string tag = "ID3";
+  tag += '\x03';
+  tag += '\0';
+  tag += '\0';
+  tag += static_cast<char>((size >> 21) & 0x7F);
+  tag += static_cast<char>((size >> 14) & 0x7F);
+  tag += static_cast<char>((size >> 7) & 0x7F);
+  tag += static_cast<char>(size & 0x7F);
+  tag += frames;
+
+  // MPEG1 Layer III, 128 kbps, 44.1 kHz, no padding -> 417 byte frames
+  std::string frame(417, '\0');
+  frame[0] = static_cast<char>(0xFF);
+  frame[1] = static_cast<char>(0xFB);
+  frame[2] = static_cast<char>(0x90);
+
+  std::ofstream out(path, std::ios::binary);
+  out.write(tag.data(), static_cast<std::streamsize>(tag.size()));
+  for (int i = 0; i < FRAMES_PER_FILE; ++i)
+    out.write(frame.data(), static_cast<std::streamsize>(frame.size()));
+}
+
+auto buildTree(const fs::path& root, int count) -> std::vector<fs::path>
+{
+  std::vector<fs::path> files;
+  files.reserve(count);
+
+  for (int i = 0; i < count; ++i)
+  {
+    const int track  = i % TRACKS_PER_ALBUM;
+    const int album  = (i / TRACKS_PER_ALBUM) % ALBUMS_PER_ARTIST;
+    const int artist = i / (TRACKS_PER_ALBUM * ALBUMS_PER_ARTIST);
+
+    const auto dir =
+      root / ("Artist " + std::to_string(artist)) / ("Album " + std::to_string(album));
+    const auto path = dir / (std::to_string(track + 1) + " - Track.mp3");
+
+    if (!fs::exists(path))
+    {
+      fs::create_directories(dir);
+      writeTrack(path, artist, album, track);
+    }
+    files.push_back(path);
+  }
+
+  return files;
+}
+
+void evict(const std::vector<fs::path>& files)
+{
+  for (const auto& f : files)
+  {
+    const int fd = ::open(f.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+      continue;
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    ::close(fd);
+  }
+}
+
+auto scan(const fs::path& root, helpers::fs::ScanBackend backend, unsigned depth) -> double
+{
+  taglib::Parser            parser(taglib::TagLibConfig{.fastPath = true});
+  core::SongLibrarySnapshot snapshot;
+
+  helpers::fs::ScanOptions options;
+  options.backend    = backend;
+  options.queueDepth = depth;
+
+  Timer t;
+  helpers::fs::dirWalkProcessAll(Directory(root.c_str()), parser, snapshot, options);
+  const double ms = t.elapsed_ms();
+
+  size_t songs = 0;
+  for (const auto& [artist, albums] : snapshot.returnSongMap())
+    for (const auto& [album, discs] : albums)
+      for (const auto& [disc, tracks] : discs)
+        for (const auto& [track, inodes] : tracks)
+          songs += inodes.size();
+
+  std::cout << "    (" << songs << " songs)\n";
+  return ms;
+}
+
+} // namespace
+
+auto main(int argc, char** argv) -> int
+{
+  const int      count = argc > 1 ? std::atoi(argv[1]) : 20000;
+  const fs::path root  = argc > 2 ? argv[2] : "/tmp/inlimbo-bench-tree";
+  const unsigned depth = argc > 3 ? static_cast<unsigned>(std::atoi(argv[3])) : 64;
+
+  inlimbo::Logger::init("bench", inlimbo::LogMode::ConsoleOnly, "", spdlog::level::err);
+
+  std::cout << "Building " << count << " files under " << root << "...\n";
+  const auto files = buildTree(root, count);
+
+  using helpers::fs::ScanBackend;
+
+  printResult("syscalls (warm)", scan(root, ScanBackend::Syscalls, depth));
+  printResult("io_uring (warm)", scan(root, ScanBackend::IoUring, depth));
+
+  evict(files);
+  printResult("syscalls (cold)", scan(root, ScanBackend::Syscalls, depth));
+
+  evict(files);
+  printResult("io_uring (cold)", scan(root, ScanBackend::IoUring, depth));
+
+  return 0;
+}
@@ -0,0 +1,139 @@
+#include "InLimbo-Types.hpp"
+#include "common.hpp"
+#include "query/Columns.hpp"
+#include "query/SongMap.hpp"
+#include "utils/algorithm/Levenshtein.hpp"
+
+#include <cstdlib>
+#include <random>
+#include <string>
+
+// Fuzzy title search over the published map, one query per keystroke.
+//
+// -> pattern : utils::algorithm::LevenshteinPattern::forEachWithin over the title column,
+//              the distance kernel alone
+// -> all     : query::songmap::read::findAllSongsByTitleFuzzy, every match ranked
+// -> best    : query::songmap::read::findSongObjByTitleFuzzy, the closest match
+//
+// Titles are a few words out of a small vocabulary, so a good share of them falls inside
+// the length band of the queries and actually gets scanned.
+//
+// usage: bench_songmap_fuzzy [tracks=1000000] [queries=20] [maxDistance=3]
+
+namespace
+{
+
+constexpr int TRACKS_PER_ALBUM  = 10;
+constexpr int ALBUMS_PER_ARTIST = 5;
+
+constexpr const char* WORDS[] = {"Love",  "Night", "The",   "Of",   "Song", "Blue",
+                                 "Dream", "Fire",  "Heart", "Rain", "City", "Dance"};
+constexpr size_t      NWORDS  = std::size(WORDS);
+
+auto titleOf(std::mt19937& rng, size_t i) -> Title
+{
+  Title      t;
+  const auto words = 1 + rng() % 4;
+
+  for (size_t w = 0; w < words; ++w)
+  {
+    if (w != 0)
+      t += ' ';
+    t += WORDS[rng() % NWORDS];
+  }
+
+  return t + " " + std::to_string(i % 1000);
+}
+
+auto buildMap(size_t tracks) -> SongMap
+{
+  SongMap      map;
+  std::mt19937 rng(1);
+
+  for (size_t i = 0; i < tracks; ++i)
+  {
+    const auto t  = static_cast<Track>(i % TRACKS_PER_ALBUM + 1);
+    const auto al = i / TRACKS_PER_ALBUM;
+
+    Metadata md;
+    md.artist     = "Artist " + std::to_string(al / ALBUMS_PER_ARTIST);
+    md.album      = "Album " + std::to_string(al);
+    md.title      = titleOf(rng, i);
+    md.track      = t;
+    md.discNumber = 1;
+
+    const auto inode = static_cast<ino_t>(i + 1);
+    map[md.artist][md.album][1][t][inode] = std::make_shared<Song>(inode, md);
+  }
+
+  return map;
+}
+
+// lower case and a typo away from the titles, like a query being typed
+auto queryOf(std::mt19937& rng) -> Title
+{
+  auto q = titleOf(rng, rng());
+  for (auto& ch : q)
+    ch = static_cast<char>(ch >= 'A' && ch <= 'Z' ? ch + 32 : ch);
+
+  q[rng() % q.size()] = 'x';
+  return q;
+}
+
+} // namespace
+
+auto main(int argc, char** argv) -> int
+{
+  const size_t tracks  = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+  const int    queries = argc > 2 ? std::atoi(argv[2]) : 20;
+  const size_t maxDist = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 3;
+
+  TS_SongMap safeMap;
+  safeMap.replace(buildMap(tracks));
+
+  const auto c = query::songmap::columns(safeMap); // built once, outside the timings
+
+  std::mt19937       rng(2);
+  std::vector<Title> qs;
+  for (int q = 0; q < queries; ++q)
+    qs.push_back(queryOf(rng));
+
+  std::cout << tracks << " songs, " << queries << " queries, maxDistance " << maxDist << "\n";
+
+  {
+    size_t hits = 0;
+
+    Timer t;
+    for (const auto& q : qs)
+    {
+      const utils::algorithm::LevenshteinPattern pattern(q, true);
+      pattern.forEachWithin(
+        c->size(), [&](size_t i) -> std::string_view { return c->title[i]; }, maxDist,
+        [&](size_t, size_t) -> void { ++hits; });
+    }
+    printResult("pattern", t.elapsed_ms() / queries);
+    std::cout << "  (hits " << hits << ")\n";
+  }
+
+  {
+    size_t hits = 0;
+
+    Timer t;
+    for (const auto& q : qs)
+      hits += query::songmap::read::findAllSongsByTitleFuzzy(safeMap, q, maxDist).size();
+    printResult("all", t.elapsed_ms() / queries);
+    std::cout << "  (hits " << hits << ")\n";
+  }
+
+  {
+    size_t hits = 0;
+
+    Timer t;
+    for (const auto& q : qs)
+      hits += query::songmap::read::findSongObjByTitleFuzzy(safeMap, q, maxDist) ? 1 : 0;
+    printResult("best", t.elapsed_ms() / queries);
+    std::cout << "  (hits " << hits << ")\n";
+  }
+
+  return 0;
+}
@@ -0,0 +1,220 @@
+#include "InLimbo-Types.hpp"
+#include "common.hpp"
+#include "query/Columns.hpp"
+#include "query/SongMap.hpp"
+#include "utils/string/Equals.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+// Point lookups on the SongMap: inode -> path, title -> song(s), path -> song.
+//
+// -> linear  : a full walk of the five map levels per lookup, what the finders did before
+//              the secondary indexes (see query/Columns.hpp)
+// -> indexed : query::songmap::read::*, hash lookups on the columns of the published map
+//
+// The index build is part of the columns build, which runs once per published map. Its
+// time is printed separately.
+//
+// usage: bench_songmap_lookup [lookups=1000] [tracks...=100000 1000000]
+
+namespace
+{
+
+constexpr int TRACKS_PER_ALBUM  = 10;
+constexpr int ALBUMS_PER_ARTIST = 5;
+
+auto pathOf(size_t i) -> PathStr { return "/music/lib/" + std::to_string(i) + ".flac"; }
+auto titleOf(size_t i) -> Title { return "Track Title " + std::to_string(i); }
+
+auto buildMap(size_t tracks) -> SongMap
+{
+  SongMap map;
+
+  for (size_t i = 0; i < tracks; ++i)
+  {
+    const auto t  = static_cast<Track>(i % TRACKS_PER_ALBUM + 1);
+    const auto al = i / TRACKS_PER_ALBUM;
+
+    Metadata md;
+    md.artist     = "Artist " + std::to_string(al / ALBUMS_PER_ARTIST);
+    md.album      = "Album " + std::to_string(al);
+    md.title      = titleOf(i);
+    md.filePath   = pathOf(i);
+    md.track      = t;
+    md.discNumber = 1;
+
+    const auto inode = static_cast<ino_t>(i + 1);
+    map[md.artist][md.album][1][t][inode] = std::make_shared<Song>(inode, md);
+  }
+
+  return map;
+}
+
+// ---- the full walks ----
+
+template <typename Fn>
+void walk(const SongMap& map, Fn&& fn)
+{
+  for (const auto& [artist, albums] : map)
+    for (const auto& [album, discs] : albums)
+      for (const auto& [disc, tracks] : discs)
+        for (const auto& [track, inodes] : tracks)
+          for (const auto& [inode, song] : inodes)
+            fn(inode, song);
+}
+
+auto linearPathByInode(const SongMap& map, ino_t id) -> PathStr
+{
+  PathStr path;
+  walk(map,
+       [&](ino_t inode, const std::shared_ptr<Song>& song) -> void
+       {
+         if (inode == id)
+           path = song->metadata.filePath;
+       });
+  return path;
+}
+
+auto linearByTitle(const SongMap& map, const Title& title) -> std::shared_ptr<Song>
+{
+  std::shared_ptr<Song> found;
+  walk(map,
+       [&](ino_t, const std::shared_ptr<Song>& song) -> void
+       {
+         if (!found && utils::string::isEquals(song->metadata.title, title))
+           found = song;
+       });
+  return found;
+}
+
+auto linearAllByTitle(const SongMap& map, const Title& title) -> Songs
+{
+  Songs found;
+  walk(map,
+       [&](ino_t, const std::shared_ptr<Song>& song) -> void
+       {
+         if (utils::string::isEquals(song->metadata.title, title))
+           found.push_back(song);
+       });
+  return found;
+}
+
+auto linearByPath(const SongMap& map, const PathStr& path) -> std::shared_ptr<Song>
+{
+  std::shared_ptr<Song> found;
+  walk(map,
+       [&](ino_t, const std::shared_ptr<Song>& song) -> void
+       {
+         if (!found && song->metadata.filePath == path)
+           found = song;
+       });
+  return found;
+}
+
+// runs fn(i) for every i in [0, n), returns microseconds per call
+template <typename Fn>
+auto perLookup(size_t n, Fn&& fn) -> double
+{
+  size_t hits = 0;
+  Timer  t;
+  for (size_t i = 0; i < n; ++i)
+    hits += fn(i) ? 1 : 0;
+
+  const double ms = t.elapsed_ms();
+  if (hits != n)
+    std::cout << "    (" << n - hits << " lookup(s) missed, check the keys)\n";
+
+  return ms * 1000.0 / static_cast<double>(n);
+}
+
+void printRow(const char* name, double linearUs, double indexedUs)
+{
+  std::cout << std::setw(20) << name << " : " << std::setw(12) << linearUs << " us  vs "
+            << std::setw(10) << indexedUs << " us  (x" << linearUs / indexedUs << ")\n";
+}
+
+void runSize(size_t tracks, size_t lookups)
+{
+  std::cout << "---- " << tracks << " tracks ----\n";
+
+  TS_SongMap safeMap;
+  safeMap.replace(buildMap(tracks));
+
+  const auto map = safeMap.pin();
+
+  Timer build;
+  query::songmap::columns(safeMap);
+  printResult("columns + indexes", build.elapsed_ms());
+
+  // a full walk per lookup is slow at 1M tracks, the linear side gets fewer lookups
+  const size_t linearLookups =
+    std::max<size_t>(1, lookups / std::max<size_t>(1, tracks / 10000));
+
+  // spread the keys over the whole library
+  auto key = [&](size_t i) -> size_t { return (i * 7919) % tracks; };
+
+  std::vector<Title>   titles;
+  std::vector<PathStr> paths;
+  titles.reserve(lookups);
+  paths.reserve(lookups);
+  for (size_t i = 0; i < lookups; ++i)
+  {
+    // case differs from the stored title on purpose
+    titles.push_back("track title " + std::to_string(key(i)));
+    paths.push_back(pathOf(key(i)));
+  }
+
+  using namespace query::songmap::read;
+
+  auto inodeOf = [&](size_t i) -> ino_t { return static_cast<ino_t>(key(i) + 1); };
+
+  printRow("path by inode",
+           perLookup(linearLookups, [&](size_t i) -> bool
+                     { return !linearPathByInode(*map, inodeOf(i)).empty(); }),
+           perLookup(lookups, [&](size_t i) -> bool
+                     { return !findSongPathByInode(safeMap, inodeOf(i)).empty(); }));
+
+  printRow("song by title",
+           perLookup(linearLookups,
+                     [&](size_t i) -> bool { return linearByTitle(*map, titles[i]) != nullptr; }),
+           perLookup(lookups, [&](size_t i) -> bool
+                     { return findSongObjByTitle(safeMap, titles[i]) != nullptr; }));
+
+  printRow("all songs by title",
+           perLookup(linearLookups,
+                     [&](size_t i) -> bool
+                     { return !linearAllByTitle(*map, titles[i]).empty(); }),
+           perLookup(lookups, [&](size_t i) -> bool
+                     { return !findAllSongsByTitle(safeMap, titles[i]).empty(); }));
+
+  printRow("song by path",
+           perLookup(linearLookups,
+                     [&](size_t i) -> bool { return linearByPath(*map, paths[i]) != nullptr; }),
+           perLookup(lookups, [&](size_t i) -> bool
+                     { return findSongObjByPath(safeMap, paths[i]) != nullptr; }));
+
+  std::cout << "\n";
+}
+
+} // namespace
+
+auto main(int argc, char** argv) -> int
+{
+  const size_t lookups = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000;
+
+  std::vector<size_t> sizes;
+  for (int i = 2; i < argc; ++i)
+    sizes.push_back(std::strtoull(argv[i], nullptr, 10));
+  if (sizes.empty())
+    sizes = {100000, 1000000};
+
+  std::cout << "(per lookup, linear is a full map walk)\n\n";
+
+  for (const size_t tracks : sizes)
+    runSize(tracks, lookups);
+
+  return 0;
+}
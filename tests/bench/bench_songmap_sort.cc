@@ -0,0 +1,155 @@
+#include "InLimbo-Types.hpp"
+#include "common.hpp"
+#include "query/Columns.hpp"
+#include "query/SongMap.hpp"
+#include "query/sort/Order.hpp"
+
+#include <cstdlib>
+#include <string>
+
+// Cost of switching the runtime sort plan.
+//
+// -> compile : query::sort::compile, a plan into its SortProgram
+// -> serial  : query::sort::buildOrder, one key per level, on the calling thread only
+// -> order   : the same with the default thread count (one per core past 50k songs)
+// -> chain   : query::sort::buildOrder, artists and albums on two keys each
+// -> plan    : mut::sortSongMap end to end (order + publishing the unchanged map)
+//
+// Plans alternate between two that move every level, so each pass does real work.
+//
+// usage: bench_songmap_sort [tracks=400000] [passes=10]
+
+namespace
+{
+
+constexpr int TRACKS_PER_ALBUM  = 10;
+constexpr int ALBUMS_PER_ARTIST = 5;
+
+auto buildMap(size_t tracks) -> SongMap
+{
+  SongMap map;
+
+  for (size_t i = 0; i < tracks; ++i)
+  {
+    const auto t  = static_cast<Track>(i % TRACKS_PER_ALBUM + 1);
+    const auto al = i / TRACKS_PER_ALBUM;
+
+    Metadata md;
+    md.artist     = "Artist " + std::to_string(al / ALBUMS_PER_ARTIST);
+    md.album      = "Album " + std::to_string(al);
+    md.title      = "Track " + std::to_string(i);
+    md.year       = static_cast<Year>(1960 + al % 60);
+    md.track      = t;
+    md.discNumber = 1;
+
+    const auto inode = static_cast<ino_t>(i + 1);
+    map[md.artist][md.album][1][t][inode] = std::make_shared<Song>(inode, md);
+  }
+
+  return map;
+}
+
+auto plan(int pass) -> query::sort::RuntimeSortPlan
+{
+  using namespace query::sort::metric;
+
+  query::sort::RuntimeSortPlan p;
+
+  if (pass % 2 == 0)
+  {
+    p.artist = ArtistMetric::LexDesc;
+    p.album  = AlbumMetric::YearAsc;
+    p.disc   = DiscMetric::DiscDesc;
+    p.track  = TrackMetric::TrackDesc;
+  }
+
+  return p;
+}
+
+// year then title for albums, album count then name for artists
+auto chainPlan(int pass) -> query::sort::RuntimeSortPlan
+{
+  using namespace query::sort::metric;
+
+  auto p = plan(pass);
+
+  p.artist     = pass % 2 == 0 ? ArtistMetric::AlbumCountDesc : ArtistMetric::AlbumCountAsc;
+  p.artistThen = {ArtistMetric::LexAsc};
+  p.album      = pass % 2 == 0 ? AlbumMetric::YearDesc : AlbumMetric::YearAsc;
+  p.albumThen  = {AlbumMetric::LexAsc};
+
+  return p;
+}
+
+} // namespace
+
+auto main(int argc, char** argv) -> int
+{
+  const size_t tracks = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 400000;
+  const int    passes = argc > 2 ? std::atoi(argv[2]) : 10;
+
+  TS_SongMap safeMap;
+  safeMap.replace(buildMap(tracks));
+
+  const auto c = query::songmap::columns(safeMap); // built once, outside the timings
+
+  std::cout << tracks << " songs, " << passes << " passes\n";
+
+  {
+    size_t sum = 0;
+
+    Timer t;
+    for (int p = 0; p < passes; ++p)
+      sum += query::sort::compile(chainPlan(p)).album.size();
+    printResult("compile", t.elapsed_ms() / passes);
+    std::cout << "  (checksum " << sum << ")\n";
+  }
+
+  {
+    const auto one   = query::sort::compile(plan(0));
+    const auto other = query::sort::compile(plan(1));
+
+    size_t sum = 0;
+
+    Timer t;
+    for (int p = 0; p < passes; ++p)
+      sum += query::sort::buildOrder(*c, p % 2 == 0 ? one : other, 1).songs.front();
+    printResult("serial", t.elapsed_ms() / passes);
+    std::cout << "  (checksum " << sum << ")\n";
+  }
+
+  {
+    const auto one   = query::sort::compile(plan(0));
+    const auto other = query::sort::compile(plan(1));
+
+    size_t sum = 0;
+
+    Timer t;
+    for (int p = 0; p < passes; ++p)
+      sum += query::sort::buildOrder(*c, p % 2 == 0 ? one : other).songs.front();
+    printResult("order", t.elapsed_ms() / passes);
+    std::cout << "  (checksum " << sum << ")\n";
+  }
+
+  {
+    const auto one   = query::sort::compile(chainPlan(0));
+    const auto other = query::sort::compile(chainPlan(1));
+
+    size_t sum = 0;
+
+    Timer t;
+    for (int p = 0; p < passes; ++p)
+      sum += query::sort::buildOrder(*c, p % 2 == 0 ? one : other).songs.front();
+    printResult("chain", t.elapsed_ms() / passes);
+    std::cout << "  (checksum " << sum << ")\n";
+  }
+
+  {
+    Timer t;
+    for (int p = 0; p < passes; ++p)
+      query::songmap::mut::sortSongMap(safeMap, plan(p));
+    printResult("plan", t.elapsed_ms() / passes);
+  }
+
+  return 0;
+}
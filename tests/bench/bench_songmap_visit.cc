@@ -0,0 +1,136 @@
+#include "InLimbo-Types.hpp"
+#include "common.hpp"
+#include "query/SongMap.hpp"
+
+#include <cstdlib>
+#include <functional>
+#include <ranges>
+#include <string>
+
+// Cost per song visited by query::songmap::read over one snapshot.
+//
+// -> std::function : the exported forEachSong, one indirect call per song
+// -> template      : forEachSong with a lambda, the callback is inlined into the loop
+// -> range view    : songs(snapshot) | filter, iterated directly
+//
+// Each sums the track numbers of songs from SINCE on, reading the year from the Song, so
+// the work per song is the same and small: what is left is the cost of getting to the
+// song. The last row filters on the year column instead.
+//
+// usage: bench_songmap_visit [tracks=200000] [passes=50]
+
+namespace
+{
+
+constexpr int TRACKS_PER_ALBUM  = 10;
+constexpr int ALBUMS_PER_ARTIST = 5;
+
+auto buildMap(size_t tracks) -> SongMap
+{
+  SongMap map;
+
+  for (size_t i = 0; i < tracks; ++i)
+  {
+    const auto t  = static_cast<Track>(i % TRACKS_PER_ALBUM + 1);
+    const auto al = i / TRACKS_PER_ALBUM;
+
+    Metadata md;
+    md.artist     = "Artist " + std::to_string(al / ALBUMS_PER_ARTIST);
+    md.album      = "Album " + std::to_string(al);
+    md.title      = "Track " + std::to_string(i);
+    md.year       = static_cast<Year>(1960 + i % 60);
+    md.track      = t;
+    md.discNumber = 1;
+
+    const auto inode = static_cast<ino_t>(i + 1);
+    map[md.artist][md.album][1][t][inode] = std::make_shared<Song>(inode, md);
+  }
+
+  return map;
+}
+
+constexpr Year SINCE = 2000;
+
+void printPerSong(const char* name, double ms, size_t visited, size_t sum)
+{
+  std::cout << std::setw(20) << name << " : " << ms * 1e6 / static_cast<double>(visited)
+            << " ns/song  (checksum " << sum << ")\n";
+}
+
+} // namespace
+
+auto main(int argc, char** argv) -> int
+{
+  const size_t tracks = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 200000;
+  const int    passes = argc > 2 ? std::atoi(argv[2]) : 50;
+
+  TS_SongMap safeMap;
+  safeMap.replace(buildMap(tracks));
+
+  using namespace query::songmap::read;
+
+  const auto   snap    = snapshot(safeMap); // builds the columns once, outside the timings
+  const size_t visited = snap->size() * static_cast<size_t>(passes);
+
+  std::cout << tracks << " songs, " << passes << " passes\n";
+
+  {
+    size_t sum = 0;
+
+    const std::function<void(const Artist&, const Album&, Disc, Track, ino_t,
+                             const std::shared_ptr<Song>&)>
+      fn = [&](const Artist&, const Album&, Disc, Track track, ino_t,
+               const std::shared_ptr<Song>& song) -> void
+    {
+      if (song->metadata.year >= SINCE)
+        sum += track;
+    };
+
+    Timer t;
+    for (int p = 0; p < passes; ++p)
+      forEachSong(safeMap, fn);
+    printPerSong("std::function", t.elapsed_ms(), visited, sum);
+  }
+
+  {
+    size_t sum = 0;
+
+    Timer t;
+    for (int p = 0; p < passes; ++p)
+      forEachSong(safeMap,
+                  [&](const Artist&, const Album&, Disc, Track track, ino_t,
+                      const std::shared_ptr<Song>& song) -> void
+                  {
+                    if (song->metadata.year >= SINCE)
+                      sum += track;
+                  });
+    printPerSong("template", t.elapsed_ms(), visited, sum);
+  }
+
+  {
+    size_t sum = 0;
+
+    auto recent = [](SongRef s) -> bool { return s.song()->metadata.year >= SINCE; };
+
+    Timer t;
+    for (int p = 0; p < passes; ++p)
+      for (const SongRef s : songs(*snap) | std::views::filter(recent))
+        sum += s.track();
+    printPerSong("range view", t.elapsed_ms(), visited, sum);
+  }
+
+  {
+    size_t sum = 0;
+
+    // same filter on the year column, the Song objects are not touched at all
+    auto recent = [](SongRef s) -> bool { return s.year() >= SINCE; };
+
+    Timer t;
+    for (int p = 0; p < passes; ++p)
+      for (const SongRef s : songs(*snap) | std::views::filter(recent))
+        sum += s.track();
+    printPerSong("range view (column)", t.elapsed_ms(), visited, sum);
+  }
+
+  return 0;
+}
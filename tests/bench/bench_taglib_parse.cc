@@ -0,0 +1,220 @@
+#include "Logger.hpp"
+#include "common.hpp"
+#include "taglib/Parser.hpp"
+#include "taglib/Properties.hpp"
+#include "taglib/source/Common.hpp"
+#include "utils/fs/Paths.hpp"
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <sys/resource.h>
+#include <vector>
+
+#include <taglib/attachedpictureframe.h>
+#include <taglib/id3v2tag.h>
+#include <taglib/mpegfile.h>
+
+// Single open tag pipeline vs the previous multi open one.
+//
+// Builds a synthetic corpus of tagged mp3s (silent CBR frames + ID3v2 with track/disc
+// fractions, album artist, lyrics and an APIC cover) and parses it with:
+//
+// -> legacy : FileRef, PropertyMap built 3 times, MPEG::File re-opened for the cover
+// -> single : taglib::Parser::parseFile, TagLib only (one MPEG::File, one PropertyMap)
+// -> fast   : taglib::Parser::parseFile with the native pread reader (taglib/fast)
+//
+// usage: bench_taglib_parse [files=2000] [corpus dir=/tmp/inlimbo-bench-corpus]
+//
+// For the syscall side, run each half under `strace -c -f`.
+
+namespace fs = std::filesystem;
+
+namespace
+{
+
+constexpr int FRAMES_PER_FILE = 64;
+
+// MPEG1 Layer III, 128 kbps, 44.1 kHz, no padding -> 417 byte frames
+void writeSilentMp3(const fs::path& path)
+{
+  std::ofstream out(path, std::ios::binary);
+
+  std::string frame(417, '\0');
+  frame[0] = static_cast<char>(0xFF);
+  frame[1] = static_cast<char>(0xFB);
+  frame[2] = static_cast<char>(0x90);
+  frame[3] = static_cast<char>(0x00);
+
+  for (int i = 0; i < FRAMES_PER_FILE; ++i)
+    out.write(frame.data(), static_cast<std::streamsize>(frame.size()));
+}
+
+void tagFile(const fs::path& path, int idx)
+{
+  TagLib::MPEG::File file(path.c_str());
+  auto*              tag = file.ID3v2Tag(true);
+
+  tag->setTitle(TagLib::String("Title " + std::to_string(idx), TagLib::String::UTF8));
+  tag->setArtist(TagLib::String("Artist " + std::to_string(idx % 50), TagLib::String::UTF8));
+  tag->setAlbum(TagLib::String("Album " + std::to_string(idx % 200), TagLib::String::UTF8));
+  tag->setGenre("Rock");
+  tag->setYear(2000 + (idx % 25));
+
+  auto props = file.properties();
+  props.replace("TRACKNUMBER", TagLib::StringList(std::to_string(idx % 12 + 1) + "/12"));
+  props.replace("DISCNUMBER", TagLib::StringList("1/1"));
+  props.replace("ALBUMARTIST", TagLib::StringList("Artist " + std::to_string(idx % 50)));
+  props.replace("LYRICS", TagLib::StringList("la la la"));
+  file.setProperties(props);
+
+  auto* pic = new TagLib::ID3v2::AttachedPictureFrame;
+  pic->setMimeType("image/jpeg");
+  pic->setType(TagLib::ID3v2::AttachedPictureFrame::FrontCover);
+  pic->setPicture(TagLib::ByteVector(16 * 1024, static_cast<char>(idx & 0xFF)));
+  tag->addFrame(pic);
+
+  file.save();
+}
+
+auto buildCorpus(const fs::path& dir, int count) -> std::vector<Path>
+{
+  fs::create_directories(dir);
+
+  std::vector<Path> files;
+  files.reserve(count);
+
+  for (int i = 0; i < count; ++i)
+  {
+    const auto p = dir / ("track_" + std::to_string(i) + ".mp3");
+    if (!fs::exists(p))
+    {
+      writeSilentMp3(p);
+      tagFile(p, i);
+    }
+    files.emplace_back(p.c_str());
+  }
+
+  return files;
+}
+
+// ------------------------------------------------------------
+// copy of the pipeline before the single open rework
+// ------------------------------------------------------------
+namespace legacy
+{
+
+void extractTrackAndTotal(TagLib::FileRef& file, Metadata& metadata)
+{
+  TagLib::PropertyMap props = file.file()->properties();
+  taglib::utils::extractTrackAndTotal(props, metadata);
+}
+
+void extractDiscAndTotal(TagLib::FileRef& file, Metadata& metadata)
+{
+  TagLib::PropertyMap props = file.file()->properties();
+  taglib::utils::extractDiscAndTotal(props, metadata);
+}
+
+auto parse(const Path& filePath, Metadata& metadata, int& unknownArtistTracks) -> bool
+{
+  metadata.filePath = filePath;
+
+  TagLib::FileRef file(filePath.c_str());
+  if (file.isNull() || !file.tag())
+    return false;
+
+  taglib::source::CommonTag::fillBasic(file.tag(), filePath, metadata);
+  extractDiscAndTotal(file, metadata);
+  extractTrackAndTotal(file, metadata);
+
+  TagLib::PropertyMap props = file.file()->properties();
+  taglib::source::CommonTag::fillProperties(props, file.audioProperties(), metadata,
+                                            unknownArtistTracks);
+
+  // fillArtUrl: mkdir + stat + a second open of the file
+  const auto cacheDir = utils::fs::getAppCacheArtPath();
+  fs::create_directories(cacheDir);
+
+  const auto outImg =
+    cacheDir / ("legacy-" + std::to_string(std::hash<std::string>{}(metadata.filePath)) + ".jpg");
+
+  if (fs::exists(outImg))
+    return true;
+
+  TagLib::MPEG::File mp3(filePath.c_str());
+  if (auto* tag = mp3.ID3v2Tag())
+  {
+    const auto& frames = tag->frameListMap()["APIC"];
+    if (!frames.isEmpty())
+      if (auto* pic = dynamic_cast<TagLib::ID3v2::AttachedPictureFrame*>(frames.front()))
+      {
+        std::ofstream out(outImg, std::ios::binary);
+        out.write(pic->picture().data(), pic->picture().size());
+      }
+  }
+
+  return true;
+}
+
+} // namespace legacy
+
+auto cpuMs() -> double
+{
+  rusage ru{};
+  getrusage(RUSAGE_SELF, &ru);
+  return (ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1e3 +
+         (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1e3;
+}
+
+} // namespace
+
+auto main(int argc, char** argv) -> int
+{
+  const int      count = argc > 1 ? std::atoi(argv[1]) : 2000;
+  const fs::path dir   = argc > 2 ? fs::path(argv[2]) : fs::path("/tmp/inlimbo-bench-corpus");
+
+  // keep the art cache inside the corpus dir
+  setenv("HOME", dir.c_str(), 1);
+
+  inlimbo::Logger::init("bench", inlimbo::LogMode::ConsoleOnly, "", spdlog::level::err);
+
+  const auto files = buildCorpus(dir / "songs", count);
+
+  // first pass of each populates the art cache, measure the steady state (rescan) as well
+  for (int pass = 0; pass < 2; ++pass)
+  {
+    {
+      int      unknown = 0;
+      double   cpu0    = cpuMs();
+      Timer    t;
+      Metadata md;
+      for (const auto& f : files)
+      {
+        md = {};
+        legacy::parse(f, md, unknown);
+      }
+      printResult(pass ? "legacy (warm art)" : "legacy (cold art)", t.elapsed_ms());
+      printResult("  cpu", cpuMs() - cpu0);
+    }
+
+    for (const bool fast : {false, true})
+    {
+      taglib::Parser parser(taglib::TagLibConfig{.fastPath = fast});
+      double         cpu0 = cpuMs();
+      Timer          t;
+      Metadata       md;
+      for (const auto& f : files)
+      {
+        md = {};
+        parser.parseFile(f, md);
+      }
+      if (fast)
+        printResult(pass ? "fast (warm art)" : "fast (cold art)", t.elapsed_ms());
+      else
+        printResult(pass ? "single (warm art)" : "single (cold art)", t.elapsed_ms());
+      printResult("  cpu", cpuMs() - cpu0);
+    }
+  }
+}
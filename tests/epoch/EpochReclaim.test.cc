@@ -0,0 +1,168 @@
+#include <gtest/gtest.h>
+
+#include "utils/threads/Epoch.hpp"
+#include "utils/threads/SafeMap.hpp"
+
+#include <atomic>
+#include <map>
+#include <semaphore>
+#include <thread>
+
+using utils::threads::Epoch;
+using utils::threads::SafeMap;
+
+namespace
+{
+
+// a reader thread that enters a guard, holds it until released and then leaves
+class HeldReader
+{
+public:
+  template <typename Fn>
+  explicit HeldReader(Fn&& inside)
+      : m_thread(
+          [this, inside = std::forward<Fn>(inside)]() -> void
+          {
+            {
+              Epoch::Guard guard;
+              inside();
+              m_entered.release();
+              m_release.acquire();
+            }
+            m_left.release();
+          })
+  {
+    m_entered.acquire();
+  }
+
+  HeldReader() : HeldReader([]() -> void {}) {}
+
+  ~HeldReader()
+  {
+    leave();
+    m_thread.join();
+  }
+
+  void leave()
+  {
+    if (std::exchange(m_inside, false))
+    {
+      m_release.release();
+      m_left.acquire();
+    }
+  }
+
+private:
+  std::binary_semaphore m_entered{0};
+  std::binary_semaphore m_release{0};
+  std::binary_semaphore m_left{0};
+  bool                  m_inside = true;
+  std::thread           m_thread;
+};
+
+// counts the live copies, so a test can tell when a retired snapshot was freed
+struct Tracked
+{
+  static inline std::atomic<int> live{0};
+
+  int value = 0;
+
+  explicit Tracked(int v) : value(v) { ++live; }
+  Tracked(const Tracked& o) : value(o.value) { ++live; }
+  auto operator=(const Tracked&) -> Tracked& = default;
+  ~Tracked() { --live; }
+};
+
+using TrackedMap = std::map<int, Tracked>;
+
+} // namespace
+
+// ------------------------------------------------------------
+// Epoch: quiescent only after the readers that could see it left
+// ------------------------------------------------------------
+
+TEST(EpochReclaim, QuiescentWithoutReaders)
+{
+  const auto retired = Epoch::advance();
+  EXPECT_TRUE(Epoch::quiescent(retired));
+}
+
+TEST(EpochReclaim, ReaderInsideBlocksUntilItLeaves)
+{
+  HeldReader reader;
+
+  const auto retired = Epoch::advance();
+  EXPECT_FALSE(Epoch::quiescent(retired));
+
+  reader.leave();
+  EXPECT_TRUE(Epoch::quiescent(retired));
+}
+
+TEST(EpochReclaim, ReaderEnteredAfterRetireDoesNotBlock)
+{
+  const auto retired = Epoch::advance();
+
+  HeldReader reader;
+  EXPECT_TRUE(Epoch::quiescent(retired));
+}
+
+TEST(EpochReclaim, NestedGuardsLeaveWithTheOutermost)
+{
+  std::binary_semaphore innerLeft{0};
+  std::binary_semaphore checked{0};
+
+  std::thread t(
+    [&]() -> void
+    {
+      Epoch::Guard outer;
+      {
+        Epoch::Guard inner;
+      }
+      innerLeft.release();
+      checked.acquire();
+    });
+
+  innerLeft.acquire();
+
+  // the inner guard leaving did not clear the slot, the outer one still holds it
+  EXPECT_FALSE(Epoch::quiescent(Epoch::advance()));
+
+  checked.release();
+  t.join();
+}
+
+// ------------------------------------------------------------
+// SafeMap: a replaced snapshot lives until its readers are gone
+// ------------------------------------------------------------
+
+TEST(EpochReclaim, SafeMapFreesRetiredMapAfterReadersLeave)
+{
+  {
+    SafeMap<TrackedMap> map;
+    map.update([](TrackedMap& m) -> void { m.emplace(1, Tracked(1)); });
+
+    // a reader keeps a reference into the published map across the writes below
+    const Tracked* seen = nullptr;
+    HeldReader     reader(
+      [&]() -> void { map.read([&](const TrackedMap& m) -> void { seen = &m.at(1); }); });
+
+    ASSERT_NE(seen, nullptr);
+    const int before = Tracked::live.load();
+
+    map.update([](TrackedMap& m) -> void { m.at(1).value = 2; });
+    map.update([](TrackedMap& m) -> void { m.at(1).value = 3; });
+
+    // the first map was retired while the reader was inside: still there, still unchanged
+    EXPECT_EQ(seen->value, 1);
+    EXPECT_GT(Tracked::live.load(), before);
+
+    reader.leave();
+
+    // the next write reclaims everything no reader can see anymore
+    map.update([](TrackedMap& m) -> void { m.at(1).value = 4; });
+    EXPECT_EQ(Tracked::live.load(), 1);
+    EXPECT_EQ(map.read([](const TrackedMap& m) -> int { return m.at(1).value; }), 4);
+  }
+
+  EXPECT_EQ(Tracked::live.load(), 0);
+}
@@ -0,0 +1,127 @@
+#include <gtest/gtest.h>
+
+#include "Reference.hpp"
+#include "utils/algorithm/Levenshtein.hpp"
+
+using utils::algorithm::LevenshteinPattern;
+
+#if defined(__AVX2__) || defined(__SSE4_1__)
+static_assert(utils::algorithm::detail::Lanes::N == laneWidth());
+#endif
+
+// ------------------------------------------------------------
+// Batches (distances / forEachWithin) in the lanes of this build
+// ------------------------------------------------------------
+
+class LevenshteinBatch : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    if (!laneSupported())
+      GTEST_SKIP() << "cpu lacks the instruction set this build targets";
+  }
+
+  static void expectBatch(std::string_view pattern, const std::vector<std::string>& texts,
+                          size_t maxDistance, bool foldCase)
+  {
+    const LevenshteinPattern p(pattern, foldCase);
+
+    const std::vector<std::string_view> views(texts.begin(), texts.end());
+    std::vector<size_t>                 out(texts.size(), 12345);
+
+    p.distances(views, maxDistance, out);
+
+    for (size_t i = 0; i < texts.size(); ++i)
+      EXPECT_EQ(out[i], referenceDistance(pattern, texts[i], maxDistance, foldCase))
+        << '"' << pattern << "\" vs \"" << texts[i] << "\" max " << maxDistance;
+  }
+};
+
+TEST_F(LevenshteinBatch, EveryBatchSize)
+{
+  // a batch that fills the lanes, one that leaves some unused, and a single text
+  TextGen gen(10);
+  const auto pattern = gen(8, 24);
+
+  for (size_t n = 0; n <= 4 * laneWidth() + 1; ++n)
+  {
+    std::vector<std::string> texts;
+    for (size_t i = 0; i < n; ++i)
+      texts.push_back(gen.mutate(pattern, i % 4));
+
+    expectBatch(pattern, texts, 3, false);
+    expectBatch(pattern, texts, SIZE_MAX - 1, false);
+  }
+}
+
+TEST_F(LevenshteinBatch, MixedLengthsAndEmptyTexts)
+{
+  // lanes run for the shortest text, the others finish on their own
+  TextGen gen(11);
+  for (int round = 0; round < 50; ++round)
+  {
+    const auto pattern = gen(1, 64);
+
+    std::vector<std::string> texts{""};
+    for (int i = 0; i < 40; ++i)
+      texts.push_back(i % 3 == 0 ? gen(0, 90) : gen.mutate(pattern, static_cast<size_t>(i % 7)));
+
+    for (size_t max : {size_t{0}, size_t{2}, size_t{5}, size_t{64}})
+      expectBatch(pattern, texts, max, round % 2 == 1);
+  }
+}
+
+TEST_F(LevenshteinBatch, EmptyPattern)
+{
+  expectBatch("", {"", "a", "abc", std::string(100, 'z')}, 2, false);
+  expectBatch("", {"", "a", "abc", std::string(100, 'z')}, SIZE_MAX - 1, true);
+}
+
+TEST_F(LevenshteinBatch, MultiWordPattern)
+{
+  TextGen gen(12);
+  const auto pattern = gen(100, 200);
+
+  std::vector<std::string> texts;
+  for (int i = 0; i < 20; ++i)
+    texts.push_back(gen.mutate(pattern, static_cast<size_t>(i)));
+  texts.push_back("");
+  texts.push_back(gen(0, 250));
+
+  expectBatch(pattern, texts, 4, false);
+  expectBatch(pattern, texts, 40, true);
+}
+
+TEST_F(LevenshteinBatch, Utf8Texts)
+{
+  const std::vector<std::string> texts = {"cafe", "caf\xc3\xa9", "CAF\xc3\x89", "Caf\xc3\xa9s",
+                                          "\xc3\xa9", ""};
+  expectBatch("caf\xc3\xa9", texts, 3, false);
+  expectBatch("caf\xc3\xa9", texts, 3, true);
+}
+
+TEST_F(LevenshteinBatch, ForEachWithinMatchesDistances)
+{
+  TextGen gen(13);
+  const auto pattern = gen(5, 40);
+
+  // more than one internal batch of 256
+  std::vector<std::string> texts;
+  for (int i = 0; i < 700; ++i)
+    texts.push_back(i % 2 == 0 ? gen.mutate(pattern, static_cast<size_t>(i % 5)) : gen(0, 50));
+
+  const LevenshteinPattern p(pattern, true);
+
+  std::vector<std::pair<size_t, size_t>> hits;
+  p.forEachWithin(
+    texts.size(), [&](size_t i) -> std::string_view { return texts[i]; }, 2,
+    [&](size_t i, size_t d) -> void { hits.emplace_back(i, d); });
+
+  std::vector<std::pair<size_t, size_t>> want;
+  for (size_t i = 0; i < texts.size(); ++i)
+    if (const size_t d = referenceDistance(pattern, texts[i], true); d <= 2)
+      want.emplace_back(i, d);
+
+  EXPECT_EQ(hits, want);
+}
@@ -0,0 +1,123 @@
+#include <gtest/gtest.h>
+
+#include "Reference.hpp"
+#include "utils/algorithm/Levenshtein.hpp"
+
+using utils::algorithm::LevenshteinPattern;
+using utils::algorithm::StringDistance;
+
+// ------------------------------------------------------------
+// Single distances (scoreWord / scoreBlocked) against the DP
+// ------------------------------------------------------------
+
+class LevenshteinDistance : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    if (!laneSupported())
+      GTEST_SKIP() << "cpu lacks the instruction set this build targets";
+  }
+
+  static void expectReference(std::string_view pattern, std::string_view text,
+                              bool foldCase = false)
+  {
+    const LevenshteinPattern p(pattern, foldCase);
+    const size_t             want = referenceDistance(pattern, text, foldCase);
+
+    EXPECT_EQ(p.distance(text), want) << '"' << pattern << "\" vs \"" << text << '"';
+
+    for (size_t max : {size_t{0}, size_t{1}, size_t{3}, want, want + 2})
+      EXPECT_EQ(p.distance(text, max), std::min(want, max + 1))
+        << '"' << pattern << "\" vs \"" << text << "\" max " << max;
+  }
+};
+
+TEST_F(LevenshteinDistance, EmptyStrings)
+{
+  expectReference("", "");
+  expectReference("", "abc");
+  expectReference("abc", "");
+  expectReference("", std::string(130, 'a'));
+  expectReference(std::string(130, 'a'), "");
+
+  EXPECT_EQ(StringDistance::levenshteinDistance("", ""), 0U);
+  EXPECT_EQ(StringDistance::levenshteinDistance("kitten", ""), 6U);
+}
+
+TEST_F(LevenshteinDistance, KnownPairs)
+{
+  EXPECT_EQ(StringDistance::levenshteinDistance("kitten", "sitting"), 3U);
+  EXPECT_EQ(StringDistance::levenshteinDistance("flaw", "lawn"), 2U);
+  EXPECT_EQ(StringDistance::levenshteinDistance("same", "same"), 0U);
+
+  expectReference("kitten", "sitting");
+  expectReference("Saturday", "Sunday");
+}
+
+TEST_F(LevenshteinDistance, RandomWithinOneWord)
+{
+  TextGen gen(1);
+  for (int i = 0; i < 500; ++i)
+  {
+    const auto pattern = gen(1, 64);
+    expectReference(pattern, gen.mutate(pattern, i % 6));
+    expectReference(pattern, gen(0, 80));
+  }
+}
+
+TEST_F(LevenshteinDistance, PatternOfExactlyOneWord)
+{
+  TextGen gen(2);
+  const auto pattern = gen(64, 64);
+  ASSERT_EQ(pattern.size(), 64U);
+
+  expectReference(pattern, pattern);
+  expectReference(pattern, gen.mutate(pattern, 3));
+  expectReference(pattern, pattern + "z");
+}
+
+TEST_F(LevenshteinDistance, MultiWordPatterns)
+{
+  // > 64 bytes runs the blocked kernel, the carries between words are what can go wrong
+  TextGen gen(3);
+  for (int i = 0; i < 200; ++i)
+  {
+    const auto pattern = gen(65, 300);
+    expectReference(pattern, gen.mutate(pattern, i % 10));
+    expectReference(pattern, gen(0, 320));
+  }
+
+  expectReference(std::string(65, 'a'), std::string(64, 'a'));
+  expectReference(std::string(128, 'a'), std::string(129, 'a'));
+  expectReference(std::string(200, 'a'), std::string(200, 'b'));
+}
+
+TEST_F(LevenshteinDistance, Utf8IsComparedByBytes)
+{
+  // 'é' is two bytes (c3 a9): against 'e' that is one substitution and one deletion
+  expectReference("caf\xc3\xa9", "cafe");
+  EXPECT_EQ(LevenshteinPattern("caf\xc3\xa9").distance("cafe"), 2U);
+
+  expectReference("\xe6\x97\xa5\xe6\x9c\xac", "\xe6\x97\xa5\xe6\x9c\xac\xe8\xaa\x9e");
+  expectReference("na\xc3\xafve caf\xc3\xa9", "naive cafe");
+}
+
+TEST_F(LevenshteinDistance, FoldCase)
+{
+  expectReference("HeLLo WoRLD", "hello world", true);
+  EXPECT_EQ(LevenshteinPattern("HeLLo", true).distance("hello"), 0U);
+  EXPECT_EQ(LevenshteinPattern("HeLLo").distance("hello"), 3U);
+
+  // only ASCII letters fold: 'É' (c3 89) and 'é' (c3 a9) still differ, '@' and '`' too
+  EXPECT_EQ(LevenshteinPattern("\xc3\x89", true).distance("\xc3\xa9"), 1U);
+  EXPECT_EQ(LevenshteinPattern("@[", true).distance("`{"), 2U);
+
+  TextGen gen(4);
+  for (int i = 0; i < 300; ++i)
+  {
+    const auto pattern = gen(1, 150);
+    expectReference(pattern, gen.mutate(pattern, i % 5), true);
+    expectReference(pattern, gen(0, 150), true);
+  }
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// The textbook 2-row DP over bytes, what LevenshteinPattern has to agree with. With foldCase
+// only ASCII letters compare case insensitively.
+inline auto referenceDistance(std::string_view a, std::string_view b, bool foldCase = false)
+  -> size_t
+{
+  const auto same = [foldCase](unsigned char x, unsigned char y) -> bool
+  {
+    if (foldCase)
+    {
+      if (x >= 'A' && x <= 'Z')
+        x = static_cast<unsigned char>(x - 'A' + 'a');
+      if (y >= 'A' && y <= 'Z')
+        y = static_cast<unsigned char>(y - 'A' + 'a');
+    }
+    return x == y;
+  };
+
+  std::vector<size_t> prev(b.size() + 1);
+  std::vector<size_t> cur(b.size() + 1);
+  std::iota(prev.begin(), prev.end(), size_t{0});
+
+  for (size_t i = 1; i <= a.size(); ++i)
+  {
+    cur[0] = i;
+    for (size_t j = 1; j <= b.size(); ++j)
+    {
+      const size_t sub = prev[j - 1] + (same(a[i - 1], b[j - 1]) ? 0 : 1);
+      cur[j]           = std::min({prev[j] + 1, cur[j - 1] + 1, sub});
+    }
+    std::swap(prev, cur);
+  }
+
+  return prev[b.size()];
+}
+
+inline auto referenceDistance(std::string_view a, std::string_view b, size_t maxDistance,
+                              bool foldCase) -> size_t
+{
+  return std::min(referenceDistance(a, b, foldCase), maxDistance + 1);
+}
+
+// Random strings over a small alphabet (so there are matches to find), mixed case and a
+// two byte UTF-8 sequence in it
+class TextGen
+{
+public:
+  explicit TextGen(std::uint32_t seed) : m_rng(seed) {}
+
+  auto operator()(size_t minLen, size_t maxLen) -> std::string
+  {
+    static constexpr std::string_view ALPHABET[] = {"a", "b", "c", "A", "B", " ", "\xc3\xa9"};
+
+    std::uniform_int_distribution<size_t> len(minLen, maxLen);
+    std::uniform_int_distribution<size_t> pick(0, std::size(ALPHABET) - 1);
+
+    std::string s;
+    const size_t n = len(m_rng);
+    while (s.size() < n)
+      s += ALPHABET[pick(m_rng)];
+    return s;
+  }
+
+  // s with a few random single byte edits
+  auto mutate(std::string s, size_t edits) -> std::string
+  {
+    std::uniform_int_distribution<int> op(0, 2);
+    for (size_t e = 0; e < edits; ++e)
+    {
+      const size_t at = s.empty() ? 0 : std::uniform_int_distribution<size_t>(0, s.size())(m_rng);
+      const int    o  = s.empty() ? 0 : op(m_rng);
+
+      if (o == 0)
+        s.insert(at, 1, 'x');
+      else if (at < s.size() && o == 1)
+        s.erase(at, 1);
+      else if (at < s.size())
+        s[at] = 'y';
+    }
+    return s;
+  }
+
+private:
+  std::mt19937 m_rng;
+};
+
+// the lane width the header was compiled for, and whether this cpu can run it
+constexpr auto laneWidth() -> size_t
+{
+#if defined(__AVX2__)
+  return 4;
+#elif defined(__SSE4_1__)
+  return 2;
+#else
+  return 1;
+#endif
+}
+
+inline auto laneSupported() -> bool
+{
+#if defined(__AVX2__)
+  return __builtin_cpu_supports("avx2");
+#elif defined(__SSE4_1__)
+  return __builtin_cpu_supports("sse4.1");
+#else
+  return true;
+#endif
+}
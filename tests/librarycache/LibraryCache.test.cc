@@ -0,0 +1,499 @@
+#include <gtest/gtest.h>
+
+#include "core/LibraryCache.hpp"
+#include "query/Columns.hpp"
+#include "query/sort/Order.hpp"
+
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+
+using core::CacheHeader;
+using core::LibraryCache;
+
+namespace fs = std::filesystem;
+
+namespace
+{
+
+auto makeSong(ino_t inode, std::string_view title, std::string_view artist,
+              std::string_view album, Disc disc, Track track) -> std::shared_ptr<Song>
+{
+  Metadata md;
+  md.title      = std::string(title);
+  md.artist     = artist;
+  md.album      = album;
+  md.genre      = std::string_view("Rock");
+  md.year       = 1999;
+  md.track      = track;
+  md.trackTotal = 12;
+  md.discNumber = disc;
+  md.discTotal  = 2;
+  md.filePath   = "/music/" + std::string(artist) + "/" + std::string(title) + ".flac";
+  md.duration   = 181.5f;
+  md.bitrate    = 320;
+
+  auto& details   = md.details.edit();
+  details.comment = "comment of " + std::string(title);
+  details.lyrics  = "la la " + std::string(title);
+  details.artUrl  = "inlimbo-art://" + std::to_string(inode);
+
+  PropertyBlock::Builder props;
+  props.add("REPLAYGAIN_TRACK_GAIN", "-6.5 dB");
+  props.add("ENCODER", std::string(title) + " encoder");
+  details.additionalProperties = props.finish();
+
+  return std::make_shared<Song>(inode, std::move(md),
+                                FileStamp{.dev = 1, .inode = inode, .mtimeNs = 42, .size = 1000});
+}
+
+auto makeLibrary() -> SongMap
+{
+  SongMap map;
+
+  const auto put = [&map](std::shared_ptr<Song> s) -> void
+  {
+    const auto& md = s->metadata;
+    map[md.artist][md.album][md.discNumber][md.track][s->inode] = std::move(s);
+  };
+
+  put(makeSong(11, "Intro", "Alpha", "First", 1, 1));
+  put(makeSong(12, "Second Song", "Alpha", "First", 1, 2));
+  put(makeSong(13, "Other Disc", "Alpha", "First", 2, 1));
+  put(makeSong(14, "Elsewhere", "Alpha", "Later", 1, 1));
+  put(makeSong(21, "B Side", "Beta", "Only", 1, 1));
+  put(makeSong(22, "Same Track", "Beta", "Only", 1, 1)); // two inodes, one track slot
+
+  return map;
+}
+
+// every song of a, looked up in b, with every field compared
+void expectSameLibrary(const SongMap& a, const SongMap& b)
+{
+  size_t songs = 0;
+
+  for (const auto& [artist, albums] : a)
+    for (const auto& [album, discs] : albums)
+      for (const auto& [disc, tracks] : discs)
+        for (const auto& [track, inodes] : tracks)
+          for (const auto& [inode, song] : inodes)
+          {
+            ++songs;
+            ASSERT_TRUE(b.contains(artist));
+            ASSERT_TRUE(b.at(artist).contains(album));
+            ASSERT_TRUE(b.at(artist).at(album).contains(disc));
+            ASSERT_TRUE(b.at(artist).at(album).at(disc).contains(track));
+            ASSERT_TRUE(b.at(artist).at(album).at(disc).at(track).contains(inode));
+
+            const auto& other = *b.at(artist).at(album).at(disc).at(track).at(inode);
+            const auto& x     = song->metadata;
+            const auto& y     = other.metadata;
+
+            EXPECT_EQ(other.inode, song->inode);
+            EXPECT_EQ(other.stamp, song->stamp);
+            EXPECT_EQ(y.title, x.title);
+            EXPECT_EQ(y.artist, x.artist);
+            EXPECT_EQ(y.album, x.album);
+            EXPECT_EQ(y.genre, x.genre);
+            EXPECT_EQ(y.year, x.year);
+            EXPECT_EQ(y.track, x.track);
+            EXPECT_EQ(y.trackTotal, x.trackTotal);
+            EXPECT_EQ(y.discNumber, x.discNumber);
+            EXPECT_EQ(y.discTotal, x.discTotal);
+            EXPECT_EQ(y.filePath, x.filePath);
+            EXPECT_EQ(y.duration, x.duration);
+            EXPECT_EQ(y.bitrate, x.bitrate);
+
+            const auto& dx = x.details.get();
+            const auto& dy = y.details.get();
+            EXPECT_EQ(dy.comment, dx.comment);
+            EXPECT_EQ(dy.lyrics, dx.lyrics);
+            EXPECT_EQ(dy.artUrl, dx.artUrl);
+            EXPECT_EQ(dy.additionalProperties.size(), dx.additionalProperties.size());
+            for (const auto& [key, value] : dx.additionalProperties)
+              EXPECT_EQ(dy.additionalProperties.find(key), value);
+          }
+
+  size_t other = 0;
+  for (const auto& [artist, albums] : b)
+    for (const auto& [album, discs] : albums)
+      for (const auto& [disc, tracks] : discs)
+        for (const auto& [track, inodes] : tracks)
+          other += inodes.size();
+
+  EXPECT_EQ(other, songs);
+}
+
+} // namespace
+
+class LibraryCacheFile : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    m_dir = fs::temp_directory_path() /
+            ("inlimbo-cache-test-" + std::to_string(::getpid()) + "-" +
+             ::testing::UnitTest::GetInstance()->current_test_info()->name());
+    fs::create_directories(m_dir);
+  }
+
+  void TearDown() override { fs::remove_all(m_dir); }
+
+  [[nodiscard]] auto file() const -> Path { return Path((m_dir / "library.bin").c_str()); }
+
+  // overwrites sizeof(T) bytes at offset of the written cache
+  template <typename T>
+  void patch(size_t offset, const T& value) const
+  {
+    std::fstream f(m_dir / "library.bin", std::ios::in | std::ios::out | std::ios::binary);
+    f.seekp(static_cast<std::streamoff>(offset));
+    f.write(reinterpret_cast<const char*>(&value), sizeof(T));
+  }
+
+  void expectRejected() const
+  {
+    EXPECT_THROW({ LibraryCache cache(file()); }, std::runtime_error);
+  }
+
+  fs::path m_dir;
+};
+
+// ------------------------------------------------------------
+// Round trip
+// ------------------------------------------------------------
+
+TEST_F(LibraryCacheFile, RoundTrip)
+{
+  const auto library = makeLibrary();
+  LibraryCache::write(file(), library, Path("/music"));
+
+  const auto cache = std::make_shared<const LibraryCache>(file());
+  EXPECT_EQ(cache->musicPath(), "/music");
+  EXPECT_EQ(cache->songs().size(), 6U);
+  EXPECT_EQ(cache->artists().size(), 2U);
+  EXPECT_EQ(cache->sortOrder(), nullptr);
+
+  expectSameLibrary(library, cache->toSongMap());
+}
+
+TEST_F(LibraryCacheFile, SameLibraryWritesSameBytes)
+{
+  const auto read = [this]() -> std::string
+  {
+    std::ifstream f(m_dir / "library.bin", std::ios::binary);
+    return {std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>()};
+  };
+
+  const auto library = makeLibrary();
+
+  LibraryCache::write(file(), library, Path("/music"));
+  const auto first = read();
+
+  LibraryCache::write(file(), library, Path("/music"));
+  EXPECT_EQ(read(), first);
+}
+
+TEST_F(LibraryCacheFile, DetailsStayInTheMappingUntilAsked)
+{
+  LibraryCache::write(file(), makeLibrary(), Path("/music"));
+
+  auto map = std::make_shared<const LibraryCache>(file())->toSongMap();
+
+  // the songs keep the mapping alive, nothing was read yet
+  const auto& song = map.at(Artist(std::string_view("Beta")))
+                       .at(Album(std::string_view("Only")))
+                       .at(1)
+                       .at(1)
+                       .at(21);
+  EXPECT_FALSE(song->metadata.details.loaded());
+
+  EXPECT_EQ(song->metadata.details.get().comment, "comment of B Side");
+  EXPECT_EQ(song->metadata.details.get().additionalProperties.find("ENCODER"),
+            "B Side encoder");
+  EXPECT_TRUE(song->metadata.details.loaded());
+}
+
+TEST_F(LibraryCacheFile, EmptyLibrary)
+{
+  LibraryCache::write(file(), SongMap{}, Path("/music"));
+
+  const LibraryCache cache(file());
+  EXPECT_TRUE(cache.songs().empty());
+  EXPECT_TRUE(cache.toSongMap().empty());
+}
+
+TEST_F(LibraryCacheFile, SortOrderRoundTrip)
+{
+  query::songmap::SortOrder order;
+  order.planHash   = 0x1234;
+  order.artists    = {1, 0};
+  order.songs      = {3, 1, 2, 0};
+  order.genreSongs = {2};
+
+  LibraryCache::write(file(), makeLibrary(), Path("/music"), &order);
+
+  const auto loaded = LibraryCache(file()).sortOrder();
+  ASSERT_NE(loaded, nullptr);
+  EXPECT_EQ(loaded->planHash, order.planHash);
+  EXPECT_EQ(loaded->artists, order.artists);
+  EXPECT_EQ(loaded->songs, order.songs);
+  EXPECT_EQ(loaded->genreSongs, order.genreSongs);
+  EXPECT_TRUE(loaded->albums.empty());
+}
+
+TEST_F(LibraryCacheFile, FailedFilesRoundTrip)
+{
+  const FailedFiles failed = {
+    {.path  = Path("/music/Alpha/broken.flac"),
+     .stamp = {.dev = 1, .inode = 77, .mtimeNs = 123'456'789, .size = 4096}},
+    {.path = Path("/music/empty.mp3"), .stamp = {.dev = 1, .inode = 78, .mtimeNs = 5, .size = 0}},
+  };
+
+  LibraryCache::write(file(), makeLibrary(), Path("/music"), nullptr, failed);
+
+  const LibraryCache cache(file());
+  const auto         loaded = cache.failedFiles();
+  ASSERT_EQ(loaded.size(), failed.size());
+  for (size_t i = 0; i < failed.size(); ++i)
+  {
+    EXPECT_EQ(loaded[i].path, failed[i].path);
+    EXPECT_EQ(loaded[i].stamp, failed[i].stamp);
+  }
+
+  // the songs are untouched by it
+  EXPECT_EQ(cache.songs().size(), 6U);
+
+  LibraryCache::write(file(), makeLibrary(), Path("/music"));
+  EXPECT_TRUE(LibraryCache(file()).failedFiles().empty());
+}
+
+// ------------------------------------------------------------
+// Columns of the cache (query::songmap::SongColumns::fromCache)
+// ------------------------------------------------------------
+
+TEST_F(LibraryCacheFile, ColumnsFromCacheMatchTheMap)
+{
+  using query::songmap::SongColumns;
+
+  const auto library = std::make_shared<const SongMap>(makeLibrary());
+  LibraryCache::write(file(), *library, Path("/music"));
+
+  const auto built  = SongColumns::build(library);
+  const auto cached = SongColumns::fromCache(std::make_shared<const LibraryCache>(file()));
+
+  ASSERT_EQ(cached->size(), built->size());
+  EXPECT_EQ(cached->artist, built->artist);
+  EXPECT_EQ(cached->album, built->album);
+  EXPECT_EQ(cached->genre, built->genre);
+  EXPECT_EQ(cached->disc, built->disc);
+  EXPECT_EQ(cached->track, built->track);
+  EXPECT_EQ(cached->year, built->year);
+  EXPECT_EQ(cached->duration, built->duration);
+  EXPECT_EQ(cached->bitrate, built->bitrate);
+  EXPECT_EQ(cached->inode, built->inode);
+  EXPECT_EQ(cached->titleNext, built->titleNext);
+  EXPECT_EQ(cached->genreSongs, built->genreSongs);
+  EXPECT_EQ(cached->artistGenres, built->artistGenres);
+
+  for (ui32 i = 0; i < built->size(); ++i)
+  {
+    EXPECT_EQ(cached->title[i], built->title[i]);
+    EXPECT_EQ(cached->findInode(built->inode[i]), built->findInode(built->inode[i]));
+  }
+
+  ASSERT_EQ(cached->artists.size(), built->artists.size());
+  for (size_t a = 0; a < built->artists.size(); ++a)
+  {
+    EXPECT_EQ(cached->artists[a].name, built->artists[a].name);
+    EXPECT_EQ(cached->artists[a].firstAlbum, built->artists[a].firstAlbum);
+    EXPECT_EQ(cached->artists[a].albumCount, built->artists[a].albumCount);
+    EXPECT_EQ(cached->artists[a].songCount, built->artists[a].songCount);
+  }
+
+  ASSERT_EQ(cached->albums.size(), built->albums.size());
+  for (size_t al = 0; al < built->albums.size(); ++al)
+  {
+    EXPECT_EQ(cached->albums[al].name, built->albums[al].name);
+    EXPECT_EQ(cached->albums[al].firstDisc, built->albums[al].firstDisc);
+    EXPECT_EQ(cached->albums[al].discCount, built->albums[al].discCount);
+    EXPECT_EQ(cached->albums[al].songCount, built->albums[al].songCount);
+  }
+
+  ASSERT_EQ(cached->discs.size(), built->discs.size());
+  for (size_t d = 0; d < built->discs.size(); ++d)
+  {
+    EXPECT_EQ(cached->discs[d].disc, built->discs[d].disc);
+    EXPECT_EQ(cached->discs[d].firstSong, built->discs[d].firstSong);
+    EXPECT_EQ(cached->discs[d].songCount, built->discs[d].songCount);
+  }
+
+  EXPECT_EQ(cached->findPath("/music/Beta/B Side.flac"),
+            built->findPath("/music/Beta/B Side.flac"));
+  EXPECT_EQ(cached->totals.tracks, built->totals.tracks);
+  EXPECT_EQ(cached->totals.artists, built->totals.artists);
+  EXPECT_EQ(cached->totals.albums, built->totals.albums);
+  EXPECT_EQ(cached->totals.genres, built->totals.genres);
+}
+
+TEST_F(LibraryCacheFile, ColumnsFromCacheMakeSongsOnFirstUse)
+{
+  using query::songmap::SongColumns;
+
+  const auto library = makeLibrary();
+  LibraryCache::write(file(), library, Path("/music"));
+
+  const auto c = SongColumns::fromCache(std::make_shared<const LibraryCache>(file()));
+
+  // a song is made once, every later ask gets the same one
+  const ui32 i = c->findPath("/music/Beta/B Side.flac");
+  ASSERT_NE(i, SongColumns::NONE);
+
+  const auto& first = c->songAt(i);
+  EXPECT_EQ(first->metadata.title, "B Side");
+  EXPECT_EQ(&c->songAt(i), &first);
+
+  // the map is filed from the songs the columns hand out
+  const auto& map = c->songMap();
+  expectSameLibrary(library, *map);
+  for (ui32 s = 0; s < c->size(); ++s)
+    EXPECT_EQ(map->at(c->artist[s]).at(c->album[s]).at(c->disc[s]).at(c->track[s]).at(
+                c->inode[s]),
+              c->songAt(s));
+
+  // and the group tables are the ones of that map
+  const auto& d  = c->discs.back();
+  const auto& al = c->albums[d.album];
+  const auto& a  = c->artists[al.artist];
+  EXPECT_EQ(&c->albumMap(a), &map->at(a.name));
+  EXPECT_EQ(&c->discMap(al), &map->at(a.name).at(al.name));
+  EXPECT_EQ(&c->trackMap(d), &map->at(a.name).at(al.name).at(d.disc));
+}
+
+TEST_F(LibraryCacheFile, AdoptLibraryCacheTakesTheSavedOrder)
+{
+  using query::songmap::SongColumns;
+  using query::songmap::SortOrder;
+
+  const auto library = std::make_shared<const SongMap>(makeLibrary());
+  const auto saved   = std::make_shared<const SortOrder>(
+    query::sort::buildOrder(*SongColumns::build(library), query::sort::compile({}), 1));
+  LibraryCache::write(file(), *library, Path("/music"), saved.get());
+
+  // the columns cache is keyed by the map address, keep the map alive past the test
+  static TS_SongMap safeMap;
+  ASSERT_TRUE(query::songmap::adoptLibraryCache(
+    safeMap, std::make_shared<const LibraryCache>(file()), {}));
+
+  const auto c = query::songmap::columns(safeMap);
+  EXPECT_EQ(c->order()->songs, saved->songs);
+  EXPECT_EQ(c->order()->artists, saved->artists);
+
+  // the published map is the one the columns make
+  EXPECT_EQ(safeMap.pin(), c->songMap());
+  EXPECT_EQ(query::songmap::columns(safeMap), c);
+}
+
+TEST_F(LibraryCacheFile, AdoptLibraryCacheRunsAnotherPlan)
+{
+  using namespace query::sort::metric;
+
+  const auto library = std::make_shared<const SongMap>(makeLibrary());
+  const auto saved   = std::make_shared<const query::songmap::SortOrder>(query::sort::buildOrder(
+    *query::songmap::SongColumns::build(library), query::sort::compile({}), 1));
+  LibraryCache::write(file(), *library, Path("/music"), saved.get());
+
+  query::sort::RuntimeSortPlan plan;
+  plan.artist = ArtistMetric::LexDesc;
+
+  static TS_SongMap safeMap;
+  EXPECT_FALSE(query::songmap::adoptLibraryCache(
+    safeMap, std::make_shared<const LibraryCache>(file()), plan));
+
+  const auto c = query::songmap::columns(safeMap);
+  EXPECT_EQ(c->order()->planHash, query::sort::hash(query::sort::compile(plan)));
+  EXPECT_EQ(c->order()->songs, query::sort::buildOrder(*c, query::sort::compile(plan), 1).songs);
+}
+
+// ------------------------------------------------------------
+// Rejected files (the caller rebuilds the library from disk)
+// ------------------------------------------------------------
+
+TEST_F(LibraryCacheFile, MissingFile) { expectRejected(); }
+
+TEST_F(LibraryCacheFile, TruncatedFile)
+{
+  LibraryCache::write(file(), makeLibrary(), Path("/music"));
+
+  const auto size = fs::file_size(m_dir / "library.bin");
+  fs::resize_file(m_dir / "library.bin", size - 8);
+  expectRejected();
+
+  // shorter than the header itself
+  fs::resize_file(m_dir / "library.bin", sizeof(CacheHeader) - 1);
+  expectRejected();
+
+  fs::resize_file(m_dir / "library.bin", 0);
+  expectRejected();
+}
+
+TEST_F(LibraryCacheFile, NotACache)
+{
+  // an old cereal snapshot, or anything else
+  {
+    std::ofstream f(m_dir / "library.bin", std::ios::binary);
+    f << std::string(4096, '\x01');
+  }
+  expectRejected();
+}
+
+TEST_F(LibraryCacheFile, BadMagic)
+{
+  LibraryCache::write(file(), makeLibrary(), Path("/music"));
+  patch(offsetof(CacheHeader, magic), 'X');
+  expectRejected();
+}
+
+TEST_F(LibraryCacheFile, WrongVersion)
+{
+  LibraryCache::write(file(), makeLibrary(), Path("/music"));
+  patch(offsetof(CacheHeader, version), ui32{INLIMBO_LIBRARY_CACHE_VERSION + 1});
+  expectRejected();
+
+  patch(offsetof(CacheHeader, version), ui32{INLIMBO_LIBRARY_CACHE_VERSION - 1});
+  expectRejected();
+}
+
+TEST_F(LibraryCacheFile, CorruptSectionTable)
+{
+  LibraryCache::write(file(), makeLibrary(), Path("/music"));
+
+  // a section running past the end of the file
+  patch(offsetof(CacheHeader, songs) + offsetof(core::Section, count), ui64{1} << 40);
+  expectRejected();
+
+  LibraryCache::write(file(), makeLibrary(), Path("/music"));
+  patch(offsetof(CacheHeader, failed) + offsetof(core::Section, count), ui64{1} << 40);
+  expectRejected();
+}
+
+TEST_F(LibraryCacheFile, MisalignedSection)
+{
+  LibraryCache::write(file(), makeLibrary(), Path("/music"));
+
+  // records are read in place, every section has to be 8 byte aligned
+  patch(offsetof(CacheHeader, props) + offsetof(core::Section, offset), ui64{13});
+  expectRejected();
+}
+
+TEST_F(LibraryCacheFile, CorruptStringRefReadsEmpty)
+{
+  LibraryCache::write(file(), makeLibrary(), Path("/music"));
+  patch(offsetof(CacheHeader, musicPath), core::StrRef{.offset = 1U << 30, .size = 5});
+
+  // references are checked on access, an out of range one reads as empty
+  const LibraryCache cache(file());
+  EXPECT_EQ(cache.musicPath(), "");
+}
@@ -0,0 +1,96 @@
+#include <gtest/gtest.h>
+
+#include "utils/map/Persistent.hpp"
+
+#include <string>
+#include <utility>
+
+using utils::map::PersistentMap;
+
+using Inner = PersistentMap<int, std::string>;
+using Outer = PersistentMap<int, Inner>;
+
+// ------------------------------------------------------------
+// Copy on write: a snapshot never sees writes made through a copy
+// ------------------------------------------------------------
+
+TEST(PersistentMapSnapshot, CopySharesUntilWritten)
+{
+  Inner a;
+  a[1] = "one";
+  a[2] = "two";
+
+  const Inner b = a;
+  EXPECT_TRUE(b.shares(a));
+
+  // const access does not detach
+  EXPECT_EQ(std::as_const(a).at(1), "one");
+  EXPECT_TRUE(b.shares(a));
+
+  a[3] = "three";
+  EXPECT_FALSE(b.shares(a));
+}
+
+TEST(PersistentMapSnapshot, SnapshotUnchangedAfterWrite)
+{
+  Inner live;
+  live[1] = "one";
+  live[2] = "two";
+
+  const Inner snapshot = live;
+
+  live[1] = "uno";
+  live[4] = "four";
+  live.erase(2);
+
+  EXPECT_EQ(snapshot.size(), 2U);
+  EXPECT_EQ(snapshot.at(1), "one");
+  EXPECT_EQ(snapshot.at(2), "two");
+  EXPECT_FALSE(snapshot.contains(4));
+
+  EXPECT_EQ(live.size(), 2U);
+  EXPECT_EQ(live.at(1), "uno");
+  EXPECT_EQ(live.at(4), "four");
+}
+
+TEST(PersistentMapSnapshot, NestedWriteCopiesOnlyItsPath)
+{
+  Outer live;
+  live[1][10] = "a";
+  live[2][20] = "b";
+
+  const Outer snapshot = live;
+
+  live[1][10] = "changed";
+  live[1][11] = "added";
+
+  // the written path is detached, the sibling level stays shared
+  EXPECT_FALSE(live.shares(snapshot));
+  EXPECT_FALSE(std::as_const(live).at(1).shares(snapshot.at(1)));
+  EXPECT_TRUE(std::as_const(live).at(2).shares(snapshot.at(2)));
+
+  EXPECT_EQ(snapshot.at(1).size(), 1U);
+  EXPECT_EQ(snapshot.at(1).at(10), "a");
+  EXPECT_EQ(snapshot.at(2).at(20), "b");
+
+  EXPECT_EQ(std::as_const(live).at(1).at(10), "changed");
+  EXPECT_EQ(std::as_const(live).at(1).at(11), "added");
+}
+
+TEST(PersistentMapSnapshot, EraseAndClearLeaveSnapshot)
+{
+  Outer live;
+  live[1][10] = "a";
+  live[2][20] = "b";
+
+  const Outer snapshot = live;
+
+  live.erase(1);
+  EXPECT_EQ(snapshot.size(), 2U);
+  EXPECT_TRUE(snapshot.contains(1));
+
+  live.clear();
+  EXPECT_TRUE(live.empty());
+  EXPECT_EQ(snapshot.size(), 2U);
+  EXPECT_EQ(snapshot.at(2).at(20), "b");
+}
@@ -0,0 +1,135 @@
+#include <gtest/gtest.h>
+
+#include "utils/string/PropertyBlock.hpp"
+
+#include <map>
+#include <string>
+#include <utility>
+
+using utils::string::InternedString;
+using utils::string::PropertyBlock;
+
+namespace
+{
+
+auto build(std::initializer_list<std::pair<std::string_view, std::string_view>> items)
+  -> PropertyBlock
+{
+  PropertyBlock::Builder b;
+  b.reserve(items.size());
+  for (const auto& [key, value] : items)
+    b.add(key, value);
+  return b.finish();
+}
+
+auto toMap(const PropertyBlock& block) -> std::map<std::string, std::string>
+{
+  std::map<std::string, std::string> out;
+  for (const auto& [key, value] : block)
+    out.emplace(key.str(), std::string(value));
+  return out;
+}
+
+} // namespace
+
+// ------------------------------------------------------------
+// Building and lookups
+// ------------------------------------------------------------
+
+TEST(PropertyBlock, EmptyBlock)
+{
+  const PropertyBlock none;
+  EXPECT_TRUE(none.empty());
+  EXPECT_EQ(none.begin(), none.end());
+  EXPECT_FALSE(none.find("ENCODER").has_value());
+  EXPECT_EQ(none.bytes(), 0U);
+
+  PropertyBlock::Builder b;
+  EXPECT_TRUE(b.finish().empty());
+}
+
+TEST(PropertyBlock, FindsEveryKey)
+{
+  const auto block = build({{"ENCODER", "LAME 3.100"},
+                            {"REPLAYGAIN_TRACK_GAIN", "-6.50 dB"},
+                            {"REPLAYGAIN_TRACK_PEAK", "0.98"},
+                            {"EMPTY", ""}});
+
+  EXPECT_EQ(block.size(), 4U);
+  EXPECT_EQ(block.find("ENCODER"), "LAME 3.100");
+  EXPECT_EQ(block.find("REPLAYGAIN_TRACK_GAIN"), "-6.50 dB");
+  EXPECT_EQ(block.find("REPLAYGAIN_TRACK_PEAK"), "0.98");
+  EXPECT_EQ(block.find("EMPTY"), "");
+  EXPECT_TRUE(block.contains("EMPTY"));
+
+  EXPECT_EQ(block.find(InternedString(std::string_view("ENCODER"))), "LAME 3.100");
+}
+
+TEST(PropertyBlock, MissingKeysAreNotInterned)
+{
+  const auto block = build({{"ENCODER", "x"}});
+
+  const std::string_view key = "PROPERTYBLOCK_TEST_NEVER_ADDED";
+  EXPECT_FALSE(block.find(key).has_value());
+  EXPECT_FALSE(block.contains(key));
+
+  // a lookup must not grow the pool
+  EXPECT_FALSE(InternedString::find(key).has_value());
+}
+
+TEST(PropertyBlock, RepeatedKeysAreJoined)
+{
+  const auto block = build({{"ARTISTS", "A"}, {"GENRE", "Rock"}, {"ARTISTS", "B"},
+                            {"ARTISTS", "C"}});
+
+  EXPECT_EQ(block.size(), 2U);
+  EXPECT_EQ(block.find("ARTISTS"), "A B C");
+  EXPECT_EQ(block.find("GENRE"), "Rock");
+}
+
+TEST(PropertyBlock, IteratesEveryEntryOnce)
+{
+  const auto block = build({{"C", "3"}, {"A", "1"}, {"B", "2"}});
+
+  const std::map<std::string, std::string> want = {{"A", "1"}, {"B", "2"}, {"C", "3"}};
+  EXPECT_EQ(toMap(block), want);
+
+  // key id order
+  InternedString prev;
+  for (const auto& [key, value] : block)
+  {
+    EXPECT_LT(prev.id(), key.id());
+    prev = key;
+  }
+}
+
+TEST(PropertyBlock, CopiesAreDeep)
+{
+  auto block = build({{"ENCODER", "x"}, {"COMMENT2", std::string(100, 'y')}});
+
+  const PropertyBlock copy = block;
+  EXPECT_EQ(toMap(copy), toMap(block));
+  EXPECT_EQ(copy.bytes(), block.bytes());
+
+  block = build({{"OTHER", "z"}});
+  EXPECT_EQ(copy.find("ENCODER"), "x");
+  EXPECT_EQ(copy.find("COMMENT2"), std::string(100, 'y'));
+  EXPECT_FALSE(copy.contains("OTHER"));
+
+  PropertyBlock moved = std::move(block);
+  EXPECT_EQ(moved.find("OTHER"), "z");
+}
+
+TEST(PropertyBlock, BuilderIsReusable)
+{
+  PropertyBlock::Builder b;
+  b.add("ENCODER", "first");
+  const auto first = b.finish();
+
+  b.add("ENCODER", "second");
+  const auto second = b.finish();
+
+  EXPECT_EQ(first.find("ENCODER"), "first");
+  EXPECT_EQ(second.find("ENCODER"), "second");
+  EXPECT_EQ(second.size(), 1U);
+}
@@ -24,3 +24,14 @@ TEST(SmallStringAssign, MoveAssign)
   EXPECT_EQ(b, "bar");
 }
 
+TEST(SmallStringAssign, MoveAssignHeap)
+{
+  const char* longStr = "a string that is well past the inline capacity";
+
+  SmallString a(longStr);
+  SmallString b("short");
+  b = std::move(a);
+  EXPECT_EQ(b, longStr);
+  EXPECT_EQ(b.size(), std::strlen(longStr));
+}
+
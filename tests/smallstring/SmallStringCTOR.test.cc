@@ -49,3 +49,17 @@ TEST(SmallStringCtor, MoveConstructor)
   SmallString b(std::move(a));
   EXPECT_EQ(b, "move");
 }
+
+TEST(SmallStringCtor, MoveConstructorHeap)
+{
+  const char* longStr = "/home/user/Music/Some Artist/Some Album/01 - Track.flac";
+
+  SmallString a(longStr);
+  ASSERT_FALSE(a.is_sso());
+
+  SmallString b(std::move(a));
+  EXPECT_EQ(b, longStr);
+  EXPECT_EQ(b.size(), std::strlen(longStr));
+  EXPECT_EQ(b.extension(), ".flac");
+  EXPECT_TRUE(a.empty());
+}
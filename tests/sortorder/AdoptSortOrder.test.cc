@@ -0,0 +1,122 @@
+#include <gtest/gtest.h>
+
+#include "Library.hpp"
+#include "query/sort/Order.hpp"
+
+using query::songmap::SortOrder;
+
+// The columns cache is keyed by the address of the TS_SongMap, so every test publishes into
+// a map of its own that outlives the test (a new map at a freed address would find the old
+// entry).
+
+namespace
+{
+
+auto otherPlan() -> query::sort::RuntimeSortPlan
+{
+  using namespace query::sort::metric;
+
+  query::sort::RuntimeSortPlan p;
+  p.artist = ArtistMetric::TrackCountDesc;
+  p.album  = AlbumMetric::YearAsc;
+  p.track  = TrackMetric::TrackDesc;
+  return p;
+}
+
+auto orderFor(const TS_SongMap& safeMap, const query::sort::RuntimeSortPlan& plan)
+  -> std::shared_ptr<const SortOrder>
+{
+  const auto c = query::songmap::columns(safeMap);
+  return std::make_shared<const SortOrder>(
+    query::sort::buildOrder(*c, query::sort::compile(plan), 1));
+}
+
+} // namespace
+
+// ------------------------------------------------------------
+// adoptSortOrder: only an order of the same program is taken
+// ------------------------------------------------------------
+
+TEST(AdoptSortOrder, RejectsAnotherPlanHash)
+{
+  static TS_SongMap safeMap;
+  safeMap.replace(generateLibrary(7));
+
+  const auto before = query::songmap::columns(safeMap)->order();
+  const auto saved  = orderFor(safeMap, otherPlan());
+
+  // saved with otherPlan(), offered for the default plan
+  EXPECT_FALSE(query::songmap::adoptSortOrder(safeMap, {}, saved));
+
+  const auto c = query::songmap::columns(safeMap);
+  EXPECT_EQ(c->order(), before);
+  EXPECT_EQ(c->order()->planHash, query::sort::hash(query::sort::compile({})));
+}
+
+TEST(AdoptSortOrder, RejectsMissingOrder)
+{
+  static TS_SongMap safeMap;
+  safeMap.replace(generateLibrary(8));
+
+  EXPECT_FALSE(query::songmap::adoptSortOrder(safeMap, {}, nullptr));
+}
+
+TEST(AdoptSortOrder, TakesMatchingOrderAsIs)
+{
+  static TS_SongMap safeMap;
+  safeMap.replace(generateLibrary(9));
+
+  const auto saved = orderFor(safeMap, otherPlan());
+  ASSERT_TRUE(query::songmap::adoptSortOrder(safeMap, otherPlan(), saved));
+
+  // the very order handed in, the plan did not run again
+  EXPECT_EQ(query::songmap::columns(safeMap)->order(), saved);
+}
+
+TEST(AdoptSortOrder, SeedsTheNextBuild)
+{
+  static TS_SongMap safeMap;
+  safeMap.replace(generateLibrary(10));
+
+  // startup: the order saved with the map is offered before any columns of it exist
+  const auto program = query::sort::compile(otherPlan());
+  const auto saved   = std::make_shared<const SortOrder>(query::sort::buildOrder(
+    *query::songmap::SongColumns::build(safeMap.pin()), program, 1));
+
+  ASSERT_TRUE(query::songmap::adoptSortOrder(safeMap, otherPlan(), saved));
+  EXPECT_EQ(query::songmap::columns(safeMap)->order(), saved);
+}
+
+TEST(AdoptSortOrder, OrderThatDoesNotFitIsDropped)
+{
+  static TS_SongMap safeMap;
+  safeMap.replace(generateLibrary(11));
+  (void)query::songmap::columns(safeMap);
+
+  // right hash, wrong shape (an order of another library)
+  static TS_SongMap other;
+  other.replace(generateLibrary(12));
+  auto wrong = orderFor(other, otherPlan());
+
+  ASSERT_TRUE(query::songmap::adoptSortOrder(safeMap, otherPlan(), wrong));
+
+  const auto c = query::songmap::columns(safeMap);
+  EXPECT_NE(c->order(), wrong);
+  EXPECT_EQ(c->order()->songs,
+            query::sort::buildOrder(*c, query::sort::compile(otherPlan()), 1).songs);
+}
+
+TEST(AdoptSortOrder, SetSortPlanReordersInstalledColumns)
+{
+  static TS_SongMap safeMap;
+  safeMap.replace(generateLibrary(13));
+
+  const auto c = query::songmap::columns(safeMap);
+  ASSERT_TRUE(query::songmap::setSortPlan(safeMap, otherPlan()));
+  EXPECT_FALSE(query::songmap::setSortPlan(safeMap, otherPlan()));
+
+  const auto program = query::sort::compile(otherPlan());
+  EXPECT_EQ(query::songmap::columns(safeMap), c);
+  EXPECT_EQ(c->order()->planHash, query::sort::hash(program));
+  EXPECT_EQ(c->order()->songs, reference::order(*c, program).songs);
+}
@@ -0,0 +1,236 @@
+#pragma once
+
+#include "InLimbo-Types.hpp"
+#include "query/Columns.hpp"
+#include "query/sort/Engine.hpp"
+#include "utils/string/Equals.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+// A small library with everything the keys have to tell apart or keep stable: names that
+// only differ in case, non ASCII names, equal album and track counts, albums without a
+// year, several discs, two files on one track.
+inline auto generateLibrary(std::uint32_t seed) -> SongMap
+{
+  static const std::vector<std::string> ARTISTS = {
+    "ABBA", "abba", "Björk", "bjork", "Zed", "zed band", "Ålborg", "Mötley", "A", "a",
+    "The Band", "the band", "Queen", "Émile", "emile", "Yes", "", "12 Stones"};
+  static const std::vector<std::string> GENRES = {"Rock", "rock", "Jazz", "", "Électro"};
+
+  std::mt19937                       rng(seed);
+  std::uniform_int_distribution<int> coin(0, 1);
+
+  const auto pick = [&rng](int lo, int hi) -> int
+  { return std::uniform_int_distribution<int>(lo, hi)(rng); };
+
+  SongMap map;
+  ino_t   inode = 1;
+
+  for (const auto& artist : ARTISTS)
+  {
+    const int albums = pick(1, 4);
+    for (int al = 0; al < albums; ++al)
+    {
+      const std::string album = (coin(rng) ? "album " : "Album ") + std::to_string(pick(0, 3));
+      const Year        year  = coin(rng) ? 0 : static_cast<Year>(1970 + pick(0, 5));
+      const Disc        discs = static_cast<Disc>(pick(1, 2));
+
+      for (Disc d = 1; d <= discs; ++d)
+      {
+        const int tracks = pick(1, 5);
+        for (int t = 0; t < tracks; ++t)
+        {
+          Metadata md;
+          md.artist     = artist;
+          md.album      = album;
+          md.title      = "Song " + std::to_string(inode);
+          md.genre      = GENRES[static_cast<size_t>(pick(0, 4))];
+          md.year       = t == 0 ? year : static_cast<Year>(pick(0, 1) * 1980);
+          md.track      = static_cast<Track>(pick(1, 6));
+          md.discNumber = d;
+
+          const auto id = inode++;
+          map[md.artist][md.album][d][md.track][id] = std::make_shared<Song>(id, md);
+        }
+      }
+    }
+  }
+
+  return map;
+}
+
+// ------------------------------------------------------------
+// The plan order the slow way: comparators and stable sorts, level by level
+// ------------------------------------------------------------
+
+namespace reference
+{
+
+using query::songmap::SongColumns;
+using query::sort::SortProgram;
+using query::sort::metric::Direction;
+using query::sort::metric::Key;
+using query::sort::metric::Step;
+
+// <0, 0, >0 like a three way compare, on one step
+inline auto compareNames(std::string_view a, std::string_view b) -> int
+{
+  if (utils::string::icompare(a, b))
+    return -1;
+  if (utils::string::icompare(b, a))
+    return 1;
+  return 0;
+}
+
+inline auto compareNumbers(ui64 a, ui64 b) -> int { return a < b ? -1 : (a > b ? 1 : 0); }
+
+inline auto albumYear(const SongColumns& c, ui32 al) -> Year
+{
+  const auto& g    = c.albums[al];
+  Track       best = std::numeric_limits<Track>::max();
+  Year        year = 0;
+
+  for (ui32 i = g.firstSong; i < g.firstSong + g.songCount; ++i)
+    if (c.track[i] < best && c.year[i] > 0)
+    {
+      best = c.track[i];
+      year = c.year[i];
+    }
+
+  return year;
+}
+
+// groups [first, first + count) in map order, stably sorted by the steps
+template <typename Cmp>
+auto sorted(ui32 first, ui32 count, const std::vector<Step>& steps, Cmp&& compareOn)
+  -> std::vector<ui32>
+{
+  std::vector<ui32> out(count);
+  std::iota(out.begin(), out.end(), first);
+
+  std::ranges::stable_sort(out,
+                           [&](ui32 x, ui32 y) -> bool
+                           {
+                             for (const auto& s : steps)
+                               if (const int r = compareOn(s.key, x, y); r != 0)
+                                 return s.dir == Direction::Asc ? r < 0 : r > 0;
+                             return false;
+                           });
+  return out;
+}
+
+struct Order
+{
+  std::vector<ui32> artists, albums, discs, songs;
+};
+
+inline auto order(const SongColumns& c, const SortProgram& p) -> Order
+{
+  Order o;
+
+  const auto artistCmp = [&](Key k, ui32 x, ui32 y) -> int
+  {
+    const auto& a = c.artists[x];
+    const auto& b = c.artists[y];
+    switch (k)
+    {
+      case Key::Name:
+        return compareNames(a.name, b.name);
+      case Key::AlbumCount:
+        return compareNumbers(a.albumCount, b.albumCount);
+      case Key::TrackCount:
+        return compareNumbers(a.songCount, b.songCount);
+      default:
+        return 0;
+    }
+  };
+
+  const auto albumCmp = [&](Key k, ui32 x, ui32 y) -> int
+  {
+    const auto& a = c.albums[x];
+    const auto& b = c.albums[y];
+    switch (k)
+    {
+      case Key::Name:
+        return compareNames(a.name, b.name);
+      case Key::Year:
+        return compareNumbers(albumYear(c, x), albumYear(c, y));
+      case Key::TrackCount:
+        return compareNumbers(a.songCount, b.songCount);
+      default:
+        return 0;
+    }
+  };
+
+  const auto discCmp = [&](Key, ui32 x, ui32 y) -> int
+  { return compareNumbers(c.discs[x].disc, c.discs[y].disc); };
+
+  const auto trackCmp = [&](Key, ui32 x, ui32 y) -> int
+  { return compareNumbers(c.track[x], c.track[y]); };
+
+  for (const ui32 a : sorted(0, static_cast<ui32>(c.artists.size()), p.artist, artistCmp))
+  {
+    o.artists.push_back(a);
+
+    const auto& ag = c.artists[a];
+    for (const ui32 al : sorted(ag.firstAlbum, ag.albumCount, p.album, albumCmp))
+    {
+      o.albums.push_back(al);
+
+      const auto& alg = c.albums[al];
+      for (const ui32 d : sorted(alg.firstDisc, alg.discCount, p.disc, discCmp))
+      {
+        o.discs.push_back(d);
+
+        const auto& dg = c.discs[d];
+        for (const ui32 i : sorted(dg.firstSong, dg.songCount, p.track, trackCmp))
+          o.songs.push_back(i);
+      }
+    }
+  }
+
+  return o;
+}
+
+} // namespace reference
+
+// every plan the config can express with one metric per level, plus chained ones
+inline auto allPlans() -> std::vector<query::sort::RuntimeSortPlan>
+{
+  using namespace query::sort::metric;
+
+  std::vector<query::sort::RuntimeSortPlan> plans;
+
+  for (int a = 0; a < static_cast<int>(ArtistMetric::COUNT); ++a)
+    for (int al = 0; al < static_cast<int>(AlbumMetric::COUNT); ++al)
+      for (int d = 0; d < static_cast<int>(DiscMetric::COUNT); ++d)
+        for (int t = 0; t < static_cast<int>(TrackMetric::COUNT); ++t)
+        {
+          query::sort::RuntimeSortPlan p;
+          p.artist = static_cast<ArtistMetric>(a);
+          p.album  = static_cast<AlbumMetric>(al);
+          p.disc   = static_cast<DiscMetric>(d);
+          p.track  = static_cast<TrackMetric>(t);
+          plans.push_back(p);
+        }
+
+  query::sort::RuntimeSortPlan chain;
+  chain.artist     = ArtistMetric::AlbumCountDesc;
+  chain.artistThen = {ArtistMetric::TrackCountAsc, ArtistMetric::LexDesc};
+  chain.album      = AlbumMetric::YearDesc;
+  chain.albumThen  = {AlbumMetric::LexAsc, AlbumMetric::TrackCountDesc};
+  plans.push_back(chain);
+
+  chain.artist     = ArtistMetric::LexAsc;
+  chain.artistThen = {ArtistMetric::LexDesc, ArtistMetric::AlbumCountAsc}; // repeated key
+  chain.album      = AlbumMetric::TrackCountAsc;
+  chain.albumThen  = {AlbumMetric::YearAsc};
+  plans.push_back(chain);
+
+  return plans;
+}
@@ -0,0 +1,154 @@
+#include <gtest/gtest.h>
+
+#include "Library.hpp"
+#include "query/sort/Order.hpp"
+
+#include <atomic>
+#include <thread>
+
+using query::songmap::SongColumns;
+using query::songmap::SortOrder;
+
+namespace
+{
+
+auto columnsOf(std::uint32_t seed) -> std::shared_ptr<SongColumns>
+{
+  return SongColumns::build(std::make_shared<const SongMap>(generateLibrary(seed)));
+}
+
+// rank, the slice starts and the posting lists follow from the four orders, check them too
+void expectConsistent(const SongColumns& c, const SortOrder& o)
+{
+  for (size_t k = 0; k < o.songs.size(); ++k)
+    ASSERT_EQ(o.rank[o.songs[k]], k);
+
+  for (const ui32 a : o.artists)
+    for (const ui32 i : o.songsOfArtist(c, a))
+      EXPECT_EQ(c.artist[i], c.artists[a].name);
+
+  for (const ui32 al : o.albums)
+    for (const ui32 i : o.songsOfAlbum(c, al))
+      EXPECT_EQ(c.album[i], c.albums[al].name);
+
+  for (ui32 g = 0; g < c.genres.size(); ++g)
+  {
+    const auto postings = o.postings(c, g);
+    EXPECT_TRUE(std::ranges::is_sorted(postings, {}, [&](ui32 i) -> ui32 { return o.rank[i]; }));
+    EXPECT_TRUE(std::ranges::is_permutation(postings, c.postings(c.genres[g])));
+  }
+}
+
+} // namespace
+
+// ------------------------------------------------------------
+// Compiled program vs a comparator sort, serial vs parallel
+// ------------------------------------------------------------
+
+TEST(SortOrderPaths, CompiledMatchesReference)
+{
+  for (const std::uint32_t seed : {1U, 2U, 3U})
+  {
+    const auto c = columnsOf(seed);
+
+    for (const auto& plan : allPlans())
+    {
+      const auto program = query::sort::compile(plan);
+      const auto want    = reference::order(*c, program);
+      const auto got     = query::sort::buildOrder(*c, program, 1);
+
+      ASSERT_EQ(got.artists, want.artists) << "seed " << seed;
+      ASSERT_EQ(got.albums, want.albums) << "seed " << seed;
+      ASSERT_EQ(got.discs, want.discs) << "seed " << seed;
+      ASSERT_EQ(got.songs, want.songs) << "seed " << seed;
+      expectConsistent(*c, got);
+    }
+  }
+}
+
+TEST(SortOrderPaths, ParallelMatchesSerial)
+{
+  const auto c = columnsOf(4);
+
+  for (const auto& plan : allPlans())
+  {
+    const auto program = query::sort::compile(plan);
+    const auto serial  = query::sort::buildOrder(*c, program, 1);
+
+    for (const size_t threads : {2U, 3U, 8U})
+    {
+      const auto parallel = query::sort::buildOrder(*c, program, threads);
+
+      ASSERT_EQ(parallel.planHash, serial.planHash);
+      ASSERT_EQ(parallel.artists, serial.artists);
+      ASSERT_EQ(parallel.albums, serial.albums);
+      ASSERT_EQ(parallel.discs, serial.discs);
+      ASSERT_EQ(parallel.songs, serial.songs);
+      ASSERT_EQ(parallel.rank, serial.rank);
+      ASSERT_EQ(parallel.artistAlbum, serial.artistAlbum);
+      ASSERT_EQ(parallel.artistSong, serial.artistSong);
+      ASSERT_EQ(parallel.albumDisc, serial.albumDisc);
+      ASSERT_EQ(parallel.albumSong, serial.albumSong);
+      ASSERT_EQ(parallel.discSong, serial.discSong);
+      ASSERT_EQ(parallel.genreSongs, serial.genreSongs);
+    }
+  }
+}
+
+TEST(SortOrderPaths, ConcurrentOrdersShareThePool)
+{
+  const auto c     = columnsOf(6);
+  const auto plans = allPlans();
+
+  std::vector<SortOrder> want;
+  for (const auto& plan : plans)
+    want.push_back(query::sort::buildOrder(*c, query::sort::compile(plan), 1));
+
+  // every thread asks for the same 4 thread pool, their chunks interleave on it
+  std::vector<std::thread> threads;
+  std::atomic<size_t>      mismatches{0};
+
+  for (size_t t = 0; t < 4; ++t)
+    threads.emplace_back(
+      [&, t]() -> void
+      {
+        for (size_t p = t; p < plans.size(); p += 4)
+          if (query::sort::buildOrder(*c, query::sort::compile(plans[p]), 4).songs !=
+              want[p].songs)
+            ++mismatches;
+      });
+
+  for (auto& t : threads)
+    t.join();
+
+  EXPECT_EQ(mismatches.load(), 0U);
+}
+
+TEST(SortOrderPaths, EmptyLibrary)
+{
+  const auto c = SongColumns::build(std::make_shared<const SongMap>());
+
+  const auto o = query::sort::buildOrder(*c, query::sort::compile({}), 4);
+  EXPECT_TRUE(o.artists.empty());
+  EXPECT_TRUE(o.songs.empty());
+}
+
+TEST(SortOrderPaths, PlanHashNamesTheProgram)
+{
+  using namespace query::sort::metric;
+
+  query::sort::RuntimeSortPlan a;
+  query::sort::RuntimeSortPlan b;
+  b.artistThen = {ArtistMetric::LexDesc}; // repeats the name key, dropped by compile
+
+  query::sort::RuntimeSortPlan other;
+  other.track = TrackMetric::TrackDesc;
+
+  const auto h = query::sort::hash(query::sort::compile(a));
+  EXPECT_NE(h, 0U);
+  EXPECT_EQ(query::sort::hash(query::sort::compile(b)), h);
+  EXPECT_NE(query::sort::hash(query::sort::compile(other)), h);
+
+  const auto c = columnsOf(5);
+  EXPECT_EQ(query::sort::buildOrder(*c, query::sort::compile(a), 1).planHash, h);
+}